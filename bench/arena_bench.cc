@@ -0,0 +1,103 @@
+#include "kunjs/parser.h"
+#include "kunjs/source.h"
+#include "benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+
+// Parsing the same script over and over, as a long-running server would:
+// into a fresh heap-allocated ast::Program each time, then into one
+// ParsedProgram whose arena is reused. The script is the one given as the
+// first argument, or 200 copies of a function that touches most of the
+// grammar. Besides the time, reports how many times operator new was called
+// per parse; once the ParsedProgram has grown to the script, none.
+//
+//   run-arena-bench [script.js]
+
+namespace {
+
+unsigned long allocations = 0;
+
+const char* CHUNK =
+  "function accumulate(list, initial) {\n"
+  "  var total = initial, i = 0;\n"
+  "  for (i = 0; i < list.length; i++) {\n"
+  "    if (list[i] >= 0 && list[i] !== null) { total += list[i] * 2; }\n"
+  "    else { total = total - 1; }\n"
+  "  }\n"
+  "  return total;\n"
+  "}\n"
+  "var message = 'accumulated: ' + accumulate(values, 0x10) / 3.5;\n";
+
+const int CHUNKS = 200;
+const int ITERATIONS = 50;
+
+void ReportAllocations(std::string const& name, unsigned long count) {
+  std::ostringstream line;
+  line << name << ", allocations";
+  std::cerr << std::left << std::setw(40) << line.str()
+            << std::right << std::setw(10) << ITERATIONS << " runs "
+            << std::setw(12) << count / ITERATIONS << " per run" << std::endl;
+}
+
+}
+
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (void* memory = std::malloc(size ? size : 1))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) throw() {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) throw() {
+  std::free(memory);
+}
+
+int main(int argc, char** argv) {
+  std::string code;
+  if (argc > 1) {
+    kunjs::MappedFile file;
+    if (!file.open(argv[1])) {
+      std::cerr << "cannot read " << argv[1] << std::endl;
+      return 1;
+    }
+    code = file.source().str();
+  } else {
+    for (int i = 0; i < CHUNKS; ++i)
+      code += CHUNK;
+  }
+
+  kunjs::Parser parser;
+  kunjs::AtomTable atoms;
+
+  unsigned long before = allocations;
+  kunjs::bench::Stopwatch heap;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    kunjs::ast::Program program;
+    parser.parse(code, program, atoms);
+  }
+  kunjs::bench::Report("heap", ITERATIONS, heap.elapsed_us());
+  ReportAllocations("heap", allocations - before);
+
+  kunjs::ParsedProgram parsed;
+  parser.parse(code, parsed); // grows the arena to its steady-state size
+
+  before = allocations;
+  kunjs::bench::Stopwatch arena;
+  for (int i = 0; i < ITERATIONS; ++i)
+    parser.parse(code, parsed);
+  kunjs::bench::Report("reused arena", ITERATIONS, arena.elapsed_us());
+  ReportAllocations("reused arena", allocations - before);
+
+  std::fprintf(stderr, "arena: %lu KB used, %lu KB reserved\n",
+               static_cast<unsigned long>(parsed.arena().used() / 1024),
+               static_cast<unsigned long>(parsed.arena().reserved() / 1024));
+  return 0;
+}
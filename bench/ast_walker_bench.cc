@@ -0,0 +1,130 @@
+#include "kunjs/arena.h"
+#include "kunjs/ast_walker.h"
+#include "kunjs/parser.h"
+#include "benchmark.h"
+
+#include <boost/variant/apply_visitor.hpp>
+#include <boost/variant/static_visitor.hpp>
+
+#include <sstream>
+#include <string>
+
+// The cost of walking a tree with ast::Walker, against a visitor recursing
+// through apply_visitor the way the passes used to: both count the nodes of
+// a megabyte of arithmetic. Then the walker alone over hand-built chains of
+// negations, deeper than recursion could go, whose time per level should
+// stay flat as they grow.
+
+namespace {
+
+namespace ast = kunjs::ast;
+
+const std::size_t CODE_SIZE = 1024 * 1024;
+const int ITERATIONS = 20;
+const std::size_t DEPTHS[] = { 1000, 10000, 100000, 1000000 };
+
+class Counter : public ast::Walker<Counter> {
+ public:
+  Counter() : nodes(0) {}
+
+  template <typename Node>
+  bool enter(Node const&) { ++nodes; return true; }
+
+  std::size_t nodes;
+};
+
+// Knows just the nodes of the arithmetic below.
+class RecursiveCounter : public boost::static_visitor<std::size_t> {
+ public:
+  std::size_t operator()(ast::AssignmentExpression const& expression) const {
+    return boost::apply_visitor(*this, expression);
+  }
+  std::size_t operator()(ast::Expression const& expression) const {
+    std::size_t nodes = 1;
+    for (ast::Expression::const_iterator it = expression.begin(); it != expression.end(); ++it)
+      nodes += (*this)(*it);
+    return nodes;
+  }
+  std::size_t operator()(ast::UnaryExpression const& unary) const {
+    return 1 + (*this)(unary.operand);
+  }
+  std::size_t operator()(ast::BinaryExpression const& binary) const {
+    return 1 + (*this)(binary.lhs) + (*this)(binary.rhs);
+  }
+  std::size_t operator()(ast::ConditionalExpression const& conditional) const {
+    return 1 + (*this)(conditional.condition) + (*this)(conditional.true_clause) +
+        (*this)(conditional.false_clause);
+  }
+  std::size_t operator()(ast::Assignment const& assignment) const {
+    return 1 + (*this)(assignment.target) + (*this)(assignment.value);
+  }
+  template <typename Node>
+  std::size_t operator()(Node const&) const { return 1; }
+};
+
+// `-(-(...-(1)))`, as in test/ast_walker_test.cc; never destroyed.
+ast::AssignmentExpression const& Negations(std::size_t depth) {
+  ast::AssignmentExpression* root =
+      new (kunjs::Arena::acquire(sizeof(ast::AssignmentExpression))) ast::AssignmentExpression;
+  ast::AssignmentExpression* expression = root;
+  for (std::size_t i = 0; i < depth; ++i) {
+    ast::UnaryExpression negation;
+    negation.operator_ = ast::op::SUB;
+    static_cast<ast::ExpressionNode&>(*expression) = negation;
+    expression = &boost::get<ast::UnaryExpression>(*expression).operand;
+  }
+  static_cast<ast::ExpressionNode&>(*expression) = ast::Literal(ast::Numeric(1));
+  return *root;
+}
+
+}
+
+int main() {
+  std::string code;
+  while (code.size() < CODE_SIZE)
+    code += "x = (a + b) * -c - d / (e ? f : g % 2), y = x * x + 1;\n";
+
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  kunjs::ParseResult result = parser.parse(code, parsed);
+  if (!result) {
+    std::cerr << result << std::endl;
+    return 1;
+  }
+
+  std::size_t recursive_nodes = 0;
+  kunjs::bench::Stopwatch recursive;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    RecursiveCounter count;
+    recursive_nodes = 0;
+    for (ast::Program::const_iterator it = parsed.program().begin(); it != parsed.program().end(); ++it)
+      recursive_nodes += count(boost::get<ast::Expression>(boost::get<ast::Statement>(*it)));
+  }
+  kunjs::bench::Report("recursive visitor", ITERATIONS, recursive.elapsed_us());
+
+  std::size_t walked_nodes = 0;
+  kunjs::bench::Stopwatch walking;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    Counter count;
+    count.walk(parsed.program());
+    walked_nodes = count.nodes;
+  }
+  kunjs::bench::Report("walker", ITERATIONS, walking.elapsed_us());
+  std::cerr << recursive_nodes << " nodes counted by recursion, " << walked_nodes
+            << " walked, the program included" << std::endl;
+
+  kunjs::Arena arena;
+  kunjs::Arena::Scope scope(arena);
+  for (std::size_t d = 0; d < sizeof(DEPTHS) / sizeof(DEPTHS[0]); ++d) {
+    ast::AssignmentExpression const& deep = Negations(DEPTHS[d]);
+    kunjs::bench::Stopwatch deep_walk;
+    for (int i = 0; i < ITERATIONS; ++i) {
+      Counter count;
+      count.walk(deep);
+    }
+    std::ostringstream name;
+    name << "walker, " << DEPTHS[d] << " levels";
+    kunjs::bench::Report(name.str(), ITERATIONS, deep_walk.elapsed_us());
+  }
+  return 0;
+}
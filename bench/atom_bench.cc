@@ -0,0 +1,110 @@
+#include "kunjs/lexer.h"
+#include "kunjs/parser.h"
+#include "benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Memory taken by names. Parses a script (the file given as the first
+// argument, or a generated one) into a ParsedProgram and reports how many
+// names it has, how big the AST arena is, and what the atom table holding
+// each distinct name once costs, counted as the bytes it asks operator new
+// for. Names used to be stored in the AST as one string per occurrence; run
+// against an older build to compare the arena sizes.
+
+namespace {
+
+std::size_t allocated = 0;
+
+const char* CHUNK =
+  "function accumulate(list, initialValue) {\n"
+  "  var total = initialValue, index = 0;\n"
+  "  for (index = 0; index < list.length; index++) {\n"
+  "    if (list[index] >= 0 && list[index] !== null) { total += list[index] * 2; }\n"
+  "    else { total = total - 1; }\n"
+  "  }\n"
+  "  return total;\n"
+  "}\n"
+  "var message = 'accumulated: ' + accumulate(values, 0x10) / 3.5;\n";
+
+const int CHUNKS = 500;
+const int ITERATIONS = 20;
+
+}
+
+void* operator new(std::size_t size) {
+  allocated += size;
+  if (void* memory = std::malloc(size ? size : 1))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) throw() {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) throw() {
+  std::free(memory);
+}
+
+int main(int argc, char** argv) {
+  std::string code;
+  if (argc > 1) {
+    std::ifstream file(argv[1], std::ios::in | std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    code = contents.str();
+  } else {
+    for (int i = 0; i < CHUNKS; ++i)
+      code += CHUNK;
+  }
+
+  kunjs::AtomTable atoms;
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed(atoms);
+  kunjs::ParseResult result = parser.parse(code, parsed);
+  if (!result) {
+    std::cerr << result << std::endl;
+    return 1;
+  }
+
+  kunjs::bench::Stopwatch parsing;
+  for (int i = 0; i < ITERATIONS; ++i)
+    parser.parse(code, parsed);
+  kunjs::bench::ReportThroughput("parse", code.size(), parsing.elapsed_us() / ITERATIONS);
+
+  kunjs::Lexer lexer;
+  kunjs::TokenStream tokens(atoms);
+  lexer.tokenize(code.data(), code.data() + code.size(), tokens);
+  std::size_t occurrences = 0;
+  std::size_t characters = 0;
+  for (std::vector<kunjs::Token>::const_iterator it = tokens.tokens.begin(); it != tokens.tokens.end(); ++it) {
+    if (it->kind == kunjs::token::IDENTIFIER) {
+      ++occurrences;
+      characters += it->length;
+    }
+  }
+
+  // the same names again, into a table of their own
+  std::size_t table_bytes = allocated;
+  {
+    kunjs::AtomTable copy;
+    for (boost::uint32_t id = 0; id < atoms.size(); ++id)
+      copy.intern(atoms.name(kunjs::Atom(id)));
+    table_bytes = allocated - table_bytes;
+  }
+
+  std::fprintf(stderr, "%lu names (%lu KB of text), %lu distinct\n",
+               static_cast<unsigned long>(occurrences),
+               static_cast<unsigned long>(characters / 1024),
+               static_cast<unsigned long>(atoms.size()));
+  std::fprintf(stderr, "AST arena: %lu KB used\n",
+               static_cast<unsigned long>(parsed.arena().used() / 1024));
+  std::fprintf(stderr, "atom table: %lu KB\n", static_cast<unsigned long>(table_bytes / 1024));
+  return 0;
+}
@@ -0,0 +1,70 @@
+#ifndef KUNJS_BENCH_BENCHMARK_H_
+#define KUNJS_BENCH_BENCHMARK_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+namespace kunjs { namespace bench {
+
+class Stopwatch {
+ public:
+  Stopwatch() : start(now()) {}
+
+  void restart() { start = now(); }
+
+  double elapsed_us() const {
+    return static_cast<double>((now() - start).total_microseconds());
+  }
+
+ private:
+  static boost::posix_time::ptime now() {
+    return boost::posix_time::microsec_clock::universal_time();
+  }
+
+  boost::posix_time::ptime start;
+};
+
+// Swallows everything written to std::cout while alive, so that chatty code
+// under measurement does not turn the benchmark into an I/O benchmark.
+class QuietStdout {
+ public:
+  QuietStdout() : saved(std::cout.rdbuf(&sink)) {}
+  ~QuietStdout() { std::cout.rdbuf(saved); }
+
+ private:
+  class NullBuffer : public std::streambuf {
+   protected:
+    int overflow(int c) { return c; }
+  };
+
+  NullBuffer sink;
+  std::streambuf* saved;
+};
+
+inline void Report(std::string const& name, int iterations, double total_us) {
+  std::cerr << std::left << std::setw(40) << name
+            << std::right << std::setw(10) << iterations << " runs "
+            << std::fixed << std::setprecision(2) << std::setw(12)
+            << total_us / iterations << " us/run" << std::endl;
+}
+
+inline void ReportThroughput(std::string const& name, std::size_t bytes, double total_us) {
+  std::cerr << std::left << std::setw(40) << name
+            << std::right << std::setw(10) << bytes / 1024 << " KB   "
+            << std::fixed << std::setprecision(2) << std::setw(12)
+            << bytes / total_us << " MB/s" << std::endl;
+}
+
+} // namespace bench
+} // namespace kunjs
+
+#endif // KUNJS_BENCH_BENCHMARK_H_
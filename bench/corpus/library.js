@@ -0,0 +1,278 @@
+/*
+ * A small utility library, in the style of the ones most pages load before
+ * their own code: collections, strings, events and a little DOM glue.
+ */
+
+var util = (function (global) {
+  var VERSION = '0.9.4';
+  var ArrayProto = Array.prototype, slice = ArrayProto.slice;
+  var hasOwn = Object.prototype.hasOwnProperty;
+  var idCounter = 0;
+
+  function isArray(value) {
+    return Object.prototype.toString.call(value) === '[object Array]';
+  }
+
+  function isFunction(value) {
+    return typeof value === 'function';
+  }
+
+  function isString(value) {
+    return typeof value === 'string' || value instanceof String;
+  }
+
+  function has(object, key) {
+    return object != null && hasOwn.call(object, key);
+  }
+
+  // Calls iterator for every element of list (or own property of an object).
+  function each(list, iterator, context) {
+    var i, length, key;
+    if (list == null) return list;
+    if (isArray(list)) {
+      for (i = 0, length = list.length; i < length; i++) {
+        if (iterator.call(context, list[i], i, list) === false) break;
+      }
+    } else {
+      for (key in list) {
+        if (has(list, key) && iterator.call(context, list[key], key, list) === false) break;
+      }
+    }
+    return list;
+  }
+
+  function map(list, iterator, context) {
+    var results = new Array();
+    each(list, function (value, index) {
+      results.push(iterator.call(context, value, index, list));
+    });
+    return results;
+  }
+
+  function filter(list, predicate, context) {
+    var results = new Array();
+    each(list, function (value, index) {
+      if (predicate.call(context, value, index, list)) results.push(value);
+    });
+    return results;
+  }
+
+  function reduce(list, iterator, memo, context) {
+    var initial = arguments.length > 2;
+    each(list, function (value, index) {
+      if (!initial) {
+        memo = value;
+        initial = true;
+      } else {
+        memo = iterator.call(context, memo, value, index, list);
+      }
+    });
+    if (!initial) throw new TypeError('Reduce of empty list with no initial value');
+    return memo;
+  }
+
+  function indexOf(list, item, from) {
+    var i = from || 0, length = list ? list.length : 0;
+    if (i < 0) i = Math.max(0, length + i);
+    for (; i < length; i++) {
+      if (list[i] === item) return i;
+    }
+    return -1;
+  }
+
+  function uniq(list) {
+    var seen = new Array();
+    each(list, function (value) {
+      if (indexOf(seen, value) < 0) seen.push(value);
+    });
+    return seen;
+  }
+
+  function range(start, stop, step) {
+    if (arguments.length <= 1) {
+      stop = start || 0;
+      start = 0;
+    }
+    step = step || 1;
+    var length = Math.max(Math.ceil((stop - start) / step), 0);
+    var result = new Array(length), index = 0;
+    while (index < length) {
+      result[index++] = start;
+      start += step;
+    }
+    return result;
+  }
+
+  function extend(target) {
+    each(slice.call(arguments, 1), function (source) {
+      var key;
+      for (key in source) {
+        if (has(source, key)) target[key] = source[key];
+      }
+    });
+    return target;
+  }
+
+  function trim(text) {
+    var start = 0, end = text.length;
+    while (start < end && ' \t\n\r'.indexOf(text.charAt(start)) >= 0) ++start;
+    while (end > start && ' \t\n\r'.indexOf(text.charAt(end - 1)) >= 0) --end;
+    return text.substring(start, end);
+  }
+
+  function escapeHtml(text) {
+    var out = '', i, c;
+    for (i = 0; i < text.length; i++) {
+      c = text.charAt(i);
+      switch (c) {
+        case '&': out += '&amp;'; break;
+        case '<': out += '&lt;'; break;
+        case '>': out += '&gt;'; break;
+        case '"': out += '&quot;'; break;
+        case '\'': out += '&#x27;'; break;
+        default: out += c;
+      }
+    }
+    return out;
+  }
+
+  function pad(number, width) {
+    var text = '' + number;
+    while (text.length < width) text = '0' + text;
+    return text;
+  }
+
+  function formatDate(date) {
+    return date.getFullYear() + '-' + pad(date.getMonth() + 1, 2) + '-' + pad(date.getDate(), 2) +
+        ' ' + pad(date.getHours(), 2) + ':' + pad(date.getMinutes(), 2);
+  }
+
+  function uniqueId(prefix) {
+    var id = ++idCounter + '';
+    return prefix ? prefix + id : id;
+  }
+
+  // Returns a function that runs fn at most once every wait milliseconds.
+  function throttle(fn, wait) {
+    var last = 0, timeout = null, context, args;
+    function later() {
+      last = (new Date()).getTime();
+      timeout = null;
+      fn.apply(context, args);
+    }
+    return function () {
+      var now = (new Date()).getTime(), remaining = wait - (now - last);
+      context = this;
+      args = arguments;
+      if (remaining <= 0) {
+        clearTimeout(timeout);
+        later();
+      } else if (!timeout) {
+        timeout = setTimeout(later, remaining);
+      }
+    };
+  }
+
+  function memoize(fn) {
+    var cache = new Array();
+    return function (key) {
+      var i;
+      for (i = 0; i < cache.length; i += 2) {
+        if (cache[i] === key) return cache[i + 1];
+      }
+      var value = fn.apply(this, arguments);
+      cache.push(key, value);
+      return value;
+    };
+  }
+
+  // A minimal event emitter.
+  function Emitter() {
+    this.handlers = new Array();
+  }
+
+  Emitter.prototype.on = function (name, handler) {
+    this.handlers.push([name, handler]);
+    return this;
+  };
+
+  Emitter.prototype.off = function (name, handler) {
+    var kept = new Array(), i, entry;
+    for (i = 0; i < this.handlers.length; i++) {
+      entry = this.handlers[i];
+      if (entry[0] !== name || (handler && entry[1] !== handler)) kept.push(entry);
+    }
+    this.handlers = kept;
+    return this;
+  };
+
+  Emitter.prototype.emit = function (name) {
+    var args = slice.call(arguments, 1), i, entry;
+    for (i = 0; i < this.handlers.length; i++) {
+      entry = this.handlers[i];
+      if (entry[0] === name) {
+        try {
+          entry[1].apply(this, args);
+        } catch (error) {
+          if (global.console) global.console.error(error);
+        }
+      }
+    }
+    return this;
+  };
+
+  function addClass(element, name) {
+    var classes = ' ' + element.className + ' ';
+    if (classes.indexOf(' ' + name + ' ') < 0)
+      element.className = trim(element.className + ' ' + name);
+  }
+
+  function removeClass(element, name) {
+    var classes = (' ' + element.className + ' ').split(' ' + name + ' ').join(' ');
+    element.className = trim(classes);
+  }
+
+  function ready(callback) {
+    var document = global.document, done = false;
+    function fire() {
+      if (done) return;
+      done = true;
+      callback();
+    }
+    if (document.readyState === 'complete') {
+      setTimeout(fire, 0);
+    } else if (document.addEventListener) {
+      document.addEventListener('DOMContentLoaded', fire, false);
+      global.addEventListener('load', fire, false);
+    } else {
+      document.attachEvent('onreadystatechange', function () {
+        if (document.readyState === 'complete') fire();
+      });
+    }
+  }
+
+  var exports = new Emitter();
+  exports.VERSION = VERSION;
+  exports.isArray = isArray;
+  exports.isFunction = isFunction;
+  exports.isString = isString;
+  exports.each = each;
+  exports.map = map;
+  exports.filter = filter;
+  exports.reduce = reduce;
+  exports.indexOf = indexOf;
+  exports.uniq = uniq;
+  exports.range = range;
+  exports.extend = extend;
+  exports.trim = trim;
+  exports.escapeHtml = escapeHtml;
+  exports.formatDate = formatDate;
+  exports.uniqueId = uniqueId;
+  exports.throttle = throttle;
+  exports.memoize = memoize;
+  exports.Emitter = Emitter;
+  exports.addClass = addClass;
+  exports.removeClass = removeClass;
+  exports.ready = ready;
+  return exports;
+})(this);
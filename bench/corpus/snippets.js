@@ -0,0 +1,40 @@
+x = 1;
+var a = b + c * d;
+if (ready) start();
+alert('Hello, world');
+for (var i = 0; i < 10; i++) sum += i;
+while (queue.length) process(queue.shift());
+document.getElementById('menu').style.display = 'none';
+window.onload = function () { init(); };
+var total = price * quantity * (1 + tax / 100);
+return;
+function noop() {}
+function add(a, b) { return a + b; }
+var visible = element.offsetWidth > 0 && element.offsetHeight > 0;
+do { n = n >> 1; } while (n > 1);
+try { load(); } catch (e) { report(e); }
+switch (key) { case 37: left(); break; case 39: right(); break; default: ignore(); }
+var days = ['mon', 'tue', 'wed', 'thu', 'fri'];
+label: for (;;) { if (done()) break label; }
+throw new Error('not implemented');
+var message = count === 1 ? 'one item' : count + ' items';
+delete cache[key];
+if (typeof callback !== 'function') callback = noop;
+var hex = 0xff & (value >>> 8);
+node.parentNode.removeChild(node);
+setTimeout(function () { poll(url, interval * 2); }, interval);
+var x = -y, z = !flag, w = ~mask;
+for (key in options) settings[key] = options[key];
+if (a) { b(); } else if (c) { d(); } else { e(); }
+var list = new Array(16);
+counter += 1, counter <<= 2;
+with (Math) r = sqrt(x * x + y * y);
+var s = 'line one\nline two\t\'quoted\'';
+(function () { var hidden = 1; expose(hidden); })();
+event.preventDefault ? event.preventDefault() : event.returnValue = false;
+var fraction = 3.14159e-2 + .5 + 10.;
+function F() { this.value = 0; }
+F.prototype.next = function () { return ++this.value; };
+var matrix = [[1, 0, 0], [0, 1, 0], [0, 0, 1]];
+i++; j--; --k; ++l;
+var ok = a instanceof Array || 'length' in a;
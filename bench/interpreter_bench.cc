@@ -0,0 +1,88 @@
+#include "kunjs/kunjs.h"
+#include "kunjs/compiler/bytecode_compiler.h"
+#include "kunjs/compiler/interpreter.h"
+#include "kunjs/parser.h"
+#include "benchmark.h"
+
+#include <string>
+
+// The time from source to result of a short script in each tier, which is
+// what a request handler run once pays; then a script run many times by
+// tiered runners that move it to the JIT after more or fewer runs, for
+// warm-up against peak; then the interpreter alone over a loop, for the cost
+// of its dispatch.
+//
+//   run-interpreter-bench
+
+namespace {
+
+const int SCRIPTS = 200;
+const int WARM_UPS = 2000;
+const int LOOPS = 20;
+
+const char SCRIPT[] =
+    "var price = 120, quantity = 3, discount = 0.15;\n"
+    "var total = price * quantity;\n"
+    "total = total - total * discount;\n"
+    "total > 300 ? 'large' : 'small';\n";
+
+// one the JIT compiles in full
+const char ARITHMETIC[] = "120 * 3 - 120 * 3 * 0.15 + 17 % 5 * (2.5 - 1) / 4 > 300;\n";
+
+const char LOOP[] =
+    "var sum = 0;\n"
+    "for (var i = 0; i < 1000000; i++)\n"
+    "  sum = (sum + i % 7) | 0;\n"
+    "sum;\n";
+
+void Startup(std::string const& name, kunjs::Runner::Tier tier) {
+  kunjs::Runner runner(tier);
+  // the JIT is made on the first run
+  runner.run(SCRIPT);
+  kunjs::bench::Stopwatch running;
+  for (int i = 0; i < SCRIPTS; ++i)
+    runner.run(SCRIPT);
+  kunjs::bench::Report(name, SCRIPTS, running.elapsed_us());
+}
+
+// calls of 0 for never.
+void WarmUp(std::string const& name, std::size_t calls) {
+  kunjs::Runner::Tiering tiering;
+  tiering.calls = calls;
+  kunjs::Runner runner(tiering);
+  kunjs::bench::Stopwatch running;
+  for (int i = 0; i < WARM_UPS; ++i)
+    runner.run(ARITHMETIC);
+  kunjs::bench::Report(name, WARM_UPS, running.elapsed_us());
+}
+
+}
+
+int main() {
+  Startup("script, interpreter", kunjs::Runner::INTERPRETER);
+  Startup("script, JIT", kunjs::Runner::JIT);
+
+  WarmUp("tiered, to the JIT after 1", 1);
+  WarmUp("tiered, to the JIT after 10", 10);
+  WarmUp("tiered, to the JIT after 100", 100);
+  WarmUp("tiered, never to the JIT", 0);
+
+  kunjs::AtomTable atoms;
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed(atoms);
+  kunjs::ParseResult result = parser.parse(LOOP, parsed);
+  if (!result) {
+    std::cerr << result << std::endl;
+    return 1;
+  }
+  kunjs::compiler::Code code;
+  kunjs::compiler::BytecodeCompiler()(parsed.program(), code);
+  kunjs::compiler::Interpreter interpreter;
+  std::string sum;
+  kunjs::bench::Stopwatch looping;
+  for (int i = 0; i < LOOPS; ++i)
+    sum = kunjs::compiler::to_string(interpreter.run(code));
+  kunjs::bench::Report("loop of 1000000, interpreter", LOOPS, looping.elapsed_us());
+  std::cerr << "sum " << sum << ", " << code.instructions.size() << " instructions" << std::endl;
+  return 0;
+}
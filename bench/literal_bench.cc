@@ -0,0 +1,67 @@
+#include "kunjs/parser.h"
+#include "benchmark.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Parsing throughput on literal-heavy input: a script made of JSON-like
+// rows (array literals, as the grammar has no object literals yet) full of
+// numbers of every shape and of strings with and without escapes. Give a file as the first argument to parse it
+// instead.
+
+namespace {
+
+const int RECORDS = 4000;
+const int ITERATIONS = 10;
+
+std::string Record(int i) {
+  std::ostringstream out;
+  out << "data.push([" << i << ", 'item number " << i << "',"
+      << " \"a longer description of item " << i << ", as JSON often has\","
+      << " " << i << "." << (i * 37) % 100 << ", " << i % 7 << ".5e-" << i % 9 << ","
+      << " 0x" << std::hex << i * 2654435761u % 0xffffff << std::dec << ","
+      << " " << 1000000000000ll * i << ","
+      << " 'it\\'s \\\"escaped\\\"\\n\\ttab \\u00e9',"
+      << " [" << i << ", " << i * 3 << ", " << -i << ", 1.25, 3e10, 0.001]]);\n";
+  return out.str();
+}
+
+}
+
+int main(int argc, char** argv) {
+  std::string code;
+  if (argc > 1) {
+    std::ifstream file(argv[1], std::ios::in | std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    code = contents.str();
+  } else {
+    for (int i = 0; i < RECORDS; ++i)
+      code += Record(i);
+  }
+
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  kunjs::ParseResult result = parser.parse(code, parsed);
+  if (!result) {
+    std::cerr << result << std::endl;
+    return 1;
+  }
+
+  kunjs::bench::Stopwatch parsing;
+  for (int i = 0; i < ITERATIONS; ++i)
+    parser.parse(code, parsed);
+  kunjs::bench::ReportThroughput("parse", code.size(), parsing.elapsed_us() / ITERATIONS);
+
+  kunjs::Lexer lexer;
+  kunjs::TokenStream tokens;
+  kunjs::bench::Stopwatch tokenizing;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    tokens.clear();
+    lexer.tokenize(code.data(), code.data() + code.size(), tokens);
+  }
+  kunjs::bench::ReportThroughput("tokenize", code.size(), tokenizing.elapsed_us() / ITERATIONS);
+  return 0;
+}
@@ -0,0 +1,64 @@
+#include "kunjs/parser.h"
+#include "benchmark.h"
+
+#include <sstream>
+#include <string>
+
+// Parse time of deeply nested loops and conditionals. Every statement should
+// be parsed once, so the time per nesting level has to stay flat as the
+// depth grows; a rule that re-parses its body shows up as a time per level
+// that doubles with every step.
+
+namespace {
+
+// The four kinds of `for` header, so each of them nests inside the others.
+const char* HEADERS[] = {
+  "for (i = 0; i < n; i++)",
+  "for (var j = 0, m = n; j < m; j++)",
+  "for (key in object)",
+  "for (var name in object)"
+};
+
+const int HEADER_COUNT = sizeof(HEADERS) / sizeof(HEADERS[0]);
+const int DEPTHS[] = { 8, 16, 32, 64, 128 };
+const int ITERATIONS = 20;
+
+std::string Nest(int depth) {
+  std::string code = "total = total + 1;\n";
+  for (int level = 0; level < depth; ++level) {
+    std::string header = HEADERS[level % HEADER_COUNT];
+    code = header + " {\n"
+        "  if (i % 2 == 0) {\n" + code + "  total++;\n  } else if (i > 3) { total = total - i; }\n"
+        "  else { outer: while (total > 0) { total--; continue outer; } }\n"
+        "}\n";
+  }
+  return code;
+}
+
+}
+
+int main() {
+  kunjs::Parser parser;
+
+  for (unsigned d = 0; d < sizeof(DEPTHS) / sizeof(DEPTHS[0]); ++d) {
+    std::string code = Nest(DEPTHS[d]);
+    if (!parser.parse(code)) {
+      std::cerr << "depth " << DEPTHS[d] << ": " << parser.parse(code) << std::endl;
+      return 1;
+    }
+
+    kunjs::bench::Stopwatch parsing;
+    for (int i = 0; i < ITERATIONS; ++i)
+      parser.parse(code);
+    double total_us = parsing.elapsed_us();
+
+    std::ostringstream name;
+    name << "nested for/if, depth " << DEPTHS[d];
+    kunjs::bench::Report(name.str(), ITERATIONS, total_us);
+
+    name << " (per level)";
+    kunjs::bench::Report(name.str(), ITERATIONS, total_us / DEPTHS[d]);
+  }
+
+  return 0;
+}
@@ -0,0 +1,63 @@
+#include "kunjs/compiler.h"
+#include "benchmark.h"
+
+#include <sstream>
+#include <string>
+
+// Compile time and run time of the same program at each level of
+// optimization. Compiling covers parsing, the passes of the level and the
+// machine code the JIT makes; running calls that machine code over and over.
+//
+//   run-optimization-bench
+
+namespace {
+
+const int TERMS = 500;
+const int COMPILATIONS = 200;
+const int RUNS = 1000000;
+
+struct Level {
+  char const* name;
+  kunjs::compiler::Optimizer::Level level;
+};
+
+const Level LEVELS[] = {
+  { "O0", kunjs::compiler::Optimizer::O0 },
+  { "O1", kunjs::compiler::Optimizer::O1 },
+  { "O2", kunjs::compiler::Optimizer::O2 },
+};
+
+}
+
+int main() {
+  std::ostringstream code;
+  code << "0.5";
+  for (int i = 1; i < TERMS; ++i)
+    code << (i % 3 == 0 ? " * " : i % 3 == 1 ? " + " : " - ") << i << ".25";
+  code << ";\n";
+
+  for (std::size_t l = 0; l < sizeof(LEVELS) / sizeof(LEVELS[0]); ++l) {
+    kunjs::Compiler compiler(LEVELS[l].level);
+    std::string name = LEVELS[l].name;
+
+    kunjs::bench::Stopwatch compiling;
+    for (int i = 0; i < COMPILATIONS; ++i) {
+      llvm::Function* program = compiler.compile(code.str());
+      compiler.native(program);
+      compiler.release(program);
+    }
+    kunjs::bench::Report(name + " compile", COMPILATIONS, compiling.elapsed_us());
+
+    llvm::Function* program = compiler.compile(code.str());
+    double (*native)() = reinterpret_cast<double (*)()>(compiler.native(program));
+    double sum = 0;
+    kunjs::bench::Stopwatch running;
+    for (int i = 0; i < RUNS; ++i)
+      sum += native();
+    kunjs::bench::Report(name + " run", RUNS, running.elapsed_us());
+    if (sum != sum)
+      std::cerr << "NaN" << std::endl;
+    compiler.release(program);
+  }
+  return 0;
+}
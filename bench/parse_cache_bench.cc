@@ -0,0 +1,86 @@
+#include "kunjs/parse_cache.h"
+#include "benchmark.h"
+
+#include <cstdio>
+#include <string>
+
+// What a parse cache hit saves. Times parsing a script (the file given as
+// the first argument, or a generated one) and flattening it, which is what
+// a miss costs, against reading the same tree back from the cache.
+
+namespace {
+
+const char* CHUNK =
+  "function accumulate(list, initialValue) {\n"
+  "  var total = initialValue, index = 0;\n"
+  "  for (index = 0; index < list.length; index++) {\n"
+  "    if (list[index] >= 0 && list[index] !== null) { total += list[index] * 2; }\n"
+  "    else { total = total - 1; }\n"
+  "  }\n"
+  "  return total;\n"
+  "}\n"
+  "var message = 'accumulated: ' + accumulate(values, 0x10) / 3.5;\n";
+
+const int CHUNKS = 500;
+const int ITERATIONS = 20;
+
+}
+
+int main(int argc, char** argv) {
+  std::string generated;
+  kunjs::MappedFile file;
+  kunjs::Source code;
+  if (argc > 1) {
+    if (!file.open(argv[1])) {
+      std::cerr << "cannot read " << argv[1] << std::endl;
+      return 1;
+    }
+    code = file.source();
+  } else {
+    for (int i = 0; i < CHUNKS; ++i)
+      generated += CHUNK;
+    code = generated;
+  }
+
+  kunjs::Parser parser;
+  kunjs::ParseCache cache(".");
+  kunjs::AtomTable atoms;
+  kunjs::flat::Tree tree;
+
+  kunjs::bench::Stopwatch parsing;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    kunjs::ParsedProgram parsed(atoms);
+    if (!parser.parse(code, parsed)) {
+      std::cerr << parser.parse(code, parsed) << std::endl;
+      return 1;
+    }
+    kunjs::flat::flatten(parsed.program(), atoms, tree);
+  }
+  kunjs::bench::ReportThroughput("parse and flatten", code.size(), parsing.elapsed_us() / ITERATIONS);
+
+  std::string data;
+  kunjs::flat::write(tree, data);
+  if (!cache.store(code, tree)) {
+    std::cerr << "cannot write " << cache.path(code) << std::endl;
+    return 1;
+  }
+
+  // a new table each time, as after a restart
+  kunjs::bench::Stopwatch loading;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    kunjs::AtomTable restarted;
+    kunjs::flat::Tree loaded;
+    if (!cache.load(code, restarted, loaded))
+      return 1;
+  }
+  kunjs::bench::ReportThroughput("cache hit", code.size(), loading.elapsed_us() / ITERATIONS);
+
+  kunjs::bench::Stopwatch hashing;
+  for (int i = 0; i < ITERATIONS; ++i)
+    kunjs::ParseCache::hash(code);
+  kunjs::bench::ReportThroughput("of which hashing the source", code.size(), hashing.elapsed_us() / ITERATIONS);
+
+  std::fprintf(stderr, "cache entry: %lu KB\n", static_cast<unsigned long>(data.size() / 1024));
+  std::remove(cache.path(code).c_str());
+  return 0;
+}
@@ -0,0 +1,68 @@
+#include "kunjs/parse_job.h"
+#include "benchmark.h"
+
+#include <boost/thread/thread.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+// How parsing many scripts scales with the number of workers. Parses the
+// same set of generated scripts (or the files given as arguments) with one
+// worker, then twice as many each round up to the hardware threads.
+
+namespace {
+
+const char* CHUNK =
+  "function accumulate(list, initialValue) {\n"
+  "  var total = initialValue, index = 0;\n"
+  "  for (index = 0; index < list.length; index++) {\n"
+  "    if (list[index] >= 0 && list[index] !== null) { total += list[index] * 2; }\n"
+  "    else { total = total - 1; }\n"
+  "  }\n"
+  "  return total;\n"
+  "}\n"
+  "var message = 'accumulated: ' + accumulate(values, 0x10) / 3.5;\n";
+
+const int SCRIPTS = 200;
+const int ITERATIONS = 5;
+
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> codes;
+  for (int i = 0; argc == 1 && i < SCRIPTS; ++i) {
+    std::string code;
+    // 8 to 64 chunks, so that the scripts are not all the same size
+    for (int j = 0; j < 8 + (i * 7) % 57; ++j)
+      code += CHUNK;
+    codes.push_back(code);
+  }
+
+  kunjs::Parser parser;
+  std::size_t bytes = 0;
+  std::size_t hardware = boost::thread::hardware_concurrency();
+  for (std::size_t threads = 1; threads <= hardware; threads *= 2) {
+    kunjs::bench::Stopwatch parsing;
+    for (int i = 0; i < ITERATIONS; ++i) {
+      kunjs::ParseJob job(parser, threads);
+      for (std::size_t j = 0; j < codes.size(); ++j)
+        job.add(codes[j]);
+      for (int j = 1; j < argc; ++j)
+        job.add_file(argv[j]);
+      if (!job.run()) {
+        std::cerr << "some of the scripts did not parse" << std::endl;
+        return 1;
+      }
+
+      bytes = 0;
+      for (std::size_t j = 0; j < job.size(); ++j)
+        bytes += job.code(j).size();
+    }
+
+    std::ostringstream name;
+    name << "parse job, " << threads << " thread(s)";
+    kunjs::bench::ReportThroughput(name.str(), bytes, parsing.elapsed_us() / ITERATIONS);
+  }
+  return 0;
+}
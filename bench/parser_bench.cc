@@ -0,0 +1,370 @@
+#include "kunjs/flat_ast.h"
+#include "kunjs/grammar_profile.h"
+#include "kunjs/parser.h"
+#include "kunjs/source.h"
+#include "benchmark.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi")
+#else
+#include <sys/resource.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The parser benchmark suite, built as the bench-parser target. Parses a
+// fixed corpus (bench/corpus plus a few generated cases) and any scripts
+// given on the command line, and reports for each case:
+//
+//   MB/s          source bytes parsed per second
+//   nodes/s       AST nodes built per second, counted as the nodes of the
+//                 flattened tree
+//   allocs/node   operator new calls per node on a first parse, into a new
+//                 atom table and a new ParsedProgram
+//   arena/node    AST arena bytes per node
+//   peak RSS      of the whole process once the case is done; it only grows,
+//                 so a case raising it is the one that needed the memory
+//
+// The table goes to stderr; with --json the same numbers are also written to
+// stdout as one JSON object, for scripts comparing two builds. With
+// --profile, each case is parsed once more and the time of every grammar
+// rule is reported (see GrammarProfile; needs a KUNJS_PROFILE_GRAMMAR build).
+//
+//   run-parser-bench [--json] [--profile] [--corpus dir] [script.js...]
+
+namespace {
+
+std::size_t allocations = 0;
+
+const std::size_t LIBRARY_SIZE = 512 * 1024;
+const int NESTING_DEPTH = 64;
+const int NESTED_STATEMENTS = 200;
+const int ARRAY_LENGTH = 2000;
+const int ARRAYS = 20;
+
+// Every case is parsed until it has taken this long, and at least
+// MIN_ITERATIONS times.
+const double MIN_TIME_US = 500 * 1000;
+const int MIN_ITERATIONS = 3;
+
+struct Case {
+  std::string name;
+  // Parsed one at a time, each into a ParsedProgram of its own.
+  std::vector<std::string> sources;
+};
+
+struct Result {
+  std::string name;
+  bool parsed;
+  std::size_t bytes;
+  std::size_t nodes;
+  int iterations;
+  double us_per_parse;
+  std::size_t allocations;
+  std::size_t arena_bytes;
+  long peak_rss_kb;
+};
+
+bool ReadFile(std::string const& path, std::string& contents) {
+  kunjs::MappedFile file;
+  if (!file.open(path))
+    return false;
+  contents = file.source().str();
+  return true;
+}
+
+long PeakRssKb() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return 0;
+  return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(__APPLE__)
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// One snippet per line, as the short inline handlers and one-liners of a
+// page, each a script of its own.
+void Snippets(std::string const& text, Case& snippets) {
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (!line.empty())
+      snippets.sources.push_back(line + "\n");
+  }
+}
+
+// The library over and over, up to LIBRARY_SIZE; the copies only redeclare
+// the same names, which is fine for the parser.
+std::string Library(std::string const& library) {
+  std::string code;
+  while (code.size() < LIBRARY_SIZE)
+    code += library;
+  return code;
+}
+
+// Parenthesized arithmetic NESTING_DEPTH levels deep, calls nested in calls,
+// and blocks nested in blocks: the cases that take the grammar deepest.
+std::string Nested() {
+  std::string expression = "x";
+  std::string call = "x";
+  std::string block = "x++;";
+  for (int level = 0; level < NESTING_DEPTH; ++level) {
+    std::ostringstream digit;
+    digit << level % 10;
+    expression = "(" + expression + (level % 2 ? " * " : " + ") + digit.str() + ")";
+    call = "f" + digit.str() + "(" + call + ", " + digit.str() + ")";
+    block = "if (x) { " + block + " }";
+  }
+
+  std::string code;
+  for (int i = 0; i < NESTED_STATEMENTS; ++i) {
+    code += "y = " + expression + ";\n";
+    code += "z = " + call + ";\n";
+    code += block + "\n";
+  }
+  return code;
+}
+
+// Long array literals of numbers and strings, as in lookup tables and data
+// embedded in scripts.
+std::string Arrays() {
+  std::ostringstream code;
+  for (int array = 0; array < ARRAYS; ++array) {
+    code << "var table" << array << " = [";
+    for (int i = 0; i < ARRAY_LENGTH; ++i) {
+      if (i)
+        code << ", ";
+      switch (i % 4) {
+        case 0: code << i; break;
+        case 1: code << i << ".25"; break;
+        case 2: code << "0x" << std::hex << i * 7 << std::dec; break;
+        default: code << "'entry " << i << "'";
+      }
+    }
+    code << "];\n";
+  }
+  return code.str();
+}
+
+bool ParseOnce(kunjs::Parser const& parser, std::string const& code, Result& result) {
+  kunjs::AtomTable atoms;
+  std::size_t before = allocations;
+  kunjs::ParsedProgram parsed(atoms);
+  if (!parser.parse(code, parsed))
+    return false;
+  result.allocations += allocations - before;
+  result.arena_bytes += parsed.arena().used();
+
+  kunjs::flat::Tree tree;
+  kunjs::flat::flatten(parsed.program(), atoms, tree);
+  result.nodes += tree.nodes.size();
+  return true;
+}
+
+Result Run(kunjs::Parser const& parser, Case const& bench) {
+  Result result;
+  result.name = bench.name;
+  result.parsed = true;
+  result.bytes = 0;
+  result.nodes = 0;
+  result.iterations = 0;
+  result.us_per_parse = 0;
+  result.allocations = 0;
+  result.arena_bytes = 0;
+
+  for (std::size_t i = 0; i < bench.sources.size(); ++i) {
+    result.bytes += bench.sources[i].size();
+    if (!ParseOnce(parser, bench.sources[i], result)) {
+      std::cerr << bench.name << ": " << parser.parse(bench.sources[i]) << std::endl;
+      result.parsed = false;
+    }
+  }
+
+  if (result.parsed) {
+    kunjs::AtomTable atoms;
+    kunjs::bench::Stopwatch parsing;
+    double elapsed = 0;
+    while (elapsed < MIN_TIME_US || result.iterations < MIN_ITERATIONS) {
+      for (std::size_t i = 0; i < bench.sources.size(); ++i) {
+        kunjs::ParsedProgram parsed(atoms);
+        parser.parse(bench.sources[i], parsed);
+      }
+      ++result.iterations;
+      elapsed = parsing.elapsed_us();
+    }
+    result.us_per_parse = elapsed / result.iterations;
+  }
+  result.peak_rss_kb = PeakRssKb();
+  return result;
+}
+
+double PerNode(std::size_t value, std::size_t nodes) {
+  return nodes ? static_cast<double>(value) / nodes : 0;
+}
+
+void Profile(kunjs::Parser const& parser, Case const& bench) {
+  kunjs::GrammarProfile profile;
+  {
+    kunjs::GrammarProfile::Scope scope(profile);
+    for (std::size_t i = 0; i < bench.sources.size(); ++i)
+      parser.parse(bench.sources[i]);
+  }
+  std::cerr << profile << std::endl;
+}
+
+void Print(Result const& result) {
+  double seconds = result.us_per_parse / 1e6;
+  std::fprintf(stderr, "%-24s %8lu KB %9lu nodes", result.name.c_str(),
+               static_cast<unsigned long>(result.bytes / 1024),
+               static_cast<unsigned long>(result.nodes));
+  if (!result.parsed) {
+    std::fprintf(stderr, "   parse error\n");
+    return;
+  }
+  std::fprintf(stderr, " %9.2f MB/s %12.0f nodes/s %6.2f allocs/node %6.1f B/node %8ld KB RSS\n",
+               result.bytes / result.us_per_parse,
+               result.nodes / seconds,
+               PerNode(result.allocations, result.nodes),
+               PerNode(result.arena_bytes, result.nodes),
+               result.peak_rss_kb);
+}
+
+std::string JsonString(std::string const& text) {
+  std::string quoted = "\"";
+  for (std::string::const_iterator it = text.begin(); it != text.end(); ++it) {
+    unsigned char c = *it;
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if (c < 0x20) {
+      char escaped[8];
+      std::sprintf(escaped, "\\u%04x", c);
+      quoted += escaped;
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+void PrintJson(std::vector<Result> const& results) {
+  std::printf("{\n  \"benchmark\": \"parser\",\n  \"cases\": [");
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    Result const& result = results[i];
+    double seconds = result.us_per_parse / 1e6;
+    std::printf("%s\n    {\"name\": %s, \"parsed\": %s, \"bytes\": %lu, \"nodes\": %lu, "
+                "\"iterations\": %d, \"us_per_parse\": %.2f, \"mb_per_s\": %.3f, "
+                "\"nodes_per_s\": %.0f, \"allocations_per_node\": %.4f, "
+                "\"arena_bytes_per_node\": %.2f, \"peak_rss_kb\": %ld}",
+                i ? "," : "",
+                JsonString(result.name).c_str(),
+                result.parsed ? "true" : "false",
+                static_cast<unsigned long>(result.bytes),
+                static_cast<unsigned long>(result.nodes),
+                result.iterations,
+                result.us_per_parse,
+                result.parsed ? result.bytes / result.us_per_parse : 0,
+                result.parsed ? result.nodes / seconds : 0,
+                PerNode(result.allocations, result.nodes),
+                PerNode(result.arena_bytes, result.nodes),
+                result.peak_rss_kb);
+  }
+  std::printf("\n  ]\n}\n");
+}
+
+}
+
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (void* memory = std::malloc(size ? size : 1))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) throw() {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) throw() {
+  std::free(memory);
+}
+
+int main(int argc, char** argv) {
+  bool json = false;
+  bool profile = false;
+  std::string corpus = "bench/corpus";
+  std::vector<std::string> scripts;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--json") == 0)
+      json = true;
+    else if (std::strcmp(argv[i], "--profile") == 0)
+      profile = true;
+    else if (std::strcmp(argv[i], "--corpus") == 0 && i + 1 < argc)
+      corpus = argv[++i];
+    else
+      scripts.push_back(argv[i]);
+  }
+
+  if (profile && !kunjs::GrammarProfile::enabled()) {
+    std::cerr << "--profile needs a build with KUNJS_PROFILE_GRAMMAR" << std::endl;
+    return 1;
+  }
+
+  std::string snippets_text, library;
+  if (!ReadFile(corpus + "/snippets.js", snippets_text) || !ReadFile(corpus + "/library.js", library)) {
+    std::cerr << "cannot read the corpus in " << corpus << " (see --corpus)" << std::endl;
+    return 1;
+  }
+
+  std::vector<Case> cases(4);
+  cases[0].name = "snippets";
+  Snippets(snippets_text, cases[0]);
+  cases[1].name = "library";
+  cases[1].sources.push_back(Library(library));
+  cases[2].name = "nested";
+  cases[2].sources.push_back(Nested());
+  cases[3].name = "arrays";
+  cases[3].sources.push_back(Arrays());
+  for (std::size_t i = 0; i < scripts.size(); ++i) {
+    Case script;
+    script.name = scripts[i];
+    script.sources.push_back(std::string());
+    if (!ReadFile(scripts[i], script.sources.back())) {
+      std::cerr << "cannot read " << scripts[i] << std::endl;
+      return 1;
+    }
+    cases.push_back(script);
+  }
+
+  kunjs::Parser parser;
+  std::vector<Result> results;
+  bool parsed = true;
+  for (std::size_t i = 0; i < cases.size(); ++i) {
+    results.push_back(Run(parser, cases[i]));
+    Print(results.back());
+    if (profile && results.back().parsed)
+      Profile(parser, cases[i]);
+    parsed = parsed && results.back().parsed;
+  }
+
+  if (json)
+    PrintJson(results);
+  return parsed ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+#include "kunjs/parser.h"
+#include "benchmark.h"
+
+#include <string>
+#include <vector>
+
+// Per-script parse latency for small scripts: building a fresh Parser (and
+// therefore a fresh grammar) for every script, as Parser::parse used to do
+// internally, against one long-lived Parser reused for every script.
+
+namespace {
+
+const char* SCRIPTS[] = {
+  "1 + 23 * (5 + n/2) % 4 - 8;",
+  "var n=10, i=20, s='some text';",
+  "var n = i == 10 ? 'yep' : 'no';",
+  "if (t == 'some text' && valid) { result -= 10; } else { result += 20; }",
+  "for(var i=0; i < 100; i++) { 100 - i; }",
+  "function veryUseful(arg1, arg2) { return arg1 * arg2; }",
+  "try { connection.open(); doAction(); } finally { connection.close(); }",
+  "switch (theDay) { case 5: write('Friday'); break; default: write('?'); }"
+};
+
+const int ITERATIONS = 200;
+
+}
+
+int main() {
+  std::vector<std::string> scripts(SCRIPTS, SCRIPTS + sizeof(SCRIPTS) / sizeof(SCRIPTS[0]));
+  int runs = ITERATIONS * static_cast<int>(scripts.size());
+  kunjs::bench::QuietStdout quiet;
+
+  kunjs::bench::Stopwatch fresh;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    for (std::vector<std::string>::const_iterator it = scripts.begin(); it != scripts.end(); ++it) {
+      kunjs::Parser parser;
+      parser.parse(*it);
+    }
+  }
+  kunjs::bench::Report("new Parser per script", runs, fresh.elapsed_us());
+
+  kunjs::Parser parser;
+  kunjs::bench::Stopwatch shared;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    for (std::vector<std::string>::const_iterator it = scripts.begin(); it != scripts.end(); ++it)
+      parser.parse(*it);
+  }
+  kunjs::bench::Report("shared Parser", runs, shared.elapsed_us());
+
+  kunjs::AtomTable atoms;
+  kunjs::bench::Stopwatch batch;
+  for (int i = 0; i < ITERATIONS; ++i)
+    parser.parse_many(scripts, atoms);
+  kunjs::bench::Report("shared Parser, parse_many", runs, batch.elapsed_us());
+
+  return 0;
+}
@@ -0,0 +1,49 @@
+#include "kunjs/lexer.h"
+#include "kunjs/parser.h"
+#include "benchmark.h"
+
+#include <string>
+
+// Throughput over a library-sized script: the lexer on its own, then the
+// whole parse (lexer plus grammar running over the tokens).
+
+namespace {
+
+const char* CHUNK =
+  "/* A block comment, as found in license headers and doc comments. */\n"
+  "function accumulate(list, initial) {\n"
+  "  var total = initial, i = 0;\n"
+  "  for (i = 0; i < list.length; i++) {\n"
+  "    if (list[i] >= 0 && list[i] !== null) { total += list[i] * 2; }\n"
+  "    else { total = total - 1; }\n"
+  "  }\n"
+  "  return total; // trailing comment\n"
+  "}\n"
+  "var message = 'accumulated: ' + accumulate(values, 0x10) / 3.5;\n";
+
+const std::size_t TARGET_SIZE = 2 * 1024 * 1024;
+const int ITERATIONS = 5;
+
+}
+
+int main() {
+  std::string code;
+  while (code.size() < TARGET_SIZE)
+    code += CHUNK;
+
+  kunjs::Lexer lexer;
+  kunjs::bench::Stopwatch lexing;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    kunjs::TokenStream tokens;
+    lexer.tokenize(code.data(), code.data() + code.size(), tokens);
+  }
+  kunjs::bench::ReportThroughput("tokenize", code.size(), lexing.elapsed_us() / ITERATIONS);
+
+  kunjs::Parser parser;
+  kunjs::bench::Stopwatch parsing;
+  for (int i = 0; i < ITERATIONS; ++i)
+    parser.parse(code);
+  kunjs::bench::ReportThroughput("parse", code.size(), parsing.elapsed_us() / ITERATIONS);
+
+  return 0;
+}
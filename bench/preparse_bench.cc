@@ -0,0 +1,72 @@
+#include "kunjs/parser.h"
+#include "benchmark.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// What pre-parsing saves. Parses a script (the file given as the first
+// argument, or a generated one made mostly of function bodies) in full and
+// in PREPARSE mode, reporting the throughput and the size of the AST arena
+// of each. Only the functions a script actually runs get parsed later, by
+// parse_body, which is not measured here.
+
+namespace {
+
+const char* CHUNK =
+  "function accumulate(list, initialValue) {\n"
+  "  var total = initialValue, index = 0;\n"
+  "  for (index = 0; index < list.length; index++) {\n"
+  "    if (list[index] >= 0 && list[index] !== null) { total += list[index] * 2; }\n"
+  "    else { total = total - 1; }\n"
+  "  }\n"
+  "  return total;\n"
+  "}\n"
+  "var message = 'accumulated: ' + accumulate(values, 0x10) / 3.5;\n";
+
+const int CHUNKS = 500;
+const int ITERATIONS = 20;
+
+double Parse(kunjs::Parser const& parser, std::string const& code,
+             kunjs::ParsedProgram& parsed, kunjs::Parser::Mode mode) {
+  kunjs::bench::Stopwatch parsing;
+  for (int i = 0; i < ITERATIONS; ++i)
+    parser.parse(code, parsed, mode);
+  return parsing.elapsed_us() / ITERATIONS;
+}
+
+}
+
+int main(int argc, char** argv) {
+  std::string code;
+  if (argc > 1) {
+    std::ifstream file(argv[1], std::ios::in | std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    code = contents.str();
+  } else {
+    for (int i = 0; i < CHUNKS; ++i)
+      code += CHUNK;
+  }
+
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  kunjs::ParseResult result = parser.parse(code, parsed);
+  if (!result) {
+    std::cerr << result << std::endl;
+    return 1;
+  }
+
+  double full = Parse(parser, code, parsed, kunjs::Parser::FULL);
+  std::size_t full_arena = parsed.arena().used();
+  double preparse = Parse(parser, code, parsed, kunjs::Parser::PREPARSE);
+  std::size_t preparse_arena = parsed.arena().used();
+
+  kunjs::bench::ReportThroughput("full parse", code.size(), full);
+  kunjs::bench::ReportThroughput("pre-parse", code.size(), preparse);
+  std::fprintf(stderr, "AST arena: %lu KB full, %lu KB pre-parsed\n",
+               static_cast<unsigned long>(full_arena / 1024),
+               static_cast<unsigned long>(preparse_arena / 1024));
+  return 0;
+}
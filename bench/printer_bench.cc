@@ -0,0 +1,80 @@
+#include "kunjs/parser.h"
+#include "kunjs/printer.h"
+#include "kunjs/source.h"
+#include "benchmark.h"
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+// Printing throughput: bench/corpus/library.js (or the script given as the
+// first argument) repeated to about LIBRARY_SIZE, parsed once and printed
+// over and over, as JavaScript into a string that is reused, as JavaScript
+// into a stream, and as a dump. Reported in MB of output per second.
+//
+//   run-printer-bench [script.js]
+
+namespace {
+
+const std::size_t LIBRARY_SIZE = 1024 * 1024;
+const int ITERATIONS = 20;
+
+// Drops what it is given, so that printing is measured rather than the disk.
+class NullBuffer : public std::streambuf {
+ protected:
+  int overflow(int c) { return c; }
+  std::streamsize xsputn(char const*, std::streamsize size) { return size; }
+};
+
+}
+
+int main(int argc, char** argv) {
+  kunjs::MappedFile file;
+  char const* path = argc > 1 ? argv[1] : "bench/corpus/library.js";
+  if (!file.open(path)) {
+    std::cerr << "cannot read " << path << std::endl;
+    return 1;
+  }
+  std::string code;
+  while (code.size() < LIBRARY_SIZE)
+    code += file.source().str();
+
+  kunjs::AtomTable atoms;
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed(atoms);
+  kunjs::ParseResult result = parser.parse(code, parsed);
+  if (!result) {
+    std::cerr << result << std::endl;
+    return 1;
+  }
+
+  kunjs::Printer javascript(atoms, kunjs::Printer::JAVASCRIPT);
+  kunjs::Printer dump(atoms, kunjs::Printer::DUMP);
+  std::string text;
+
+  kunjs::bench::Stopwatch to_string;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    text.clear();
+    kunjs::CodeBuffer out(text);
+    javascript.print(parsed.program(), out);
+  }
+  kunjs::bench::ReportThroughput("javascript into a string", text.size(), to_string.elapsed_us() / ITERATIONS);
+
+  NullBuffer sink;
+  std::ostream stream(&sink);
+  kunjs::bench::Stopwatch to_stream;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    kunjs::CodeBuffer out(stream);
+    javascript.print(parsed.program(), out);
+  }
+  kunjs::bench::ReportThroughput("javascript into a stream", text.size(), to_stream.elapsed_us() / ITERATIONS);
+
+  kunjs::bench::Stopwatch dumping;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    text.clear();
+    kunjs::CodeBuffer out(text);
+    dump.print(parsed.program(), out);
+  }
+  kunjs::bench::ReportThroughput("dump into a string", text.size(), dumping.elapsed_us() / ITERATIONS);
+  return 0;
+}
@@ -0,0 +1,75 @@
+#include "kunjs/lexer.h"
+#include "benchmark.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Tokenizing throughput on sources that are mostly whitespace and comments:
+// license headers, doc comments and deep indentation, as unminified library
+// code has them. Give a file as the first argument to tokenize it instead.
+
+namespace {
+
+const char* LICENSE =
+  "/*\n"
+  " * Licensed under the Apache License, Version 2.0 (the \"License\"); you may not\n"
+  " * use this file except in compliance with the License. You may obtain a copy of\n"
+  " * the License at http://www.apache.org/licenses/LICENSE-2.0\n"
+  " *\n"
+  " * Unless required by applicable law or agreed to in writing, software\n"
+  " * distributed under the License is distributed on an \"AS IS\" BASIS, WITHOUT\n"
+  " * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n"
+  " */\n";
+
+const char* CHUNK =
+  "        /**\n"
+  "         * Sums the non-negative entries of list, doubled, starting from\n"
+  "         * initialValue; every negative entry takes one off the total.\n"
+  "         */\n"
+  "        function accumulate(list, initialValue) {\n"
+  "            var total = initialValue,   // running sum\n"
+  "                index = 0;\n"
+  "\n"
+  "            for (index = 0; index < list.length; index++) {\n"
+  "                if (list[index] >= 0) {\n"
+  "                    total += list[index] * 2;  // doubled on purpose\n"
+  "                } else {\n"
+  "                    total = total - 1;\n"
+  "                }\n"
+  "            }\n"
+  "\n"
+  "            return total;\n"
+  "        }\n"
+  "\n";
+
+const int CHUNKS = 2000;
+const int ITERATIONS = 20;
+
+}
+
+int main(int argc, char** argv) {
+  std::string code;
+  if (argc > 1) {
+    std::ifstream file(argv[1], std::ios::in | std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    code = contents.str();
+  } else {
+    for (int i = 0; i < CHUNKS; ++i)
+      code += (i % 20 ? CHUNK : LICENSE);
+  }
+
+  kunjs::Lexer lexer;
+  kunjs::TokenStream tokens;
+  kunjs::bench::Stopwatch tokenizing;
+  for (int i = 0; i < ITERATIONS; ++i) {
+    tokens.clear();
+    if (lexer.tokenize(code.data(), code.data() + code.size(), tokens) != code.size()) {
+      std::cerr << "the source does not tokenize" << std::endl;
+      return 1;
+    }
+  }
+  kunjs::bench::ReportThroughput("tokenize", code.size(), tokenizing.elapsed_us() / ITERATIONS);
+  return 0;
+}
@@ -0,0 +1,116 @@
+#include "kunjs/arena.h"
+
+#include <cstdlib>
+#include <new>
+
+#if defined(_MSC_VER)
+#define KUNJS_THREAD_LOCAL __declspec(thread)
+#else
+#define KUNJS_THREAD_LOCAL __thread
+#endif
+
+namespace kunjs {
+
+namespace {
+
+const std::size_t ALIGNMENT = sizeof(double) > sizeof(void*) ? sizeof(double) : sizeof(void*);
+
+inline std::size_t Align(std::size_t size) {
+  return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+// Put in front of every acquired chunk, so release() can tell arena memory
+// from heap memory without being told where it came from.
+union Header {
+  Arena* arena;
+  char padding[ALIGNMENT];
+};
+
+KUNJS_THREAD_LOCAL Arena* current_arena = 0;
+
+}
+
+Arena::Arena(std::size_t block_size)
+    : block_size(block_size), block(0), top(0), limit(0),
+      used_bytes(0), reserved_bytes(0) {}
+
+Arena::~Arena() {
+  for (std::vector<Block>::iterator it = blocks.begin(); it != blocks.end(); ++it)
+    std::free(it->memory);
+}
+
+void* Arena::allocate(std::size_t size) {
+  size = Align(size);
+  used_bytes += size;
+
+  if (size <= std::size_t(limit - top)) {
+    char* memory = top;
+    top += size;
+    return memory;
+  }
+
+  // Blocks kept from before the last reset come first. The rest of a block
+  // that is too small for this chunk is left unused until the next reset.
+  for (std::size_t next = top ? block + 1 : 0; next < blocks.size(); ++next) {
+    if (blocks[next].size >= size) {
+      block = next;
+      top = blocks[next].memory + size;
+      limit = blocks[next].memory + blocks[next].size;
+      return blocks[next].memory;
+    }
+  }
+
+  Block fresh;
+  fresh.size = size > block_size ? size : block_size;
+  fresh.memory = static_cast<char*>(std::malloc(fresh.size));
+  if (!fresh.memory)
+    throw std::bad_alloc();
+
+  blocks.push_back(fresh);
+  reserved_bytes += fresh.size;
+  block = blocks.size() - 1;
+  top = fresh.memory + size;
+  limit = fresh.memory + fresh.size;
+  return fresh.memory;
+}
+
+void Arena::reset() {
+  block = 0;
+  top = 0;
+  limit = 0;
+  used_bytes = 0;
+}
+
+Arena::Scope::Scope(Arena& arena) : previous(current_arena) {
+  current_arena = &arena;
+}
+
+Arena::Scope::~Scope() {
+  current_arena = previous;
+}
+
+Arena* Arena::current() {
+  return current_arena;
+}
+
+void* Arena::acquire(std::size_t size) {
+  Header* header;
+  if (current_arena)
+    header = static_cast<Header*>(current_arena->allocate(sizeof(Header) + size));
+  else
+    header = static_cast<Header*>(::operator new(sizeof(Header) + size));
+
+  header->arena = current_arena;
+  return header + 1;
+}
+
+void Arena::release(void* pointer) {
+  if (!pointer)
+    return;
+
+  Header* header = static_cast<Header*>(pointer) - 1;
+  if (!header->arena)
+    ::operator delete(header);
+}
+
+} // namespace kunjs
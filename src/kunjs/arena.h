@@ -0,0 +1,120 @@
+#ifndef KUNJS_ARENA_H_
+#define KUNJS_ARENA_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <boost/config.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace kunjs {
+
+// Bump allocator. Memory is handed out from a few big blocks and is never
+// freed piecemeal: reset() takes all of it back at once and keeps the blocks
+// for the next round, so an arena that is reset and refilled with data of
+// about the same size stops asking the system for memory.
+class Arena : private boost::noncopyable {
+ public:
+  static const std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+  explicit Arena(std::size_t block_size = DEFAULT_BLOCK_SIZE);
+  ~Arena();
+
+  // Aligned for any AST node.
+  void* allocate(std::size_t size);
+
+  void reset();
+
+  // Bytes handed out since the last reset, and bytes held in blocks.
+  std::size_t used() const { return used_bytes; }
+  std::size_t reserved() const { return reserved_bytes; }
+
+  // Makes an arena the target of acquire() on the calling thread while alive.
+  class Scope : private boost::noncopyable {
+   public:
+    explicit Scope(Arena& arena);
+    ~Scope();
+
+   private:
+    Arena* previous;
+  };
+
+  // Arena of the innermost Scope on the calling thread, or 0.
+  static Arena* current();
+
+  // Allocates from the current arena, or from the heap when there is none.
+  // release() frees what came from the heap and leaves arena memory to its
+  // arena, so objects may be destroyed whether or not a Scope is active.
+  static void* acquire(std::size_t size);
+  static void release(void* pointer);
+
+ private:
+  struct Block {
+    char* memory;
+    std::size_t size;
+  };
+
+  std::size_t block_size;
+  std::vector<Block> blocks;
+  std::size_t block;
+  char* top;
+  char* limit;
+  std::size_t used_bytes;
+  std::size_t reserved_bytes;
+};
+
+// Standard allocator over Arena::acquire/release, for the containers and
+// strings of the AST. It is stateless: which arena a container allocates from
+// is decided by the Scope active when it grows.
+template <typename T>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef T const* const_pointer;
+  typedef T& reference;
+  typedef T const& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  template <typename U>
+  struct rebind { typedef ArenaAllocator<U> other; };
+
+  // Nothrow, so that the lists of the AST are too when they are empty: a
+  // boost::variant with an alternative like that falls back to it when
+  // assigning another one, instead of backing its content up on the heap.
+  ArenaAllocator() BOOST_NOEXCEPT {}
+  template <typename U>
+  ArenaAllocator(ArenaAllocator<U> const&) BOOST_NOEXCEPT {}
+
+  pointer address(reference value) const { return &value; }
+  const_pointer address(const_reference value) const { return &value; }
+
+  pointer allocate(size_type n, void const* = 0) {
+    return static_cast<pointer>(Arena::acquire(n * sizeof(T)));
+  }
+
+  void deallocate(pointer memory, size_type) {
+    Arena::release(memory);
+  }
+
+  size_type max_size() const { return size_type(-1) / sizeof(T); }
+
+  void construct(pointer memory, const_reference value) { new (memory) T(value); }
+  void destroy(pointer object) { object->~T(); }
+};
+
+template <typename T, typename U>
+inline bool operator==(ArenaAllocator<T> const&, ArenaAllocator<U> const&) { return true; }
+
+template <typename T, typename U>
+inline bool operator!=(ArenaAllocator<T> const&, ArenaAllocator<U> const&) { return false; }
+
+} // namespace kunjs
+
+#endif // KUNJS_ARENA_H_
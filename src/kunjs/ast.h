@@ -5,6 +5,10 @@
 #pragma once
 #endif
 
+#include "kunjs/arena.h"
+#include "kunjs/atom.h"
+
+#include <boost/cstdint.hpp>
 #include <boost/optional.hpp>
 #include <boost/spirit/home/support/attributes.hpp>
 #include <boost/variant/recursive_variant.hpp>
@@ -14,20 +18,137 @@
 
 namespace kunjs { namespace ast {
 
+// Every node and every list or string hanging from it is allocated through
+// Arena::acquire, so a program parsed inside an Arena::Scope lives entirely
+// in that arena (see ParsedProgram).
+template <typename T>
+struct List { typedef std::vector<T, ArenaAllocator<T> > type; };
+
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char> > String;
+
+// Identifiers, labels and property names are atoms of the engine's
+// AtomTable (the one the program was parsed with); only string literals are
+// stored as text.
+using kunjs::Atom;
+
+// Where a node starts in its source: the byte offset of its first token,
+// counted from the start of the whole source (also in bodies parsed later,
+// see Parser::parse_body). A LineTable of the source turns it into a line and
+// a column. Kept in the node itself, 32 bits each, so locating the nodes
+// costs the parser no allocation. Statements, functions, calls and operator
+// expressions are located; offset is NONE for the nodes the parser does not
+// locate (the blocks of try statements and of switch clauses) and for nodes
+// made by anything other than the parser.
+struct Located {
+  static const boost::uint32_t NONE = 0xffffffffu;
+
+  Located() : offset(NONE) {}
+
+  boost::uint32_t offset;
+};
+
+// Base of the nodes held through a recursive_wrapper, which allocates them
+// with new. Variants holding them by value construct them with placement new.
+struct Node : Located {
+  static void* operator new(std::size_t size) { return Arena::acquire(size); }
+  static void operator delete(void* pointer) { Arena::release(pointer); }
+
+  static void* operator new(std::size_t, void* place) { return place; }
+  static void operator delete(void*, void*) {}
+};
+
+// O(name, spelling) for every operator. Names are the ones of the tokens
+// spelled the same way (see KUNJS_TOKEN_LIST).
+#define KUNJS_OPERATOR_LIST(O)               \
+  /* binary */                               \
+  O(OR, "||")                                \
+  O(AND, "&&")                               \
+  O(BIT_OR, "|")                             \
+  O(BIT_XOR, "^")                            \
+  O(BIT_AND, "&")                            \
+  O(EQ, "==")                                \
+  O(NE, "!=")                                \
+  O(EQ_STRICT, "===")                        \
+  O(NE_STRICT, "!==")                        \
+  O(LT, "<")                                 \
+  O(GT, ">")                                 \
+  O(LTE, "<=")                               \
+  O(GTE, ">=")                               \
+  O(INSTANCEOF, "instanceof")                \
+  O(IN, "in")                                \
+  O(SHL, "<<")                               \
+  O(SAR, ">>")                               \
+  O(SHR, ">>>")                              \
+  O(ADD, "+")                                \
+  O(SUB, "-")                                \
+  O(MUL, "*")                                \
+  O(DIV, "/")                                \
+  O(MOD, "%")                                \
+  /* unary, besides ADD and SUB */           \
+  O(DELETE, "delete")                        \
+  O(VOID, "void")                            \
+  O(TYPEOF, "typeof")                        \
+  O(INC, "++")                               \
+  O(DEC, "--")                               \
+  O(BIT_NOT, "~")                            \
+  O(NOT, "!")                                \
+  /* assignment */                           \
+  O(ASSIGN, "=")                             \
+  O(ASSIGN_ADD, "+=")                        \
+  O(ASSIGN_SUB, "-=")                        \
+  O(ASSIGN_MUL, "*=")                        \
+  O(ASSIGN_DIV, "/=")                        \
+  O(ASSIGN_MOD, "%=")                        \
+  O(ASSIGN_SHL, "<<=")                       \
+  O(ASSIGN_SAR, ">>=")                       \
+  O(ASSIGN_SHR, ">>>=")                      \
+  O(ASSIGN_BIT_AND, "&=")                    \
+  O(ASSIGN_BIT_OR, "|=")                     \
+  O(ASSIGN_BIT_XOR, "^=")                    \
+  O(NEW, "new")
+
+namespace op {
+
+#define O(name, spelling) name,
+enum Operator {
+  KUNJS_OPERATOR_LIST(O)
+  OPERATOR_COUNT
+};
+#undef O
+
+inline char const* spelling(Operator op) {
+#define O(name, spelling) spelling,
+  static char const* const SPELLINGS[OPERATOR_COUNT] = {
+    KUNJS_OPERATOR_LIST(O)
+  };
+#undef O
+  return SPELLINGS[op];
+}
+
+} // namespace op
+
+typedef op::Operator Operator;
+
 struct Null {};
 
 typedef boost::variant<int, double> Numeric;
-typedef boost::variant<ast::Null, bool, Numeric, std::string> Literal;
+typedef boost::variant<ast::Null, bool, Numeric, String> Literal;
 
 struct This {};
 
 struct AssignmentExpression;
-typedef std::vector<AssignmentExpression> Expression;
-typedef std::vector<AssignmentExpression> ArrayLiteral;
+typedef List<AssignmentExpression>::type Expression;
 
-typedef boost::variant<This, std::string, Literal, Expression> PrimaryExpression;
+// A struct rather than a typedef, so that `[a, b]` can be told apart from a
+// parenthesized `(a, b)`. Visitors taking an Expression take both. Holes
+// (`[a, , b]`) are not kept.
+struct ArrayLiteral : List<AssignmentExpression>::type {};
 
-typedef std::vector<AssignmentExpression> Arguments;
+typedef boost::variant<This, Atom, Literal, Expression, ArrayLiteral> PrimaryExpression;
+
+// A struct rather than a typedef, so that call arguments can be told apart
+// from a `[expression]` in CallModifiers.
+struct Arguments : List<AssignmentExpression>::type {};
 
 struct FunctionExpression;
 
@@ -36,11 +157,11 @@ typedef boost::variant<
           boost::recursive_wrapper<FunctionExpression>
         > MemberOptions;
 
-typedef boost::variant<Expression, std::string> MemberModifier;
+typedef boost::variant<Expression, Atom> MemberModifier;
 
 struct MemberAccess {
   MemberOptions member;
-  std::vector<MemberModifier> modifiers;
+  List<MemberModifier>::type modifiers;
 };
 
 struct Instantiation;
@@ -49,131 +170,86 @@ typedef boost::variant<
           boost::recursive_wrapper<Instantiation>
         > MemberExpression;
 
-struct Instantiation {
+struct Instantiation : Node {
   MemberExpression member;
   Arguments arguments;
 };
 
-struct NewExpression {
-  std::vector<std::string> operators;
+struct NewExpression : Node {
+  List<Operator>::type operators;
   MemberExpression member;
 };
 
-typedef boost::variant<Arguments, Expression, std::string> CallModifiers;
-struct CallExpression {
+typedef boost::variant<Arguments, Expression, Atom> CallModifiers;
+struct CallExpression : Node {
   MemberExpression target;
   Arguments arguments;
-  std::vector<CallModifiers> modifiers;
+  List<CallModifiers>::type modifiers;
 };
 
 typedef boost::variant<CallExpression, NewExpression> LhsExpression;
 
-struct PostfixExpression {
-  LhsExpression lhs;
-  boost::optional<std::string> operator_;
-};
-
-struct UnaryExpression {
-  std::vector<std::string> operators;
-  PostfixExpression rhs;
-};
-
-struct MultiplicativeOperation {
-  std::string operator_;
-  UnaryExpression rhs;
-};
-struct MultiplicativeExpression {
-  UnaryExpression lhs;
-  std::vector<MultiplicativeOperation> operations;
-};
-
-struct AdditiveOperation {
-  std::string operator_;
-  MultiplicativeExpression rhs;
-};
-struct AdditiveExpression {
-  MultiplicativeExpression lhs;
-  std::vector<AdditiveOperation> operations;
-};
-
-struct ShiftOperation{
-  std::string operator_;
-  AdditiveExpression rhs;
-};
-struct ShiftExpression {
-  AdditiveExpression lhs;
-  std::vector<ShiftOperation> operations;
-};
-
-struct RelationalOperation {
-  std::string operator_;
-  ShiftExpression rhs;
-};
-struct RelationalExpression {
-  ShiftExpression lhs;
-  std::vector<RelationalOperation> operations;
-};
-
-struct EqualityOperation {
-  std::string operator_;
-  RelationalExpression rhs;
-};
-struct EqualityExpression {
-  RelationalExpression lhs;
-  std::vector<EqualityOperation> operations;
-};
-
-struct BitwiseAndExpression {
-  EqualityExpression lhs;
-  std::vector<EqualityExpression> operations;
-};
-
-struct BitwiseXorExpression {
-  BitwiseAndExpression lhs;
-  std::vector<BitwiseAndExpression> operations;
-};
+// Expressions are flat: names and literals are stored as they are, and each
+// operator gets a single node holding its operands, whatever its precedence.
+struct UnaryExpression;
+struct PostfixExpression;
+struct BinaryExpression;
+struct ConditionalExpression;
+struct Assignment;
 
-struct BitwiseOrExpression {
-  BitwiseXorExpression lhs;
-  std::vector<BitwiseXorExpression> operations;
-};
+typedef boost::variant<
+          This,
+          Atom,
+          Literal,
+          Expression, // parenthesized
+          ArrayLiteral,
+          boost::recursive_wrapper<CallExpression>,
+          boost::recursive_wrapper<NewExpression>,
+          boost::recursive_wrapper<UnaryExpression>,
+          boost::recursive_wrapper<PostfixExpression>,
+          boost::recursive_wrapper<BinaryExpression>,
+          boost::recursive_wrapper<ConditionalExpression>,
+          boost::recursive_wrapper<Assignment>
+        > ExpressionNode;
 
-struct LogicalAndExpression {
-  BitwiseOrExpression lhs;
-  std::vector<BitwiseOrExpression> operations;
-};
+// A struct rather than a typedef, so that Expression can be declared before
+// it is complete.
+struct AssignmentExpression : ExpressionNode {};
 
-struct LogicalOrExpression {
-  LogicalAndExpression lhs;
-  std::vector<LogicalAndExpression> operations;
+struct UnaryExpression : Node {
+  Operator operator_;
+  AssignmentExpression operand;
 };
 
-struct ConditionalClauses {
-  boost::recursive_wrapper<AssignmentExpression> true_clause;
-  boost::recursive_wrapper<AssignmentExpression> false_clause;
+struct PostfixExpression : Node {
+  Operator operator_;
+  AssignmentExpression operand;
 };
 
-struct ConditionalExpression {
-  LogicalOrExpression lhs;
-  boost::optional<ConditionalClauses> conditional_clauses;
+struct BinaryExpression : Node {
+  Operator operator_;
+  AssignmentExpression lhs;
+  AssignmentExpression rhs;
 };
 
-struct AssignmentOperation {
-  LhsExpression lhs;
-  std::string operator_;
+struct ConditionalExpression : Node {
+  AssignmentExpression condition;
+  AssignmentExpression true_clause;
+  AssignmentExpression false_clause;
 };
 
-struct AssignmentExpression {
-  std::vector<AssignmentOperation> assignments;
-  ConditionalExpression rhs;
+struct Assignment : Node {
+  Operator operator_;
+  AssignmentExpression target;
+  AssignmentExpression value;
 };
 
 struct VarDeclaration {
-  std::string name;
+  Atom name;
   boost::optional<AssignmentExpression> assignment;
 };
 
-typedef std::vector<VarDeclaration> Var;
+typedef List<VarDeclaration>::type Var;
 
 struct Noop {};
 
@@ -186,15 +262,15 @@ struct ForWithVar;
 struct Foreach;
 struct ForeachWithVar;
 
-struct Continue {
-  boost::optional<std::string> label;
+struct Continue : Located {
+  boost::optional<Atom> label;
 };
 
-struct Break {
-  boost::optional<std::string> label;
+struct Break : Located {
+  boost::optional<Atom> label;
 };
 
-struct Return {
+struct Return : Located {
   boost::optional<Expression> expression;
 };
 
@@ -205,7 +281,7 @@ struct Switch;
 
 struct LabelledStatement;
 
-struct Throw {
+struct Throw : Located {
   Throw() {}
   explicit Throw(Expression expression)
       : expression(expression) {}
@@ -214,7 +290,9 @@ struct Throw {
 
 struct Try;
 
-typedef boost::make_recursive_variant<
+struct Block;
+
+typedef boost::variant<
           Expression,
           Var,
           Noop,
@@ -233,34 +311,38 @@ typedef boost::make_recursive_variant<
           boost::recursive_wrapper<Switch>,
           Throw,
           boost::recursive_wrapper<Try>,
-          std::string,
-          std::vector<boost::recursive_variant_>
-        >::type Statement;
+          String,
+          boost::recursive_wrapper<Block>
+        > Statement;
+
+// A braced block. A struct deriving from the list, so that it can be declared
+// before Statement is complete and be allocated like the other nodes.
+struct Block : List<Statement>::type, Node {};
 
-struct If {
+struct If : Node {
   Expression condition;
   Statement true_clause;
   boost::optional<Statement> false_clause;
 };
 
-struct DoWhile {
+struct DoWhile : Node {
   Statement statement;
   Expression condition;
 };
 
-struct While {
+struct While : Node {
   Expression condition;
   Statement statement;
 };
 
-struct For {
+struct For : Node {
   boost::optional<Expression> initialization;
   boost::optional<Expression> condition;
   boost::optional<Expression> action;
   Statement statement;
 };
 
-struct ForWithVar {
+struct ForWithVar : Node {
   Var initialization;
   boost::optional<Expression> condition;
   boost::optional<Expression> action;
@@ -268,99 +350,117 @@ struct ForWithVar {
 };
 
 
-struct Foreach {
+struct Foreach : Node {
   LhsExpression item;
   Expression list;
   Statement statement;
 };
 
-struct ForeachWithVar {
+struct ForeachWithVar : Node {
   VarDeclaration item;
   Expression list;
   Statement statement;
 };
 
-struct With {
+struct With : Node {
   Expression context;
   Statement statement;
 };
 
-struct LabelledStatement {
-  std::string label;
+struct LabelledStatement : Node {
+  Atom label;
   Statement statement;
 };
 
 struct Case {
   Expression match_clause;
-  std::vector<Statement> statements;
+  Block statements;
 };
 
-typedef std::vector<Statement> Default;
+typedef Block Default;
 
-struct Switch {
+struct Switch : Node {
   Expression condition;
-  std::vector<Case> clauses;
+  List<Case>::type clauses;
   boost::optional<Default> default_clause;
-  std::vector<Case> other_clauses;
+  List<Case>::type other_clauses;
 };
 
-typedef std::vector<Statement> Finally;
+typedef Block Finally;
 
 struct Catch {
-  std::string exception_name;
-  std::vector<Statement> statements;
+  Atom exception_name;
+  Block statements;
 };
 
-struct Try {
-  std::vector<Statement> statements;
+struct Try : Node {
+  Block statements;
   boost::optional<Catch> catch_block;
   boost::optional<Finally> finally_block;
 };
 
 struct FunctionDeclaration;
 
+// Statement comes first, so that a default SourceElement is an empty
+// statement the parser can fill in place.
 typedef boost::variant<
-          boost::recursive_wrapper<FunctionDeclaration>,
-          Statement
+          Statement,
+          boost::recursive_wrapper<FunctionDeclaration>
         > SourceElement;
 
-typedef std::vector<SourceElement> FunctionBody;
+// Where something lies in the source, in bytes.
+struct Span {
+  Span() : offset(0), length(0) {}
+  boost::uint32_t offset;
+  boost::uint32_t length;
+};
+
+// The elements of a function. A body the parser only skipped over (see
+// Parser::PREPARSE) is lazy: it has no elements yet, and source is the text
+// between its braces, for Parser::parse_body to parse when the function is
+// first needed.
+struct FunctionBody : List<SourceElement>::type {
+  FunctionBody() : lazy(false) {}
+
+  bool lazy;
+  Span source;
+};
 
-struct FunctionDeclaration {
-  std::string name;
-  std::vector<std::string> parameters;
+struct FunctionDeclaration : Node {
+  Atom name;
+  List<Atom>::type parameters;
   FunctionBody body;
 };
 
-struct FunctionExpression {
-  boost::optional<std::string> name;
-  std::vector<std::string> parameters;
+struct FunctionExpression : Node {
+  boost::optional<Atom> name;
+  List<Atom>::type parameters;
   FunctionBody body;
 };
 
-typedef std::vector<SourceElement> Program;
+typedef List<SourceElement>::type Program;
 
 } // namespace ast
 } // namespace kunjs
 
 BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::FunctionDeclaration,
-    (std::string, name)
-    (std::vector<std::string>, parameters)
+    (kunjs::Atom, name)
+    (kunjs::ast::List<kunjs::Atom>::type, parameters)
     (kunjs::ast::FunctionBody, body)
 )
 
 BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::FunctionExpression,
-    (boost::optional<std::string>, name)
-    (std::vector<std::string>, parameters)
+    (boost::optional<kunjs::Atom>, name)
+    (kunjs::ast::List<kunjs::Atom>::type, parameters)
     (kunjs::ast::FunctionBody, body)
 )
 
 BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::MemberAccess,
     (kunjs::ast::MemberOptions, member)
-    (std::vector<kunjs::ast::MemberModifier>, modifiers)
+    (kunjs::ast::List<kunjs::ast::MemberModifier>::type, modifiers)
 )
 
 BOOST_FUSION_ADAPT_STRUCT(
@@ -371,7 +471,7 @@ BOOST_FUSION_ADAPT_STRUCT(
 
 BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::NewExpression,
-    (std::vector<std::string>, operators)
+    (kunjs::ast::List<kunjs::ast::Operator>::type, operators)
     (kunjs::ast::MemberExpression, member)
 )
 
@@ -379,144 +479,18 @@ BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::CallExpression,
     (kunjs::ast::MemberExpression, target)
     (kunjs::ast::Arguments, arguments)
-    (std::vector<kunjs::ast::CallModifiers>, modifiers)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::PostfixExpression,
-    (kunjs::ast::LhsExpression, lhs)
-    (boost::optional<std::string>, operator_)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::UnaryExpression,
-    (std::vector<std::string>, operators)
-    (kunjs::ast::PostfixExpression, rhs)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::MultiplicativeExpression,
-    (kunjs::ast::UnaryExpression, lhs)
-    (std::vector<kunjs::ast::MultiplicativeOperation>, operations)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::MultiplicativeOperation,
-    (std::string, operator_)
-    (kunjs::ast::UnaryExpression, rhs)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::AdditiveExpression,
-    (kunjs::ast::MultiplicativeExpression, lhs)
-    (std::vector<kunjs::ast::AdditiveOperation>, operations)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::AdditiveOperation,
-    (std::string, operator_)
-    (kunjs::ast::MultiplicativeExpression, rhs)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::ShiftExpression,
-    (kunjs::ast::AdditiveExpression, lhs)
-    (std::vector<kunjs::ast::ShiftOperation>, operations)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::ShiftOperation,
-    (std::string, operator_)
-    (kunjs::ast::AdditiveExpression, rhs)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::RelationalExpression,
-    (kunjs::ast::ShiftExpression, lhs)
-    (std::vector<kunjs::ast::RelationalOperation>, operations)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::RelationalOperation,
-    (std::string, operator_)
-    (kunjs::ast::ShiftExpression, rhs)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::EqualityExpression,
-    (kunjs::ast::RelationalExpression, lhs)
-    (std::vector<kunjs::ast::EqualityOperation>, operations)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::EqualityOperation,
-    (std::string, operator_)
-    (kunjs::ast::RelationalExpression, rhs)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::BitwiseAndExpression,
-    (kunjs::ast::EqualityExpression, lhs)
-    (std::vector<kunjs::ast::EqualityExpression>, operations)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::BitwiseXorExpression,
-    (kunjs::ast::BitwiseAndExpression, lhs)
-    (std::vector<kunjs::ast::BitwiseAndExpression>, operations)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::BitwiseOrExpression,
-    (kunjs::ast::BitwiseXorExpression, lhs)
-    (std::vector<kunjs::ast::BitwiseXorExpression>, operations)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::LogicalAndExpression,
-    (kunjs::ast::BitwiseOrExpression, lhs)
-    (std::vector<kunjs::ast::BitwiseOrExpression>, operations)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::LogicalOrExpression,
-    (kunjs::ast::LogicalAndExpression, lhs)
-    (std::vector<kunjs::ast::LogicalAndExpression>, operations)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::ConditionalClauses,
-    (boost::recursive_wrapper<kunjs::ast::AssignmentExpression>, true_clause)
-    (boost::recursive_wrapper<kunjs::ast::AssignmentExpression>, false_clause)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::ConditionalExpression,
-    (kunjs::ast::LogicalOrExpression, lhs)
-    (boost::optional<kunjs::ast::ConditionalClauses>, conditional_clauses)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::AssignmentOperation,
-    (kunjs::ast::LhsExpression, lhs)
-    (std::string, operator_)
-)
-
-BOOST_FUSION_ADAPT_STRUCT(
-    kunjs::ast::AssignmentExpression,
-    (std::vector<kunjs::ast::AssignmentOperation>, assignments)
-    (kunjs::ast::ConditionalExpression, rhs)
+    (kunjs::ast::List<kunjs::ast::CallModifiers>::type, modifiers)
 )
 
 BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::Catch,
-    (std::string, exception_name)
-    (std::vector<kunjs::ast::Statement>, statements)
+    (kunjs::Atom, exception_name)
+    (kunjs::ast::Block, statements)
 )
 
 BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::Try,
-    (std::vector<kunjs::ast::Statement>, statements)
+    (kunjs::ast::Block, statements)
     (boost::optional<kunjs::ast::Catch>, catch_block)
     (boost::optional<kunjs::ast::Finally>, finally_block)
 )
@@ -535,20 +509,20 @@ BOOST_FUSION_ADAPT_STRUCT(
 BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::Case,
     (kunjs::ast::Expression, match_clause)
-    (std::vector<kunjs::ast::Statement>, statements)
+    (kunjs::ast::Block, statements)
 )
 
 BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::Switch,
     (kunjs::ast::Expression, condition)
-    (std::vector<kunjs::ast::Case>, clauses)
+    (kunjs::ast::List<kunjs::ast::Case>::type, clauses)
     (boost::optional<kunjs::ast::Default>, default_clause)
-    (std::vector<kunjs::ast::Case>, other_clauses)
+    (kunjs::ast::List<kunjs::ast::Case>::type, other_clauses)
 )
 
 BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::LabelledStatement,
-    (std::string, label)
+    (kunjs::Atom, label)
     (kunjs::ast::Statement, statement)
 )
 
@@ -559,12 +533,12 @@ BOOST_FUSION_ADAPT_STRUCT(
 
 BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::Break,
-    (boost::optional<std::string>, label)
+    (boost::optional<kunjs::Atom>, label)
 )
 
 BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::Continue,
-    (boost::optional<std::string>, label)
+    (boost::optional<kunjs::Atom>, label)
 )
 
 BOOST_FUSION_ADAPT_STRUCT(
@@ -618,7 +592,7 @@ BOOST_FUSION_ADAPT_STRUCT(
 
 BOOST_FUSION_ADAPT_STRUCT(
     kunjs::ast::VarDeclaration,
-    (std::string, name)
+    (kunjs::Atom, name)
     (boost::optional<kunjs::ast::AssignmentExpression>, assignment)
 )
 
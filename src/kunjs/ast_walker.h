@@ -0,0 +1,570 @@
+#ifndef KUNJS_AST_WALKER_H_
+#define KUNJS_AST_WALKER_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "kunjs/ast.h"
+
+#include <boost/variant/apply_visitor.hpp>
+#include <boost/variant/static_visitor.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace kunjs { namespace ast {
+
+namespace walk {
+
+// What an Expression, a Block, an Atom or a String is depends on where it
+// is. The walker hands these to the hooks instead, made from the node they
+// stand for.
+
+// An Expression as a statement: `a = 1, b = 2;`.
+struct ExpressionStatement {
+  ExpressionStatement(Expression const& expression) : expression(expression) {}
+  Expression const& expression;
+};
+
+// An Expression held by another expression, between parentheses.
+struct Parenthesized {
+  Parenthesized(Expression const& expression) : expression(expression) {}
+  Expression const& expression;
+};
+
+// An Expression as a modifier of a member or of a call: `[expression]`.
+struct Subscript {
+  Subscript(Expression const& expression) : expression(expression) {}
+  Expression const& expression;
+};
+
+// An Atom as a modifier of a member or of a call: `.name`.
+struct Property {
+  Property(Atom const& name) : name(name) {}
+  Atom name;
+};
+
+// The statements of a switch's default clause.
+struct Default {
+  Default(Block const& statements) : statements(statements) {}
+  Block const& statements;
+};
+
+// The statements of a try's finally block.
+struct Finally {
+  Finally(Block const& statements) : statements(statements) {}
+  Block const& statements;
+};
+
+// A debugger statement, which the parser keeps as a String.
+struct Debugger {
+  Debugger(String const& text) : text(text) {}
+  String const& text;
+};
+
+// N(KIND, Hook, Stored) for every kind of node the walker visits: the type
+// its hooks take, and the type of the AST node it is made from. The comment
+// after each one lists its slots (see Walker), "?" marking a slot that may
+// have no child and "..." any number of them.
+#define KUNJS_WALK_LIST(N)                                                                     \
+  N(PROGRAM, Program, Program)                         /* elements... */                       \
+  N(FUNCTION_DECLARATION, FunctionDeclaration, FunctionDeclaration) /* FUNCTION_BODY */        \
+  N(FUNCTION_EXPRESSION, FunctionExpression, FunctionExpression)    /* FUNCTION_BODY */        \
+  N(FUNCTION_BODY, FunctionBody, FunctionBody)         /* elements..., none if lazy */         \
+  /* statements */                                                                             \
+  N(EXPRESSION_STATEMENT, walk::ExpressionStatement, Expression) /* expressions... */          \
+  N(VAR, Var, Var)                                     /* VAR_DECLARATION... */                \
+  N(VAR_DECLARATION, VarDeclaration, VarDeclaration)   /* initializer? */                      \
+  N(EMPTY, Noop, Noop)                                                                         \
+  N(BLOCK, Block, Block)                               /* statements... */                     \
+  N(IF, If, If)                                        /* SEQUENCE, statement, else? */        \
+  N(DO_WHILE, DoWhile, DoWhile)                        /* statement, SEQUENCE */               \
+  N(WHILE, While, While)                               /* SEQUENCE, statement */               \
+  N(FOR, For, For)                                     /* SEQUENCE?, SEQUENCE?, SEQUENCE?,     \
+                                                          statement */                         \
+  N(FOR_WITH_VAR, ForWithVar, ForWithVar)              /* VAR, SEQUENCE?, SEQUENCE?,           \
+                                                          statement */                         \
+  N(FOREACH, Foreach, Foreach)                         /* CALL or NEW, SEQUENCE, statement */  \
+  N(FOREACH_WITH_VAR, ForeachWithVar, ForeachWithVar)  /* VAR_DECLARATION, SEQUENCE,           \
+                                                          statement */                         \
+  N(CONTINUE, Continue, Continue)                                                              \
+  N(BREAK, Break, Break)                                                                       \
+  N(RETURN, Return, Return)                            /* SEQUENCE? */                         \
+  N(WITH, With, With)                                  /* SEQUENCE, statement */               \
+  N(LABELLED, LabelledStatement, LabelledStatement)    /* statement */                         \
+  N(SWITCH, Switch, Switch)                            /* SEQUENCE, CASE..., DEFAULT?,         \
+                                                          CASE... */                           \
+  N(CASE, Case, Case)                                  /* SEQUENCE, statements... */           \
+  N(DEFAULT, walk::Default, Block)                     /* statements... */                     \
+  N(THROW, Throw, Throw)                               /* SEQUENCE */                          \
+  N(TRY, Try, Try)                                     /* BLOCK, CATCH?, FINALLY? */           \
+  N(CATCH, Catch, Catch)                               /* statements... */                     \
+  N(FINALLY, walk::Finally, Block)                     /* statements... */                     \
+  N(DEBUGGER, walk::Debugger, String)                                                          \
+  /* expressions */                                                                            \
+  N(SEQUENCE, Expression, Expression)                  /* expressions... */                    \
+  N(NAME, Atom, Atom)                                                                          \
+  N(THIS, This, This)                                                                          \
+  N(LITERAL, Literal, Literal)                                                                 \
+  N(PARENTHESIZED, walk::Parenthesized, Expression)    /* expressions... */                    \
+  N(ARRAY, ArrayLiteral, ArrayLiteral)                 /* expressions... */                    \
+  N(UNARY, UnaryExpression, UnaryExpression)           /* operand */                           \
+  N(POSTFIX, PostfixExpression, PostfixExpression)     /* operand */                           \
+  N(BINARY, BinaryExpression, BinaryExpression)        /* lhs, rhs */                          \
+  N(CONDITIONAL, ConditionalExpression, ConditionalExpression) /* condition, true clause,      \
+                                                                  false clause */              \
+  N(ASSIGNMENT, Assignment, Assignment)                /* target, value */                     \
+  N(CALL, CallExpression, CallExpression)              /* member, ARGUMENTS, modifiers... */   \
+  N(NEW, NewExpression, NewExpression)                 /* member */                            \
+  N(MEMBER_ACCESS, MemberAccess, MemberAccess)         /* member, modifiers... */              \
+  N(INSTANTIATION, Instantiation, Instantiation)       /* member, ARGUMENTS */                 \
+  N(ARGUMENTS, Arguments, Arguments)                   /* expressions... */                    \
+  N(SUBSCRIPT, walk::Subscript, Expression)            /* expressions... */                    \
+  N(PROPERTY, walk::Property, Atom)
+
+enum Kind {
+#define N(kind, hook, stored) kind,
+  KUNJS_WALK_LIST(N)
+#undef N
+  KIND_COUNT
+};
+
+// The kind whose hooks take Hook, and the type of the nodes it is made from.
+template <typename Hook>
+struct KindOf;
+
+#define N(kind, hook, stored)            \
+  template <>                            \
+  struct KindOf<hook> {                  \
+    static const Kind value = kind;      \
+    typedef stored Stored;               \
+  };
+KUNJS_WALK_LIST(N)
+#undef N
+
+} // namespace walk
+
+// Walks a tree depth first, calling the hooks of Derived on every node:
+//
+//   bool enter(node)            before its children; false skips them, and
+//                               leave(node) too
+//   void at(node, slot)         before the child in each slot, in order,
+//                               whether node has a child in that slot or not
+//   void leave(node)            after its children
+//
+// Nodes are the AST nodes, or the walk:: types above where the meaning of an
+// AST type depends on where it is; KUNJS_WALK_LIST tells which types a hook
+// may take and which slots each kind has. Derived overloads the hooks for the
+// kinds it is interested in, and the defaults below do nothing for the
+// others:
+//
+//   class Counter : public ast::Walker<Counter> {
+//    public:
+//     using ast::Walker<Counter>::enter;
+//     bool enter(ast::BinaryExpression const&) { ++binaries; return true; }
+//     std::size_t binaries;
+//   };
+//
+// The hooks are chosen at compile time. The walk recurses only for the first
+// RECURSION_DEPTH levels, where that is fastest; the nodes below are kept on
+// a stack of frames of their own, so that a tree thousands of levels deep
+// takes no more native stack than a shallow one. Hooks may walk other trees,
+// or other parts of the same tree, in turn.
+template <typename Derived>
+class Walker {
+ public:
+  // levels of the tree walked by recursion
+  static const std::size_t RECURSION_DEPTH = 128;
+
+  void walk(Program const& program) {
+    std::size_t base = frames.size();
+    Push<Program>(program);
+    Run(base);
+  }
+
+  void walk(Statement const& statement) {
+    std::size_t base = frames.size();
+    boost::apply_visitor(StatementPusher(*this), statement);
+    Run(base);
+  }
+
+  void walk(AssignmentExpression const& expression) {
+    std::size_t base = frames.size();
+    boost::apply_visitor(ExpressionPusher(*this), expression);
+    Run(base);
+  }
+
+  template <typename Node>
+  bool enter(Node const&) { return true; }
+
+  template <typename Node>
+  void at(Node const&, std::size_t) {}
+
+  template <typename Node>
+  void leave(Node const&) {}
+
+ protected:
+  Walker() : depth(0) {}
+  ~Walker() {}
+
+ private:
+  // A node being visited, and the slot whose child comes next.
+  struct Frame {
+    walk::Kind kind;
+    void const* node;
+    std::size_t slot;
+    std::size_t slots;
+  };
+
+  Derived& derived() { return static_cast<Derived&>(*this); }
+
+  // Enters node as a Hook and, unless the hook said to skip it, walks its
+  // children right away if it is shallow enough, or stacks it otherwise. The
+  // first node stacked runs the frames until it is left; the ones stacked
+  // while they run are left to that loop.
+  template <typename Hook>
+  void Push(typename walk::KindOf<Hook>::Stored const& node) {
+    Hook const& hook = node;
+    if (!derived().enter(hook))
+      return;
+    std::size_t slots = Slots(hook);
+    if (depth < RECURSION_DEPTH || !slots) {
+      ++depth;
+      for (std::size_t slot = 0; slot < slots; ++slot) {
+        derived().at(hook, slot);
+        Child(hook, slot);
+      }
+      --depth;
+      derived().leave(hook);
+      return;
+    }
+    Frame frame = { walk::KindOf<Hook>::value, &node, 0, slots };
+    frames.push_back(frame);
+    if (depth == RECURSION_DEPTH) {
+      ++depth;
+      Run(frames.size() - 1);
+      --depth;
+    }
+  }
+
+  void Run(std::size_t base) {
+    while (frames.size() > base) {
+      Frame& top = frames.back();
+      if (top.slot < top.slots) {
+        Step(top.kind, top.node, top.slot++);
+      } else {
+        walk::Kind kind = top.kind;
+        void const* node = top.node;
+        frames.pop_back();
+        Leave(kind, node);
+      }
+    }
+  }
+
+  // Calls at() for a slot and stacks its child.
+  void Step(walk::Kind kind, void const* node, std::size_t slot) {
+    switch (kind) {
+#define N(kind, hook, stored)                                   \
+      case walk::kind: {                                        \
+        hook const& current = *static_cast<stored const*>(node); \
+        derived().at(current, slot);                            \
+        Child(current, slot);                                   \
+        break;                                                  \
+      }
+      KUNJS_WALK_LIST(N)
+#undef N
+      default:
+        assert(!"unknown kind of node");
+    }
+  }
+
+  void Leave(walk::Kind kind, void const* node) {
+    switch (kind) {
+#define N(kind, hook, stored)                                     \
+      case walk::kind:                                            \
+        derived().leave(static_cast<hook const&>(*static_cast<stored const*>(node))); \
+        break;
+      KUNJS_WALK_LIST(N)
+#undef N
+      default:
+        assert(!"unknown kind of node");
+    }
+  }
+
+  // Stack the nodes held by the variants, by what they stand for there.
+
+  struct StatementPusher : boost::static_visitor<> {
+    explicit StatementPusher(Walker& walker) : walker(walker) {}
+
+    void operator()(Statement const& statement) const { boost::apply_visitor(*this, statement); }
+    void operator()(Expression const& expression) const { walker.Push<walk::ExpressionStatement>(expression); }
+    void operator()(String const& text) const { walker.Push<walk::Debugger>(text); }
+
+    template <typename Node>
+    void operator()(Node const& node) const { walker.Push<Node>(node); }
+
+    Walker& walker;
+  };
+
+  struct ExpressionPusher : boost::static_visitor<> {
+    explicit ExpressionPusher(Walker& walker) : walker(walker) {}
+
+    void operator()(PrimaryExpression const& expression) const { boost::apply_visitor(*this, expression); }
+    void operator()(MemberOptions const& expression) const { boost::apply_visitor(*this, expression); }
+    void operator()(MemberExpression const& expression) const { boost::apply_visitor(*this, expression); }
+    void operator()(LhsExpression const& expression) const { boost::apply_visitor(*this, expression); }
+    void operator()(Expression const& expression) const { walker.Push<walk::Parenthesized>(expression); }
+
+    template <typename Node>
+    void operator()(Node const& node) const { walker.Push<Node>(node); }
+
+    Walker& walker;
+  };
+
+  struct ModifierPusher : boost::static_visitor<> {
+    explicit ModifierPusher(Walker& walker) : walker(walker) {}
+
+    void operator()(Arguments const& arguments) const { walker.Push<Arguments>(arguments); }
+    void operator()(Expression const& expression) const { walker.Push<walk::Subscript>(expression); }
+    void operator()(Atom const& name) const { walker.Push<walk::Property>(name); }
+
+    Walker& walker;
+  };
+
+  template <typename Node>
+  void PushElement(Node const& node) { boost::apply_visitor(StatementPusher(*this), node); }
+
+  template <typename Node>
+  void PushExpression(Node const& node) { boost::apply_visitor(ExpressionPusher(*this), node); }
+
+  template <typename Node>
+  void PushModifier(Node const& node) { boost::apply_visitor(ModifierPusher(*this), node); }
+
+  void PushOptional(boost::optional<ast::Expression> const& expression) {
+    if (expression) Push<ast::Expression>(expression.get());
+  }
+
+  // The slots of every kind, and the child in each.
+
+  static std::size_t Slots(Program const& program) { return program.size(); }
+  void Child(Program const& program, std::size_t slot) { PushElement(program[slot]); }
+
+  static std::size_t Slots(FunctionDeclaration const&) { return 1; }
+  void Child(FunctionDeclaration const& function, std::size_t) { Push<FunctionBody>(function.body); }
+
+  static std::size_t Slots(FunctionExpression const&) { return 1; }
+  void Child(FunctionExpression const& function, std::size_t) { Push<FunctionBody>(function.body); }
+
+  static std::size_t Slots(FunctionBody const& body) { return body.lazy ? 0 : body.size(); }
+  void Child(FunctionBody const& body, std::size_t slot) { PushElement(body[slot]); }
+
+  static std::size_t Slots(walk::ExpressionStatement const& node) { return node.expression.size(); }
+  void Child(walk::ExpressionStatement const& node, std::size_t slot) { PushExpression(node.expression[slot]); }
+
+  static std::size_t Slots(Var const& var) { return var.size(); }
+  void Child(Var const& var, std::size_t slot) { Push<VarDeclaration>(var[slot]); }
+
+  static std::size_t Slots(VarDeclaration const&) { return 1; }
+  void Child(VarDeclaration const& declaration, std::size_t) {
+    if (declaration.assignment) PushExpression(declaration.assignment.get());
+  }
+
+  static std::size_t Slots(Noop const&) { return 0; }
+
+  static std::size_t Slots(Block const& block) { return block.size(); }
+  void Child(Block const& block, std::size_t slot) { PushElement(block[slot]); }
+
+  static std::size_t Slots(If const&) { return 3; }
+  void Child(If const& node, std::size_t slot) {
+    switch (slot) {
+      case 0: Push<ast::Expression>(node.condition); break;
+      case 1: PushElement(node.true_clause); break;
+      default: if (node.false_clause) PushElement(node.false_clause.get());
+    }
+  }
+
+  static std::size_t Slots(DoWhile const&) { return 2; }
+  void Child(DoWhile const& loop, std::size_t slot) {
+    if (slot == 0) PushElement(loop.statement);
+    else Push<ast::Expression>(loop.condition);
+  }
+
+  static std::size_t Slots(While const&) { return 2; }
+  void Child(While const& loop, std::size_t slot) {
+    if (slot == 0) Push<ast::Expression>(loop.condition);
+    else PushElement(loop.statement);
+  }
+
+  static std::size_t Slots(For const&) { return 4; }
+  void Child(For const& loop, std::size_t slot) {
+    switch (slot) {
+      case 0: PushOptional(loop.initialization); break;
+      case 1: PushOptional(loop.condition); break;
+      case 2: PushOptional(loop.action); break;
+      default: PushElement(loop.statement);
+    }
+  }
+
+  static std::size_t Slots(ForWithVar const&) { return 4; }
+  void Child(ForWithVar const& loop, std::size_t slot) {
+    switch (slot) {
+      case 0: Push<Var>(loop.initialization); break;
+      case 1: PushOptional(loop.condition); break;
+      case 2: PushOptional(loop.action); break;
+      default: PushElement(loop.statement);
+    }
+  }
+
+  static std::size_t Slots(Foreach const&) { return 3; }
+  void Child(Foreach const& loop, std::size_t slot) {
+    switch (slot) {
+      case 0: PushExpression(loop.item); break;
+      case 1: Push<ast::Expression>(loop.list); break;
+      default: PushElement(loop.statement);
+    }
+  }
+
+  static std::size_t Slots(ForeachWithVar const&) { return 3; }
+  void Child(ForeachWithVar const& loop, std::size_t slot) {
+    switch (slot) {
+      case 0: Push<VarDeclaration>(loop.item); break;
+      case 1: Push<ast::Expression>(loop.list); break;
+      default: PushElement(loop.statement);
+    }
+  }
+
+  static std::size_t Slots(Continue const&) { return 0; }
+  static std::size_t Slots(Break const&) { return 0; }
+
+  static std::size_t Slots(Return const&) { return 1; }
+  void Child(Return const& node, std::size_t) { PushOptional(node.expression); }
+
+  static std::size_t Slots(With const&) { return 2; }
+  void Child(With const& with, std::size_t slot) {
+    if (slot == 0) Push<ast::Expression>(with.context);
+    else PushElement(with.statement);
+  }
+
+  static std::size_t Slots(LabelledStatement const&) { return 1; }
+  void Child(LabelledStatement const& labelled, std::size_t) { PushElement(labelled.statement); }
+
+  // The default slot is there whether or not the switch has a default clause.
+  static std::size_t Slots(Switch const& node) {
+    return 2 + node.clauses.size() + node.other_clauses.size();
+  }
+  void Child(Switch const& node, std::size_t slot) {
+    if (slot == 0) {
+      Push<ast::Expression>(node.condition);
+    } else if (slot <= node.clauses.size()) {
+      Push<Case>(node.clauses[slot - 1]);
+    } else if (slot == node.clauses.size() + 1) {
+      if (node.default_clause) Push<walk::Default>(node.default_clause.get());
+    } else {
+      Push<Case>(node.other_clauses[slot - node.clauses.size() - 2]);
+    }
+  }
+
+  static std::size_t Slots(Case const& clause) { return 1 + clause.statements.size(); }
+  void Child(Case const& clause, std::size_t slot) {
+    if (slot == 0) Push<ast::Expression>(clause.match_clause);
+    else PushElement(clause.statements[slot - 1]);
+  }
+
+  static std::size_t Slots(walk::Default const& node) { return node.statements.size(); }
+  void Child(walk::Default const& node, std::size_t slot) { PushElement(node.statements[slot]); }
+
+  static std::size_t Slots(Throw const&) { return 1; }
+  void Child(Throw const& node, std::size_t) { Push<ast::Expression>(node.expression); }
+
+  static std::size_t Slots(Try const&) { return 3; }
+  void Child(Try const& node, std::size_t slot) {
+    switch (slot) {
+      case 0: Push<Block>(node.statements); break;
+      case 1: if (node.catch_block) Push<Catch>(node.catch_block.get()); break;
+      default: if (node.finally_block) Push<walk::Finally>(node.finally_block.get());
+    }
+  }
+
+  static std::size_t Slots(Catch const& node) { return node.statements.size(); }
+  void Child(Catch const& node, std::size_t slot) { PushElement(node.statements[slot]); }
+
+  static std::size_t Slots(walk::Finally const& node) { return node.statements.size(); }
+  void Child(walk::Finally const& node, std::size_t slot) { PushElement(node.statements[slot]); }
+
+  static std::size_t Slots(walk::Debugger const&) { return 0; }
+
+  static std::size_t Slots(ast::Expression const& expression) { return expression.size(); }
+  void Child(ast::Expression const& expression, std::size_t slot) { PushExpression(expression[slot]); }
+
+  static std::size_t Slots(Atom) { return 0; }
+  static std::size_t Slots(This const&) { return 0; }
+  static std::size_t Slots(Literal const&) { return 0; }
+
+  static std::size_t Slots(walk::Parenthesized const& node) { return node.expression.size(); }
+  void Child(walk::Parenthesized const& node, std::size_t slot) { PushExpression(node.expression[slot]); }
+
+  static std::size_t Slots(ArrayLiteral const& array) { return array.size(); }
+  void Child(ArrayLiteral const& array, std::size_t slot) { PushExpression(array[slot]); }
+
+  static std::size_t Slots(UnaryExpression const&) { return 1; }
+  void Child(UnaryExpression const& node, std::size_t) { PushExpression(node.operand); }
+
+  static std::size_t Slots(PostfixExpression const&) { return 1; }
+  void Child(PostfixExpression const& node, std::size_t) { PushExpression(node.operand); }
+
+  static std::size_t Slots(BinaryExpression const&) { return 2; }
+  void Child(BinaryExpression const& node, std::size_t slot) { PushExpression(slot == 0 ? node.lhs : node.rhs); }
+
+  static std::size_t Slots(ConditionalExpression const&) { return 3; }
+  void Child(ConditionalExpression const& node, std::size_t slot) {
+    PushExpression(slot == 0 ? node.condition : slot == 1 ? node.true_clause : node.false_clause);
+  }
+
+  static std::size_t Slots(Assignment const&) { return 2; }
+  void Child(Assignment const& node, std::size_t slot) { PushExpression(slot == 0 ? node.target : node.value); }
+
+  static std::size_t Slots(CallExpression const& call) { return 2 + call.modifiers.size(); }
+  void Child(CallExpression const& call, std::size_t slot) {
+    if (slot == 0) PushExpression(call.target);
+    else if (slot == 1) Push<Arguments>(call.arguments);
+    else PushModifier(call.modifiers[slot - 2]);
+  }
+
+  static std::size_t Slots(NewExpression const&) { return 1; }
+  void Child(NewExpression const& node, std::size_t) { PushExpression(node.member); }
+
+  static std::size_t Slots(MemberAccess const& access) { return 1 + access.modifiers.size(); }
+  void Child(MemberAccess const& access, std::size_t slot) {
+    if (slot == 0) PushExpression(access.member);
+    else PushModifier(access.modifiers[slot - 1]);
+  }
+
+  static std::size_t Slots(Instantiation const&) { return 2; }
+  void Child(Instantiation const& node, std::size_t slot) {
+    if (slot == 0) PushExpression(node.member);
+    else Push<Arguments>(node.arguments);
+  }
+
+  static std::size_t Slots(Arguments const& arguments) { return arguments.size(); }
+  void Child(Arguments const& arguments, std::size_t slot) { PushExpression(arguments[slot]); }
+
+  static std::size_t Slots(walk::Subscript const& node) { return node.expression.size(); }
+  void Child(walk::Subscript const& node, std::size_t slot) { PushExpression(node.expression[slot]); }
+
+  static std::size_t Slots(walk::Property const&) { return 0; }
+
+  // Leaves, which have no slots.
+  template <typename Node>
+  void Child(Node const&, std::size_t) { assert(!"a leaf has no children"); }
+
+  std::vector<Frame> frames;
+  // levels being walked by recursion, one more while the frames run
+  std::size_t depth;
+};
+
+} // namespace ast
+} // namespace kunjs
+
+#endif // KUNJS_AST_WALKER_H_
@@ -0,0 +1,57 @@
+#include "kunjs/atom.h"
+
+#include <boost/functional/hash.hpp>
+
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace kunjs {
+
+namespace {
+
+// A name still in the source, looked up without copying it into a string
+// first. Hashes like boost::hash<std::string>, so it finds the table's keys.
+struct Span {
+  char const* first;
+  char const* last;
+};
+
+struct SpanHash {
+  std::size_t operator()(Span const& span) const {
+    return boost::hash_range(span.first, span.last);
+  }
+};
+
+struct SpanEqual {
+  bool operator()(Span const& span, std::string const& name) const {
+    std::size_t length = span.last - span.first;
+    return name.size() == length && std::memcmp(name.data(), span.first, length) == 0;
+  }
+};
+
+}
+
+std::ostream& operator<<(std::ostream& out, Atom atom) {
+  return out << "#" << atom.id;
+}
+
+Atom AtomTable::intern(char const* first, char const* last) {
+  Span span = {first, last};
+  Ids::const_iterator found = ids.find(span, SpanHash(), SpanEqual());
+  if (found != ids.end())
+    return found->second;
+
+  Atom atom(boost::uint32_t(names.size()));
+  Ids::iterator inserted = ids.insert(std::make_pair(std::string(first, last), atom)).first;
+  names.push_back(&inserted->first);
+  return atom;
+}
+
+Atom AtomTable::find(char const* first, char const* last) const {
+  Span span = {first, last};
+  Ids::const_iterator found = ids.find(span, SpanHash(), SpanEqual());
+  return found == ids.end() ? Atom() : found->second;
+}
+
+} // namespace kunjs
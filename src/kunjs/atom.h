@@ -0,0 +1,64 @@
+#ifndef KUNJS_ATOM_H_
+#define KUNJS_ATOM_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace kunjs {
+
+// An interned name: identifiers, labels and property names. Atoms from the
+// same table are equal exactly when their names are, so passes after the
+// parser compare (and hash) names as integers and never look at the text.
+struct Atom {
+  static const boost::uint32_t NONE = 0xffffffffu;
+
+  Atom() : id(NONE) {}
+  explicit Atom(boost::uint32_t id) : id(id) {}
+
+  bool operator==(Atom other) const { return id == other.id; }
+  bool operator!=(Atom other) const { return id != other.id; }
+  bool operator<(Atom other) const { return id < other.id; }
+
+  boost::uint32_t id;
+};
+
+// Prints the id; the name is only known to the table.
+std::ostream& operator<<(std::ostream& out, Atom atom);
+
+// The names of one engine, each stored once. Atoms are numbered from 0 in
+// the order their names were first seen, and the table only grows, so atoms
+// stay valid (and a name's string stays at the same address) for as long as
+// the table lives. Not synchronized: every thread parsing at the same time
+// needs its own table.
+class AtomTable : private boost::noncopyable {
+ public:
+  Atom intern(char const* first, char const* last);
+  Atom intern(std::string const& name) { return intern(name.data(), name.data() + name.size()); }
+
+  // Atom of name, or Atom() when it was never interned.
+  Atom find(char const* first, char const* last) const;
+
+  std::string const& name(Atom atom) const { return *names[atom.id]; }
+
+  std::size_t size() const { return names.size(); }
+
+ private:
+  typedef boost::unordered_map<std::string, Atom> Ids;
+
+  Ids ids;
+  std::vector<std::string const*> names;
+};
+
+} // namespace kunjs
+
+#endif // KUNJS_ATOM_H_
@@ -1,24 +1,111 @@
 #include "kunjs/compiler.h"
-#include "kunjs/compiler/program_compiler.h"
 #include "kunjs/parser.h"
 
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/once.hpp>
+
+#include <llvm/ExecutionEngine/JIT.h>
 #include <llvm/LLVMContext.h>
-#include <llvm/Constants.h>
+#include <llvm/System/Threading.h>
+#include <llvm/Target/TargetSelect.h>
 
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace kunjs {
 
-llvm::Value* Compiler::compile(std::string code) {
-  ast::Program ast;
-  Parser parser;
-  compiler::ProgramCompiler compile(llvm::getGlobalContext());
+namespace {
+
+boost::once_flag llvm_ready = BOOST_ONCE_INIT;
 
-  parser.parse(code, ast);
-  llvm::Value* result = compile(ast);
-  result->dump();
-  return result;
+// Held while a JIT is made or deleted: EngineBuilder::create() loads the
+// symbols of the process into a list of LLVM's that no lock of its own
+// guards, and the list of every JIT is made by the first one.
+boost::mutex jits;
+
+// LLVM 2.8 turns its SSE instructions off where CPUID tells of AVX, which it
+// can select only some of (returning 0.0 alone fails): on x86-64, the JIT
+// keeps to SSE2, which all of them have.
+std::vector<std::string> Features() {
+  std::vector<std::string> features;
+#if defined(__x86_64__) || defined(_M_X64)
+  features.push_back("+sse2");
+  features.push_back("-avx");
+#endif
+  return features;
 }
 
-} // namespace kunjs
+// The locks that make the global state of LLVM safe to share between
+// engines, and the target.
+void Start() {
+  llvm::llvm_start_multithreaded();
+  llvm::InitializeNativeTarget();
+}
+
+}
+
+Compiler::StartLLVM::StartLLVM() {
+  boost::call_once(llvm_ready, Start);
+}
+
+Compiler::Compiler(compiler::Optimizer::Level level)
+    : programs(new llvm::Module("kunjs", context_of_programs)), engine(0) {
+  std::string error;
+  {
+    boost::mutex::scoped_lock making(jits);
+    engine = llvm::EngineBuilder(programs)
+        .setEngineKind(llvm::EngineKind::JIT)
+        .setOptLevel(compiler::Optimizer::code_generation(level))
+        .setMAttrs(Features())
+        .setErrorStr(&error)
+        .create();
+  }
+  if (!engine) {
+    delete programs;
+    throw std::runtime_error("cannot make a JIT: " + error);
+  }
+  optimizer.reset(new compiler::Optimizer(*programs, *engine->getTargetData(), level));
+}
+
+Compiler::~Compiler() {
+  // the passes refer to the module the engine deletes
+  optimizer.reset();
+  boost::mutex::scoped_lock deleting(jits);
+  delete engine;
+}
 
+llvm::Function* Compiler::compile(Source code, ParseResult& result,
+                                  compiler::ProgramCompiler::Coverage coverage) {
+  ParsedProgram parsed(atoms);
+  result = parser.parse(code, parsed);
+  if (!result)
+    return 0;
+
+  compiler::ProgramCompiler compile(*programs, coverage);
+  llvm::Function* program = compile(parsed.program());
+  if (!program)
+    return 0;
+  optimizer->run(*program);
+  return program;
+}
+
+llvm::Function* Compiler::compile(Source code) {
+  ParseResult result;
+  return compile(code, result);
+}
+
+llvm::GenericValue Compiler::run(llvm::Function* program) {
+  return engine->runFunction(program, std::vector<llvm::GenericValue>());
+}
+
+void* Compiler::native(llvm::Function* program) {
+  return engine->getPointerToFunction(program);
+}
+
+void Compiler::release(llvm::Function* program) {
+  engine->freeMachineCodeForFunction(program);
+  program->eraseFromParent();
+}
+
+} // namespace kunjs
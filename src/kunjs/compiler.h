@@ -5,17 +5,74 @@
 #pragma once
 #endif
 
-#include <llvm/Value.h>
-#include <string>
+#include "kunjs/atom.h"
+#include "kunjs/compiler/optimizer.h"
+#include "kunjs/compiler/program_compiler.h"
+#include "kunjs/parser.h"
+#include "kunjs/source.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/ExecutionEngine/GenericValue.h>
+#include <llvm/Function.h>
+#include <llvm/LLVMContext.h>
+#include <llvm/Module.h>
 
 namespace kunjs {
 
-class Compiler {
+// An engine: compiles programs into functions of a module of its own (see
+// compiler::ProgramCompiler for what they return), and runs them with a JIT
+// over that module. Types, constants and code all live in the LLVMContext of
+// the engine, which frees them when it is destroyed. Engines share nothing
+// but a lock held while their JIT is made or deleted, so each can compile and
+// run on a thread of its own; one engine is for one thread at a time.
+//
+// The level of optimization (see compiler::Optimizer) is the engine's: O0 for
+// scripts run once, O2 for code that runs long.
+class Compiler : private boost::noncopyable {
  public:
-  llvm::Value* compile(std::string code);
+  // Throws std::runtime_error when no JIT can be made for this machine.
+  explicit Compiler(compiler::Optimizer::Level level = compiler::Optimizer::O1);
+  ~Compiler();
+
+  // The function code compiles to, or 0 when it does not parse, as result
+  // tells. With compiler::ProgramCompiler::WHOLE, also 0 for code that parses
+  // but cannot be compiled in full yet.
+  llvm::Function* compile(Source code, ParseResult& result,
+                          compiler::ProgramCompiler::Coverage coverage =
+                              compiler::ProgramCompiler::PARTIAL);
+  llvm::Function* compile(Source code);
+
+  // Runs a function compiled by compile(), making its machine code first.
+  llvm::GenericValue run(llvm::Function* program);
+
+  // The machine code of a function compiled by compile(), made if run() has
+  // not made it yet.
+  void* native(llvm::Function* program);
+
+  // Frees the machine code and the IR of a function compiled by compile().
+  void release(llvm::Function* program);
+
+  llvm::LLVMContext& context() { return context_of_programs; }
+  llvm::Module& module() { return *programs; }
+
+ private:
+  // Names of every program compiled by this engine.
+  AtomTable atoms;
+  Parser parser;
+  // Readies LLVM for engines on many threads, once per process, before the
+  // first context is made.
+  struct StartLLVM { StartLLVM(); } start;
+  // outlives programs and engine
+  llvm::LLVMContext context_of_programs;
+  // module of the functions compiled, owned by engine
+  llvm::Module* programs;
+  llvm::ExecutionEngine* engine;
+  boost::scoped_ptr<compiler::Optimizer> optimizer;
 };
 
 } // namespace kunjs
 
 #endif // KUNJS_COMPILER_H_
-
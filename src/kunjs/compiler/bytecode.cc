@@ -0,0 +1,49 @@
+#include "kunjs/compiler/bytecode.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace kunjs { namespace compiler {
+
+namespace {
+
+std::string NumberToString(double value) {
+  if (value != value)
+    return "NaN";
+  if (value - value != 0)
+    return value > 0 ? "Infinity" : "-Infinity";
+  if (value == 0)
+    return "0";  // -0 too
+
+  char text[32];
+  for (int precision = 15; precision <= 17; ++precision) {
+    std::sprintf(text, "%.*g", precision, value);
+    if (std::strtod(text, 0) == value)
+      break;
+  }
+  return text;
+}
+
+}
+
+std::string to_string(Value const& value) {
+  switch (value.type) {
+    case Value::BOOLEAN:
+      return value.boolean ? "true" : "false";
+    case Value::INTEGER: {
+      std::ostringstream text;
+      text << value.integer;
+      return text.str();
+    }
+    case Value::DOUBLE:
+      return NumberToString(value.number);
+    case Value::STRING:
+      return value.string;
+    default:
+      return "null";
+  }
+}
+
+} // namespace compiler
+} // namespace kunjs
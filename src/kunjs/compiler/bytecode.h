@@ -0,0 +1,153 @@
+#ifndef KUNJS_COMPILER_BYTECODE_H_
+#define KUNJS_COMPILER_BYTECODE_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace kunjs { namespace compiler {
+
+// A value of a program run by the Interpreter. Numbers are JavaScript's
+// doubles, kept as integers while they are ones an i32 holds: a result past
+// 32 bits, with a fraction or of -0 is a double, and so is one of a double.
+struct Value {
+  enum Type { NULL_VALUE, BOOLEAN, INTEGER, DOUBLE, STRING };
+
+  Value() : type(NULL_VALUE) { integer = 0; }
+  explicit Value(bool boolean) : type(BOOLEAN) { this->boolean = boolean; }
+  explicit Value(boost::int32_t integer) : type(INTEGER) { this->integer = integer; }
+  explicit Value(double number) : type(DOUBLE) { this->number = number; }
+  explicit Value(char const* string) : type(STRING) { this->string = string; }
+
+  Type type;
+  union {
+    bool boolean;
+    boost::int32_t integer;
+    double number;
+    // NUL-terminated; owned by the Code or the Interpreter it comes from
+    char const* string;
+  };
+};
+
+// value as JavaScript turns it into a string: the shortest digits that give
+// a number back, without a fraction for integers.
+std::string to_string(Value const& value);
+
+namespace bytecode {
+
+// B(name) for every instruction, with what it does to the registers r. Its
+// operands a, b and c are registers but where told otherwise; jumps go to
+// the instruction target(), counted from the first.
+#define KUNJS_BYTECODE_LIST(B)                                              \
+  B(LOAD_CONSTANT)  /* r[a] = constants[b] */                               \
+  B(LOAD_NULL)      /* r[a] = null */                                       \
+  B(MOVE)           /* r[a] = r[b] */                                       \
+  B(ADD)            /* r[a] = r[b] + r[c], and so on */                     \
+  B(SUB)                                                                    \
+  B(MUL)                                                                    \
+  B(DIV)                                                                    \
+  B(MOD)                                                                    \
+  B(SHL)                                                                    \
+  B(SAR)                                                                    \
+  B(SHR)                                                                    \
+  B(BIT_AND)                                                                \
+  B(BIT_OR)                                                                 \
+  B(BIT_XOR)                                                                \
+  B(EQ)                                                                     \
+  B(NE)                                                                     \
+  B(EQ_STRICT)                                                              \
+  B(NE_STRICT)                                                              \
+  B(LT)                                                                     \
+  B(GT)                                                                     \
+  B(LTE)                                                                    \
+  B(GTE)                                                                    \
+  B(NEGATE)         /* r[a] = -r[b] */                                      \
+  B(TO_NUMBER)      /* r[a] = +r[b] */                                      \
+  B(NOT)            /* r[a] = !r[b] */                                      \
+  B(BIT_NOT)        /* r[a] = ~r[b] */                                      \
+  B(TYPEOF)         /* r[a] = typeof r[b] */                                \
+  B(INCREMENT)      /* r[a] = r[b] + 1 */                                   \
+  B(DECREMENT)      /* r[a] = r[b] - 1 */                                   \
+  B(JUMP)           /* to target() */                                       \
+  B(JUMP_IF_TRUE)   /* to target() if r[a] is true */                       \
+  B(JUMP_IF_FALSE)  /* to target() unless r[a] is true */                   \
+  B(LOOP)           /* back to target(), the start of a loop */             \
+  B(RETURN)         /* ends the program with r[a] */
+
+enum Opcode {
+#define B(name) name,
+  KUNJS_BYTECODE_LIST(B)
+#undef B
+  OPCODE_COUNT
+};
+
+inline char const* name(Opcode opcode) {
+#define B(name) #name,
+  static char const* const NAMES[OPCODE_COUNT] = {
+    KUNJS_BYTECODE_LIST(B)
+  };
+#undef B
+  return NAMES[opcode];
+}
+
+} // namespace bytecode
+
+// Registers, constants and the halves of a jump's target.
+typedef boost::uint16_t Operand;
+
+const std::size_t MAX_OPERAND = 0xffff;
+
+// Eight bytes: an opcode and three operands. A jump keeps its target in b
+// (low half) and c (high half).
+struct Instruction {
+  boost::uint16_t opcode;
+  Operand a;
+  Operand b;
+  Operand c;
+
+  std::size_t target() const { return b | static_cast<std::size_t>(c) << 16; }
+  void target(std::size_t instruction) {
+    b = static_cast<Operand>(instruction);
+    c = static_cast<Operand>(instruction >> 16);
+  }
+};
+
+// A program compiled by BytecodeCompiler, run from its first instruction.
+// Register RESULT holds the value of the last expression statement run, the
+// ones after it the variables of the program (see Scope), and the rest the
+// values being computed; all are null to start with.
+struct Code : private boost::noncopyable {
+  static const Operand RESULT = 0;
+  static const Operand FIRST_VARIABLE = 1;
+
+  Code() : registers(0) {}
+
+  // The string constants stay where they are, so the values pointing into
+  // them stay valid.
+  void swap(Code& other) {
+    instructions.swap(other.instructions);
+    constants.swap(other.constants);
+    strings.swap(other.strings);
+    std::swap(registers, other.registers);
+  }
+
+  std::vector<Instruction> instructions;
+  std::vector<Value> constants;
+  // the text of the string constants, which point into it
+  std::deque<std::string> strings;
+  std::size_t registers;
+};
+
+} // namespace compiler
+} // namespace kunjs
+
+#endif // KUNJS_COMPILER_BYTECODE_H_
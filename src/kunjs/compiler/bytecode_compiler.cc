@@ -0,0 +1,488 @@
+#include "kunjs/compiler/bytecode_compiler.h"
+#include "kunjs/compiler/scope.h"
+#include "kunjs/ast_walker.h"
+
+#include <boost/optional.hpp>
+#include <boost/variant/apply_visitor.hpp>
+#include <boost/variant/get.hpp>
+#include <boost/variant/static_visitor.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace kunjs { namespace compiler {
+
+namespace {
+
+// The opcode of a binary operator, and of the one a compound assignment
+// applies. False for the ones without (logical operators are jumps).
+bool Arithmetic(ast::Operator operator_, bytecode::Opcode& opcode) {
+  switch (operator_) {
+    case ast::op::ADD: case ast::op::ASSIGN_ADD: opcode = bytecode::ADD; return true;
+    case ast::op::SUB: case ast::op::ASSIGN_SUB: opcode = bytecode::SUB; return true;
+    case ast::op::MUL: case ast::op::ASSIGN_MUL: opcode = bytecode::MUL; return true;
+    case ast::op::DIV: case ast::op::ASSIGN_DIV: opcode = bytecode::DIV; return true;
+    case ast::op::MOD: case ast::op::ASSIGN_MOD: opcode = bytecode::MOD; return true;
+    case ast::op::SHL: case ast::op::ASSIGN_SHL: opcode = bytecode::SHL; return true;
+    case ast::op::SAR: case ast::op::ASSIGN_SAR: opcode = bytecode::SAR; return true;
+    case ast::op::SHR: case ast::op::ASSIGN_SHR: opcode = bytecode::SHR; return true;
+    case ast::op::BIT_AND: case ast::op::ASSIGN_BIT_AND: opcode = bytecode::BIT_AND; return true;
+    case ast::op::BIT_OR: case ast::op::ASSIGN_BIT_OR: opcode = bytecode::BIT_OR; return true;
+    case ast::op::BIT_XOR: case ast::op::ASSIGN_BIT_XOR: opcode = bytecode::BIT_XOR; return true;
+    case ast::op::EQ: opcode = bytecode::EQ; return true;
+    case ast::op::NE: opcode = bytecode::NE; return true;
+    case ast::op::EQ_STRICT: opcode = bytecode::EQ_STRICT; return true;
+    case ast::op::NE_STRICT: opcode = bytecode::NE_STRICT; return true;
+    case ast::op::LT: opcode = bytecode::LT; return true;
+    case ast::op::GT: opcode = bytecode::GT; return true;
+    case ast::op::LTE: opcode = bytecode::LTE; return true;
+    case ast::op::GTE: opcode = bytecode::GTE; return true;
+    default:
+      // TODO: instanceof and in
+      return false;
+  }
+}
+
+class ConstantCompiler : public boost::static_visitor<Value> {
+ public:
+  explicit ConstantCompiler(Code& code) : code(code) {}
+
+  Value operator()(ast::Null const&) const { return Value(); }
+  Value operator()(bool literal) const { return Value(literal); }
+  Value operator()(ast::Numeric const& numeric) const { return boost::apply_visitor(*this, numeric); }
+  Value operator()(int literal) const { return Value(static_cast<boost::int32_t>(literal)); }
+  Value operator()(double literal) const { return Value(literal); }
+  Value operator()(ast::String const& literal) const {
+    code.strings.push_back(std::string(literal.begin(), literal.end()));
+    return Value(code.strings.back().c_str());
+  }
+
+ private:
+  Code& code;
+};
+
+class CodeCompiler : public ast::Walker<CodeCompiler> {
+ public:
+  using ast::Walker<CodeCompiler>::at;
+
+  CodeCompiler(Scope const& scope, Code& code)
+      : scope(scope), code(code), top(Code::FIRST_VARIABLE + scope.size()), fits(true) {
+    code.registers = top;
+    Check(top);
+  }
+
+  // False once an operand did not fit.
+  bool ok() const { return fits; }
+
+  void finish() { Emit(bytecode::RETURN, Code::RESULT); }
+
+  // Statements leave no value: what their expressions computed is dropped.
+  template <typename Node>
+  bool enter(Node const&) {
+    marks.push_back(top);
+    return true;
+  }
+
+  template <typename Node>
+  void leave(Node const&) { Drop(); }
+
+  // lists of expressions, each taking the register of the one before
+
+  void at(ast::walk::ExpressionStatement const&, std::size_t slot) { Discard(slot); }
+  void at(ast::Expression const&, std::size_t slot) { Discard(slot); }
+  void at(ast::walk::Parenthesized const&, std::size_t slot) { Discard(slot); }
+
+  void leave(ast::walk::ExpressionStatement const&) {
+    Emit(bytecode::MOVE, Code::RESULT, marks.back());
+    Drop();
+  }
+  void leave(ast::Expression const&) { Keep(); }
+  void leave(ast::walk::Parenthesized const&) { Keep(); }
+
+  bool enter(Atom name) {
+    std::size_t slot = scope.find(name);
+    if (slot == Scope::NONE)
+      return Null();
+    Emit(bytecode::MOVE, top, Variable(slot));
+    return Pushed();
+  }
+  bool enter(ast::This const&) { return Null(); }
+  bool enter(ast::Literal const& literal) {
+    code.constants.push_back(boost::apply_visitor(ConstantCompiler(code), literal));
+    Emit(bytecode::LOAD_CONSTANT, top, code.constants.size() - 1);
+    return Pushed();
+  }
+
+  bool enter(ast::UnaryExpression const& unary) {
+    if (unary.operator_ == ast::op::INC || unary.operator_ == ast::op::DEC) {
+      std::size_t slot = Assigned(unary.operand);
+      if (slot == Scope::NONE)
+        return Null();
+      Operand variable = Variable(slot);
+      Emit(unary.operator_ == ast::op::INC ? bytecode::INCREMENT : bytecode::DECREMENT,
+           variable, variable);
+      Emit(bytecode::MOVE, top, variable);
+      return Pushed();
+    }
+    marks.push_back(top);
+    return true;
+  }
+  void leave(ast::UnaryExpression const& unary) {
+    std::size_t value = marks.back();
+    switch (unary.operator_) {
+      case ast::op::SUB: Emit(bytecode::NEGATE, value, value); break;
+      case ast::op::ADD: Emit(bytecode::TO_NUMBER, value, value); break;
+      case ast::op::NOT: Emit(bytecode::NOT, value, value); break;
+      case ast::op::BIT_NOT: Emit(bytecode::BIT_NOT, value, value); break;
+      case ast::op::TYPEOF: Emit(bytecode::TYPEOF, value, value); break;
+      default:
+        // void, and delete until there are objects
+        Emit(bytecode::LOAD_NULL, value);
+    }
+    Keep();
+  }
+
+  // The value is the one before, as a number.
+  bool enter(ast::PostfixExpression const& postfix) {
+    std::size_t slot = Assigned(postfix.operand);
+    if (slot == Scope::NONE)
+      return Null();
+    Operand variable = Variable(slot);
+    Emit(bytecode::TO_NUMBER, top, variable);
+    Emit(postfix.operator_ == ast::op::INC ? bytecode::INCREMENT : bytecode::DECREMENT,
+         variable, top);
+    return Pushed();
+  }
+
+  // && and || jump over their right operand, which takes the register of the
+  // left one, when the left one decides.
+  void at(ast::BinaryExpression const& binary, std::size_t slot) {
+    if (slot && (binary.operator_ == ast::op::AND || binary.operator_ == ast::op::OR)) {
+      jumps.push_back(Jump(binary.operator_ == ast::op::AND ? bytecode::JUMP_IF_FALSE
+                                                            : bytecode::JUMP_IF_TRUE,
+                           marks.back()));
+      top = marks.back();
+    }
+  }
+  void leave(ast::BinaryExpression const& binary) {
+    std::size_t value = marks.back();
+    bytecode::Opcode opcode;
+    if (binary.operator_ == ast::op::AND || binary.operator_ == ast::op::OR) {
+      Land(jumps.back());
+      jumps.pop_back();
+    } else if (Arithmetic(binary.operator_, opcode)) {
+      Emit(opcode, value, value, value + 1);
+    } else {
+      Emit(bytecode::LOAD_NULL, value);
+    }
+    Keep();
+  }
+
+  void at(ast::ConditionalExpression const&, std::size_t slot) {
+    if (slot == 1) {
+      jumps.push_back(Jump(bytecode::JUMP_IF_FALSE, marks.back()));
+    } else if (slot == 2) {
+      std::size_t end = Jump(bytecode::JUMP);
+      Land(jumps.back());
+      jumps.back() = end;
+    }
+    top = marks.back();
+  }
+  void leave(ast::ConditionalExpression const&) {
+    Land(jumps.back());
+    jumps.pop_back();
+    Keep();
+  }
+
+  // The value is walked on its own, since the target is not a value to
+  // compute but the variable to store into.
+  bool enter(ast::Assignment const& assignment) {
+    std::size_t value = top;
+    std::size_t slot = Assigned(assignment.target);
+    if (slot == Scope::NONE) {
+      // TODO: members; the value is still computed for what it does
+      walk(assignment.value);
+      return false;
+    }
+
+    Operand variable = Variable(slot);
+    bytecode::Opcode opcode;
+    if (Arithmetic(assignment.operator_, opcode)) {
+      Emit(bytecode::MOVE, value, variable);
+      Pushed();
+      walk(assignment.value);
+      Emit(opcode, value, value, value + 1);
+      top = value + 1;
+    } else {
+      walk(assignment.value);
+    }
+    Emit(bytecode::MOVE, variable, value);
+    return false;
+  }
+
+  bool enter(ast::ArrayLiteral const&) { return Null(); }
+  bool enter(ast::CallExpression const&) { return Null(); }
+  bool enter(ast::NewExpression const&) { return Null(); }
+  bool enter(ast::MemberAccess const&) { return Null(); }
+  bool enter(ast::Instantiation const&) { return Null(); }
+  bool enter(ast::FunctionExpression const&) { return Null(); }
+
+  void leave(ast::VarDeclaration const& declaration) {
+    if (declaration.assignment)
+      Emit(bytecode::MOVE, Variable(scope.find(declaration.name)), marks.back());
+    Drop();
+  }
+
+  void at(ast::If const& statement, std::size_t slot) {
+    if (slot == 1) {
+      jumps.push_back(Jump(bytecode::JUMP_IF_FALSE, marks.back()));
+    } else if (slot == 2 && statement.false_clause) {
+      std::size_t end = Jump(bytecode::JUMP);
+      Land(jumps.back());
+      jumps.back() = end;
+    }
+    top = marks.back();
+  }
+  void leave(ast::If const&) {
+    Land(jumps.back());
+    jumps.pop_back();
+    Drop();
+  }
+
+  // Every loop goes through one LOOP an iteration, continue included.
+
+  bool enter(ast::While const&) { return Open(true); }
+  void at(ast::While const&, std::size_t slot) {
+    if (slot == 1)
+      targets.back().breaks.push_back(Jump(bytecode::JUMP_IF_FALSE, marks.back()));
+    top = marks.back();
+  }
+  void leave(ast::While const&) {
+    Land(targets.back().continues);
+    Emit(bytecode::LOOP, 0);
+    code.instructions.back().target(targets.back().start);
+    Close();
+  }
+
+  bool enter(ast::DoWhile const&) { return Open(true); }
+  void at(ast::DoWhile const&, std::size_t slot) {
+    if (slot == 1)
+      Land(targets.back().continues);
+    top = marks.back();
+  }
+  void leave(ast::DoWhile const&) {
+    targets.back().breaks.push_back(Jump(bytecode::JUMP_IF_FALSE, marks.back()));
+    Emit(bytecode::LOOP, 0);
+    code.instructions.back().target(targets.back().start);
+    Close();
+  }
+
+  // The action comes before the statement in the tree, and after it when
+  // run: it is compiled between the condition and the statement, and jumped
+  // over on the way in.
+  bool enter(ast::For const&) { return Open(true); }
+  void at(ast::For const& loop, std::size_t slot) { AtFor(loop.condition, slot); }
+  void leave(ast::For const&) { LeaveFor(); }
+
+  bool enter(ast::ForWithVar const&) { return Open(true); }
+  void at(ast::ForWithVar const& loop, std::size_t slot) { AtFor(loop.condition, slot); }
+  void leave(ast::ForWithVar const&) { LeaveFor(); }
+
+  bool enter(ast::LabelledStatement const& statement) { return Open(false, statement.label); }
+  void leave(ast::LabelledStatement const&) { Close(); }
+
+  bool enter(ast::Break const& statement) {
+    if (Target* target = Find(statement.label, false))
+      target->breaks.push_back(Jump(bytecode::JUMP));
+    return false;
+  }
+  bool enter(ast::Continue const& statement) {
+    if (Target* target = Find(statement.label, true))
+      target->continues.push_back(Jump(bytecode::JUMP));
+    return false;
+  }
+
+  // TODO: functions, for-in, switch, with, try and throw
+  bool enter(ast::FunctionDeclaration const&) { return false; }
+  bool enter(ast::Foreach const&) { return false; }
+  bool enter(ast::ForeachWithVar const&) { return false; }
+  bool enter(ast::Return const&) { return false; }
+  bool enter(ast::With const&) { return false; }
+  bool enter(ast::Switch const&) { return false; }
+  bool enter(ast::Throw const&) { return false; }
+  bool enter(ast::Try const&) { return false; }
+
+ private:
+  // A statement break and continue may leave: a loop or a labelled
+  // statement, and the jumps out of it to land once it is compiled.
+  struct Target {
+    bool loop;
+    Atom label;
+    // where a loop goes back to
+    std::size_t start;
+    // where the action of a for loop is
+    std::size_t action;
+    std::vector<std::size_t> breaks;
+    std::vector<std::size_t> continues;
+  };
+
+  std::size_t Here() const { return code.instructions.size(); }
+
+  void Emit(bytecode::Opcode opcode, std::size_t a, std::size_t b = 0, std::size_t c = 0) {
+    Check(a);
+    Check(b);
+    Check(c);
+    Instruction instruction = {
+      static_cast<boost::uint16_t>(opcode),
+      static_cast<Operand>(a), static_cast<Operand>(b), static_cast<Operand>(c)
+    };
+    code.instructions.push_back(instruction);
+  }
+
+  // A jump, whose target is set by Land.
+  std::size_t Jump(bytecode::Opcode opcode, std::size_t condition = 0) {
+    Emit(opcode, condition);
+    return Here() - 1;
+  }
+
+  void Land(std::size_t jump) { code.instructions[jump].target(Here()); }
+  void Land(std::vector<std::size_t> const& jumps) {
+    for (std::size_t i = 0; i < jumps.size(); ++i)
+      Land(jumps[i]);
+  }
+
+  void Check(std::size_t operand) {
+    if (operand > MAX_OPERAND)
+      fits = false;
+  }
+
+  Operand Variable(std::size_t slot) {
+    Check(Code::FIRST_VARIABLE + slot);
+    return static_cast<Operand>(Code::FIRST_VARIABLE + slot);
+  }
+
+  // The slot of the variable target names, if it is one.
+  std::size_t Assigned(ast::AssignmentExpression const& target) const {
+    Atom const* name = boost::get<Atom>(&target);
+    return name ? scope.find(*name) : Scope::NONE;
+  }
+
+  // Ends a node entered in full: its value is in the register it was entered
+  // at.
+  bool Pushed() {
+    ++top;
+    code.registers = std::max(code.registers, top);
+    return false;
+  }
+
+  bool Null() {
+    Emit(bytecode::LOAD_NULL, top);
+    return Pushed();
+  }
+
+  // Before each expression of a list but the first: the one before is
+  // dropped, and the next one takes its register.
+  void Discard(std::size_t slot) {
+    if (slot)
+      top = marks.back();
+  }
+
+  void Keep() {
+    top = marks.back();
+    marks.pop_back();
+    Pushed();
+  }
+
+  void Drop() {
+    top = marks.back();
+    marks.pop_back();
+  }
+
+  bool Open(bool loop, Atom label = Atom()) {
+    marks.push_back(top);
+    Target target;
+    target.loop = loop;
+    target.label = label;
+    target.start = target.action = Here();
+    // a loop right inside a labelled statement is the one its label continues
+    if (loop && !targets.empty() && !targets.back().loop && targets.back().start == Here())
+      target.label = targets.back().label;
+    targets.push_back(target);
+    return true;
+  }
+
+  void Close() {
+    Land(targets.back().breaks);
+    targets.pop_back();
+    Drop();
+  }
+
+  // The innermost loop, or the innermost statement labelled label, that a
+  // break or (if loop) a continue leaves; 0 when there is none.
+  Target* Find(boost::optional<Atom> const& label, bool loop) {
+    for (std::size_t i = targets.size(); i-- > 0;) {
+      Target& target = targets[i];
+      if (loop && !target.loop)
+        continue;
+      if (label ? target.label == *label : target.loop)
+        return &target;
+    }
+    return 0;
+  }
+
+  //   initialization
+  //   start:   condition; JUMP_IF_FALSE out; JUMP body
+  //   action:  action; LOOP start
+  //   body:    statement; JUMP action
+  //   out:
+  void AtFor(boost::optional<ast::Expression> const& condition, std::size_t slot) {
+    Target& loop = targets.back();
+    top = marks.back();
+    if (slot == 1) {
+      loop.start = Here();
+    } else if (slot == 2) {
+      if (condition)
+        loop.breaks.push_back(Jump(bytecode::JUMP_IF_FALSE, marks.back()));
+      jumps.push_back(Jump(bytecode::JUMP));
+      loop.action = Here();
+    } else if (slot == 3) {
+      Emit(bytecode::LOOP, 0);
+      code.instructions.back().target(loop.start);
+      Land(jumps.back());
+      jumps.pop_back();
+    }
+  }
+
+  void LeaveFor() {
+    Target& loop = targets.back();
+    Emit(bytecode::JUMP, 0);
+    code.instructions.back().target(loop.action);
+    for (std::size_t i = 0; i < loop.continues.size(); ++i)
+      code.instructions[loop.continues[i]].target(loop.action);
+    Close();
+  }
+
+  Scope const& scope;
+  Code& code;
+  // the first register free
+  std::size_t top;
+  bool fits;
+  // top when the nodes being walked were entered
+  std::vector<std::size_t> marks;
+  // the jumps of the conditionals being walked, to land where they end
+  std::vector<std::size_t> jumps;
+  std::vector<Target> targets;
+};
+
+}
+
+bool BytecodeCompiler::operator()(ast::Program const& program, Code& code) const {
+  Scope scope(program);
+  CodeCompiler compiler(scope, code);
+  compiler.walk(program);
+  compiler.finish();
+  return compiler.ok();
+}
+
+} // namespace compiler
+} // namespace kunjs
@@ -0,0 +1,36 @@
+#ifndef KUNJS_COMPILER_BYTECODECOMPILER_H_
+#define KUNJS_COMPILER_BYTECODECOMPILER_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "kunjs/ast.h"
+#include "kunjs/compiler/bytecode.h"
+
+namespace kunjs { namespace compiler {
+
+// Compiles a program into Code for the Interpreter, which starts running it
+// long before the JIT could have made machine code of it: the first tier for
+// scripts that run a few times, where ProgramCompiler is for code that runs
+// long. Values are the same in both (see Value), and the bytecode covers
+// more of the language: variables (given registers by a Scope), assignments,
+// unary and logical operators, conditionals, if statements and loops. What
+// cannot be compiled yet is skipped, its value null: functions and calls,
+// objects and members, for-in, switch, with, try and throw.
+//
+// Registers are allocated as on a stack: each expression leaves its value in
+// the first register free when it is entered, and its operands use the ones
+// after. ASTs are walked with an ast::Walker, so that deep ones do not run
+// out of native stack.
+class BytecodeCompiler {
+ public:
+  // Compiles program into code, which is empty. False when program needs more
+  // registers or constants than an Operand can name; code is then partial.
+  bool operator()(ast::Program const& program, Code& code) const;
+};
+
+} // namespace compiler
+} // namespace kunjs
+
+#endif // KUNJS_COMPILER_BYTECODECOMPILER_H_
@@ -2,67 +2,115 @@
 #include "kunjs/compiler/statement_compiler.h"
 #include "kunjs/ast.h"
 
-#include <boost/variant.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/variant/apply_visitor.hpp>
 
 #include <llvm/Support/IRBuilder.h>
 #include <llvm/Constants.h>
 #include <llvm/DerivedTypes.h>
-#include <llvm/Metadata.h>
+#include <llvm/GlobalVariable.h>
 #include <llvm/LLVMContext.h>
 
-#include <iostream>
+#include <cmath>
+#include <limits>
 #include <string>
 
 namespace kunjs { namespace compiler {
 
-ExpressionCompiler::ExpressionCompiler(llvm::LLVMContext& ctx) :
-    context(ctx), builder(llvm::IRBuilder<>(ctx)) {}
-
-llvm::Value* ExpressionCompiler::operator()(ast::AssignmentExpression const& expression) {
-  //for (std::vector<ast::AssignmentOperation>::const_iterator it = expression.assignments.begin();
-  //it != expression.assignments.end(); ++it) {
-  //(*this)(it->lhs);
-  //it->operator_;
-  //}
-
-  return (*this)(expression.rhs);
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::ConditionalExpression const& expression) {
-  return (*this)(expression.lhs);
-  //if (expression.conditional_clauses) {
-  //ast::ConditionalClauses ternary = expression.conditional_clauses.get();
-  // true
-  //(*this)(ternary.true_clause.get());
-  // false
-  //(*this)(ternary.false_clause.get());
-  //}
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::LogicalOrExpression const& expression) {
-  return (*this)(expression.lhs);
-  //std::for_each(expression.operations.begin(), expression.operations.end(), *this);
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::LogicalAndExpression const& expression) {
-  return (*this)(expression.lhs);
-  //std::for_each(expression.operations.begin(), expression.operations.end(), *this);
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::BitwiseOrExpression const& expression) {
-  return (*this)(expression.lhs);
-  //std::for_each(expression.operations.begin(), expression.operations.end(), *this);
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::BitwiseXorExpression const& expression) {
-  return (*this)(expression.lhs);
-  //std::for_each(expression.operations.begin(), expression.operations.end(), *this);
+ExpressionCompiler::ExpressionCompiler(llvm::Module& module, llvm::BasicBlock* block) :
+    module(module), context(module.getContext()), builder(block), whole(true) {}
+
+llvm::Value* ExpressionCompiler::binary(ast::Operator operator_,
+                                        llvm::Value* lhs, llvm::Value* rhs) {
+  if (!Computable(operator_, lhs, rhs))
+    return 0;
+
+  switch (operator_) {
+    case ast::op::EQ_STRICT: return CreateCmpEQInstruction(lhs, rhs);
+    case ast::op::NE_STRICT: return CreateCmpNEInstruction(lhs, rhs);
+    case ast::op::EQ: return CreateCmpEQInstruction(lhs, rhs);
+    case ast::op::NE: return CreateCmpNEInstruction(lhs, rhs);
+    case ast::op::LTE: return CreateCmpLEInstruction(lhs, rhs);
+    case ast::op::GTE: return CreateCmpGEInstruction(lhs, rhs);
+    case ast::op::LT: return CreateCmpLTInstruction(lhs, rhs);
+    case ast::op::GT: return CreateCmpGTInstruction(lhs, rhs);
+    case ast::op::SHR: return CreateLShrInstruction(lhs, rhs);
+    case ast::op::SHL: return CreateShlInstruction(lhs, rhs);
+    case ast::op::SAR: return CreateAShrInstruction(lhs, rhs);
+    case ast::op::BIT_AND: return CreateAndInstruction(lhs, rhs);
+    case ast::op::BIT_OR: return CreateOrInstruction(lhs, rhs);
+    case ast::op::BIT_XOR: return CreateXorInstruction(lhs, rhs);
+    case ast::op::ADD: return CreateAddInstruction(lhs, rhs);
+    case ast::op::SUB: return CreateSubInstruction(lhs, rhs);
+    case ast::op::MUL: return CreateMulInstruction(lhs, rhs);
+    case ast::op::DIV: return CreateDivInstruction(lhs, rhs);
+    case ast::op::MOD: return CreateRemInstruction(lhs, rhs);
+    default:
+      return 0;
+  }
 }
 
-llvm::Value* ExpressionCompiler::operator()(ast::BitwiseAndExpression const& expression) {
-  return (*this)(expression.lhs);
-  //std::for_each(expression.operations.begin(), expression.operations.end(), *this);
+bool ExpressionCompiler::Number(llvm::Value* value) {
+  return value->getType()->isIntegerTy(32) || value->getType()->isDoubleTy();
+}
+
+// Whether binary makes the operation JavaScript would do of lhs and rhs, as
+// the Interpreter does it.
+bool ExpressionCompiler::Computable(ast::Operator operator_,
+                                    llvm::Value* lhs, llvm::Value* rhs) {
+  if (Number(lhs) && Number(rhs)) {
+    switch (operator_) {
+      case ast::op::ADD: case ast::op::SUB: case ast::op::MUL:
+        return !lhs->getType()->isIntegerTy() || !rhs->getType()->isIntegerTy() ||
+            Int32Result(operator_, lhs, rhs);
+      case ast::op::SHL: case ast::op::SAR: case ast::op::SHR:
+      case ast::op::BIT_AND: case ast::op::BIT_OR: case ast::op::BIT_XOR:
+        return Int32Operand(lhs) && Int32Operand(rhs);
+      default:
+        return true;
+    }
+  }
+  bool equality = operator_ == ast::op::EQ || operator_ == ast::op::NE ||
+      operator_ == ast::op::EQ_STRICT || operator_ == ast::op::NE_STRICT;
+  return equality && lhs->getType()->isIntegerTy(1) && rhs->getType()->isIntegerTy(1);
+}
+
+// Integer + - * are i32 ones, which are only right where the result is one:
+// past 32 bits, or -0, it is a double in the Interpreter. Only constants
+// tell.
+bool ExpressionCompiler::Int32Result(ast::Operator operator_,
+                                     llvm::Value* lhs, llvm::Value* rhs) {
+  llvm::ConstantInt* left = llvm::dyn_cast<llvm::ConstantInt>(lhs);
+  llvm::ConstantInt* right = llvm::dyn_cast<llvm::ConstantInt>(rhs);
+  if (!left || !right)
+    return false;
+
+  boost::int64_t a = left->getSExtValue();
+  boost::int64_t b = right->getSExtValue();
+  boost::int64_t result =
+      operator_ == ast::op::ADD ? a + b : operator_ == ast::op::SUB ? a - b : a * b;
+  if (operator_ == ast::op::MUL && result == 0 && (a < 0 || b < 0))
+    return false;
+  return result >= std::numeric_limits<boost::int32_t>::min() &&
+      result <= std::numeric_limits<boost::int32_t>::max();
+}
+
+// Whether ToInt32 makes the one of value: doubles go through an i64, which
+// NaN, infinities and the ones past 2^63 do not fit.
+bool ExpressionCompiler::Int32Operand(llvm::Value* value) {
+  if (!value->getType()->isDoubleTy())
+    return true;
+  llvm::ConstantFP* constant = llvm::dyn_cast<llvm::ConstantFP>(value);
+  if (!constant)
+    return false;
+  double number = constant->getValueAPF().convertToDouble();
+  return std::fabs(number) < 9223372036854775808.0;
+}
+
+llvm::Value* ExpressionCompiler::Unsupported() {
+  whole = false;
+  return llvm::ConstantPointerNull::get(
+      llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)));
 }
 
 llvm::Value* ExpressionCompiler::CreateCmpEQInstruction(llvm::Value* lhs, llvm::Value* rhs) {
@@ -77,32 +125,14 @@ llvm::Value* ExpressionCompiler::CreateCmpEQInstruction(llvm::Value* lhs, llvm::
 
 llvm::Value* ExpressionCompiler::CreateCmpNEInstruction(llvm::Value* lhs, llvm::Value* rhs) {
   if (lhs->getType()->isDoubleTy() || rhs->getType()->isDoubleTy()) {
-    return builder.CreateFCmpONE(builder.CreateSIToFP(lhs, llvm::Type::getDoubleTy(context)),
+    return builder.CreateFCmpUNE(builder.CreateSIToFP(lhs, llvm::Type::getDoubleTy(context)),
                                  builder.CreateSIToFP(rhs, llvm::Type::getDoubleTy(context)),
-                                 "fcmp_one");
+                                 "fcmp_une");
   } else {
     return builder.CreateICmpNE(lhs, rhs, "icmp_sne");
   }
 }
 
-llvm::Value* ExpressionCompiler::operator()(ast::EqualityExpression const& expression) {
-  llvm::Value* result = (*this)(expression.lhs);
-  for (std::vector<ast::EqualityOperation>::const_iterator it = expression.operations.begin();
-       it != expression.operations.end(); ++it) {
-    llvm::Value* rhs = (*this)(it->rhs);
-    if (it->operator_ == "===") {
-      result = CreateCmpEQInstruction(result, rhs);
-    } else if (it->operator_ == "!==") {
-      result = CreateCmpNEInstruction(result, rhs);
-    } else if (it->operator_ == "==") {
-      result = CreateCmpEQInstruction(result, rhs);
-    } else if (it->operator_ == "!=") {
-      result = CreateCmpNEInstruction(result, rhs);
-    } // TODO: else { throw error }
-  }
-  return result;
-}
-
 llvm::Value* ExpressionCompiler::CreateCmpLEInstruction(llvm::Value* lhs, llvm::Value* rhs) {
   if (lhs->getType()->isDoubleTy() || rhs->getType()->isDoubleTy()) {
     return builder.CreateFCmpOLE(builder.CreateSIToFP(lhs, llvm::Type::getDoubleTy(context)),
@@ -143,65 +173,45 @@ llvm::Value* ExpressionCompiler::CreateCmpGTInstruction(llvm::Value* lhs, llvm::
   }
 }
 
-llvm::Value* ExpressionCompiler::operator()(ast::RelationalExpression const& expression) {
-  llvm::Value* result = (*this)(expression.lhs);
-
-  for (std::vector<ast::RelationalOperation>::const_iterator it = expression.operations.begin();
-       it != expression.operations.end(); ++it) {
-    llvm::Value* rhs = (*this)(it->rhs);
-    if (it->operator_ == "<=") {
-      result = CreateCmpLEInstruction(result, rhs);
-    } else if (it->operator_ == ">=") {
-      result = CreateCmpGEInstruction(result, rhs);
-    } else if (it->operator_ == "<") {
-      result = CreateCmpLTInstruction(result, rhs);
-    } else if (it->operator_ == ">") {
-      result = CreateCmpGTInstruction(result, rhs);
-    //} else if (it->operator_ == "instanceof") {
-    //  result = CreateInstanceofInstruction(result, rhs);
-    //} else if (it->operator_ == "in") {
-    //  result = CreateInInstruction(result, rhs);
-    } // TODO: else { throw error }
-  }
+// JavaScript's ToInt32: integers as they are, doubles truncated and taken
+// modulo 2^32, by way of an i64 (exact for those that fit one).
+llvm::Value* ExpressionCompiler::ToInt32(llvm::Value* value) {
+  if (!value->getType()->isDoubleTy())
+    return value;
+  return builder.CreateTrunc(builder.CreateFPToSI(value, llvm::Type::getInt64Ty(context)),
+                             llvm::Type::getInt32Ty(context));
+}
 
-  return result;
+// Only the low 5 bits of a count count.
+llvm::Value* ExpressionCompiler::ShiftCount(llvm::Value* value) {
+  return builder.CreateAnd(ToInt32(value),
+                           llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 31));
 }
 
 llvm::Value* ExpressionCompiler::CreateShlInstruction(llvm::Value* lhs, llvm::Value* rhs) {
-  return builder.CreateShl(builder.CreateFPToSI(lhs, llvm::Type::getInt32Ty(context)),
-                           builder.CreateFPToUI(rhs, llvm::Type::getInt32Ty(context)),
-                           "<<");
+  return builder.CreateShl(ToInt32(lhs), ShiftCount(rhs), "<<");
 }
 
 llvm::Value* ExpressionCompiler::CreateAShrInstruction(llvm::Value* lhs, llvm::Value* rhs) {
-  return builder.CreateAShr(builder.CreateFPToSI(lhs, llvm::Type::getInt32Ty(context)),
-                            builder.CreateFPToUI(rhs, llvm::Type::getInt32Ty(context)),
-                            ">>");
+  return builder.CreateAShr(ToInt32(lhs), ShiftCount(rhs), ">>");
 }
 
+// The result is unsigned, past what an i32 holds: a double.
 llvm::Value* ExpressionCompiler::CreateLShrInstruction(llvm::Value* lhs, llvm::Value* rhs) {
-  return builder.CreateLShr(builder.CreateFPToSI(lhs, llvm::Type::getInt32Ty(context)),
-                            builder.CreateFPToUI(rhs, llvm::Type::getInt32Ty(context)),
-                            ">>>");
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::ShiftExpression const& expression) {
-  llvm::Value* result = (*this)(expression.lhs);
-
-  for (std::vector<ast::ShiftOperation>::const_iterator it = expression.operations.begin();
-       it != expression.operations.end(); ++it) {
-    llvm::Value* rhs = (*this)(it->rhs);
-    if (it->operator_ == ">>>") {
-      result = CreateLShrInstruction(result, rhs);
-    } else if (it->operator_ == "<<") {
-      result = CreateShlInstruction(result, rhs);
-    } else if (it->operator_ == ">>") {
-      result = CreateAShrInstruction(result, rhs);
-    } // TODO: else throw error
-  }
+  return builder.CreateUIToFP(builder.CreateLShr(ToInt32(lhs), ShiftCount(rhs), ">>>"),
+                              llvm::Type::getDoubleTy(context));
+}
 
-  return result;
+llvm::Value* ExpressionCompiler::CreateAndInstruction(llvm::Value* lhs, llvm::Value* rhs) {
+  return builder.CreateAnd(ToInt32(lhs), ToInt32(rhs), "&");
+}
 
+llvm::Value* ExpressionCompiler::CreateOrInstruction(llvm::Value* lhs, llvm::Value* rhs) {
+  return builder.CreateOr(ToInt32(lhs), ToInt32(rhs), "|");
+}
+
+llvm::Value* ExpressionCompiler::CreateXorInstruction(llvm::Value* lhs, llvm::Value* rhs) {
+  return builder.CreateXor(ToInt32(lhs), ToInt32(rhs), "^");
 }
 
 llvm::Value* ExpressionCompiler::CreateAddInstruction(llvm::Value* lhs, llvm::Value* rhs) {
@@ -224,22 +234,6 @@ llvm::Value* ExpressionCompiler::CreateSubInstruction(llvm::Value* lhs, llvm::Va
   }
 }
 
-llvm::Value* ExpressionCompiler::operator()(ast::AdditiveExpression const& expression) {
-  llvm::Value* result = (*this)(expression.lhs);
-
-  for (std::vector<ast::AdditiveOperation>::const_iterator it = expression.operations.begin();
-       it != expression.operations.end(); ++it) {
-    llvm::Value* rhs = (*this)(it->rhs);
-    if (it->operator_ == "+") {
-      result = CreateAddInstruction(result, rhs);
-    } else if (it->operator_ == "-") {
-      result = CreateSubInstruction(result, rhs);
-    } // TODO: else throw error
-  }
-
-  return result;
-}
-
 llvm::Value* ExpressionCompiler::CreateMulInstruction(llvm::Value* lhs, llvm::Value* rhs) {
   if (lhs->getType()->isDoubleTy() || rhs->getType()->isDoubleTy()) {
     return builder.CreateFMul(builder.CreateSIToFP(lhs, llvm::Type::getDoubleTy(context)),
@@ -250,154 +244,59 @@ llvm::Value* ExpressionCompiler::CreateMulInstruction(llvm::Value* lhs, llvm::Va
   }
 }
 
+// Integers are divided as doubles too: a quotient can have a fraction, or be
+// infinite or NaN, and a remainder be -0.
 llvm::Value* ExpressionCompiler::CreateDivInstruction(llvm::Value* lhs, llvm::Value* rhs) {
-  if (lhs->getType()->isDoubleTy() || rhs->getType()->isDoubleTy()) {
-    return builder.CreateFDiv(builder.CreateSIToFP(lhs, llvm::Type::getDoubleTy(context)),
-                              builder.CreateSIToFP(rhs, llvm::Type::getDoubleTy(context)),
-                              "div_double");
-  } else {
-    return builder.CreateSDiv(lhs, rhs, "div_int");
-  }
+  return builder.CreateFDiv(builder.CreateSIToFP(lhs, llvm::Type::getDoubleTy(context)),
+                            builder.CreateSIToFP(rhs, llvm::Type::getDoubleTy(context)),
+                            "div_double");
 }
 
 llvm::Value* ExpressionCompiler::CreateRemInstruction(llvm::Value* lhs, llvm::Value* rhs) {
-  if (lhs->getType()->isDoubleTy() || rhs->getType()->isDoubleTy()) {
-    return builder.CreateFRem(builder.CreateSIToFP(lhs, llvm::Type::getDoubleTy(context)),
-                              builder.CreateSIToFP(rhs, llvm::Type::getDoubleTy(context)),
-                              "rem_double");
-  } else {
-    return builder.CreateSRem(lhs, rhs, "rem_int");
-  }
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::MultiplicativeExpression const& expression) {
-  llvm::Value* result = (*this)(expression.lhs);
-
-  for (std::vector<ast::MultiplicativeOperation>::const_iterator it = expression.operations.begin();
-       it != expression.operations.end(); ++it) {
-    llvm::Value* rhs = (*this)(it->rhs);
-    if (it->operator_ == "*") {
-      result = CreateMulInstruction(result, rhs);
-    } else if (it->operator_ == "/") {
-      result = CreateDivInstruction(result, rhs);
-    } else if (it->operator_ == "%") {
-      result = CreateRemInstruction(result, rhs);
-    } // TODO: else throw error
+  return builder.CreateFRem(builder.CreateSIToFP(lhs, llvm::Type::getDoubleTy(context)),
+                            builder.CreateSIToFP(rhs, llvm::Type::getDoubleTy(context)),
+                            "rem_double");
+}
+
+llvm::Value* ExpressionCompiler::operator()(flat::Tree const& tree, flat::Index node) {
+  flat::Node const& expression = tree[node];
+  LiteralCompiler literal(module);
+
+  switch (expression.kind) {
+    case flat::node::NULL_LITERAL:
+      return literal(ast::Null());
+    case flat::node::BOOLEAN:
+      return literal(expression.value != 0);
+    case flat::node::NUMBER:
+      return literal(tree.numbers[expression.value]);
+    case flat::node::STRING:
+      return literal(llvm::StringRef(tree.strings[expression.value]));
+
+    case flat::node::SEQUENCE: {
+      StatementCompiler compile(module, builder.GetInsertBlock());
+      llvm::Value* value = compile(tree, node);
+      if (!compile.complete())
+        whole = false;
+      return value;
+    }
+
+    case flat::node::BINARY: {
+      llvm::Value* lhs = (*this)(tree, tree.child(node, 0));
+      llvm::Value* rhs = (*this)(tree, tree.child(node, 1));
+      llvm::Value* value = binary(ast::Operator(expression.value), lhs, rhs);
+      return value ? value : Unsupported();
+    }
+
+    default:
+      return Unsupported();
   }
-
-  return result;
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::UnaryExpression const& expression) {
-  //for (std::vector<std::string>::const_iterator it = expression.operators.begin();
-  //it != expression.operators.end(); ++it) {
-  ////unary operation
-  //*it;
-  //}
-
-  return (*this)(expression.rhs);
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::PostfixExpression const& expression) {
-  return (*this)(expression.lhs);
-
-  //if (expression.operator_) {
-  //expression.operator_.get();
-  //}
 }
 
-llvm::Value* ExpressionCompiler::operator()(ast::LhsExpression const& expression) {
-  return boost::apply_visitor(*this, expression);
-}
 
-llvm::Value* ExpressionCompiler::operator()(ast::CallExpression const& expression) {
-  return llvm::ConstantPointerNull::get(
-      llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)));
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::NewExpression const& expression) {
-  //for (std::vector<std::string>::const_iterator it = expression.operators.begin();
-  //it != expression.operators.end(); ++it) {
-  //// new operations
-  //*it;
-  //}
-
-  return (*this)(expression.member);
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::MemberExpression const& expression) {
-  return boost::apply_visitor(*this, expression);
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::MemberAccess const& expression) {
-  return (*this)(expression.member);
-
-  //if (!expression.modifiers.empty()) {
-  //std::for_each(expression.modifiers.begin(), expression.modifiers.end(), *this);
-  //}
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::MemberOptions const& expression) {
-  return boost::apply_visitor(*this, expression);
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::MemberModifier const& expression) {
-  return llvm::ConstantPointerNull::get(
-      llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)));
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::Instantiation const& expression) {
-  //StatementCompiler compile_statement(context);
-
-  // instantiation
-  //(*this)(expression.member);
-
-  // arguments
-  //compile_statement(expression.arguments);
+LiteralCompiler::LiteralCompiler(llvm::Module& module)
+  : module(module), context(module.getContext()) {}
 
-  return llvm::ConstantPointerNull::get(
-      llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)));
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::PrimaryExpression const& expression) {
-  PrimaryExpressionCompiler compiler = PrimaryExpressionCompiler(context);
-  return boost::apply_visitor(compiler, expression);
-}
-
-llvm::Value* ExpressionCompiler::operator()(ast::FunctionExpression const& expression) {
-  return llvm::ConstantPointerNull::get(
-      llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)));
-}
-
-
-PrimaryExpressionCompiler::PrimaryExpressionCompiler(llvm::LLVMContext& context)
-  : context(context) {}
-
-llvm::Value* PrimaryExpressionCompiler::operator()(ast::This const& node) {
-  return llvm::ConstantPointerNull::get(
-      llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)));
-}
-
-llvm::Value* PrimaryExpressionCompiler::operator()(std::string const& identifier) {
-  return llvm::ConstantPointerNull::get(
-      llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)));
-}
-
-llvm::Value* PrimaryExpressionCompiler::operator()(ast::Literal const& literal) {
-  LiteralCompiler compiler = LiteralCompiler(context);
-  return boost::apply_visitor(compiler, literal);
-}
-
-llvm::Value* PrimaryExpressionCompiler::operator()(ast::Expression const& expression) {
-  StatementCompiler compile(context);
-  return compile(expression);
-}
-
-
-LiteralCompiler::LiteralCompiler(llvm::LLVMContext& context)
-  : context(context) {}
-
-llvm::Value* LiteralCompiler::operator()(ast::Null const& literal) {
+llvm::Value* LiteralCompiler::operator()(ast::Null const&) {
   return llvm::ConstantPointerNull::get(
       llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)));
 }
@@ -418,8 +317,17 @@ llvm::Value* LiteralCompiler::operator()(double literal) {
   return llvm::ConstantFP::get(context, llvm::APFloat(literal));
 }
 
-llvm::Value* LiteralCompiler::operator()(std::string const& literal) {
-  return llvm::MDString::get(context, literal);
+llvm::Value* LiteralCompiler::operator()(ast::String const& literal) {
+  return (*this)(llvm::StringRef(literal.data(), literal.size()));
+}
+
+llvm::Value* LiteralCompiler::operator()(llvm::StringRef literal) {
+  llvm::Constant* characters = llvm::ConstantArray::get(context, literal);
+  llvm::GlobalVariable* string = new llvm::GlobalVariable(
+      module, characters->getType(), true, llvm::GlobalValue::PrivateLinkage, characters, "string");
+  llvm::Constant* zero = llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0);
+  llvm::Constant* first[] = { zero, zero };
+  return llvm::ConstantExpr::getGetElementPtr(string, first, 2);
 }
 
 
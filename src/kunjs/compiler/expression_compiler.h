@@ -6,8 +6,11 @@
 #endif
 
 #include "kunjs/ast.h"
+#include "kunjs/flat_ast.h"
 #include <boost/variant/static_visitor.hpp>
 
+#include <llvm/BasicBlock.h>
+#include <llvm/Module.h>
 #include <llvm/Value.h>
 #include <llvm/Support/IRBuilder.h>
 #include <llvm/LLVMContext.h>
@@ -16,36 +19,37 @@
 
 namespace kunjs { namespace compiler {
 
-class ExpressionCompiler : public boost::static_visitor<llvm::Value*> {
-
+// Compiles the expressions of a flattened tree, and the operations
+// ProgramCompiler needs for the ones of an AST, into instructions at the end
+// of block, with the constants they need in module.
+class ExpressionCompiler {
  public:
-  ExpressionCompiler(llvm::LLVMContext& context);
-  llvm::Value* operator()(ast::AssignmentExpression const& expression);
-  llvm::Value* operator()(ast::ConditionalExpression const& expression);
-  llvm::Value* operator()(ast::LogicalOrExpression const& expression);
-  llvm::Value* operator()(ast::LogicalAndExpression const& expression);
-  llvm::Value* operator()(ast::BitwiseOrExpression const& expression);
-  llvm::Value* operator()(ast::BitwiseXorExpression const& expression);
-  llvm::Value* operator()(ast::BitwiseAndExpression const& expression);
-  llvm::Value* operator()(ast::EqualityExpression const& expression);
-  llvm::Value* operator()(ast::RelationalExpression const& expression);
-  llvm::Value* operator()(ast::ShiftExpression const& expression);
-  llvm::Value* operator()(ast::AdditiveExpression const& expression);
-  llvm::Value* operator()(ast::MultiplicativeExpression const& expression);
-  llvm::Value* operator()(ast::UnaryExpression const& expression);
-  llvm::Value* operator()(ast::PostfixExpression const& expression);
-  llvm::Value* operator()(ast::LhsExpression const& expression);
-  llvm::Value* operator()(ast::CallExpression const& expression);
-  llvm::Value* operator()(ast::NewExpression const& expression);
-  llvm::Value* operator()(ast::MemberExpression const& expression);
-  llvm::Value* operator()(ast::MemberAccess const& expression);
-  llvm::Value* operator()(ast::MemberOptions const& expression);
-  llvm::Value* operator()(ast::MemberModifier const& expression);
-  llvm::Value* operator()(ast::Instantiation const& expression);
-  llvm::Value* operator()(ast::PrimaryExpression const& expression);
-  llvm::Value* operator()(ast::FunctionExpression const& expression);
+  ExpressionCompiler(llvm::Module& module, llvm::BasicBlock* block);
+
+  // The expression rooted at node in a flattened tree. What cannot be
+  // compiled yet (names, unary, postfix, conditional and logical operations,
+  // assignments, calls, members and literal arrays) is a null i8*, and makes
+  // complete() false.
+  llvm::Value* operator()(flat::Tree const& tree, flat::Index node);
+
+  // lhs operator_ rhs, for a binary operator; 0 for the ones it cannot
+  // compile yet (logical operators, instanceof and in) and for operands it
+  // cannot compute them of as the Interpreter does: numbers are, and
+  // booleans for equality, but integer + - * only where the result stays an
+  // integer, and shifts and bitwise operators only of doubles that fit an
+  // i64.
+  llvm::Value* binary(ast::Operator operator_, llvm::Value* lhs, llvm::Value* rhs);
+
+  // False when some of the expressions compiled to a value they do not have.
+  bool complete() const { return whole; }
 
  private:
+  static bool Number(llvm::Value* value);
+  static bool Computable(ast::Operator operator_, llvm::Value* lhs, llvm::Value* rhs);
+  static bool Int32Result(ast::Operator operator_, llvm::Value* lhs, llvm::Value* rhs);
+  static bool Int32Operand(llvm::Value* value);
+  llvm::Value* Unsupported();
+
   llvm::Value* CreateCmpEQInstruction(llvm::Value* lhs, llvm::Value* rhs);
   llvm::Value* CreateCmpNEInstruction(llvm::Value* lhs, llvm::Value* rhs);
   llvm::Value* CreateCmpLEInstruction(llvm::Value* lhs, llvm::Value* rhs);
@@ -53,10 +57,16 @@ class ExpressionCompiler : public boost::static_visitor<llvm::Value*> {
   llvm::Value* CreateCmpLTInstruction(llvm::Value* lhs, llvm::Value* rhs);
   llvm::Value* CreateCmpGTInstruction(llvm::Value* lhs, llvm::Value* rhs);
 
+  llvm::Value* ToInt32(llvm::Value* value);
+  llvm::Value* ShiftCount(llvm::Value* value);
   llvm::Value* CreateShlInstruction(llvm::Value* lhs, llvm::Value* rhs);
   llvm::Value* CreateAShrInstruction(llvm::Value* lhs, llvm::Value* rhs);
   llvm::Value* CreateLShrInstruction(llvm::Value* lhs, llvm::Value* rhs);
 
+  llvm::Value* CreateAndInstruction(llvm::Value* lhs, llvm::Value* rhs);
+  llvm::Value* CreateOrInstruction(llvm::Value* lhs, llvm::Value* rhs);
+  llvm::Value* CreateXorInstruction(llvm::Value* lhs, llvm::Value* rhs);
+
   llvm::Value* CreateAddInstruction(llvm::Value* lhs, llvm::Value* rhs);
   llvm::Value* CreateSubInstruction(llvm::Value* lhs, llvm::Value* rhs);
 
@@ -64,37 +74,29 @@ class ExpressionCompiler : public boost::static_visitor<llvm::Value*> {
   llvm::Value* CreateDivInstruction(llvm::Value* lhs, llvm::Value* rhs);
   llvm::Value* CreateRemInstruction(llvm::Value* lhs, llvm::Value* rhs);
 
+  llvm::Module& module;
   llvm::LLVMContext& context;
   llvm::IRBuilder<> builder;
+  bool whole;
 
 };
 
 
-class PrimaryExpressionCompiler : public boost::static_visitor<llvm::Value*> {
- public:
-  PrimaryExpressionCompiler(llvm::LLVMContext& context);
-  llvm::Value* operator()(ast::This const& node);
-  llvm::Value* operator()(std::string const& identifier);
-  llvm::Value* operator()(ast::Literal const& literal);
-  llvm::Value* operator()(ast::Expression const& expression);
-
- private:
-  llvm::LLVMContext& context;
-
-};
-
-
+// Strings are constant globals of module, and their values point to the
+// first of their characters, followed by a NUL.
 class LiteralCompiler : public boost::static_visitor<llvm::Value*> {
  public:
-  LiteralCompiler(llvm::LLVMContext& context);
+  LiteralCompiler(llvm::Module& module);
   llvm::Value* operator()(ast::Null const& literal);
   llvm::Value* operator()(bool literal);
   llvm::Value* operator()(ast::Numeric const& numeric);
   llvm::Value* operator()(int literal);
   llvm::Value* operator()(double literal);
-  llvm::Value* operator()(std::string const& literal);
+  llvm::Value* operator()(ast::String const& literal);
+  llvm::Value* operator()(llvm::StringRef literal);
 
  private:
+  llvm::Module& module;
   llvm::LLVMContext& context;
 
 };
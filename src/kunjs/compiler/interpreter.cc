@@ -0,0 +1,290 @@
+#include "kunjs/compiler/interpreter.h"
+
+#include <boost/cstdint.hpp>
+
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+// Threaded dispatch needs the address of a label, a GCC extension.
+#if defined(__GNUC__)
+#define KUNJS_THREADED_DISPATCH
+#endif
+
+namespace kunjs { namespace compiler {
+
+namespace {
+
+const boost::int32_t INT32_MIN_VALUE = std::numeric_limits<boost::int32_t>::min();
+const boost::int32_t INT32_MAX_VALUE = std::numeric_limits<boost::int32_t>::max();
+
+inline bool Integers(Value const& lhs, Value const& rhs) {
+  return lhs.type == Value::INTEGER && rhs.type == Value::INTEGER;
+}
+
+inline bool IsNumber(Value const& value) {
+  return value.type == Value::INTEGER || value.type == Value::DOUBLE;
+}
+
+double StringToNumber(char const* text) {
+  while (std::isspace(static_cast<unsigned char>(*text)))
+    ++text;
+  if (!*text)
+    return 0;
+  char* end;
+  double number = std::strtod(text, &end);
+  while (std::isspace(static_cast<unsigned char>(*end)))
+    ++end;
+  return *end ? std::numeric_limits<double>::quiet_NaN() : number;
+}
+
+inline double Number(Value const& value) {
+  switch (value.type) {
+    case Value::INTEGER: return value.integer;
+    case Value::DOUBLE: return value.number;
+    case Value::BOOLEAN: return value.boolean;
+    case Value::STRING: return StringToNumber(value.string);
+    default: return 0;
+  }
+}
+
+inline bool Truthy(Value const& value) {
+  switch (value.type) {
+    case Value::BOOLEAN: return value.boolean;
+    case Value::INTEGER: return value.integer != 0;
+    case Value::DOUBLE: return value.number != 0 && value.number == value.number;
+    case Value::STRING: return *value.string != 0;
+    default: return false;
+  }
+}
+
+// Modulo 2^32, as for the bitwise operators.
+inline boost::int32_t ToInt32(Value const& value) {
+  if (value.type == Value::INTEGER)
+    return value.integer;
+  double number = Number(value);
+  if (number != number || number - number != 0)
+    return 0;
+  number = std::fmod(number < 0 ? -std::floor(-number) : std::floor(number), 4294967296.0);
+  if (number < 0)
+    number += 4294967296.0;
+  return static_cast<boost::int32_t>(static_cast<boost::uint32_t>(number));
+}
+
+// Shifts wrap, as i32 do.
+inline Value Wrapped(boost::uint32_t integer) {
+  return Value(static_cast<boost::int32_t>(integer));
+}
+
+// An integer result stays one where an i32 holds it; others are doubles, as
+// all numbers are in JavaScript.
+inline Value Exact(boost::int64_t integer) {
+  if (integer < INT32_MIN_VALUE || integer > INT32_MAX_VALUE)
+    return Value(static_cast<double>(integer));
+  return Value(static_cast<boost::int32_t>(integer));
+}
+
+// A zero result of a negative operand is -0, which only a double holds.
+inline Value Signed(boost::int64_t integer, bool negative) {
+  return integer == 0 && negative ? Value(-0.0) : Exact(integer);
+}
+
+inline Value Add(Value const& lhs, Value const& rhs, std::deque<std::string>& strings) {
+  if (Integers(lhs, rhs))
+    return Exact(boost::int64_t(lhs.integer) + rhs.integer);
+  if (lhs.type == Value::STRING || rhs.type == Value::STRING) {
+    strings.push_back(to_string(lhs) + to_string(rhs));
+    return Value(strings.back().c_str());
+  }
+  return Value(Number(lhs) + Number(rhs));
+}
+
+inline Value Subtract(Value const& lhs, Value const& rhs) {
+  if (Integers(lhs, rhs))
+    return Exact(boost::int64_t(lhs.integer) - rhs.integer);
+  return Value(Number(lhs) - Number(rhs));
+}
+
+// A product of two i32 fits an i64, and rounds to the double JavaScript's
+// multiplication gives.
+inline Value Multiply(Value const& lhs, Value const& rhs) {
+  if (Integers(lhs, rhs))
+    return Signed(boost::int64_t(lhs.integer) * rhs.integer, lhs.integer < 0 || rhs.integer < 0);
+  return Value(Number(lhs) * Number(rhs));
+}
+
+// Integers divide as integers where the quotient is one; by 0, or with a
+// fraction, the division is a double one.
+inline Value Divide(Value const& lhs, Value const& rhs) {
+  if (Integers(lhs, rhs) && rhs.integer != 0 &&
+      boost::int64_t(lhs.integer) % rhs.integer == 0)
+    return Signed(boost::int64_t(lhs.integer) / rhs.integer, rhs.integer < 0);
+  return Value(Number(lhs) / Number(rhs));
+}
+
+// The sign of a remainder is the one of lhs.
+inline Value Remainder(Value const& lhs, Value const& rhs) {
+  if (Integers(lhs, rhs) && rhs.integer != 0)
+    return Signed(boost::int64_t(lhs.integer) % rhs.integer, lhs.integer < 0);
+  return Value(std::fmod(Number(lhs), Number(rhs)));
+}
+
+inline bool Less(Value const& lhs, Value const& rhs) {
+  if (Integers(lhs, rhs))
+    return lhs.integer < rhs.integer;
+  if (lhs.type == Value::STRING && rhs.type == Value::STRING)
+    return std::strcmp(lhs.string, rhs.string) < 0;
+  return Number(lhs) < Number(rhs);
+}
+
+inline bool LessOrEqual(Value const& lhs, Value const& rhs) {
+  if (Integers(lhs, rhs))
+    return lhs.integer <= rhs.integer;
+  if (lhs.type == Value::STRING && rhs.type == Value::STRING)
+    return std::strcmp(lhs.string, rhs.string) <= 0;
+  return Number(lhs) <= Number(rhs);
+}
+
+// Loosely, booleans and strings compare to numbers as numbers.
+inline bool Equal(Value const& lhs, Value const& rhs, bool strict) {
+  if (Integers(lhs, rhs))
+    return lhs.integer == rhs.integer;
+  if (IsNumber(lhs) && IsNumber(rhs))
+    return Number(lhs) == Number(rhs);
+  if (lhs.type == rhs.type) {
+    switch (lhs.type) {
+      case Value::BOOLEAN: return lhs.boolean == rhs.boolean;
+      case Value::STRING: return std::strcmp(lhs.string, rhs.string) == 0;
+      default: return true;
+    }
+  }
+  if (strict || lhs.type == Value::NULL_VALUE || rhs.type == Value::NULL_VALUE)
+    return false;
+  return Number(lhs) == Number(rhs);
+}
+
+inline Value Negate(Value const& value) {
+  if (value.type == Value::INTEGER && value.integer != 0 && value.integer != INT32_MIN_VALUE)
+    return Value(static_cast<boost::int32_t>(-value.integer));
+  return Value(-Number(value));
+}
+
+inline Value ToNumber(Value const& value) {
+  switch (value.type) {
+    case Value::INTEGER: case Value::DOUBLE: return value;
+    case Value::BOOLEAN: return Value(static_cast<boost::int32_t>(value.boolean));
+    case Value::STRING: return Value(StringToNumber(value.string));
+    default: return Value(static_cast<boost::int32_t>(0));
+  }
+}
+
+inline Value Increment(Value const& value) {
+  if (value.type == Value::INTEGER && value.integer != INT32_MAX_VALUE)
+    return Value(static_cast<boost::int32_t>(value.integer + 1));
+  return Value(Number(value) + 1);
+}
+
+inline Value Decrement(Value const& value) {
+  if (value.type == Value::INTEGER && value.integer != INT32_MIN_VALUE)
+    return Value(static_cast<boost::int32_t>(value.integer - 1));
+  return Value(Number(value) - 1);
+}
+
+inline Value TypeOf(Value const& value) {
+  switch (value.type) {
+    case Value::BOOLEAN: return Value("boolean");
+    case Value::INTEGER: case Value::DOUBLE: return Value("number");
+    case Value::STRING: return Value("string");
+    default: return Value("object");
+  }
+}
+
+}
+
+Value Interpreter::run(Code const& code) {
+  assert(!code.instructions.empty() && code.registers > Code::RESULT);
+  registers.assign(code.registers, Value());
+  taken = 0;
+  strings.clear();
+
+  Value* r = &registers[0];
+  Value const* constants = code.constants.empty() ? 0 : &code.constants[0];
+  Instruction const* first = &code.instructions[0];
+  Instruction const* pc = first;
+  std::size_t loops = 0;
+
+#if defined(KUNJS_THREADED_DISPATCH)
+  static void* const HANDLERS[bytecode::OPCODE_COUNT] = {
+#define B(name) &&do_##name,
+    KUNJS_BYTECODE_LIST(B)
+#undef B
+  };
+#define CASE(name) do_##name:
+#define DISPATCH() goto *HANDLERS[pc->opcode]
+  DISPATCH();
+#else
+#define CASE(name) case bytecode::name:
+#define DISPATCH() continue
+  for (;;) switch (pc->opcode) {
+#endif
+#define NEXT() ++pc; DISPATCH()
+#define JUMP_TO(target) pc = first + (target); DISPATCH()
+
+  CASE(LOAD_CONSTANT) r[pc->a] = constants[pc->b]; NEXT();
+  CASE(LOAD_NULL) r[pc->a] = Value(); NEXT();
+  CASE(MOVE) r[pc->a] = r[pc->b]; NEXT();
+
+  CASE(ADD) r[pc->a] = Add(r[pc->b], r[pc->c], strings); NEXT();
+  CASE(SUB) r[pc->a] = Subtract(r[pc->b], r[pc->c]); NEXT();
+  CASE(MUL) r[pc->a] = Multiply(r[pc->b], r[pc->c]); NEXT();
+  CASE(DIV) r[pc->a] = Divide(r[pc->b], r[pc->c]); NEXT();
+  CASE(MOD) r[pc->a] = Remainder(r[pc->b], r[pc->c]); NEXT();
+
+  CASE(SHL) r[pc->a] = Wrapped(static_cast<boost::uint32_t>(ToInt32(r[pc->b])) << (ToInt32(r[pc->c]) & 31)); NEXT();
+  CASE(SAR) r[pc->a] = Value(static_cast<boost::int32_t>(ToInt32(r[pc->b]) >> (ToInt32(r[pc->c]) & 31))); NEXT();
+  CASE(SHR) r[pc->a] = Exact(static_cast<boost::uint32_t>(ToInt32(r[pc->b])) >> (ToInt32(r[pc->c]) & 31)); NEXT();
+  CASE(BIT_AND) r[pc->a] = Value(static_cast<boost::int32_t>(ToInt32(r[pc->b]) & ToInt32(r[pc->c]))); NEXT();
+  CASE(BIT_OR) r[pc->a] = Value(static_cast<boost::int32_t>(ToInt32(r[pc->b]) | ToInt32(r[pc->c]))); NEXT();
+  CASE(BIT_XOR) r[pc->a] = Value(static_cast<boost::int32_t>(ToInt32(r[pc->b]) ^ ToInt32(r[pc->c]))); NEXT();
+
+  CASE(EQ) r[pc->a] = Value(Equal(r[pc->b], r[pc->c], false)); NEXT();
+  CASE(NE) r[pc->a] = Value(!Equal(r[pc->b], r[pc->c], false)); NEXT();
+  CASE(EQ_STRICT) r[pc->a] = Value(Equal(r[pc->b], r[pc->c], true)); NEXT();
+  CASE(NE_STRICT) r[pc->a] = Value(!Equal(r[pc->b], r[pc->c], true)); NEXT();
+  CASE(LT) r[pc->a] = Value(Less(r[pc->b], r[pc->c])); NEXT();
+  CASE(GT) r[pc->a] = Value(Less(r[pc->c], r[pc->b])); NEXT();
+  CASE(LTE) r[pc->a] = Value(LessOrEqual(r[pc->b], r[pc->c])); NEXT();
+  CASE(GTE) r[pc->a] = Value(LessOrEqual(r[pc->c], r[pc->b])); NEXT();
+
+  CASE(NEGATE) r[pc->a] = Negate(r[pc->b]); NEXT();
+  CASE(TO_NUMBER) r[pc->a] = ToNumber(r[pc->b]); NEXT();
+  CASE(NOT) r[pc->a] = Value(!Truthy(r[pc->b])); NEXT();
+  CASE(BIT_NOT) r[pc->a] = Value(static_cast<boost::int32_t>(~ToInt32(r[pc->b]))); NEXT();
+  CASE(TYPEOF) r[pc->a] = TypeOf(r[pc->b]); NEXT();
+  CASE(INCREMENT) r[pc->a] = Increment(r[pc->b]); NEXT();
+  CASE(DECREMENT) r[pc->a] = Decrement(r[pc->b]); NEXT();
+
+  CASE(JUMP) JUMP_TO(pc->target());
+  CASE(JUMP_IF_TRUE) if (Truthy(r[pc->a])) { JUMP_TO(pc->target()); } NEXT();
+  CASE(JUMP_IF_FALSE) if (!Truthy(r[pc->a])) { JUMP_TO(pc->target()); } NEXT();
+  CASE(LOOP) ++loops; JUMP_TO(pc->target());
+
+  CASE(RETURN) taken = loops; return r[pc->a];
+
+#if !defined(KUNJS_THREADED_DISPATCH)
+    default:
+      assert(!"unknown opcode");
+      return Value();
+  }
+#endif
+#undef JUMP_TO
+#undef NEXT
+#undef DISPATCH
+#undef CASE
+}
+
+} // namespace compiler
+} // namespace kunjs
@@ -0,0 +1,47 @@
+#ifndef KUNJS_COMPILER_INTERPRETER_H_
+#define KUNJS_COMPILER_INTERPRETER_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "kunjs/compiler/bytecode.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace kunjs { namespace compiler {
+
+// Runs Code compiled by BytecodeCompiler. Each instruction jumps straight to
+// the next one's handler (through a table of label addresses where GCC allows
+// it, or a switch), rather than going back through one switch for all.
+// The registers and strings are kept from one run to the next, so running
+// again allocates little. One interpreter is for one thread at a time.
+class Interpreter : private boost::noncopyable {
+ public:
+  Interpreter() : taken(0) {}
+
+  // Runs code and returns the value of the last expression statement it ran.
+  // A string returned lives until the next run, or as long as code when it is
+  // one of its constants.
+  Value run(Code const& code);
+
+  // How many times the last run went back to the start of a loop (through
+  // bytecode::LOOP), for deciding when code is worth compiling.
+  std::size_t back_edges() const { return taken; }
+
+ private:
+  std::vector<Value> registers;
+  std::size_t taken;
+  // strings made by the program being run
+  std::deque<std::string> strings;
+};
+
+} // namespace compiler
+} // namespace kunjs
+
+#endif // KUNJS_COMPILER_INTERPRETER_H_
@@ -0,0 +1,67 @@
+#include "kunjs/compiler/optimizer.h"
+
+#include <llvm/Instructions.h>
+#include <llvm/Support/InstIterator.h>
+#include <llvm/Transforms/IPO.h>
+#include <llvm/Transforms/Scalar.h>
+
+namespace kunjs { namespace compiler {
+
+namespace {
+
+bool Calls(llvm::Function& function) {
+  for (llvm::inst_iterator i = llvm::inst_begin(function), end = llvm::inst_end(function); i != end; ++i)
+    if (llvm::isa<llvm::CallInst>(*i) || llvm::isa<llvm::InvokeInst>(*i))
+      return true;
+  return false;
+}
+
+}
+
+Optimizer::Optimizer(llvm::Module& module, llvm::TargetData const& target, Level level)
+    : level(level), module(module), functions(&module) {
+  if (level == O0)
+    return;
+
+  functions.add(new llvm::TargetData(target));
+  functions.add(llvm::createPromoteMemoryToRegisterPass());
+  functions.add(llvm::createInstructionCombiningPass());
+  functions.add(llvm::createReassociatePass());
+  functions.add(llvm::createGVNPass());
+  functions.add(llvm::createCFGSimplificationPass());
+  if (level == O2) {
+    functions.add(llvm::createLoopRotatePass());
+    functions.add(llvm::createLICMPass());
+    functions.add(llvm::createLoopUnrollPass());
+    // what unrolling and hoisting leave behind
+    functions.add(llvm::createInstructionCombiningPass());
+    functions.add(llvm::createCFGSimplificationPass());
+
+    modules.add(new llvm::TargetData(target));
+    modules.add(llvm::createFunctionInliningPass());
+  }
+  functions.doInitialization();
+}
+
+void Optimizer::run(llvm::Function& function) {
+  if (level == O0)
+    return;
+
+  // Inlining first, so that the function passes see the inlined code. It
+  // goes over every function of the module, programs kept by a Runner
+  // included, so it only runs for a function with calls to inline.
+  if (level == O2 && Calls(function))
+    modules.run(module);
+  functions.run(function);
+}
+
+llvm::CodeGenOpt::Level Optimizer::code_generation(Level level) {
+  switch (level) {
+    case O0: return llvm::CodeGenOpt::None;
+    case O1: return llvm::CodeGenOpt::Less;
+    default: return llvm::CodeGenOpt::Default;
+  }
+}
+
+} // namespace compiler
+} // namespace kunjs
@@ -0,0 +1,48 @@
+#ifndef KUNJS_COMPILER_OPTIMIZER_H_
+#define KUNJS_COMPILER_OPTIMIZER_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <boost/noncopyable.hpp>
+
+#include <llvm/Function.h>
+#include <llvm/Module.h>
+#include <llvm/PassManager.h>
+#include <llvm/Target/TargetData.h>
+#include <llvm/Target/TargetMachine.h>
+
+namespace kunjs { namespace compiler {
+
+// The passes the functions of module go through once compiled, before the
+// JIT makes machine code of them:
+//
+//   O0  none, for scripts run once, where compiling fast matters most
+//   O1  mem2reg, instcombine, reassociate, GVN and simplifycfg
+//   O2  those, then LICM and loop unrolling, and inlining over the whole
+//       module when the function makes calls, for code that runs long
+//       enough to pay for them
+class Optimizer : private boost::noncopyable {
+ public:
+  enum Level { O0, O1, O2 };
+
+  Optimizer(llvm::Module& module, llvm::TargetData const& target, Level level);
+
+  void run(llvm::Function& function);
+
+  // How hard the code generator of the JIT should try at level.
+  static llvm::CodeGenOpt::Level code_generation(Level level);
+
+ private:
+  Level level;
+  llvm::Module& module;
+  llvm::FunctionPassManager functions;
+  // at O2 only
+  llvm::PassManager modules;
+};
+
+} // namespace compiler
+} // namespace kunjs
+
+#endif // KUNJS_COMPILER_OPTIMIZER_H_
@@ -1,49 +1,192 @@
 #include "kunjs/compiler/program_compiler.h"
+#include "kunjs/compiler/expression_compiler.h"
 #include "kunjs/compiler/statement_compiler.h"
 #include "kunjs/ast.h"
+#include "kunjs/ast_walker.h"
 
-#include <boost/variant.hpp>
 #include <boost/variant/apply_visitor.hpp>
 
 #include <llvm/Constants.h>
 #include <llvm/DerivedTypes.h>
+#include <llvm/Instructions.h>
 #include <llvm/LLVMContext.h>
 
 #include <string>
+#include <vector>
 
 namespace kunjs { namespace compiler {
 
-ProgramCompiler::ProgramCompiler(llvm::LLVMContext& context)
-    : context(context) {}
+namespace {
 
-llvm::Value* ProgramCompiler::operator()(std::vector<ast::Statement> const& list) const {
-  llvm::Value* result;
-  for (std::vector<ast::Statement>::const_iterator it = list.begin(); it != list.end(); ++it)
-    result = (*this)(*it);
+// Leaves the value of every node it walks on a stack: the value of its last
+// child for most of them, so that a statement or a sequence has the value of
+// the last expression in it. What cannot be compiled yet has a null value and
+// is not walked into; complete() tells whether there was any.
+class TreeCompiler : public ast::Walker<TreeCompiler> {
+ public:
+  using ast::Walker<TreeCompiler>::at;
 
-  return result;
-}
+  TreeCompiler(llvm::Module& module, llvm::BasicBlock* block)
+      : module(module), context(module.getContext()), expression(module, block), whole(true) {}
+
+  // The value of the last node walked.
+  llvm::Value* result() const { return values.empty() ? 0 : values.back(); }
+
+  // False when some of the tree compiled to a value it does not have.
+  bool complete() const { return whole; }
+
+  template <typename Node>
+  bool enter(Node const&) {
+    marks.push_back(values.size());
+    return true;
+  }
+
+  // A statement without a value keeps the value of the one before it, which
+  // is left to the interpreter for now.
+  template <typename Node>
+  void leave(Node const&) {
+    if (values.size() == marks.back())
+      whole = false;
+    Take(values.size() > marks.back() ? values.back() : 0);
+  }
+
+  void leave(ast::Program const&) { Take(values.size() > marks.back() ? values.back() : 0); }
+
+  bool enter(Atom) { return Null(); }
+  bool enter(ast::This const&) { return Null(); }
+  bool enter(ast::Literal const& literal) {
+    LiteralCompiler compile(module);
+    values.push_back(boost::apply_visitor(compile, literal));
+    return false;
+  }
+
+  // What ExpressionCompiler::binary cannot compute is null, as is what is
+  // not compiled at all.
+  void leave(ast::BinaryExpression const& binary) {
+    llvm::Value* rhs = values.back();
+    llvm::Value* lhs = values[values.size() - 2];
+    llvm::Value* value = expression.binary(binary.operator_, lhs, rhs);
+    if (value)
+      Take(value);
+    else
+      Partial(NullValue());
+  }
 
-llvm::Value* ProgramCompiler::operator()(ast::Program const& program) const {
-  llvm::Value* result;
-  for (ast::Program::const_iterator it = program.begin(); it != program.end(); ++it)
-    result = (*this)(*it);
+  // Not compiled yet: expressions other than binary ones, declarations,
+  // control flow, functions, calls and modifiers.
+  bool enter(ast::ConditionalExpression const&) { return Null(); }
+  bool enter(ast::MemberAccess const&) { return Null(); }
+  bool enter(ast::UnaryExpression const&) { return Null(); }
+  bool enter(ast::PostfixExpression const&) { return Null(); }
+  bool enter(ast::Assignment const&) { return Null(); }
+  bool enter(ast::ArrayLiteral const&) { return Null(); }
+  bool enter(ast::VarDeclaration const&) { return Null(); }
+  bool enter(ast::Noop const&) { return Null(); }
+  bool enter(ast::If const&) { return Null(); }
+  bool enter(ast::DoWhile const&) { return Null(); }
+  bool enter(ast::While const&) { return Null(); }
+  bool enter(ast::For const&) { return Null(); }
+  bool enter(ast::ForWithVar const&) { return Null(); }
+  bool enter(ast::Foreach const&) { return Null(); }
+  bool enter(ast::ForeachWithVar const&) { return Null(); }
+  bool enter(ast::Continue const&) { return Null(); }
+  bool enter(ast::Break const&) { return Null(); }
+  bool enter(ast::Return const&) { return Null(); }
+  bool enter(ast::With const&) { return Null(); }
+  bool enter(ast::LabelledStatement const&) { return Null(); }
+  bool enter(ast::Switch const&) { return Null(); }
+  bool enter(ast::Throw const&) { return Null(); }
+  bool enter(ast::Try const&) { return Null(); }
+  bool enter(ast::walk::Debugger const&) { return Null(); }
+  bool enter(ast::FunctionDeclaration const&) { return Null(); }
+  bool enter(ast::FunctionExpression const&) { return Null(); }
+  bool enter(ast::CallExpression const&) { return Null(); }
+  bool enter(ast::Instantiation const&) { return Null(); }
+  bool enter(ast::walk::Subscript const&) { return Null(); }
+  bool enter(ast::walk::Property const&) { return Null(); }
+
+ private:
+  llvm::Value* NullValue() {
+    return llvm::ConstantPointerNull::get(
+        llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)));
+  }
+
+  bool Null() {
+    whole = false;
+    values.push_back(NullValue());
+    return false;
+  }
+
+  // Replaces the values of the children of the node being left by value.
+  void Take(llvm::Value* value) {
+    values.resize(marks.back());
+    marks.pop_back();
+    values.push_back(value);
+  }
+
+  void Partial(llvm::Value* value) {
+    whole = false;
+    Take(value);
+  }
+
+  llvm::Module& module;
+  llvm::LLVMContext& context;
+  ExpressionCompiler expression;
+  bool whole;
+  std::vector<llvm::Value*> values;
+  // where the values of the nodes being walked start
+  std::vector<std::size_t> marks;
+};
 
-  return result;
 }
 
-llvm::Value* ProgramCompiler::operator()(ast::SourceElement const& element) const {
-  return boost::apply_visitor(*this, element);
+ProgramCompiler::ProgramCompiler(llvm::Module& module, Coverage coverage)
+    : module(module), coverage(coverage) {}
+
+llvm::Function* ProgramCompiler::operator()(ast::Program const& program,
+                                            std::string const& name) const {
+  llvm::BasicBlock* block = llvm::BasicBlock::Create(module.getContext(), "entry");
+  TreeCompiler compiler(module, block);
+  compiler.walk(program);
+  if (coverage == WHOLE && !compiler.complete()) {
+    block->dropAllReferences();
+    delete block;
+    return 0;
+  }
+  return Emit(block, compiler.result(), name);
 }
 
-llvm::Value* ProgramCompiler::operator()(ast::FunctionDeclaration const& function) const {
-  return llvm::ConstantPointerNull::get(
-      llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)));
+llvm::Function* ProgramCompiler::operator()(flat::Tree const& tree,
+                                            std::string const& name) const {
+  llvm::BasicBlock* block = llvm::BasicBlock::Create(module.getContext(), "entry");
+  StatementCompiler compiler(module, block);
+  llvm::Value* result = 0;
+  flat::Node const& program = tree[tree.root];
+  for (flat::Index i = 0; i < program.count; ++i)
+    result = compiler(tree, tree.child(tree.root, i));
+  if (coverage == WHOLE && !compiler.complete()) {
+    block->dropAllReferences();
+    delete block;
+    return 0;
+  }
+  return Emit(block, result, name);
 }
 
-llvm::Value* ProgramCompiler::operator()(ast::Statement const& statement) const {
-  StatementCompiler statement_compiler(context);
-  return boost::apply_visitor(statement_compiler, statement);
+// The type of the function is the one of its result, which is only known once
+// the body is compiled: block is filled first, and given to the function
+// after.
+llvm::Function* ProgramCompiler::Emit(llvm::BasicBlock* block, llvm::Value* result,
+                                      std::string const& name) const {
+  if (!result)
+    result = llvm::ConstantPointerNull::get(
+        llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(module.getContext())));
+
+  llvm::Function* function = llvm::Function::Create(
+      llvm::FunctionType::get(result->getType(), false),
+      llvm::GlobalValue::ExternalLinkage, name, &module);
+  function->getBasicBlockList().push_back(block);
+  llvm::ReturnInst::Create(module.getContext(), result, block);
+  return function;
 }
 
 } // namespace compiler
@@ -6,28 +6,38 @@
 #endif
 
 #include "kunjs/ast.h"
+#include "kunjs/flat_ast.h"
 
-#include <boost/variant/static_visitor.hpp>
-
+#include <llvm/BasicBlock.h>
+#include <llvm/Function.h>
+#include <llvm/Module.h>
 #include <llvm/Value.h>
-#include <llvm/LLVMContext.h>
 
 #include <string>
 
 namespace kunjs { namespace compiler {
 
-class ProgramCompiler : public boost::static_visitor<llvm::Value*> {
-
+// Compiles a program into a new function of module, which takes nothing and
+// returns the value of the last statement: an i1, i32 or double, an i8* to
+// the characters of a string, or a null i8* for what cannot be compiled yet
+// (and for a program without statements). ASTs are walked with an
+// ast::Walker, so that deep ones do not run out of native stack.
+class ProgramCompiler {
  public:
-  ProgramCompiler(llvm::LLVMContext& context);
-  llvm::Value* operator()(ast::Program const& node) const;
-  llvm::Value* operator()(ast::SourceElement const& node) const;
-  llvm::Value* operator()(ast::FunctionDeclaration const& node) const;
-  llvm::Value* operator()(std::vector<ast::Statement> const& list) const;
-  llvm::Value* operator()(ast::Statement const& node) const;
+  // What a program that cannot be compiled in full compiles to: a function
+  // where null stands for the rest (PARTIAL), or none at all (WHOLE), for
+  // callers that need the same results as the Interpreter.
+  enum Coverage { PARTIAL, WHOLE };
+
+  explicit ProgramCompiler(llvm::Module& module, Coverage coverage = PARTIAL);
+  llvm::Function* operator()(ast::Program const& program, std::string const& name = "program") const;
+  llvm::Function* operator()(flat::Tree const& tree, std::string const& name = "program") const;
 
  private:
-  llvm::LLVMContext& context;
+  llvm::Function* Emit(llvm::BasicBlock* block, llvm::Value* result, std::string const& name) const;
+
+  llvm::Module& module;
+  Coverage coverage;
 };
 
 } // namespace compiler
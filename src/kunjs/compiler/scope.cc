@@ -0,0 +1,65 @@
+#include "kunjs/compiler/scope.h"
+#include "kunjs/ast_walker.h"
+
+#include <boost/variant/get.hpp>
+
+#include <map>
+#include <utility>
+
+namespace kunjs { namespace compiler {
+
+namespace {
+
+class Declarations : public ast::Walker<Declarations> {
+ public:
+  using ast::Walker<Declarations>::enter;
+
+  explicit Declarations(std::map<Atom, std::size_t>& slots) : slots(slots) {}
+
+  bool enter(ast::VarDeclaration const& declaration) {
+    Declare(declaration.name);
+    return true;
+  }
+  bool enter(ast::Assignment const& assignment) {
+    Declare(assignment.target);
+    return true;
+  }
+  bool enter(ast::UnaryExpression const& unary) {
+    if (unary.operator_ == ast::op::INC || unary.operator_ == ast::op::DEC)
+      Declare(unary.operand);
+    return true;
+  }
+  bool enter(ast::PostfixExpression const& postfix) {
+    Declare(postfix.operand);
+    return true;
+  }
+
+  bool enter(ast::FunctionDeclaration const&) { return false; }
+  bool enter(ast::FunctionExpression const&) { return false; }
+
+ private:
+  void Declare(Atom name) { slots.insert(std::make_pair(name, slots.size())); }
+
+  // a name being assigned; members are not variables
+  void Declare(ast::AssignmentExpression const& target) {
+    if (Atom const* name = boost::get<Atom>(&target))
+      Declare(*name);
+  }
+
+  std::map<Atom, std::size_t>& slots;
+};
+
+}
+
+Scope::Scope(ast::Program const& program) {
+  Declarations declarations(slots);
+  declarations.walk(program);
+}
+
+std::size_t Scope::find(Atom name) const {
+  std::map<Atom, std::size_t>::const_iterator slot = slots.find(name);
+  return slot == slots.end() ? NONE : slot->second;
+}
+
+} // namespace compiler
+} // namespace kunjs
@@ -0,0 +1,38 @@
+#ifndef KUNJS_COMPILER_SCOPE_H_
+#define KUNJS_COMPILER_SCOPE_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "kunjs/ast.h"
+
+#include <cstddef>
+#include <map>
+
+namespace kunjs { namespace compiler {
+
+// The variables of a program: the names it declares with var, and the ones
+// it assigns, increments or decrements without declaring them, which are
+// global. Each has a slot of its own, numbered from 0 in the order the names
+// first appear. Functions are not looked into, since their variables are
+// their own.
+class Scope {
+ public:
+  static const std::size_t NONE = static_cast<std::size_t>(-1);
+
+  explicit Scope(ast::Program const& program);
+
+  // The slot of name, or NONE when it is no variable of the program.
+  std::size_t find(Atom name) const;
+
+  std::size_t size() const { return slots.size(); }
+
+ private:
+  std::map<Atom, std::size_t> slots;
+};
+
+} // namespace compiler
+} // namespace kunjs
+
+#endif // KUNJS_COMPILER_SCOPE_H_
@@ -5,9 +5,10 @@
 #pragma once
 #endif
 
-#include "kunjs/ast.h"
-#include <boost/variant/static_visitor.hpp>
+#include "kunjs/flat_ast.h"
 
+#include <llvm/BasicBlock.h>
+#include <llvm/Module.h>
 #include <llvm/Value.h>
 #include <llvm/LLVMContext.h>
 
@@ -15,35 +16,25 @@
 
 namespace kunjs { namespace compiler {
 
-class StatementCompiler : public boost::static_visitor<llvm::Value*> {
-
+// Compiles the statements of a flattened tree into instructions at the end of
+// block; ProgramCompiler compiles the ones of an AST.
+class StatementCompiler {
  public:
-  StatementCompiler(llvm::LLVMContext& context);
-  llvm::Value* operator()(ast::Expression const& expression);
-  llvm::Value* operator()(ast::Var const& var);
-  llvm::Value* operator()(ast::VarDeclaration const& var);
-  llvm::Value* operator()(ast::Noop const& noop);
-  llvm::Value* operator()(ast::If const& conditional);
-  llvm::Value* operator()(ast::DoWhile const& loop);
-  llvm::Value* operator()(ast::While const& loop);
-  llvm::Value* operator()(ast::For const& loop);
-  llvm::Value* operator()(ast::ForWithVar const& loop);
-  llvm::Value* operator()(ast::Foreach const& loop);
-  llvm::Value* operator()(ast::ForeachWithVar const& loop);
-  llvm::Value* operator()(ast::Continue const& node);
-  llvm::Value* operator()(ast::Break const& node);
-  llvm::Value* operator()(ast::Return const& node);
-  llvm::Value* operator()(ast::With const& with);
-  llvm::Value* operator()(ast::LabelledStatement const& labelled);
-  llvm::Value* operator()(ast::Switch const& conditional);
-  llvm::Value* operator()(ast::Case const& clause);
-  llvm::Value* operator()(ast::Throw const& node);
-  llvm::Value* operator()(ast::Try const& node);
-  llvm::Value* operator()(std::string const& debugger);
-  llvm::Value* operator()(std::vector<ast::Statement> const& list);
+  StatementCompiler(llvm::Module& module, llvm::BasicBlock* block);
+
+  // The statement at node in a flattened tree; 0 for a block without
+  // statements. Only expressions and blocks are compiled yet: the other
+  // statements are a null i8*, and make complete() false.
+  llvm::Value* operator()(flat::Tree const& tree, flat::Index node);
+
+  // False when some of the statements compiled to a value they do not have.
+  bool complete() const { return whole; }
 
  private:
+  llvm::Module& module;
+  llvm::BasicBlock* block;
   llvm::LLVMContext& context;
+  bool whole;
 };
 
 } // namespace compiler
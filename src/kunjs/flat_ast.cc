@@ -0,0 +1,698 @@
+#include "kunjs/flat_ast.h"
+#include "kunjs/ast_walker.h"
+
+#include <boost/static_assert.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/variant/apply_visitor.hpp>
+#include <boost/variant/static_visitor.hpp>
+
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace kunjs { namespace flat {
+
+namespace node {
+
+namespace {
+
+#define N(name) #name,
+char const* const NAMES[KIND_COUNT] = {
+  KUNJS_NODE_LIST(N)
+};
+#undef N
+
+}
+
+char const* name(Kind kind) {
+  return NAMES[kind];
+}
+
+} // namespace node
+
+void Tree::clear() {
+  root = NONE;
+  nodes.clear();
+  children.clear();
+  numbers.clear();
+  strings.clear();
+}
+
+namespace {
+
+typedef std::vector<Index> Indices;
+
+// Appends nodes to a tree.
+class Builder {
+ public:
+  explicit Builder(Tree& tree) : tree(tree) {}
+
+  Index add(node::Kind kind, Index value, Index const* children, Index count) {
+    Node added;
+    added.kind = kind;
+    added.value = value;
+    added.first = Index(tree.children.size());
+    added.count = count;
+    tree.children.insert(tree.children.end(), children, children + count);
+    tree.nodes.push_back(added);
+    return Index(tree.nodes.size() - 1);
+  }
+
+  Index add(node::Kind kind, Index value = NONE) {
+    return add(kind, value, 0, 0);
+  }
+
+  Index add(node::Kind kind, Index value, Index child) {
+    return add(kind, value, &child, 1);
+  }
+
+  Index add(node::Kind kind, Index value, Indices const& children) {
+    return add(kind, value, children.empty() ? 0 : &children[0], Index(children.size()));
+  }
+
+  Index name(Atom atom) {
+    return atom.id;
+  }
+
+  Index number(ast::Numeric const& number) {
+    tree.numbers.push_back(number);
+    return Index(tree.numbers.size() - 1);
+  }
+
+  Index string(ast::String const& text) {
+    tree.strings.push_back(std::string(text.data(), text.size()));
+    return Index(tree.strings.size() - 1);
+  }
+
+ private:
+  Tree& tree;
+};
+
+class LiteralFlattener : public boost::static_visitor<Index> {
+ public:
+  explicit LiteralFlattener(Builder& builder) : builder(builder) {}
+
+  Index operator()(ast::Null const&) const { return builder.add(node::NULL_LITERAL); }
+  Index operator()(bool literal) const { return builder.add(node::BOOLEAN, literal ? 1 : 0); }
+  Index operator()(ast::Numeric const& number) const { return builder.add(node::NUMBER, builder.number(number)); }
+  Index operator()(ast::String const& text) const { return builder.add(node::STRING, builder.string(text)); }
+
+ private:
+  Builder& builder;
+};
+
+// Adds the nodes as the walk leaves them, so that children come first. What
+// has been added but not yet taken by a parent is kept on a stack: a node
+// takes as its children everything added since it was entered, and leaves
+// itself in their place. A missing optional child is a NONE put on the stack
+// in its slot.
+class Flattener : public ast::Walker<Flattener> {
+ public:
+  using ast::Walker<Flattener>::leave;
+
+  explicit Flattener(Builder& builder) : builder(builder) {}
+
+  Index root() const {
+    return values.back();
+  }
+
+  template <typename Node>
+  bool enter(Node const&) {
+    marks.push_back(values.size());
+    return true;
+  }
+
+  template <typename Node>
+  void at(Node const&, std::size_t) {}
+
+  bool enter(ast::FunctionDeclaration const& function) {
+    marks.push_back(values.size());
+    values.push_back(Parameters(function.parameters));
+    return true;
+  }
+
+  void leave(ast::FunctionDeclaration const& function) {
+    Take(node::FUNCTION_DECLARATION, builder.name(function.name));
+  }
+
+  bool enter(ast::FunctionExpression const& function) {
+    marks.push_back(values.size());
+    values.push_back(Parameters(function.parameters));
+    return true;
+  }
+
+  void leave(ast::FunctionExpression const& function) {
+    Take(node::FUNCTION_EXPRESSION, function.name ? builder.name(function.name.get()) : NONE);
+  }
+
+  void leave(ast::Program const&) { Take(node::PROGRAM); }
+  void leave(ast::FunctionBody const&) { Take(node::BLOCK); }
+
+  // Statements
+
+  void leave(ast::walk::ExpressionStatement const&) { Take(node::SEQUENCE); }
+  void leave(ast::Var const&) { Take(node::VAR); }
+
+  void leave(ast::VarDeclaration const& declaration) {
+    Take(node::VAR_DECLARATION, builder.name(declaration.name));
+  }
+
+  bool enter(ast::Noop const&) { return Leaf(node::EMPTY); }
+  void leave(ast::Block const&) { Take(node::BLOCK); }
+
+  void at(ast::If const& conditional, std::size_t slot) {
+    if (slot == 2 && !conditional.false_clause) values.push_back(NONE);
+  }
+
+  void leave(ast::If const&) { Take(node::IF); }
+  void leave(ast::DoWhile const&) { Take(node::DO_WHILE); }
+  void leave(ast::While const&) { Take(node::WHILE); }
+
+  void at(ast::For const& loop, std::size_t slot) {
+    if ((slot == 0 && !loop.initialization) || (slot == 1 && !loop.condition)
+        || (slot == 2 && !loop.action))
+      values.push_back(NONE);
+  }
+
+  void leave(ast::For const&) { Take(node::FOR); }
+
+  void at(ast::ForWithVar const& loop, std::size_t slot) {
+    if ((slot == 1 && !loop.condition) || (slot == 2 && !loop.action))
+      values.push_back(NONE);
+  }
+
+  void leave(ast::ForWithVar const&) { Take(node::FOR_WITH_VAR); }
+  void leave(ast::Foreach const&) { Take(node::FOR_IN); }
+  void leave(ast::ForeachWithVar const&) { Take(node::FOR_IN_WITH_VAR); }
+
+  bool enter(ast::Continue const& statement) {
+    return Leaf(node::CONTINUE, statement.label ? builder.name(statement.label.get()) : NONE);
+  }
+
+  bool enter(ast::Break const& statement) {
+    return Leaf(node::BREAK, statement.label ? builder.name(statement.label.get()) : NONE);
+  }
+
+  void at(ast::Return const& statement, std::size_t) {
+    if (!statement.expression) values.push_back(NONE);
+  }
+
+  void leave(ast::Return const&) { Take(node::RETURN); }
+  void leave(ast::With const&) { Take(node::WITH); }
+
+  void leave(ast::LabelledStatement const& labelled) {
+    Take(node::LABELLED, builder.name(labelled.label));
+  }
+
+  // The clauses keep their source order, whether they come before or after
+  // the default one.
+  void leave(ast::Switch const&) { Take(node::SWITCH); }
+  void leave(ast::Case const&) { Take(node::CASE); }
+  void leave(ast::walk::Default const&) { Take(node::DEFAULT); }
+  void leave(ast::Throw const&) { Take(node::THROW); }
+
+  void at(ast::Try const& statement, std::size_t slot) {
+    if ((slot == 1 && !statement.catch_block) || (slot == 2 && !statement.finally_block))
+      values.push_back(NONE);
+  }
+
+  void leave(ast::Try const&) { Take(node::TRY); }
+
+  void leave(ast::Catch const& clause) {
+    Take(node::CATCH, builder.name(clause.exception_name));
+  }
+
+  void leave(ast::walk::Finally const&) { Take(node::BLOCK); }
+  bool enter(ast::walk::Debugger const&) { return Leaf(node::DEBUGGER); }
+
+  // Expressions
+
+  void leave(ast::Expression const&) { Take(node::SEQUENCE); }
+
+  bool enter(Atom identifier) { return Leaf(node::NAME, builder.name(identifier)); }
+  bool enter(ast::This const&) { return Leaf(node::THIS); }
+
+  bool enter(ast::Literal const& literal) {
+    values.push_back(boost::apply_visitor(LiteralFlattener(builder), literal));
+    return false;
+  }
+
+  void leave(ast::walk::Parenthesized const&) { Take(node::SEQUENCE); }
+  void leave(ast::ArrayLiteral const&) { Take(node::ARRAY); }
+
+  void leave(ast::UnaryExpression const& expression) { Take(node::UNARY, expression.operator_); }
+  void leave(ast::PostfixExpression const& expression) { Take(node::POSTFIX, expression.operator_); }
+  void leave(ast::BinaryExpression const& expression) { Take(node::BINARY, expression.operator_); }
+  void leave(ast::ConditionalExpression const&) { Take(node::CONDITIONAL); }
+  void leave(ast::Assignment const& expression) { Take(node::ASSIGNMENT, expression.operator_); }
+
+  // Every modifier wraps what came before it: `a.b(c)[d]` is
+  // INDEX(CALL(MEMBER b(NAME a), NAME c), SEQUENCE(NAME d)). Calls and
+  // accesses are what their last modifier made of them, and take nothing.
+  bool enter(ast::CallExpression const&) {
+    invocations.push_back(node::CALL);
+    return true;
+  }
+
+  void leave(ast::CallExpression const&) {
+    invocations.pop_back();
+  }
+
+  bool enter(ast::MemberAccess const&) { return true; }
+  void leave(ast::MemberAccess const&) {}
+
+  bool enter(ast::Instantiation const&) {
+    invocations.push_back(node::NEW);
+    return true;
+  }
+
+  void leave(ast::Instantiation const&) {
+    invocations.pop_back();
+  }
+
+  // Arguments take the callee before them too, as a CALL or, those of an
+  // instantiation, as a NEW.
+  bool enter(ast::Arguments const&) {
+    marks.push_back(values.size() - 1);
+    return true;
+  }
+
+  void leave(ast::Arguments const&) {
+    Take(invocations.back());
+  }
+
+  void leave(ast::walk::Subscript const&) {
+    Take(node::SEQUENCE);
+    Wrap(node::INDEX, NONE, 2);
+  }
+
+  bool enter(ast::walk::Property const& property) {
+    Wrap(node::MEMBER, builder.name(property.name), 1);
+    return false;
+  }
+
+  // `new new a` has no arguments for either constructor.
+  bool enter(ast::NewExpression const&) { return true; }
+
+  void leave(ast::NewExpression const& expression) {
+    for (std::size_t i = 0; i < expression.operators.size(); ++i)
+      Wrap(node::NEW, NONE, 1);
+  }
+
+ private:
+  bool Leaf(node::Kind kind, Index value = NONE) {
+    values.push_back(builder.add(kind, value));
+    return false;
+  }
+
+  // Adds a node of what was added since the last mark.
+  void Take(node::Kind kind, Index value = NONE) {
+    std::size_t mark = marks.back();
+    marks.pop_back();
+    Index added = builder.add(kind, value, values.empty() ? 0 : &values[0] + mark,
+                              Index(values.size() - mark));
+    values.resize(mark);
+    values.push_back(added);
+  }
+
+  // Adds a node of the last count nodes added.
+  void Wrap(node::Kind kind, Index value, std::size_t count) {
+    marks.push_back(values.size() - count);
+    Take(kind, value);
+  }
+
+  Index Parameters(ast::List<Atom>::type const& parameters) {
+    Indices children;
+    children.reserve(parameters.size());
+    for (ast::List<Atom>::type::const_iterator it = parameters.begin(); it != parameters.end(); ++it)
+      children.push_back(builder.add(node::NAME, builder.name(*it)));
+    return builder.add(node::PARAMETERS, NONE, children);
+  }
+
+  Builder& builder;
+  Indices values;
+  std::vector<std::size_t> marks;
+  // Whether the arguments being flattened are those of a call or of an
+  // instantiation.
+  std::vector<node::Kind> invocations;
+};
+
+// Kinds whose value is an atom (or NONE).
+bool IsNamed(node::Kind kind) {
+  switch (kind) {
+    case node::FUNCTION_DECLARATION: case node::FUNCTION_EXPRESSION:
+    case node::VAR_DECLARATION: case node::CONTINUE: case node::BREAK:
+    case node::LABELLED: case node::CATCH: case node::NAME: case node::MEMBER:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsOperation(node::Kind kind) {
+  return kind == node::UNARY || kind == node::POSTFIX || kind == node::BINARY ||
+         kind == node::ASSIGNMENT;
+}
+
+void Print(std::ostream& out, Tree const& tree, Index index, int depth) {
+  out << std::string(2 * depth, ' ');
+  if (index == NONE) {
+    out << "-" << std::endl;
+    return;
+  }
+
+  Node const& current = tree[index];
+  out << node::name(current.kind);
+  if (IsNamed(current.kind) && current.value != NONE)
+    out << " " << tree.atoms->name(Atom(current.value));
+  else if (IsOperation(current.kind))
+    out << " " << ast::op::spelling(ast::Operator(current.value));
+
+  switch (current.kind) {
+    case node::BOOLEAN:
+      out << (current.value ? " true" : " false");
+      break;
+    case node::NUMBER:
+      out << " " << tree.numbers[current.value];
+      break;
+    case node::STRING:
+      out << " '" << tree.strings[current.value] << "'";
+      break;
+    default:
+      break;
+  }
+  out << std::endl;
+
+  for (Index i = 0; i < current.count; ++i)
+    Print(out, tree, tree.child(index, i), depth + 1);
+}
+
+}
+
+void flatten(ast::Program const& program, AtomTable const& atoms, Tree& tree) {
+  tree.clear();
+  tree.atoms = &atoms;
+  Builder builder(tree);
+  Flattener flattener(builder);
+  flattener.walk(program);
+  tree.root = flattener.root();
+}
+
+namespace {
+
+const boost::uint32_t MAGIC = 0x4653544bu; // "KTSF" read in little endian
+
+// Nodes are written as they are in memory.
+BOOST_STATIC_ASSERT(sizeof(Node) == 16);
+
+// What write() puts in front of the tables. Counts are in elements; the
+// nodes come right after it, at an offset that keeps them aligned.
+struct Header {
+  boost::uint32_t magic;
+  boost::uint32_t version;
+  Index root;
+  boost::uint32_t nodes;
+  boost::uint32_t children;
+  boost::uint32_t numbers;
+  boost::uint32_t names;
+  boost::uint32_t strings;
+};
+
+struct StoredNumber {
+  boost::uint32_t is_double;
+  boost::int32_t integer;
+  double real;
+};
+
+class StoreNumber : public boost::static_visitor<StoredNumber> {
+ public:
+  StoredNumber operator()(int value) const {
+    StoredNumber number = {0, value, 0};
+    return number;
+  }
+  StoredNumber operator()(double value) const {
+    StoredNumber number = {1, 0, value};
+    return number;
+  }
+};
+
+void Append(std::string& out, void const* data, std::size_t size) {
+  out.append(static_cast<char const*>(data), size);
+}
+
+void AppendText(std::string& out, std::string const& text) {
+  boost::uint32_t length = boost::uint32_t(text.size());
+  Append(out, &length, sizeof(length));
+  out += text;
+}
+
+// Walks data front to back; every read fails once one has gone past its end.
+class Reader {
+ public:
+  explicit Reader(Source data) : it(data.begin()), end(data.end()) {}
+
+  bool take(void* out, std::size_t size) {
+    if (std::size_t(end - it) < size)
+      return false;
+    std::memcpy(out, it, size);
+    it += size;
+    return true;
+  }
+
+  template <typename T>
+  bool take(std::vector<T>& out, boost::uint32_t count) {
+    if (std::size_t(end - it) / sizeof(T) < count)
+      return false;
+    out.resize(count);
+    return !count || take(&out[0], count * sizeof(T));
+  }
+
+  // A text as it is in data, which must outlive out.
+  bool take(Source& out) {
+    boost::uint32_t length;
+    if (!take(&length, sizeof(length)) || std::size_t(end - it) < length)
+      return false;
+    out = Source(it, length);
+    it += length;
+    return true;
+  }
+
+  bool take(std::string& out) {
+    Source text;
+    if (!take(text))
+      return false;
+    out.assign(text.begin(), text.end());
+    return true;
+  }
+
+  bool done() const { return it == end; }
+
+ private:
+  char const* it;
+  char const* end;
+};
+
+// How many children a node has, and which of the first ones may be NONE, as
+// the comments of KUNJS_NODE_LIST tell.
+struct Arity {
+  Index least;
+  Index most;
+  boost::uint32_t optional;
+};
+
+Arity ArityOf(node::Kind kind) {
+  const Arity none = {0, 0, 0}, one = {1, 1, 0}, two = {2, 2, 0}, three = {3, 3, 0};
+  const Arity any = {0, NONE, 0}, some = {1, NONE, 0};
+  switch (kind) {
+    case node::PROGRAM: case node::PARAMETERS: case node::VAR: case node::BLOCK:
+    case node::DEFAULT: case node::CATCH: case node::ARRAY:
+      return any;
+    case node::SWITCH: case node::CASE: case node::SEQUENCE: case node::CALL: case node::NEW:
+      return some;
+    case node::FUNCTION_DECLARATION: case node::FUNCTION_EXPRESSION: case node::DO_WHILE:
+    case node::WHILE: case node::WITH: case node::BINARY: case node::ASSIGNMENT:
+    case node::INDEX:
+      return two;
+    case node::FOR_IN: case node::FOR_IN_WITH_VAR: case node::CONDITIONAL:
+      return three;
+    case node::LABELLED: case node::THROW: case node::UNARY: case node::POSTFIX:
+    case node::MEMBER:
+      return one;
+    case node::VAR_DECLARATION: {
+      Arity initializer = {0, 1, 0};
+      return initializer;
+    }
+    case node::IF: {
+      Arity otherwise = {3, 3, 1u << 2};
+      return otherwise;
+    }
+    case node::FOR: {
+      Arity loop = {4, 4, 1u << 0 | 1u << 1 | 1u << 2};
+      return loop;
+    }
+    case node::FOR_WITH_VAR: {
+      Arity loop = {4, 4, 1u << 1 | 1u << 2};
+      return loop;
+    }
+    case node::RETURN: {
+      Arity value = {1, 1, 1u << 0};
+      return value;
+    }
+    case node::TRY: {
+      Arity clauses = {3, 3, 1u << 1 | 1u << 2};
+      return clauses;
+    }
+    default:
+      return none;
+  }
+}
+
+// Kinds whose atom may be NONE.
+bool MayBeAnonymous(node::Kind kind) {
+  return kind == node::FUNCTION_EXPRESSION || kind == node::CONTINUE || kind == node::BREAK;
+}
+
+// Checks what read() cannot trust to be right: every node has the children
+// its kind has, every value refers to an entry of its table, and every child
+// comes before its parent.
+bool IsConsistent(Tree const& tree, std::size_t names) {
+  if (tree.root >= tree.nodes.size())
+    return false;
+
+  for (Index i = 0; i < tree.nodes.size(); ++i) {
+    Node const& current = tree.nodes[i];
+    if (current.kind < 0 || current.kind >= node::KIND_COUNT)
+      return false;
+    if (current.first > tree.children.size() || tree.children.size() - current.first < current.count)
+      return false;
+    Arity arity = ArityOf(current.kind);
+    if (current.count < arity.least || current.count > arity.most)
+      return false;
+    for (Index c = 0; c < current.count; ++c) {
+      Index child = tree.children[current.first + c];
+      if (child == NONE ? c >= 32 || !(arity.optional >> c & 1) : child >= i)
+        return false;
+    }
+
+    bool valid = true;
+    if (IsNamed(current.kind))
+      valid = current.value == NONE ? MayBeAnonymous(current.kind) : current.value < names;
+    else if (IsOperation(current.kind))
+      valid = current.value < ast::op::OPERATOR_COUNT;
+    else if (current.kind == node::NUMBER)
+      valid = current.value < tree.numbers.size();
+    else if (current.kind == node::STRING)
+      valid = current.value < tree.strings.size();
+    if (!valid)
+      return false;
+  }
+  return true;
+}
+
+}
+
+void write(Tree const& tree, std::string& out) {
+  // Atoms are only meaningful to the table they came from: the names are
+  // stored instead, numbered in the order the nodes use them.
+  std::vector<Node> nodes(tree.nodes);
+  std::vector<Index> names;
+  boost::unordered_map<Index, Index> numbering;
+  for (std::vector<Node>::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+    if (!IsNamed(it->kind) || it->value == NONE)
+      continue;
+    std::pair<boost::unordered_map<Index, Index>::iterator, bool> added =
+        numbering.insert(std::make_pair(it->value, Index(names.size())));
+    if (added.second)
+      names.push_back(it->value);
+    it->value = added.first->second;
+  }
+
+  Header header;
+  header.magic = MAGIC;
+  header.version = FORMAT_VERSION;
+  header.root = tree.root;
+  header.nodes = boost::uint32_t(nodes.size());
+  header.children = boost::uint32_t(tree.children.size());
+  header.numbers = boost::uint32_t(tree.numbers.size());
+  header.names = boost::uint32_t(names.size());
+  header.strings = boost::uint32_t(tree.strings.size());
+  Append(out, &header, sizeof(header));
+
+  if (!nodes.empty())
+    Append(out, &nodes[0], nodes.size() * sizeof(Node));
+  if (!tree.children.empty())
+    Append(out, &tree.children[0], tree.children.size() * sizeof(Index));
+  for (std::size_t i = 0; i < tree.numbers.size(); ++i) {
+    StoredNumber number = boost::apply_visitor(StoreNumber(), tree.numbers[i]);
+    Append(out, &number, sizeof(number));
+  }
+  for (std::size_t i = 0; i < names.size(); ++i)
+    AppendText(out, tree.atoms->name(Atom(names[i])));
+  for (std::size_t i = 0; i < tree.strings.size(); ++i)
+    AppendText(out, tree.strings[i]);
+}
+
+bool read(Source data, AtomTable& atoms, Tree& tree) {
+  tree.clear();
+  tree.atoms = &atoms;
+
+  Reader reader(data);
+  Header header;
+  if (!reader.take(&header, sizeof(header)) || header.magic != MAGIC ||
+      header.version != FORMAT_VERSION)
+    return false;
+
+  std::vector<StoredNumber> numbers;
+  bool complete = reader.take(tree.nodes, header.nodes) &&
+                  reader.take(tree.children, header.children) &&
+                  reader.take(numbers, header.numbers);
+
+  // interned once the whole tree is known to be good; counts are grown to
+  // rather than trusted, as data can be too short for them
+  std::vector<Source> names;
+  Source name;
+  for (boost::uint32_t i = 0; complete && i < header.names; ++i) {
+    complete = reader.take(name);
+    names.push_back(name);
+  }
+  for (boost::uint32_t i = 0; complete && i < header.strings; ++i) {
+    tree.strings.push_back(std::string());
+    complete = reader.take(tree.strings.back());
+  }
+
+  if (complete) {
+    tree.numbers.reserve(numbers.size());
+    for (std::size_t i = 0; i < numbers.size(); ++i) {
+      if (numbers[i].is_double)
+        tree.numbers.push_back(numbers[i].real);
+      else
+        tree.numbers.push_back(int(numbers[i].integer));
+    }
+    tree.root = header.root;
+  }
+
+  if (!complete || !reader.done() || !IsConsistent(tree, names.size())) {
+    tree.clear();
+    return false;
+  }
+
+  std::vector<Atom> interned;
+  interned.reserve(names.size());
+  for (std::size_t i = 0; i < names.size(); ++i)
+    interned.push_back(atoms.intern(names[i].begin(), names[i].end()));
+  for (std::vector<Node>::iterator it = tree.nodes.begin(); it != tree.nodes.end(); ++it) {
+    if (IsNamed(it->kind) && it->value != NONE)
+      it->value = interned[it->value].id;
+  }
+  return true;
+}
+
+std::ostream& operator<<(std::ostream& out, Tree const& tree) {
+  if (tree.root != NONE)
+    Print(out, tree, tree.root, 0);
+  return out;
+}
+
+} // namespace flat
+} // namespace kunjs
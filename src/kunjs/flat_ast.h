@@ -0,0 +1,156 @@
+#ifndef KUNJS_FLAT_AST_H_
+#define KUNJS_FLAT_AST_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "kunjs/ast.h"
+#include "kunjs/atom.h"
+#include "kunjs/source.h"
+
+#include <boost/cstdint.hpp>
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// A compact form of ast::Program: every node lives in one array and refers
+// to its children by index, so a pass over the tree walks a few contiguous
+// arrays instead of chasing the variants' pointers, and the tree can be
+// copied or written out as plain data.
+
+namespace kunjs { namespace flat {
+
+typedef boost::uint32_t Index;
+
+// Missing optional child, or a node without a value.
+const Index NONE = 0xffffffffu;
+
+namespace node {
+
+// N(name) for every node kind. The comment after each one tells what its
+// value is ("atom" is the id of an Atom of Tree::atoms, "operator" an
+// ast::Operator, and the other names side tables of Tree) and which children
+// it has, in order; "?" marks a child that may be NONE and "..." any number
+// of them.
+#define KUNJS_NODE_LIST(N)                                                 \
+  N(PROGRAM)              /* statements... */                              \
+  N(FUNCTION_DECLARATION) /* atom: PARAMETERS, BLOCK */                    \
+  N(FUNCTION_EXPRESSION)  /* atom or NONE: PARAMETERS, BLOCK */            \
+  N(PARAMETERS)           /* NAME... */                                    \
+  /* statements */                                                         \
+  N(VAR)                  /* VAR_DECLARATION... */                         \
+  N(VAR_DECLARATION)      /* atom: initializer? */                         \
+  N(EMPTY)                                                                 \
+  N(BLOCK)                /* statements... */                              \
+  N(IF)                   /* condition, statement, else? */                \
+  N(DO_WHILE)             /* statement, condition */                       \
+  N(WHILE)                /* condition, statement */                       \
+  N(FOR)                  /* init?, condition?, action?, statement */      \
+  N(FOR_WITH_VAR)         /* VAR, condition?, action?, statement */        \
+  N(FOR_IN)               /* item, list, statement */                      \
+  N(FOR_IN_WITH_VAR)      /* VAR_DECLARATION, list, statement */           \
+  N(CONTINUE)             /* atom or NONE */                               \
+  N(BREAK)                /* atom or NONE */                               \
+  N(RETURN)               /* expression? */                                \
+  N(WITH)                 /* context, statement */                         \
+  N(LABELLED)             /* atom: statement */                            \
+  N(SWITCH)               /* condition, CASE or DEFAULT... */              \
+  N(CASE)                 /* match, statements... */                       \
+  N(DEFAULT)              /* statements... */                              \
+  N(THROW)                /* expression */                                 \
+  N(TRY)                  /* BLOCK, CATCH?, BLOCK? */                      \
+  N(CATCH)                /* atom: statements... */                        \
+  N(DEBUGGER)                                                              \
+  /* expressions */                                                        \
+  N(SEQUENCE)             /* expressions... (comma, parentheses) */        \
+  N(ARRAY)                /* elements... */                                \
+  N(NAME)                 /* atom */                                       \
+  N(THIS)                                                                  \
+  N(NULL_LITERAL)                                                          \
+  N(BOOLEAN)              /* 0 or 1 */                                     \
+  N(NUMBER)               /* numbers */                                    \
+  N(STRING)               /* strings */                                    \
+  N(UNARY)                /* operator: operand */                          \
+  N(POSTFIX)              /* operator: operand */                          \
+  N(BINARY)               /* operator: lhs, rhs */                         \
+  N(CONDITIONAL)          /* condition, true clause, false clause */       \
+  N(ASSIGNMENT)           /* operator: target, value */                    \
+  N(CALL)                 /* callee, arguments... */                       \
+  N(NEW)                  /* constructor, arguments... */                  \
+  N(MEMBER)               /* atom: object */                               \
+  N(INDEX)                /* object, SEQUENCE */
+
+enum Kind {
+#define N(name) name,
+  KUNJS_NODE_LIST(N)
+#undef N
+  KIND_COUNT
+};
+
+char const* name(Kind kind);
+
+} // namespace node
+
+// 16 bytes per node. Its children are the count entries of Tree::children
+// starting at first.
+struct Node {
+  node::Kind kind;
+  Index value;
+  Index first;
+  Index count;
+};
+
+class Tree {
+ public:
+  Tree() : root(NONE), atoms(0) {}
+
+  Node const& operator[](Index index) const { return nodes[index]; }
+
+  // i-th child of node; NONE for a missing optional one.
+  Index child(Index node, Index i) const { return children[nodes[node].first + i]; }
+
+  void clear();
+
+  // Nodes come after their children, so the root is the last one.
+  Index root;
+  std::vector<Node> nodes;
+  std::vector<Index> children;
+
+  // Table of the program's names: identifiers, labels and property names.
+  AtomTable const* atoms;
+
+  // Side tables the literals' values refer to.
+  std::vector<ast::Numeric> numbers;
+  std::vector<std::string> strings;
+};
+
+// Replaces the contents of tree with program, whose names are atoms of
+// atoms (which must outlive the tree).
+void flatten(ast::Program const& program, AtomTable const& atoms, Tree& tree);
+
+// Version of the format write() produces. Bump it whenever Node, the node
+// kinds or the operators change: read() rejects data of any other version.
+const boost::uint32_t FORMAT_VERSION = 2;
+
+// Appends tree to out as plain data: a header, then the nodes and the
+// children exactly as they are in memory, then the numbers, the names the
+// tree uses and the strings. Numbers are in the byte order of the machine,
+// and read() rejects data written on a machine of the other order.
+void write(Tree const& tree, std::string& out);
+
+// Replaces the contents of tree with a tree written by write(). Its names
+// are interned into atoms, which becomes the tree's table. The nodes and the
+// children are copied out in one go, so data can be a MappedFile's source.
+// False, leaving tree empty, when data is of another version or is not a
+// whole, consistent tree.
+bool read(Source data, AtomTable& atoms, Tree& tree);
+
+// One node per line, children indented under their parent.
+std::ostream& operator<<(std::ostream& out, Tree const& tree);
+
+} // namespace flat
+} // namespace kunjs
+
+#endif // KUNJS_FLAT_AST_H_
@@ -1,350 +1,1005 @@
 #include "kunjs/grammar.h"
+#include "kunjs/grammar_profile.h"
+#include "kunjs/in_place_parser.h"
+#include "kunjs/lexer.h"
+#include "kunjs/token_parser.h"
 
 #include <boost/spirit/include/qi_operator.hpp>
-#include <boost/spirit/include/qi_lit.hpp>
-#include <boost/spirit/include/qi_lexeme.hpp>
-#include <boost/spirit/include/qi_raw.hpp>
-#include <boost/spirit/include/qi_eol.hpp>
-#include <boost/spirit/include/qi_eps.hpp>
-#include <boost/spirit/include/qi_int.hpp>
-#include <boost/spirit/include/qi_real.hpp>
-#include <boost/spirit/include/qi_bool.hpp>
-#include <boost/spirit/include/qi_lazy.hpp>
 #include <boost/spirit/include/qi_action.hpp>
+#include <boost/spirit/home/qi/nonterminal/debug_handler.hpp>
+#include <boost/move/utility_core.hpp>
+#include <boost/type_traits/is_base_of.hpp>
+#include <boost/variant/apply_visitor.hpp>
+#include <boost/variant/static_visitor.hpp>
+
+#include <cassert>
 
 namespace kunjs {
 
-using qi::lit;
-using qi::lexeme;
-using qi::raw;
-using qi::eol;
-using qi::eps;
 using qi::_val;
 using qi::_1;
-using qi::_2;
-using qi::_3;
-using qi::_4;
-using qi::on_error;
-using qi::fail;
-using qi::int_;
-using qi::double_;
-using qi::bool_;
-using boost::phoenix::function;
 using boost::phoenix::construct;
-using ascii::string;
-using ascii::char_;
-using ascii::alpha;
-using ascii::alnum;
-
-struct error_handler_ {
-  template <typename, typename, typename>
-  struct result { typedef void type; };
-
-  template <typename Iterator>
-  void operator()(qi::info const& what, Iterator err_pos, Iterator last) const {
-    std::cout
-        << "Error! Expecting "
-        << what
-        << " here: \""
-        << std::string(err_pos, last)
-        << "\""
-        << std::endl;
+
+namespace {
+
+// Where the token at it starts in the whole source (see ast::Located).
+template <typename Iterator>
+boost::uint32_t Offset(Iterator const& it) {
+  return it.stream().origin + it->offset;
+}
+
+// Records where node starts, for the kinds of node that keep it.
+template <typename T>
+void Locate(T& node, boost::uint32_t offset, boost::true_type) {
+  node.offset = offset;
+}
+
+template <typename T>
+void Locate(T&, boost::uint32_t, boost::false_type) {}
+
+template <typename T>
+void Locate(T& node, boost::uint32_t offset) {
+  Locate(node, offset, boost::is_base_of<ast::Located, T>());
+}
+
+// Statements start with a keyword far more often than not, so instead of
+// trying the statement rules in order the first token picks the one rule
+// that can match. Only labels and `for` headers need to look further ahead,
+// and they never look past the header. No statement is parsed twice, and
+// the chosen rule builds its node in place, inside the Statement variant.
+template <typename Iterator>
+struct statement_parser : qi::primitive_parser<statement_parser<Iterator> > {
+  template <typename Context, typename It>
+  struct attribute { typedef ast::Statement type; };
+
+  explicit statement_parser(javascript_grammar<Iterator> const& grammar)
+      : grammar(grammar) {}
+
+  template <typename Context, typename Skipper>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const&, ast::Statement& attr) const {
+    if (first == last)
+      return false;
+
+    javascript_grammar<Iterator> const& g = grammar;
+    Iterator it = first;
+    bool matched = false;
+
+    switch (it->kind) {
+      case token::VAR: matched = ParseInto(g.variable_statement, it, last, attr); break;
+      case token::SEMICOLON: matched = ParseInto(g.empty_statement, it, last, attr); break;
+      case token::IF: matched = ParseInto(g.if_statement, it, last, attr); break;
+      case token::DO: matched = ParseInto(g.do_while_statement, it, last, attr); break;
+      case token::WHILE: matched = ParseInto(g.while_statement, it, last, attr); break;
+      case token::CONTINUE: matched = ParseInto(g.continue_statement, it, last, attr); break;
+      case token::BREAK: matched = ParseInto(g.break_statement, it, last, attr); break;
+      case token::RETURN: matched = ParseInto(g.return_statement, it, last, attr); break;
+      case token::WITH: matched = ParseInto(g.with_statement, it, last, attr); break;
+      case token::SWITCH: matched = ParseInto(g.switch_statement, it, last, attr); break;
+      case token::THROW: matched = ParseInto(g.throw_statement, it, last, attr); break;
+      case token::TRY: matched = ParseInto(g.try_statement, it, last, attr); break;
+      case token::DEBUGGER: matched = ParseInto(g.debugger_statement, it, last, attr); break;
+      case token::LBRACE: matched = ParseInto(g.block, it, last, attr); break;
+
+      case token::FOR:
+        if (IsVarHeader(it, last)) {
+          if (HasClauses(it, last))
+            matched = ParseInto(g.for_with_var_statement, it, last, attr);
+          else
+            matched = ParseInto(g.foreach_with_var_statement, it, last, attr);
+        } else {
+          if (HasClauses(it, last))
+            matched = ParseInto(g.for_statement, it, last, attr);
+          else
+            matched = ParseInto(g.foreach_statement, it, last, attr);
+        }
+        break;
+
+      case token::IDENTIFIER:
+        if (last - it > 1 && it[1].kind == token::COLON)
+          matched = ParseInto(g.labelled_statement, it, last, attr);
+        else
+          matched = ParseInto(g.expression_statement, it, last, attr);
+        break;
+
+      // everything else that can start an expression; `function` cannot
+      // start an expression statement
+      case token::NUMBER: case token::STRING:
+      case token::THIS: case token::NULL_LITERAL:
+      case token::TRUE_LITERAL: case token::FALSE_LITERAL:
+      case token::LPAREN: case token::LBRACKET: case token::NEW:
+      case token::DELETE: case token::VOID: case token::TYPEOF:
+      case token::INC: case token::DEC: case token::ADD: case token::SUB:
+      case token::BIT_NOT: case token::NOT:
+        matched = ParseInto(g.expression_statement, it, last, attr);
+        break;
+
+      default:
+        break;
+    }
+
+    if (matched)
+      first = it;
+    return matched;
+  }
+
+  template <typename Context>
+  qi::info what(Context&) const {
+    return qi::info("statement");
+  }
+
+ private:
+  template <typename Rule>
+  static bool ParseInto(Rule const& rule, Iterator& first, Iterator const& last, ast::Statement& attr) {
+    typedef typename Rule::attr_type node_type;
+    attr = node_type();
+    node_type& node = boost::get<node_type>(attr);
+    boost::uint32_t offset = Offset(first);
+    if (!rule.parse(first, last, boost::spirit::unused, boost::spirit::unused, node))
+      return false;
+
+    Locate(node, offset);
+    return true;
+  }
+
+  // `for (var ...`
+  static bool IsVarHeader(Iterator it, Iterator const& last) {
+    return last - it > 2 && it[2].kind == token::VAR;
+  }
+
+  // Whether the `for` header starting at it has the three clauses of a
+  // plain for loop, rather than being a for-in: only the former has a `;`
+  // outside of any brackets. Stops at the closing parenthesis.
+  static bool HasClauses(Iterator it, Iterator const& last) {
+    int depth = 0;
+    for (++it; it != last; ++it) {
+      switch (it->kind) {
+        case token::LPAREN: case token::LBRACKET: case token::LBRACE:
+          ++depth;
+          break;
+        case token::RPAREN: case token::RBRACKET: case token::RBRACE:
+          if (--depth == 0) return false;
+          break;
+        case token::SEMICOLON:
+          if (depth == 1) return true;
+          break;
+        default:
+          break;
+      }
+    }
+    return false;
   }
+
+  javascript_grammar<Iterator> const& grammar;
 };
-const function<error_handler_> error_handler = error_handler_();
+
+// Makes node hold a default T and returns it.
+template <typename T, typename Variant>
+T& Become(Variant& node) {
+  node = T();
+  return boost::get<T>(node);
+}
+
+template <typename T>
+T& Become(ast::AssignmentExpression& node) {
+  static_cast<ast::ExpressionNode&>(node) = T();
+  return boost::get<T>(node);
+}
+
+// A function declaration or a statement, told apart by the first token.
+// Statements are parsed straight into the element, without the copy
+// `function_declaration | statement` would make of each of them.
+template <typename Iterator>
+struct source_element_parser : qi::primitive_parser<source_element_parser<Iterator> > {
+  template <typename Context, typename It>
+  struct attribute { typedef ast::SourceElement type; };
+
+  explicit source_element_parser(javascript_grammar<Iterator> const& grammar)
+      : grammar(grammar) {}
+
+  template <typename Context, typename Skipper>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const&, ast::SourceElement& attr) const {
+    if (first == last)
+      return false;
+
+    if (first->kind == token::FUNCTION) {
+      ast::FunctionDeclaration& declaration = Become<ast::FunctionDeclaration>(attr);
+      declaration.offset = Offset(first);
+      return grammar.function_declaration.parse(first, last, boost::spirit::unused, boost::spirit::unused,
+                                                declaration);
+    }
+
+    return grammar.statement.parse(first, last, boost::spirit::unused, boost::spirit::unused,
+                                   Become<ast::Statement>(attr));
+  }
+
+  template <typename Context>
+  qi::info what(Context&) const {
+    return qi::info("source_element");
+  }
+
+  javascript_grammar<Iterator> const& grammar;
+};
+
+// A function body with its braces. When the stream says so, the body is
+// only skipped over: the lexer has already dropped the comments and told
+// the strings apart, so the brace tokens are enough to find where it ends.
+// Its syntax is checked when it is parsed for real, by Parser::parse_body.
+template <typename Iterator>
+struct function_body_parser : qi::primitive_parser<function_body_parser<Iterator> > {
+  template <typename Context, typename It>
+  struct attribute { typedef ast::FunctionBody type; };
+
+  explicit function_body_parser(javascript_grammar<Iterator> const& grammar)
+      : grammar(grammar) {}
+
+  template <typename Context, typename Skipper>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const&, ast::FunctionBody& attr) const {
+    if (first == last || first->kind != token::LBRACE)
+      return false;
+
+    Iterator it = first;
+    ++it;
+    if (first.stream().skip_function_bodies) {
+      int depth = 1;
+      for (; it != last; ++it) {
+        if (it->kind == token::LBRACE)
+          ++depth;
+        else if (it->kind == token::RBRACE && --depth == 0)
+          break;
+      }
+      if (it == last)
+        throw failure(it, last, qi::info("token", token::spelling(token::RBRACE)));
+
+      boost::uint32_t start = first->offset + 1;
+      attr.lazy = true;
+      attr.source.offset = first.stream().origin + start;
+      attr.source.length = it->offset - start;
+    } else {
+      grammar.function_body.parse(it, last, boost::spirit::unused, boost::spirit::unused, attr);
+      if (it == last || it->kind != token::RBRACE)
+        throw failure(it, last, qi::info("token", token::spelling(token::RBRACE)));
+    }
+
+    first = ++it;
+    return true;
+  }
+
+  template <typename Context>
+  qi::info what(Context&) const {
+    return qi::info("token", token::spelling(token::LBRACE));
+  }
+
+ private:
+  typedef qi::expectation_failure<Iterator> failure;
+
+  javascript_grammar<Iterator> const& grammar;
+};
+
+// How tightly a binary operator binds, from 1 for || to 10 for * / %; 0
+// for anything that is not a binary operator.
+int Precedence(token::Kind kind) {
+  switch (kind) {
+    case token::OR: return 1;
+    case token::AND: return 2;
+    case token::BIT_OR: return 3;
+    case token::BIT_XOR: return 4;
+    case token::BIT_AND: return 5;
+    case token::EQ: case token::NE: case token::EQ_STRICT: case token::NE_STRICT:
+      return 6;
+    case token::LT: case token::GT: case token::LTE: case token::GTE:
+    case token::INSTANCEOF: case token::IN:
+      return 7;
+    case token::SHL: case token::SAR: case token::SHR: return 8;
+    case token::ADD: case token::SUB: return 9;
+    case token::MUL: case token::DIV: case token::MOD: return 10;
+    default: return 0;
+  }
+}
+
+// The operator spelled like an operator token. Both lists use the same
+// names, so this is a jump table built from them.
+ast::Operator OperatorOf(token::Kind kind) {
+  switch (kind) {
+#define O(name, spelling) case token::name: return ast::op::name;
+    KUNJS_OPERATOR_LIST(O)
+#undef O
+    default:
+      assert(false && "not an operator token");
+      return ast::op::OPERATOR_COUNT;
+  }
+}
+
+bool IsAssignment(token::Kind kind) {
+  return kind >= token::ASSIGN && kind <= token::ASSIGN_BIT_XOR;
+}
+
+bool IsPrefix(token::Kind kind) {
+  switch (kind) {
+    case token::DELETE: case token::VOID: case token::TYPEOF:
+    case token::INC: case token::DEC: case token::ADD: case token::SUB:
+    case token::BIT_NOT: case token::NOT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Moves the node from holds into to, leaving from with a new node of the
+// same kind. to is made to hold that kind first: a boost::variant moved into
+// one holding the same kind moves its recursive_wrapper, which swaps the
+// pointers to the nodes, so however large the subtree, nothing is copied.
+template <typename Variant>
+struct node_mover : boost::static_visitor<> {
+  node_mover(Variant& from, Variant& to) : from(from), to(to) {}
+
+  template <typename T>
+  void operator()(T const&) const {
+    Become<T>(to);
+    to = boost::move(from);
+  }
+
+  Variant& from;
+  Variant& to;
+};
+
+template <typename Variant>
+void Move(Variant& from, Variant& to) {
+  boost::apply_visitor(node_mover<Variant>(from, to), from);
+}
+
+// Makes node hold a new T whose child is the node it held, and returns the
+// T: the left operand becomes part of the operator after it.
+template <typename T, typename Variant>
+T& Wrap(Variant& node, Variant T::*child) {
+  Variant held;
+  Move(node, held);
+  T& wrapper = Become<T>(node);
+  Move(held, wrapper.*child);
+  return wrapper;
+}
+
+// Moves a primary expression, parsed as an operand, into the member access
+// it turns out to be the object of. Lists are swapped rather than copied.
+struct primary_mover : boost::static_visitor<> {
+  explicit primary_mover(ast::PrimaryExpression& to) : to(to) {}
+
+  void operator()(ast::This const& node) const { to = node; }
+  void operator()(Atom const& node) const { to = node; }
+  void operator()(ast::Literal const& node) const { to = node; }
+  void operator()(ast::Expression& node) const { Become<ast::Expression>(to).swap(node); }
+  void operator()(ast::ArrayLiteral& node) const { Become<ast::ArrayLiteral>(to).swap(node); }
+
+  template <typename T>
+  void operator()(T const&) const {
+    assert(false && "not a primary expression");
+  }
+
+  ast::PrimaryExpression& to;
+};
+
+// Parses rule into a new node of its kind, held by node.
+template <typename Rule, typename Iterator, typename Node>
+bool ParseNode(Rule const& rule, Iterator& first, Iterator const& last, Node& node) {
+  typedef typename Rule::attr_type node_type;
+  return rule.parse(first, last, boost::spirit::unused, boost::spirit::unused, Become<node_type>(node));
+}
+
+// A name, literal, `this`, array literal or parenthesized expression, into
+// node: an ast::PrimaryExpression, or the ast::AssignmentExpression it stands
+// for as an operand. Nothing else starts with `(`, so what follows one must
+// be an expression and a `)`.
+template <typename Iterator, typename Node>
+bool ParsePrimary(javascript_grammar<Iterator> const& g, Iterator& first, Iterator const& last,
+                  Node& node) {
+  typedef qi::expectation_failure<Iterator> failure;
+
+  if (first == last)
+    return false;
+
+  switch (first->kind) {
+    case token::IDENTIFIER:
+      return ParseNode(g.identifier, first, last, node);
+    case token::THIS:
+      Become<ast::This>(node);
+      ++first;
+      return true;
+    case token::NUMBER: case token::STRING: case token::NULL_LITERAL:
+    case token::TRUE_LITERAL: case token::FALSE_LITERAL:
+      return ParseNode(g.literal, first, last, node);
+    case token::LBRACKET:
+      return ParseNode(g.array_literal, first, last, node);
+    case token::LPAREN: {
+      Iterator it = first;
+      ++it;
+      if (!ParseNode(g.expression, it, last, node))
+        throw failure(it, last, qi::info("expression"));
+      if (it == last || it->kind != token::RPAREN)
+        throw failure(it, last, qi::info("token", token::spelling(token::RPAREN)));
+      first = ++it;
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// `[a, , b]`, each element parsed where it ends up. Holes are not kept, and
+// there is at least one element. Once past the `[`, the literal must be
+// complete.
+template <typename Iterator>
+struct array_literal_parser : qi::primitive_parser<array_literal_parser<Iterator> > {
+  typedef qi::expectation_failure<Iterator> failure;
+
+  template <typename Context, typename It>
+  struct attribute { typedef ast::ArrayLiteral type; };
+
+  explicit array_literal_parser(javascript_grammar<Iterator> const& grammar)
+      : grammar(grammar) {}
+
+  template <typename Context, typename Skipper>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const&, ast::ArrayLiteral& attr) const {
+    if (first == last || first->kind != token::LBRACKET)
+      return false;
+
+    Iterator it = SkipCommas(first + 1, last);
+    ParseElement(it, last, attr);
+
+    while (it != last && it->kind == token::COMMA) {
+      it = SkipCommas(it, last);
+      if (it != last && it->kind == token::RBRACKET)
+        break;
+      ParseElement(it, last, attr);
+    }
+    if (it == last || it->kind != token::RBRACKET)
+      throw failure(it, last, qi::info("token", token::spelling(token::RBRACKET)));
+
+    first = ++it;
+    return true;
+  }
+
+  template <typename Context>
+  qi::info what(Context&) const {
+    return qi::info("array_literal");
+  }
+
+ private:
+  void ParseElement(Iterator& it, Iterator const& last, ast::ArrayLiteral& attr) const {
+    if (!detail::ParseBack(grammar.assignment_expression, it, last, attr))
+      throw failure(it, last, qi::info("assignment_expression"));
+  }
+
+  static Iterator SkipCommas(Iterator it, Iterator const& last) {
+    while (it != last && it->kind == token::COMMA)
+      ++it;
+    return it;
+  }
+
+  javascript_grammar<Iterator> const& grammar;
+};
+
+// Call and new expressions, in one pass over their tokens: the `new`
+// operators they start with are counted, then the member expression after
+// them is parsed, and what comes after it tells what it is part of.
+// Arguments go to the innermost `new` still without any, as in
+// `new new A()()`; each `new` left without is an operator of a
+// NewExpression, and arguments after a member whose every `new` has some
+// make a call of it. Node is either an ast::LhsExpression or, for an operand
+// in a larger expression, the ast::AssignmentExpression it stands for.
+template <typename Iterator>
+struct lhs_parser : qi::primitive_parser<lhs_parser<Iterator> > {
+  typedef qi::expectation_failure<Iterator> failure;
+
+  template <typename Context, typename It>
+  struct attribute { typedef ast::LhsExpression type; };
+
+  explicit lhs_parser(javascript_grammar<Iterator> const& grammar)
+      : grammar(grammar) {}
+
+  template <typename Context, typename Skipper, typename Node>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const&, Node& node) const {
+    Iterator it = first;
+    std::size_t news = 0;
+    for (; it != last && it->kind == token::NEW; ++it)
+      ++news;
+
+    ast::MemberExpression member;
+    ast::MemberAccess& access = boost::get<ast::MemberAccess>(member);
+    if (!ParseObject(it, last, access.member))
+      return false;
+    ParseModifiers(it, last, access.modifiers);
+    if (!Finish(first, it, last, news, member, node))
+      return false;
+
+    first = it;
+    return true;
+  }
+
+  // node holds the primary expression parsed from first to it. When
+  // something is accessed or called on it, makes node the call or new
+  // expression it is the object of, and moves it past that.
+  bool parse_object_of(Iterator const& first, Iterator& it, Iterator const& last,
+                       ast::AssignmentExpression& node) const {
+    if (it == last || (it->kind != token::DOT && it->kind != token::LBRACKET && it->kind != token::LPAREN))
+      return true;
+
+    ast::MemberExpression member;
+    ast::MemberAccess& access = boost::get<ast::MemberAccess>(member);
+    boost::apply_visitor(primary_mover(Become<ast::PrimaryExpression>(access.member)), node);
+    ParseModifiers(it, last, access.modifiers);
+    return Finish(first, it, last, 0, member, node);
+  }
+
+  template <typename Context>
+  qi::info what(Context&) const {
+    return qi::info("lhs_expression");
+  }
+
+ private:
+  bool ParseObject(Iterator& it, Iterator const& last, ast::MemberOptions& object) const {
+    if (it == last || it->kind != token::FUNCTION)
+      return ParsePrimary(grammar, it, last, Become<ast::PrimaryExpression>(object));
+
+    ast::FunctionExpression& function = Become<ast::FunctionExpression>(object);
+    function.offset = Offset(it);
+    return grammar.function_expression.parse(it, last, boost::spirit::unused, boost::spirit::unused,
+                                             function);
+  }
+
+  template <typename Modifiers>
+  void ParseModifiers(Iterator& it, Iterator const& last, Modifiers& modifiers) const {
+    while (ParseModifier(it, last, modifiers)) {}
+  }
+
+  // One `.name` or `[expression]`, at the end of modifiers. Once past the
+  // `.` or the `[`, the modifier must be complete.
+  template <typename Modifiers>
+  bool ParseModifier(Iterator& it, Iterator const& last, Modifiers& modifiers) const {
+    if (it == last || (it->kind != token::DOT && it->kind != token::LBRACKET))
+      return false;
+
+    Iterator next = it;
+    ++next;
+    modifiers.push_back(typename Modifiers::value_type());
+    if (it->kind == token::DOT) {
+      if (!ParseNode(grammar.identifier_name, next, last, modifiers.back()))
+        throw failure(next, last, qi::info("identifier_name"));
+    } else {
+      if (!ParseNode(grammar.expression, next, last, modifiers.back()))
+        throw failure(next, last, qi::info("expression"));
+      if (next == last || next->kind != token::RBRACKET)
+        throw failure(next, last, qi::info("token", token::spelling(token::RBRACKET)));
+      ++next;
+    }
+
+    it = next;
+    return true;
+  }
+
+  // Makes node what member, parsed from first to it after news `new`
+  // operators, is part of.
+  template <typename Node>
+  bool Finish(Iterator const& first, Iterator& it, Iterator const& last, std::size_t news,
+              ast::MemberExpression& member, Node& node) const {
+    for (; news > 0 && it != last && it->kind == token::LPAREN; --news) {
+      ast::Instantiation& instantiation = Wrap(member, &ast::Instantiation::member);
+      instantiation.offset = Offset(first + (news - 1));
+      if (!grammar.arguments.parse(it, last, boost::spirit::unused, boost::spirit::unused,
+                                   instantiation.arguments))
+        return false;
+    }
+
+    if (news == 0 && it != last && it->kind == token::LPAREN) {
+      ast::CallExpression& call = Become<ast::CallExpression>(node);
+      call.offset = Offset(first);
+      Move(member, call.target);
+      if (!grammar.arguments.parse(it, last, boost::spirit::unused, boost::spirit::unused, call.arguments))
+        return false;
+      ParseCallModifiers(it, last, call.modifiers);
+      return true;
+    }
+
+    ast::NewExpression& expression = Become<ast::NewExpression>(node);
+    expression.offset = Offset(first);
+    expression.operators.assign(news, ast::op::NEW);
+    Move(member, expression.member);
+    return true;
+  }
+
+  void ParseCallModifiers(Iterator& it, Iterator const& last,
+                          ast::List<ast::CallModifiers>::type& modifiers) const {
+    for (;;) {
+      if (it == last || it->kind != token::LPAREN) {
+        if (!ParseModifier(it, last, modifiers))
+          return;
+        continue;
+      }
+
+      modifiers.push_back(ast::Arguments());
+      if (!grammar.arguments.parse(it, last, boost::spirit::unused, boost::spirit::unused,
+                                   boost::get<ast::Arguments>(modifiers.back()))) {
+        modifiers.pop_back();
+        return;
+      }
+    }
+  }
+
+  javascript_grammar<Iterator> const& grammar;
+};
+
+// Assignment, conditional, binary, unary and postfix expressions, by
+// precedence climbing over the tokens, in one pass: an operand is parsed,
+// then every binary operator after it that binds at least as tightly as the
+// caller allows takes it as its left operand, and parses its right operand
+// with the operators that bind tighter still. Each operator gets one node.
+// An operand becomes part of the operator after it by being moved into it
+// (see Wrap), which never copies its subtree.
+template <typename Iterator>
+struct expression_parser : qi::primitive_parser<expression_parser<Iterator> > {
+  template <typename Context, typename It>
+  struct attribute { typedef ast::AssignmentExpression type; };
+
+  explicit expression_parser(javascript_grammar<Iterator> const& grammar)
+      : grammar(grammar) {}
+
+  template <typename Context, typename Skipper>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const&, ast::AssignmentExpression& attr) const {
+    return ParseAssignment(first, last, attr);
+  }
+
+  template <typename Context>
+  qi::info what(Context&) const {
+    return qi::info("assignment_expression");
+  }
+
+ private:
+  typedef qi::expectation_failure<Iterator> failure;
+
+  // Only a name, a literal, a parenthesized expression, a call or a new
+  // expression is assigned to; anything else stops before the operator.
+  bool ParseAssignment(Iterator& first, Iterator const& last, ast::AssignmentExpression& out) const {
+    Iterator it = first;
+    if (!ParseConditional(it, last, out))
+      return false;
+
+    if (it != last && IsAssignment(it->kind) && IsTarget(out)) {
+      ast::Assignment& assignment = Wrap(out, &ast::Assignment::target);
+      assignment.offset = Offset(first);
+      assignment.operator_ = OperatorOf(it->kind);
+      ++it;
+      if (!ParseAssignment(it, last, assignment.value))
+        throw failure(it, last, qi::info("assignment_expression"));
+    }
+
+    first = it;
+    return true;
+  }
+
+  bool ParseConditional(Iterator& first, Iterator const& last, ast::AssignmentExpression& out) const {
+    Iterator it = first;
+    if (!ParseBinary(it, last, out, 1))
+      return false;
+
+    if (it != last && it->kind == token::CONDITIONAL) {
+      ast::ConditionalExpression& conditional = Wrap(out, &ast::ConditionalExpression::condition);
+      conditional.offset = Offset(first);
+      ++it;
+      if (!ParseAssignment(it, last, conditional.true_clause))
+        throw failure(it, last, qi::info("assignment_expression"));
+      if (it == last || it->kind != token::COLON)
+        throw failure(it, last, qi::info("token", token::spelling(token::COLON)));
+      ++it;
+      if (!ParseAssignment(it, last, conditional.false_clause))
+        throw failure(it, last, qi::info("assignment_expression"));
+    }
+
+    first = it;
+    return true;
+  }
+
+  // Operators of the same precedence are left associative: the right operand
+  // only takes the ones that bind tighter, and the loop makes the node built
+  // so far the left operand of the next one.
+  bool ParseBinary(Iterator& first, Iterator const& last, ast::AssignmentExpression& out,
+                   int min_precedence) const {
+    Iterator it = first;
+    if (!ParseUnary(it, last, out))
+      return false;
+
+    for (;;) {
+      int precedence = it != last ? Precedence(it->kind) : 0;
+      if (precedence == 0 || precedence < min_precedence)
+        break;
+
+      ast::BinaryExpression& binary = Wrap(out, &ast::BinaryExpression::lhs);
+      binary.offset = Offset(first);
+      binary.operator_ = OperatorOf(it->kind);
+      ++it;
+      if (!ParseBinary(it, last, binary.rhs, precedence + 1))
+        throw failure(it, last, qi::info("unary_expression"));
+    }
+
+    first = it;
+    return true;
+  }
+
+  bool ParseUnary(Iterator& first, Iterator const& last, ast::AssignmentExpression& out) const {
+    if (first == last || !IsPrefix(first->kind))
+      return ParsePostfix(first, last, out);
+
+    ast::UnaryExpression& unary = Become<ast::UnaryExpression>(out);
+    unary.offset = Offset(first);
+    unary.operator_ = OperatorOf(first->kind);
+    Iterator it = first;
+    ++it;
+    if (!ParseUnary(it, last, unary.operand))
+      throw failure(it, last, qi::info("unary_expression"));
+
+    first = it;
+    return true;
+  }
+
+  // No line terminator is allowed before the operator: `a\n++b` is two
+  // expressions, not `a++ b`.
+  bool ParsePostfix(Iterator& first, Iterator const& last, ast::AssignmentExpression& out) const {
+    Iterator it = first;
+    if (!ParseLeaf(it, last, out))
+      return false;
+
+    if (it != last && (it->kind == token::INC || it->kind == token::DEC) &&
+        !it.follows_line_break()) {
+      ast::PostfixExpression& postfix = Wrap(out, &ast::PostfixExpression::operand);
+      postfix.offset = Offset(first);
+      postfix.operator_ = OperatorOf(it->kind);
+      ++it;
+    }
+
+    first = it;
+    return true;
+  }
+
+  // Names, literals and parenthesized expressions are stored as they are,
+  // unless something is called or accessed on them. The first token tells
+  // which it is, so nothing is parsed twice.
+  bool ParseLeaf(Iterator& first, Iterator const& last, ast::AssignmentExpression& out) const {
+    lhs_parser<Iterator> lhs(grammar);
+    if (first != last && (first->kind == token::NEW || first->kind == token::FUNCTION))
+      return lhs.parse(first, last, boost::spirit::unused, boost::spirit::unused, out);
+
+    Iterator it = first;
+    if (!ParsePrimary(grammar, it, last, out))
+      return false;
+    if (!lhs.parse_object_of(first, it, last, out))
+      return false;
+
+    first = it;
+    return true;
+  }
+
+  struct is_target : boost::static_visitor<bool> {
+    template <typename T>
+    bool operator()(T const&) const { return true; }
+
+    bool operator()(ast::UnaryExpression const&) const { return false; }
+    bool operator()(ast::PostfixExpression const&) const { return false; }
+    bool operator()(ast::BinaryExpression const&) const { return false; }
+    bool operator()(ast::ConditionalExpression const&) const { return false; }
+    bool operator()(ast::Assignment const&) const { return false; }
+  };
+
+  static bool IsTarget(ast::AssignmentExpression const& node) {
+    return boost::apply_visitor(is_target(), node);
+  }
+
+  javascript_grammar<Iterator> const& grammar;
+};
+
+// Hooked into every rule when the grammar is built with
+// KUNJS_PROFILE_GRAMMAR, through the same handler BOOST_SPIRIT_DEBUG uses to
+// trace the rules. Reports each call to the current GrammarProfile, if any.
+template <typename Iterator>
+struct rule_profiler {
+  explicit rule_profiler(std::size_t rule) : rule(rule) {}
+
+  template <typename Context>
+  void operator()(Iterator const& first, Iterator const& last, Context const&,
+                  qi::debug_handler_state state, std::string const& name) const {
+    GrammarProfile* profile = GrammarProfile::current();
+    if (!profile)
+      return;
+
+    switch (state) {
+      case qi::pre_parse:
+        profile->enter(rule, name, first != last ? first->offset : End(first));
+        break;
+      case qi::successful_parse:
+        profile->leave(true, End(first));
+        break;
+      case qi::failed_parse:
+        profile->leave(false, 0);
+        break;
+    }
+  }
+
+  // Where the token before it ends, which is where the match of a rule
+  // stopping at it ends.
+  static boost::uint32_t End(Iterator const& it) {
+    if (it == it.stream().begin())
+      return 0;
+    return it[-1].offset + it[-1].length;
+  }
+
+  std::size_t rule;
+};
+
+}
+
+#if defined(KUNJS_PROFILE_GRAMMAR)
+#define KUNJS_GRAMMAR_NODE(r) \
+  BOOST_SPIRIT_DEBUG_NODE(r); qi::debug(r, rule_profiler<Iterator>(rules++))
+#else
+#define KUNJS_GRAMMAR_NODE(r) BOOST_SPIRIT_DEBUG_NODE(r)
+#endif
 
 template <typename Iterator>
 javascript_grammar<Iterator>::javascript_grammar()
   : javascript_grammar::base_type(program, "program") {
 
+  boost::proto::terminal<token_parser>::type const
+      lparen = tok(token::LPAREN),
+      rparen = tok(token::RPAREN),
+      lbrace = tok(token::LBRACE),
+      rbrace = tok(token::RBRACE),
+      semicolon = tok(token::SEMICOLON),
+      comma = tok(token::COMMA),
+      colon = tok(token::COLON);
+  boost::proto::terminal<line_end_parser>::type const line_end = terminal(line_end_parser());
+
   // Top level
-  program %= *source_element;
-  source_element %= function_declaration | statement;
-
-  function_declaration %= lit("function") > identifier > '(' > -formal_parameter_list > ')' > '{' > function_body > '}';
-  function_expression %= lit("function") > -identifier > '(' > -formal_parameter_list > ')' > '{' > function_body > '}';
-  formal_parameter_list %= identifier % ",";
-  function_body %= *source_element;
-
-  statement %=
-      !lit("function") >> expression[_val = _1] >> ";"
-      | variable_statement
-      | empty_statement
-      | if_statement
-      | do_while_statement
-      | while_statement
-      | for_statement
-      | for_with_var_statement
-      | foreach_statement
-      | foreach_with_var_statement
-      | continue_statement
-      | break_statement
-      | return_statement
-      | with_statement
-      | labelled_statement
-      | switch_statement
-      | throw_statement
-      | try_statement
-      | string("debugger") > ";"
-      | lit("{") > *statement > lit("}");
-
-  variable_statement %= lit("var") >> (variable_declaration % ",") >> ";";
-  variable_declaration %= identifier >> -("=" >> assignment_expression);
-
-  empty_statement %= lit(";")[_val = construct<ast::Noop>()];
-
-  if_statement %= lit("if") >> "(" >> expression >> ")" >> statement >> -(lit("else") >> statement);
-
-  do_while_statement %= lit("do") >> statement >> "while" >> "(" >> expression >> ")" > ";";
-  while_statement %= lit("while") >> "(" >> expression >> ")" >> statement;
-  for_statement %= lit("for") >> "(" >> -expression >> ";" >> -expression >> ";" >> -expression >> ")" >> statement;
-  for_with_var_statement %= lit("for") >> "(" >> "var" >> (variable_declaration % ",") >> ";" >> -expression >> ";" >> -expression >> ")" >> statement;
-  foreach_statement %= lit("for") >> "(" >> lhs_expression >> "in" >> expression >> ")" >> statement;
-  foreach_with_var_statement %= lit("for") >> "(" >> "var" >> variable_declaration >> "in" >> expression >> ")" >> statement;
-
-  continue_statement %= lit("continue") > !eol > -identifier > ";";
-  break_statement %= lit("break") > !eol > -identifier > ";";
-  return_statement %= lit("return") > !eol > -expression > ";";
-
-  with_statement %= lit("with") > "(" > expression > ")" > statement;
+  program %= many(source_element);
+  source_element %= terminal(source_element_parser<Iterator>(*this));
+
+  // not a rule of its own, so that a missing body is reported as a missing "{"
+  typename boost::proto::terminal<function_body_parser<Iterator> >::type const
+      function_block = terminal(function_body_parser<Iterator>(*this));
+
+  function_declaration %= tok(token::FUNCTION) > identifier > lparen > -formal_parameter_list > rparen > function_block;
+  function_expression %= tok(token::FUNCTION) > -identifier > lparen > -formal_parameter_list > rparen > function_block;
+  formal_parameter_list %= identifier % comma;
+  function_body %= many(source_element);
+
+  statement %= terminal(statement_parser<Iterator>(*this));
+  expression_statement %= expression >> semicolon;
+  debugger_statement %= op(token::DEBUGGER) > semicolon;
+  block %= lbrace > many(statement) > rbrace;
+
+  variable_statement %= tok(token::VAR) >> list(variable_declaration, token::COMMA) >> semicolon;
+  variable_declaration %= identifier >> maybe(initializer);
+  initializer %= tok(token::ASSIGN) >> assignment_expression;
+
+  empty_statement = semicolon;
+
+  if_statement %= tok(token::IF) >> lparen >> expression >> rparen >> statement >> maybe(else_clause);
+  else_clause %= tok(token::ELSE) >> statement;
+
+  do_while_statement %= tok(token::DO) >> statement >> tok(token::WHILE) >> lparen >> expression >> rparen > semicolon;
+  while_statement %= tok(token::WHILE) >> lparen >> expression >> rparen >> statement;
+  for_statement %= tok(token::FOR) >> lparen >> maybe(expression) >> semicolon >> maybe(expression) >> semicolon >> maybe(expression) >> rparen >> statement;
+  for_with_var_statement %= tok(token::FOR) >> lparen >> tok(token::VAR) >> list(variable_declaration, token::COMMA) >> semicolon >> maybe(expression) >> semicolon >> maybe(expression) >> rparen >> statement;
+  foreach_statement %= tok(token::FOR) >> lparen >> lhs_expression >> tok(token::IN) >> expression >> rparen >> statement;
+  foreach_with_var_statement %= tok(token::FOR) >> lparen >> tok(token::VAR) >> variable_declaration >> tok(token::IN) >> expression >> rparen >> statement;
+
+  // a line break ends these, as a `;` would
+  continue_statement %= tok(token::CONTINUE) > maybe_on_same_line(identifier) > line_end;
+  break_statement %= tok(token::BREAK) > maybe_on_same_line(identifier) > line_end;
+  return_statement %= tok(token::RETURN) > maybe_on_same_line(expression) > line_end;
+
+  with_statement %= tok(token::WITH) > lparen > expression > rparen > statement;
 
   // TODO if there are no case clauses, default is not optional
-  switch_statement %= lit("switch") > "(" > expression > ")"
-      > "{" > *case_clause > -default_clause > *case_clause > "}";
-  case_clause %= lit("case") > expression > ":" > *statement;
-  default_clause %= lit("default") > ":" > *statement;
-
-  labelled_statement %= identifier >> ":" > statement;
-
-  throw_statement %= lit("throw") > !eol > expression[_val = construct<ast::Throw>(_1)] > ";";
-
-  try_statement %= lit("try") >> "{" >> *statement >> "}" >> (catch_block || finally_block);
-  catch_block %= lit("catch") > "(" > identifier > ")" > "{" >> *statement > "}";
-  finally_block %= lit("finally") > "{" >> *statement > "}";
-
-  expression %= assignment_expression % lit(',');
-
-  assignment_expression %= *(lhs_expression >> assignment_operator) >> conditional_expression;
-  assignment_operator %=
-      !lit("==") >> string("=")
-      | string("*=")
-      | string("/=")
-      | string("%=")
-      | string("+=")
-      | string("-=")
-      | string("<<=")
-      | string(">>=")
-      | string(">>>=")
-      | string("&=")
-      | string("^=")
-      | string("|=");
-
-  conditional_clauses %= '?' > assignment_expression > ':' > assignment_expression;
-  conditional_expression %= logical_or_expression
-      >> -(conditional_clauses);
-
-  logical_or_expression %= logical_and_expression >> *("||" >> logical_and_expression);
-
-  logical_and_expression %= bitwise_or_expression >> *("&&" >> bitwise_or_expression);
-
-  bitwise_or_expression %= bitwise_xor_expression >> *("|" >> bitwise_xor_expression);
-
-  bitwise_xor_expression %= bitwise_and_expression >> *("^" >> bitwise_and_expression);
-
-  bitwise_and_expression %= equality_expression >> *("&" >> equality_expression);
-
-  equality_expression %= relational_expression >> *(equality_operator > relational_expression);
-  equality_operator %= 
-      string("===")
-      | string("!==")
-      | string("==")
-      | string("!=");
-
-  relational_expression %= shift_expression >> *(relational_operator > shift_expression);
-  relational_operator %= 
-      string("<=")
-      | string(">=")
-      | string("<")
-      | string (">")
-      | string("instanceof")
-      | string("in");
-
-  shift_expression %= additive_expression >> *(shift_operator > additive_expression);
-  shift_operator %=
-      string(">>>")
-      | string("<<")
-      | string(">>");
-
-  additive_expression %= multiplicative_expression >> *(additive_operator > multiplicative_expression);
-  additive_operator %= string("+") | string("-");
-
-  multiplicative_expression %= unary_expression >> *(multiplicative_operator > unary_expression);
-  multiplicative_operator %=
-      string("*")
-      | string("/")
-      | string("%");
-
-  unary_expression %= ((*unary_operator) >> postfix_expression);
-  unary_operator %= string("delete")
-      | string("void")
-      | string("typeof")
-      | string("++")
-      | string("--")
-      | string("+")
-      | string("-")
-      | string("~")
-      | string("!");
-
-  postfix_expression %= lhs_expression >> -(!eol >> postfix_operator);
-  postfix_operator %= string("++") | string("--");
-
-  lhs_expression %= call_expression | new_expression;
-
-  call_expression %= member_expression >> arguments
-      >> *(arguments | ('[' >> expression >> ']') | ('.' >> identifier_name));
-
-  arguments %= lit('(') >> -(assignment_expression % ',') >> ')';
-
-  new_expression %= *string("new") >> member_expression;
-
-  member_access %= (primary_expression | function_expression)
-      >> *(('[' >> expression >> ']') | ('.' >> identifier_name));
-
-  instantiation %= member_expression >> arguments;
-  member_expression %=
-      member_access
-      | lit("new") > instantiation;
-
-  primary_expression %=
-      this_reference
-      | identifier
-      | literal 
-      | array_literal 
-      //| object_literal 
-      | '(' >> expression >> ')';
-
-  array_literal = '[' >> *lit(',') >> assignment_expression
-      >> *(+lit(',') >> assignment_expression) >> *lit(',') >> ']';
-
-  this_reference %= string("this")[_val = construct<ast::This>()];
-
-  // Lexical Grammar
-  identifier %= !reserved_word >> identifier_name;
-
-  // FIXME: unicode characters and connectors
-  identifier_name %= identifier_start >> *alnum;
-
-  identifier_start %= alpha | char_('$') | char_('_');
+  switch_statement %= tok(token::SWITCH) > lparen > expression > rparen
+      > lbrace > *case_clause > -default_clause > *case_clause > rbrace;
+  case_clause %= tok(token::CASE) > expression > colon > many(statement);
+  default_clause %= tok(token::DEFAULT) > colon > many(statement);
+
+  labelled_statement %= identifier >> colon > statement;
+
+  throw_statement %= tok(token::THROW) > expression[_val = construct<ast::Throw>(_1)] > semicolon;
+
+  try_statement %= tok(token::TRY) >> lbrace >> many(statement) >> rbrace
+      >> &(tok(token::CATCH) | tok(token::FINALLY)) >> maybe(catch_block) >> maybe(finally_block);
+  catch_block %= tok(token::CATCH) > lparen > identifier > rparen > lbrace >> many(statement) > rbrace;
+  finally_block %= tok(token::FINALLY) > lbrace >> many(statement) > rbrace;
+
+  expression %= list(assignment_expression, token::COMMA);
+
+  assignment_expression %= terminal(expression_parser<Iterator>(*this));
 
-  reserved_word %=
-      keyword
-      | future_reserved_word
-      | string("null")
-      | string("true")
-      | string("false");
+  lhs_expression %= terminal(lhs_parser<Iterator>(*this));
+  arguments %= lparen >> -list(assignment_expression, token::COMMA) >> rparen;
+  array_literal %= terminal(array_literal_parser<Iterator>(*this));
 
-  keyword %= keywords >> !alnum;
-  keywords = "break", "do", "case", "else", "catch",  "finally", "continue",
-           "for", "debugger", "function",  "default", "if", "delete", "in",
-           "instanceof", "new",  "return", "switch", "this", "throw", "try",
-           "typeof",  "var", "void", "while",  "with";
-
-  future_reserved_word %= future_reserved_words >> !alnum;
-  future_reserved_words = "class", "enum", "const", "export", "implements", "let",
-                        "interface", "package", "yield", "extends", "import",
-                        "private", "protected", "super", "public", "static";
+  // Lexical Grammar: the lexer has already told identifiers, keywords and
+  // literals apart
+  identifier %= terminal(name_parser(false));
+  identifier_name %= terminal(name_parser(true));
 
   literal %=
       null_literal
-      | bool_
+      | boolean_literal
       | numeric_literal
       | string_literal;
 
-  null_literal %= string("null")[_val = construct<ast::Null>()];
-
-  numeric_literal %= int_ >> !lit('.') | double_;
-
-  string_literal %=
-      '"' >> lexeme[*(~char_('"'))] >> '"'
-      | '\'' >> lexeme[*(~char_('\''))] >> '\'';
-
-  on_error<fail>(program, error_handler(_4, _3, _2));
-
-  BOOST_SPIRIT_DEBUG_NODE(program);
-  BOOST_SPIRIT_DEBUG_NODE(source_element);
-  BOOST_SPIRIT_DEBUG_NODE(function_declaration);
-  BOOST_SPIRIT_DEBUG_NODE(function_expression);
-  BOOST_SPIRIT_DEBUG_NODE(formal_parameter_list);
-  BOOST_SPIRIT_DEBUG_NODE(function_body);
-  BOOST_SPIRIT_DEBUG_NODE(statement);
-  BOOST_SPIRIT_DEBUG_NODE(variable_statement);
-  BOOST_SPIRIT_DEBUG_NODE(variable_declaration);
-  BOOST_SPIRIT_DEBUG_NODE(empty_statement);
-  BOOST_SPIRIT_DEBUG_NODE(if_statement);
-  BOOST_SPIRIT_DEBUG_NODE(do_while_statement);
-  BOOST_SPIRIT_DEBUG_NODE(while_statement);
-  BOOST_SPIRIT_DEBUG_NODE(for_statement);
-  BOOST_SPIRIT_DEBUG_NODE(for_with_var_statement);
-  BOOST_SPIRIT_DEBUG_NODE(foreach_statement);
-  BOOST_SPIRIT_DEBUG_NODE(foreach_with_var_statement);
-  BOOST_SPIRIT_DEBUG_NODE(continue_statement);
-  BOOST_SPIRIT_DEBUG_NODE(break_statement);
-  BOOST_SPIRIT_DEBUG_NODE(return_statement);
-  BOOST_SPIRIT_DEBUG_NODE(with_statement);
-  BOOST_SPIRIT_DEBUG_NODE(labelled_statement);
-  BOOST_SPIRIT_DEBUG_NODE(switch_statement);
-  BOOST_SPIRIT_DEBUG_NODE(case_clause);
-  BOOST_SPIRIT_DEBUG_NODE(default_clause);
-  BOOST_SPIRIT_DEBUG_NODE(throw_statement);
-  BOOST_SPIRIT_DEBUG_NODE(try_statement);
-  BOOST_SPIRIT_DEBUG_NODE(catch_block);
-  BOOST_SPIRIT_DEBUG_NODE(finally_block);
-  BOOST_SPIRIT_DEBUG_NODE(expression);
-  BOOST_SPIRIT_DEBUG_NODE(assignment_expression);
-  BOOST_SPIRIT_DEBUG_NODE(assignment_operator);
-  BOOST_SPIRIT_DEBUG_NODE(conditional_clauses);
-  BOOST_SPIRIT_DEBUG_NODE(conditional_expression);
-  BOOST_SPIRIT_DEBUG_NODE(logical_or_expression);
-  BOOST_SPIRIT_DEBUG_NODE(logical_and_expression);
-  BOOST_SPIRIT_DEBUG_NODE(bitwise_or_expression);
-  BOOST_SPIRIT_DEBUG_NODE(bitwise_xor_expression);
-  BOOST_SPIRIT_DEBUG_NODE(bitwise_and_expression);
-  BOOST_SPIRIT_DEBUG_NODE(equality_expression);
-  BOOST_SPIRIT_DEBUG_NODE(equality_operator);
-  BOOST_SPIRIT_DEBUG_NODE(relational_expression);
-  BOOST_SPIRIT_DEBUG_NODE(relational_operator);
-  BOOST_SPIRIT_DEBUG_NODE(shift_expression);
-  BOOST_SPIRIT_DEBUG_NODE(shift_operator);
-  BOOST_SPIRIT_DEBUG_NODE(additive_expression);
-  BOOST_SPIRIT_DEBUG_NODE(additive_operator);
-  BOOST_SPIRIT_DEBUG_NODE(multiplicative_expression);
-  BOOST_SPIRIT_DEBUG_NODE(multiplicative_operator);
-  BOOST_SPIRIT_DEBUG_NODE(unary_expression);
-  BOOST_SPIRIT_DEBUG_NODE(unary_operator);
-  BOOST_SPIRIT_DEBUG_NODE(postfix_expression);
-  BOOST_SPIRIT_DEBUG_NODE(postfix_operator);
-  BOOST_SPIRIT_DEBUG_NODE(lhs_expression);
-  BOOST_SPIRIT_DEBUG_NODE(call_expression);
-  BOOST_SPIRIT_DEBUG_NODE(arguments);
-  BOOST_SPIRIT_DEBUG_NODE(new_expression);
-  BOOST_SPIRIT_DEBUG_NODE(member_access);
-  BOOST_SPIRIT_DEBUG_NODE(instantiation);
-  BOOST_SPIRIT_DEBUG_NODE(member_expression);
-  BOOST_SPIRIT_DEBUG_NODE(primary_expression);
-  BOOST_SPIRIT_DEBUG_NODE(array_literal);
-  BOOST_SPIRIT_DEBUG_NODE(this_reference);
-  BOOST_SPIRIT_DEBUG_NODE(identifier);
-  BOOST_SPIRIT_DEBUG_NODE(identifier_name);
-  BOOST_SPIRIT_DEBUG_NODE(identifier_start);
-  BOOST_SPIRIT_DEBUG_NODE(reserved_word);
-  BOOST_SPIRIT_DEBUG_NODE(keyword);
-  BOOST_SPIRIT_DEBUG_NODE(literal);
-  BOOST_SPIRIT_DEBUG_NODE(null_literal);
-  BOOST_SPIRIT_DEBUG_NODE(numeric_literal);
-  BOOST_SPIRIT_DEBUG_NODE(string_literal);
+  null_literal = tok(token::NULL_LITERAL);
+  boolean_literal = tok(token::TRUE_LITERAL)[_val = true] | tok(token::FALSE_LITERAL)[_val = false];
+
+  numeric_literal %= terminal(number_parser());
+
+  string_literal %= terminal(string_parser());
+
+  // There is no on_error handler: expectation failures propagate to the
+  // caller as qi::expectation_failure, and Parser::parse turns them into a
+  // ParseResult without copying any of the source.
+
+#if defined(KUNJS_PROFILE_GRAMMAR)
+  // Rules are numbered for GrammarProfile in the order they are named here.
+  std::size_t rules = 0;
+#endif
+
+  KUNJS_GRAMMAR_NODE(program);
+  KUNJS_GRAMMAR_NODE(source_element);
+  KUNJS_GRAMMAR_NODE(function_declaration);
+  KUNJS_GRAMMAR_NODE(function_expression);
+  KUNJS_GRAMMAR_NODE(formal_parameter_list);
+  KUNJS_GRAMMAR_NODE(function_body);
+  KUNJS_GRAMMAR_NODE(statement);
+  KUNJS_GRAMMAR_NODE(expression_statement);
+  KUNJS_GRAMMAR_NODE(debugger_statement);
+  KUNJS_GRAMMAR_NODE(block);
+  KUNJS_GRAMMAR_NODE(variable_statement);
+  KUNJS_GRAMMAR_NODE(variable_declaration);
+  KUNJS_GRAMMAR_NODE(initializer);
+  KUNJS_GRAMMAR_NODE(empty_statement);
+  KUNJS_GRAMMAR_NODE(if_statement);
+  KUNJS_GRAMMAR_NODE(else_clause);
+  KUNJS_GRAMMAR_NODE(do_while_statement);
+  KUNJS_GRAMMAR_NODE(while_statement);
+  KUNJS_GRAMMAR_NODE(for_statement);
+  KUNJS_GRAMMAR_NODE(for_with_var_statement);
+  KUNJS_GRAMMAR_NODE(foreach_statement);
+  KUNJS_GRAMMAR_NODE(foreach_with_var_statement);
+  KUNJS_GRAMMAR_NODE(continue_statement);
+  KUNJS_GRAMMAR_NODE(break_statement);
+  KUNJS_GRAMMAR_NODE(return_statement);
+  KUNJS_GRAMMAR_NODE(with_statement);
+  KUNJS_GRAMMAR_NODE(labelled_statement);
+  KUNJS_GRAMMAR_NODE(switch_statement);
+  KUNJS_GRAMMAR_NODE(case_clause);
+  KUNJS_GRAMMAR_NODE(default_clause);
+  KUNJS_GRAMMAR_NODE(throw_statement);
+  KUNJS_GRAMMAR_NODE(try_statement);
+  KUNJS_GRAMMAR_NODE(catch_block);
+  KUNJS_GRAMMAR_NODE(finally_block);
+  KUNJS_GRAMMAR_NODE(expression);
+  KUNJS_GRAMMAR_NODE(assignment_expression);
+  KUNJS_GRAMMAR_NODE(lhs_expression);
+  KUNJS_GRAMMAR_NODE(arguments);
+  KUNJS_GRAMMAR_NODE(array_literal);
+  KUNJS_GRAMMAR_NODE(identifier);
+  KUNJS_GRAMMAR_NODE(identifier_name);
+  KUNJS_GRAMMAR_NODE(literal);
+  KUNJS_GRAMMAR_NODE(null_literal);
+  KUNJS_GRAMMAR_NODE(boolean_literal);
+  KUNJS_GRAMMAR_NODE(numeric_literal);
+  KUNJS_GRAMMAR_NODE(string_literal);
 }
 
-template struct javascript_grammar<std::string::const_iterator>;
+template struct javascript_grammar<TokenIterator>;
 
 } // namespace kunjs
 
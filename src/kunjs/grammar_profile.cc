@@ -0,0 +1,150 @@
+#include "kunjs/grammar_profile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(_MSC_VER)
+#define KUNJS_THREAD_LOCAL __declspec(thread)
+#else
+#define KUNJS_THREAD_LOCAL __thread
+#endif
+
+namespace kunjs {
+
+namespace {
+
+KUNJS_THREAD_LOCAL GrammarProfile* current_profile = 0;
+
+// A monotonic clock, in nanoseconds. Rules are called millions of times per
+// parse, so this has to be cheaper than the microsecond clocks of the
+// benchmarks.
+boost::uint64_t Now() {
+#if defined(_WIN32)
+  static LARGE_INTEGER frequency;
+  if (!frequency.QuadPart)
+    QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  return boost::uint64_t(now.QuadPart / double(frequency.QuadPart) * 1e9);
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return boost::uint64_t(now.tv_sec) * 1000000000u + now.tv_nsec;
+#endif
+}
+
+bool Costlier(GrammarProfile::Rule const& lhs, GrammarProfile::Rule const& rhs) {
+  if (lhs.self_ns != rhs.self_ns)
+    return lhs.self_ns > rhs.self_ns;
+  return lhs.calls > rhs.calls;
+}
+
+}
+
+GrammarProfile::Rule::Rule()
+    : calls(0), matches(0), bytes(0), total_ns(0), self_ns(0) {}
+
+bool GrammarProfile::enabled() {
+#if defined(KUNJS_PROFILE_GRAMMAR)
+  return true;
+#else
+  return false;
+#endif
+}
+
+GrammarProfile::GrammarProfile() {}
+
+std::vector<GrammarProfile::Rule> GrammarProfile::rules() const {
+  std::vector<Rule> called;
+  for (std::vector<Rule>::const_iterator it = counters.begin(); it != counters.end(); ++it) {
+    if (it->calls)
+      called.push_back(*it);
+  }
+  std::stable_sort(called.begin(), called.end(), Costlier);
+  return called;
+}
+
+void GrammarProfile::clear() {
+  counters.clear();
+  calls.clear();
+}
+
+GrammarProfile::Scope::Scope(GrammarProfile& profile) : previous(current_profile) {
+  current_profile = &profile;
+}
+
+GrammarProfile::Scope::~Scope() {
+  current_profile->calls.clear();
+  current_profile = previous;
+}
+
+GrammarProfile* GrammarProfile::current() {
+  return current_profile;
+}
+
+void GrammarProfile::enter(std::size_t rule, std::string const& name, boost::uint32_t offset) {
+  if (rule >= counters.size())
+    counters.resize(rule + 1);
+  if (counters[rule].name.empty())
+    counters[rule].name = name;
+
+  Call call = { rule, offset, 0, 0 };
+  calls.push_back(call);
+  calls.back().start_ns = Now();
+}
+
+void GrammarProfile::leave(bool matched, boost::uint32_t offset) {
+  boost::uint64_t now = Now();
+  if (calls.empty())
+    return;
+
+  Call call = calls.back();
+  calls.pop_back();
+  boost::uint64_t elapsed = now - call.start_ns;
+  if (!calls.empty())
+    calls.back().nested_ns += elapsed;
+
+  Rule& counter = counters[call.rule];
+  ++counter.calls;
+  counter.total_ns += elapsed;
+  counter.self_ns += elapsed > call.nested_ns ? elapsed - call.nested_ns : 0;
+  if (matched) {
+    ++counter.matches;
+    counter.bytes += offset > call.offset ? offset - call.offset : 0;
+  }
+}
+
+std::ostream& operator<<(std::ostream& out, GrammarProfile const& profile) {
+  std::vector<GrammarProfile::Rule> rules = profile.rules();
+  boost::uint64_t total = 0;
+  for (std::size_t i = 0; i < rules.size(); ++i)
+    total += rules[i].self_ns;
+
+  char line[160];
+  std::sprintf(line, "%-28s %10s %10s %10s %10s %10s %6s %10s\n",
+               "rule", "calls", "matches", "failures", "KB", "self ms", "self", "total ms");
+  out << line;
+  for (std::size_t i = 0; i < rules.size(); ++i) {
+    GrammarProfile::Rule const& rule = rules[i];
+    std::sprintf(line, "%-28s %10lu %10lu %10lu %10lu %10.2f %5.1f%% %10.2f\n",
+                 rule.name.c_str(),
+                 static_cast<unsigned long>(rule.calls),
+                 static_cast<unsigned long>(rule.matches),
+                 static_cast<unsigned long>(rule.failures()),
+                 static_cast<unsigned long>(rule.bytes / 1024),
+                 rule.self_ns / 1e6,
+                 total ? 100.0 * rule.self_ns / total : 0.0,
+                 rule.total_ns / 1e6);
+    out << line;
+  }
+  return out;
+}
+
+} // namespace kunjs
@@ -0,0 +1,96 @@
+#ifndef KUNJS_GRAMMARPROFILE_H_
+#define KUNJS_GRAMMARPROFILE_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace kunjs {
+
+// Where the time of a parse goes, rule by rule. When kunjs is built with
+// KUNJS_PROFILE_GRAMMAR, every rule of javascript_grammar reports its calls
+// to the profile of the innermost Scope on the calling thread; otherwise the
+// rules are left as they are and profiles stay empty.
+//
+//   GrammarProfile profile;
+//   {
+//     GrammarProfile::Scope scope(profile);
+//     parser.parse(code);
+//   }
+//   std::cerr << profile;
+//
+// A profile is not synchronized: threads parsing at the same time need one
+// each.
+class GrammarProfile : private boost::noncopyable {
+ public:
+  struct Rule {
+    Rule();
+
+    boost::uint64_t failures() const { return calls - matches; }
+
+    std::string name;
+    boost::uint64_t calls;
+    boost::uint64_t matches;
+    // Source bytes spanned by the tokens of the matches.
+    boost::uint64_t bytes;
+    // Time spent in the rule, with and without the rules it called. A rule
+    // that calls itself counts the nested calls in total_ns more than once.
+    boost::uint64_t total_ns;
+    boost::uint64_t self_ns;
+  };
+
+  // Whether the grammar was built to report to profiles.
+  static bool enabled();
+
+  GrammarProfile();
+
+  // The rules that were called, costliest (by self time) first.
+  std::vector<Rule> rules() const;
+
+  void clear();
+
+  // Makes a profile the one rules report to on the calling thread while
+  // alive. Rules already running when it is created are not counted.
+  class Scope : private boost::noncopyable {
+   public:
+    explicit Scope(GrammarProfile& profile);
+    ~Scope();
+
+   private:
+    GrammarProfile* previous;
+  };
+
+  // Profile of the innermost Scope on the calling thread, or 0.
+  static GrammarProfile* current();
+
+  // Called by the rules, around each of their calls. Offsets are those of
+  // the source bytes at the start of the call and after its match.
+  void enter(std::size_t rule, std::string const& name, boost::uint32_t offset);
+  void leave(bool matched, boost::uint32_t offset);
+
+ private:
+  struct Call {
+    std::size_t rule;
+    boost::uint32_t offset;
+    boost::uint64_t start_ns;
+    boost::uint64_t nested_ns;
+  };
+
+  std::vector<Rule> counters;
+  std::vector<Call> calls;
+};
+
+// A table of the rules, costliest first.
+std::ostream& operator<<(std::ostream& out, GrammarProfile const& profile);
+
+} // namespace kunjs
+
+#endif // KUNJS_GRAMMARPROFILE_H_
@@ -0,0 +1,187 @@
+#ifndef KUNJS_IN_PLACE_PARSER_H_
+#define KUNJS_IN_PLACE_PARSER_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "kunjs/ast.h"
+#include "kunjs/token_parser.h"
+
+#include <boost/optional.hpp>
+#include <boost/proto/proto.hpp>
+#include <boost/spirit/home/qi/parser.hpp>
+#include <boost/spirit/home/support/handles_container.hpp>
+#include <boost/spirit/home/support/info.hpp>
+#include <boost/spirit/home/support/unused.hpp>
+
+#include <vector>
+
+// Replacements for Qi's kleene star, list and optional over a single rule.
+// The AST nodes are recursive variants, which copy their whole subtree
+// whenever they are assigned or relocated; *rule, rule % separator and -rule
+// parse each element into a temporary and copy it into place, so every
+// enclosing block would copy the statements nested in it once more. These
+// build each element where it ends up instead.
+
+namespace kunjs {
+
+namespace qi = boost::spirit::qi;
+
+namespace detail {
+
+// Parses one more element at the end of container, leaving the container as
+// it was when there is none. Growing the vector copies what is already in
+// it, so it only grows once there is one more element to put in it; until
+// then, elements go straight into the spare capacity.
+template <typename Rule, typename Iterator, typename Container>
+bool ParseBack(Rule const& rule, Iterator& first, Iterator const& last, Container& container) {
+  typedef typename Container::value_type value_type;
+  static const std::size_t INITIAL_CAPACITY = 4;
+
+  if (container.capacity() == 0)
+    container.reserve(INITIAL_CAPACITY);
+
+  if (container.size() < container.capacity()) {
+    container.push_back(value_type());
+    if (rule.parse(first, last, boost::spirit::unused, boost::spirit::unused, container.back()))
+      return true;
+    container.pop_back();
+    return false;
+  }
+
+  value_type element;
+  if (!rule.parse(first, last, boost::spirit::unused, boost::spirit::unused, element))
+    return false;
+  container.push_back(element);
+  return true;
+}
+
+} // namespace detail
+
+// Like *rule.
+template <typename Rule>
+struct in_place_kleene : qi::primitive_parser<in_place_kleene<Rule> > {
+  template <typename Context, typename Iterator>
+  struct attribute { typedef typename ast::List<typename Rule::attr_type>::type type; };
+
+  explicit in_place_kleene(Rule const& rule) : rule(rule) {}
+
+  template <typename Iterator, typename Context, typename Skipper, typename Attribute>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const&, Attribute& attr) const {
+    while (detail::ParseBack(rule, first, last, attr)) {}
+    return true;
+  }
+
+  template <typename Context>
+  qi::info what(Context& context) const {
+    return qi::info("kleene", rule.what(context));
+  }
+
+  Rule const& rule;
+};
+
+// Like rule % separator, for a separator token.
+template <typename Rule>
+struct in_place_list : qi::primitive_parser<in_place_list<Rule> > {
+  template <typename Context, typename Iterator>
+  struct attribute { typedef typename ast::List<typename Rule::attr_type>::type type; };
+
+  in_place_list(Rule const& rule, token::Kind separator)
+      : rule(rule), separator(separator) {}
+
+  template <typename Iterator, typename Context, typename Skipper, typename Attribute>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const&, Attribute& attr) const {
+    if (!detail::ParseBack(rule, first, last, attr))
+      return false;
+
+    while (first != last && first->kind == separator) {
+      Iterator next = first;
+      ++next;
+      if (!detail::ParseBack(rule, next, last, attr))
+        break;
+      first = next;
+    }
+    return true;
+  }
+
+  template <typename Context>
+  qi::info what(Context& context) const {
+    return qi::info("list", rule.what(context));
+  }
+
+  Rule const& rule;
+  token::Kind separator;
+};
+
+// Like -rule. With same_line set, nothing is parsed from the next line: a
+// rule starting after a line break is left out.
+template <typename Rule>
+struct in_place_optional : qi::primitive_parser<in_place_optional<Rule> > {
+  template <typename Context, typename Iterator>
+  struct attribute { typedef boost::optional<typename Rule::attr_type> type; };
+
+  explicit in_place_optional(Rule const& rule, bool same_line = false)
+      : rule(rule), same_line(same_line) {}
+
+  template <typename Iterator, typename Context, typename Skipper, typename Attribute>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const&, Attribute& attr) const {
+    if (same_line && first != last && first.follows_line_break()) {
+      attr = boost::none;
+      return true;
+    }
+
+    attr = typename Rule::attr_type();
+    if (!rule.parse(first, last, boost::spirit::unused, boost::spirit::unused, *attr))
+      attr = boost::none;
+    return true;
+  }
+
+  template <typename Context>
+  qi::info what(Context& context) const {
+    return qi::info("optional", rule.what(context));
+  }
+
+  Rule const& rule;
+  bool same_line;
+};
+
+template <typename Rule>
+typename boost::proto::terminal<in_place_kleene<Rule> >::type many(Rule const& rule) {
+  return terminal(in_place_kleene<Rule>(rule));
+}
+
+template <typename Rule>
+typename boost::proto::terminal<in_place_optional<Rule> >::type maybe(Rule const& rule) {
+  return terminal(in_place_optional<Rule>(rule));
+}
+
+// Like maybe, for what has to start on the line it follows.
+template <typename Rule>
+typename boost::proto::terminal<in_place_optional<Rule> >::type maybe_on_same_line(Rule const& rule) {
+  return terminal(in_place_optional<Rule>(rule, true));
+}
+
+template <typename Rule>
+typename boost::proto::terminal<in_place_list<Rule> >::type list(Rule const& rule, token::Kind separator) {
+  return terminal(in_place_list<Rule>(rule, separator));
+}
+
+} // namespace kunjs
+
+namespace boost { namespace spirit { namespace traits {
+
+template <typename Rule, typename Attribute, typename Context, typename Iterator>
+struct handles_container<kunjs::in_place_kleene<Rule>, Attribute, Context, Iterator>
+  : mpl::true_ {};
+
+template <typename Rule, typename Attribute, typename Context, typename Iterator>
+struct handles_container<kunjs::in_place_list<Rule>, Attribute, Context, Iterator>
+  : mpl::true_ {};
+
+} } }
+
+#endif // KUNJS_IN_PLACE_PARSER_H_
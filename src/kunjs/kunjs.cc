@@ -1,13 +1,183 @@
 #include "kunjs/kunjs.h"
+#include "kunjs/compiler/bytecode_compiler.h"
 
-#include <iostream>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <llvm/DerivedTypes.h>
+
+#include <sstream>
 
 namespace kunjs {
 
+namespace {
+
+// What a program compiled by Compiler returned, by the type it returns.
+compiler::Value ToValue(llvm::Type const* type, llvm::GenericValue const& value) {
+  if (type->isIntegerTy(1))
+    return compiler::Value(value.IntVal.getBoolValue());
+  if (type->isIntegerTy())
+    return compiler::Value(static_cast<boost::int32_t>(value.IntVal.getSExtValue()));
+  if (type->isDoubleTy())
+    return compiler::Value(value.DoubleVal);
+
+  char const* string = static_cast<char const*>(llvm::GVTOP(value));
+  return string ? compiler::Value(string) : compiler::Value();
+}
+
+compiler::Value::Type TypeOf(llvm::Type const* type) {
+  if (type->isIntegerTy(1))
+    return compiler::Value::BOOLEAN;
+  if (type->isIntegerTy())
+    return compiler::Value::INTEGER;
+  if (type->isDoubleTy())
+    return compiler::Value::DOUBLE;
+  return compiler::Value::STRING;
+}
+
+// Calls the machine code of a program that returns type, as made by the JIT.
+compiler::Value Call(void* native, compiler::Value::Type type) {
+  boost::intptr_t address = reinterpret_cast<boost::intptr_t>(native);
+  switch (type) {
+    case compiler::Value::BOOLEAN:
+      return compiler::Value(reinterpret_cast<bool (*)()>(address)());
+    case compiler::Value::INTEGER:
+      return compiler::Value(reinterpret_cast<boost::int32_t (*)()>(address)());
+    case compiler::Value::DOUBLE:
+      return compiler::Value(reinterpret_cast<double (*)()>(address)());
+    default: {
+      char const* string = reinterpret_cast<char const* (*)()>(address)();
+      return string ? compiler::Value(string) : compiler::Value();
+    }
+  }
+}
+
+boost::posix_time::ptime Now() {
+  return boost::posix_time::microsec_clock::universal_time();
+}
+
+std::string Describe(ParseResult const& result) {
+  std::ostringstream error;
+  error << result;
+  return error.str();
+}
+
+}
+
+Runner::~Runner() {
+  Forget();
+}
+
 std::string Runner::run(std::string code) {
-  std::cout << "Running: " << code << "\n";
-  return code;
+  if (tier == JIT)
+    return RunCompiled(code);
+  if (tier == TIERED)
+    return RunTiered(code);
+
+  ParsedProgram parsed(atoms);
+  ParseResult result = parser.parse(code, parsed);
+  if (!result)
+    return Describe(result);
+
+  compiler::Code bytecode;
+  if (!compiler::BytecodeCompiler()(parsed.program(), bytecode))
+    return RunCompiled(code);
+  return compiler::to_string(interpreter.run(bytecode));
+}
+
+void Runner::compile_queued() {
+  for (std::size_t i = 0; i < queue.size(); ++i) {
+    Script& script = *queue[i];
+    boost::posix_time::ptime start = Now();
+    ParseResult result;
+    llvm::Function* program =
+        Engine().compile(*script.code, result, compiler::ProgramCompiler::WHOLE);
+    if (program) {
+      script.program = program;
+      script.native = engine->native(program);
+      script.type = TypeOf(program->getReturnType());
+      script.state = Script::NATIVE;
+    } else {
+      script.state = Script::DECLINED;
+    }
+    Notify(program ? TierEvent::COMPILED : TierEvent::DECLINED, script,
+           (Now() - start).total_microseconds());
+  }
+  queue.clear();
+}
+
+std::string Runner::RunCompiled(std::string const& code) {
+  ParseResult result;
+  llvm::Function* program = Engine().compile(code, result);
+  if (!program)
+    return Describe(result);
+
+  std::string value = compiler::to_string(
+      ToValue(program->getReturnType(), engine->run(program)));
+  engine->release(program);
+  return value;
 }
 
+std::string Runner::RunTiered(std::string const& code) {
+  compile_queued();
+
+  Scripts::iterator found = scripts.find(code);
+  if (found == scripts.end()) {
+    ParsedProgram parsed(atoms);
+    ParseResult result = parser.parse(code, parsed);
+    if (!result)
+      return Describe(result);
+
+    compiler::Code bytecode;
+    if (!compiler::BytecodeCompiler()(parsed.program(), bytecode))
+      return RunCompiled(code);
+    if (scripts.size() >= MAX_SCRIPTS)
+      Forget();
+    found = scripts.insert(Scripts::value_type(code, new Script)).first;
+    found->second->code = &found->first;
+    found->second->bytecode.swap(bytecode);
+  }
+
+  Script& script = *found->second;
+  ++script.calls;
+  if (script.state == Script::NATIVE)
+    return compiler::to_string(Call(script.native, script.type));
+
+  compiler::Value value = interpreter.run(script.bytecode);
+  script.back_edges += interpreter.back_edges();
+  if (script.state == Script::INTERPRETED && Hot(script)) {
+    script.state = Script::QUEUED;
+    queue.push_back(&script);
+    Notify(TierEvent::QUEUED, script);
+  }
+  return compiler::to_string(value);
 }
 
+bool Runner::Hot(Script const& script) const {
+  return (tiering.calls && script.calls >= tiering.calls) ||
+      (tiering.back_edges && script.back_edges >= tiering.back_edges);
+}
+
+void Runner::Notify(TierEvent::Kind kind, Script const& script,
+                    boost::uint64_t elapsed_us) const {
+  if (tiering.listener)
+    tiering.listener(TierEvent(kind, *script.code, script.calls, script.back_edges, elapsed_us));
+}
+
+// Frees every script, and the machine code of those compiled.
+void Runner::Forget() {
+  for (Scripts::iterator i = scripts.begin(); i != scripts.end(); ++i) {
+    if (i->second->program)
+      engine->release(i->second->program);
+    delete i->second;
+  }
+  scripts.clear();
+  queue.clear();
+}
+
+Compiler& Runner::Engine() {
+  if (!engine)
+    engine.reset(new Compiler(tier == TIERED ? tiering.level : level));
+  return *engine;
+}
+
+}
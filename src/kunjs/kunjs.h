@@ -1,13 +1,121 @@
 #ifndef KUNJS_KUNJS_H_
 #define KUNJS_KUNJS_H_
 
+#include "kunjs/compiler.h"
+#include "kunjs/compiler/interpreter.h"
+
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace kunjs {
 
-class Runner {
+// A script changing tier in a Runner (see Runner::Tiering).
+struct TierEvent {
+  enum Kind {
+    QUEUED,    // hot: to be compiled before the next run
+    COMPILED,  // runs as machine code from now on
+    DECLINED   // cannot be compiled in full yet, so stays interpreted
+  };
+
+  TierEvent(Kind kind, std::string const& code, std::size_t calls,
+            std::size_t back_edges, boost::uint64_t elapsed_us)
+      : kind(kind), code(code), calls(calls), back_edges(back_edges), elapsed_us(elapsed_us) {}
+
+  Kind kind;
+  std::string code;
+  // runs of the script, and the loops it went round in them, so far
+  std::size_t calls;
+  std::size_t back_edges;
+  // spent compiling, for COMPILED and DECLINED
+  boost::uint64_t elapsed_us;
+};
+
+// Runs programs in one of three tiers: the interpreter starts them at once,
+// while the JIT takes longer to start and runs them faster. TIERED starts
+// every script in the interpreter and moves the ones that run often, or loop
+// long, to the JIT. The JIT is made the first time a program runs there.
+class Runner : private boost::noncopyable {
  public:
+  enum Tier {
+    INTERPRETER,  // bytecode (see compiler::BytecodeCompiler)
+    JIT,          // machine code, optimized at level
+    TIERED        // both, as Tiering says
+  };
+
+  // When TIERED hands a script to the JIT: once it has run calls times, or
+  // gone round back_edges loops in all, whichever comes first; 0 for never.
+  // The JIT then compiles it at level before the next run. Only scripts
+  // compiler::ProgramCompiler compiles in full move, so that both tiers give
+  // the same results. listener, when set, hears of every move.
+  struct Tiering {
+    Tiering() : calls(100), back_edges(10000), level(compiler::Optimizer::O2) {}
+
+    std::size_t calls;
+    std::size_t back_edges;
+    compiler::Optimizer::Level level;
+    boost::function<void (TierEvent const&)> listener;
+  };
+
+  explicit Runner(Tier tier = TIERED,
+                  compiler::Optimizer::Level level = compiler::Optimizer::O1)
+      : tier(tier), level(level) {}
+  explicit Runner(Tiering const& tiering)
+      : tier(TIERED), level(compiler::Optimizer::O1), tiering(tiering) {}
+  ~Runner();
+
+  // Runs code in the tier of the runner, or with the JIT when it is too large
+  // for bytecode. Returns the value of its last statement as JavaScript would
+  // turn it into a string, or why code does not parse.
   std::string run(std::string code);
+
+  // Compiles the scripts queued by TIERED now rather than on the next run.
+  void compile_queued();
+
+ private:
+  // A script TIERED has run, kept by its code.
+  struct Script : private boost::noncopyable {
+    enum State { INTERPRETED, QUEUED, NATIVE, DECLINED };
+
+    Script() : code(0), calls(0), back_edges(0), state(INTERPRETED), program(0), native(0) {}
+
+    std::string const* code;
+    compiler::Code bytecode;
+    std::size_t calls;
+    std::size_t back_edges;
+    State state;
+    // once NATIVE
+    llvm::Function* program;
+    void* native;
+    compiler::Value::Type type;
+  };
+  typedef boost::unordered_map<std::string, Script*> Scripts;
+
+  // scripts kept before all are forgotten
+  static const std::size_t MAX_SCRIPTS = 256;
+
+  std::string RunCompiled(std::string const& code);
+  std::string RunTiered(std::string const& code);
+  bool Hot(Script const& script) const;
+  void Notify(TierEvent::Kind kind, Script const& script, boost::uint64_t elapsed_us = 0) const;
+  void Forget();
+  Compiler& Engine();
+
+  Tier tier;
+  compiler::Optimizer::Level level;
+  Tiering tiering;
+  AtomTable atoms;
+  Parser parser;
+  compiler::Interpreter interpreter;
+  boost::scoped_ptr<Compiler> engine;
+  Scripts scripts;
+  std::vector<Script*> queue;
 };
 
 }
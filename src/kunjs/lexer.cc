@@ -0,0 +1,680 @@
+#include "kunjs/lexer.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <string>
+
+// Whitespace and comment bodies are scanned a block of bytes at a time when
+// the compiler targets AVX2 (32 bytes) or SSE2 (16 bytes, always there on
+// x86-64). Defining KUNJS_NO_SIMD keeps the plain loops, which also handle
+// whatever is left at the end of the source on the other paths.
+#if !defined(KUNJS_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define KUNJS_SIMD_WIDTH 32
+#elif !defined(KUNJS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || \
+                                  (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define KUNJS_SIMD_WIDTH 16
+#endif
+
+#if defined(KUNJS_SIMD_WIDTH) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace kunjs {
+
+namespace token {
+
+namespace {
+
+#define T(name, spelling) spelling,
+char const* const SPELLINGS[KIND_COUNT] = {
+  KUNJS_TOKEN_LIST(T)
+};
+#undef T
+
+}
+
+char const* spelling(Kind kind) {
+  return SPELLINGS[kind];
+}
+
+} // namespace token
+
+namespace {
+
+// Perfect hash over the 45 reserved words: no two of them share a slot, so
+// classifying an identifier-like word costs one hash and one memcmp.
+const unsigned KEYWORD_SLOTS = 128;
+
+inline unsigned KeywordHash(char const* word, std::size_t length) {
+  unsigned char const* w = reinterpret_cast<unsigned char const*>(word);
+  return (length + (w[0] << 5) + (w[1] << 3) + 3 * w[length - 1]) & (KEYWORD_SLOTS - 1);
+}
+
+class KeywordTable {
+ public:
+  KeywordTable() {
+    for (unsigned i = 0; i < KEYWORD_SLOTS; ++i)
+      slots[i] = token::IDENTIFIER;
+
+    for (int kind = token::BREAK; kind <= token::FALSE_LITERAL; ++kind) {
+      char const* word = token::spelling(token::Kind(kind));
+      unsigned slot = KeywordHash(word, std::strlen(word));
+      assert(slots[slot] == token::IDENTIFIER && "keyword hash is not perfect");
+      slots[slot] = token::Kind(kind);
+    }
+  }
+
+  token::Kind classify(char const* word, std::size_t length) const {
+    if (length < 2 || length > 10)
+      return token::IDENTIFIER;
+
+    token::Kind kind = slots[KeywordHash(word, length)];
+    if (kind == token::IDENTIFIER)
+      return kind;
+
+    char const* spelling = token::spelling(kind);
+    if (std::strlen(spelling) != length || std::memcmp(spelling, word, length) != 0)
+      return token::IDENTIFIER;
+
+    return kind;
+  }
+
+ private:
+  token::Kind slots[KEYWORD_SLOTS];
+};
+
+const KeywordTable KEYWORDS;
+
+inline bool IsIdentifierStart(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '$' || c == '_';
+}
+
+// FIXME: unicode characters and connectors
+inline bool IsIdentifierPart(char c) {
+  return IsIdentifierStart(c) || (c >= '0' && c <= '9');
+}
+
+inline bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+inline bool IsHexDigit(char c) {
+  return IsDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+inline bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+#if defined(KUNJS_SIMD_WIDTH)
+
+#if KUNJS_SIMD_WIDTH == 32
+typedef __m256i Block;
+inline Block Load(char const* p) { return _mm256_loadu_si256(reinterpret_cast<Block const*>(p)); }
+inline Block Splat(char c) { return _mm256_set1_epi8(c); }
+inline Block Equal(Block a, Block b) { return _mm256_cmpeq_epi8(a, b); }
+inline Block Either(Block a, Block b) { return _mm256_or_si256(a, b); }
+inline Block Both(Block a, Block b) { return _mm256_and_si256(a, b); }
+inline Block Minus(Block a, Block b) { return _mm256_sub_epi8(a, b); }
+inline Block Min(Block a, Block b) { return _mm256_min_epu8(a, b); }
+inline boost::uint32_t Mask(Block b) { return boost::uint32_t(_mm256_movemask_epi8(b)); }
+#else
+typedef __m128i Block;
+inline Block Load(char const* p) { return _mm_loadu_si128(reinterpret_cast<Block const*>(p)); }
+inline Block Splat(char c) { return _mm_set1_epi8(c); }
+inline Block Equal(Block a, Block b) { return _mm_cmpeq_epi8(a, b); }
+inline Block Either(Block a, Block b) { return _mm_or_si128(a, b); }
+inline Block Both(Block a, Block b) { return _mm_and_si128(a, b); }
+inline Block Minus(Block a, Block b) { return _mm_sub_epi8(a, b); }
+inline Block Min(Block a, Block b) { return _mm_min_epu8(a, b); }
+inline boost::uint32_t Mask(Block b) { return boost::uint32_t(_mm_movemask_epi8(b)); }
+#endif
+
+const std::ptrdiff_t WIDTH = KUNJS_SIMD_WIDTH;
+const boost::uint32_t WHOLE_BLOCK = boost::uint32_t(0xffffffffu >> (32 - KUNJS_SIMD_WIDTH));
+
+// Index of the lowest set bit; mask is not 0.
+inline unsigned LowestBit(boost::uint32_t mask) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return unsigned(index);
+#else
+  return unsigned(__builtin_ctz(mask));
+#endif
+}
+
+// One bit per byte of bytes that is whitespace: a space, or one of \t \n
+// \v \f \r, which are the consecutive codes 9 to 13.
+inline boost::uint32_t Blanks(Block bytes) {
+  Block controls = Minus(bytes, Splat('\t'));
+  Block in_range = Equal(Min(controls, Splat(4)), controls);
+  return Mask(Either(Equal(bytes, Splat(' ')), in_range));
+}
+
+#endif
+
+// First character from it on that is not whitespace, or last.
+inline char const* SkipBlanks(char const* it, char const* last) {
+  // most runs are a single space between two tokens
+  if (it == last || !IsSpace(*it))
+    return it;
+  ++it;
+#if defined(KUNJS_SIMD_WIDTH)
+  for (; last - it >= WIDTH; it += WIDTH) {
+    boost::uint32_t others = ~Blanks(Load(it)) & WHOLE_BLOCK;
+    if (others)
+      return it + LowestBit(others);
+  }
+#endif
+  for (; it != last && IsSpace(*it); ++it) {}
+  return it;
+}
+
+// First line terminator from it on, or last.
+inline char const* FindLineEnd(char const* it, char const* last) {
+#if defined(KUNJS_SIMD_WIDTH)
+  Block const lf = Splat('\n');
+  Block const cr = Splat('\r');
+  for (; last - it >= WIDTH; it += WIDTH) {
+    Block bytes = Load(it);
+    boost::uint32_t ends = Mask(Either(Equal(bytes, lf), Equal(bytes, cr)));
+    if (ends)
+      return it + LowestBit(ends);
+  }
+#endif
+  for (; it != last && *it != '\n' && *it != '\r'; ++it) {}
+  return it;
+}
+
+// The "*/" closing a block comment whose body starts at it, or 0.
+inline char const* FindCommentEnd(char const* it, char const* last) {
+#if defined(KUNJS_SIMD_WIDTH)
+  // a "*/" starts wherever a '*' is followed by a '/': compare the block
+  // with '*' and the block one byte further with '/'
+  Block const star = Splat('*');
+  Block const slash = Splat('/');
+  for (; last - it > WIDTH; it += WIDTH) {
+    boost::uint32_t ends = Mask(Both(Equal(Load(it), star), Equal(Load(it + 1), slash)));
+    if (ends)
+      return it + LowestBit(ends);
+  }
+#endif
+  for (; last - it >= 2; ++it) {
+    if (it[0] == '*' && it[1] == '/')
+      return it;
+  }
+  return 0;
+}
+
+// Skips whitespace and comments. Returns 0 on an unterminated block comment.
+char const* SkipSpace(char const* it, char const* last) {
+  while (true) {
+    it = SkipBlanks(it, last);
+    if (last - it < 2 || it[0] != '/') {
+      return it;
+    } else if (it[1] == '/') {
+      it = FindLineEnd(it + 2, last);
+    } else if (it[1] == '*') {
+      char const* end = FindCommentEnd(it + 2, last);
+      if (!end) return 0;
+      it = end + 2;
+    } else {
+      return it;
+    }
+  }
+}
+
+inline bool Next(char const* it, char const* last, std::size_t n, char c) {
+  return std::size_t(last - it) > n && it[n] == c;
+}
+
+// Longest match, dispatching on the first character. Returns KIND_COUNT when
+// no punctuator starts at it.
+token::Kind ScanPunctuator(char const* it, char const* last, std::size_t& length) {
+  length = 1;
+  switch (*it) {
+    case '{': return token::LBRACE;
+    case '}': return token::RBRACE;
+    case '(': return token::LPAREN;
+    case ')': return token::RPAREN;
+    case '[': return token::LBRACKET;
+    case ']': return token::RBRACKET;
+    case '.': return token::DOT;
+    case ';': return token::SEMICOLON;
+    case ',': return token::COMMA;
+    case '?': return token::CONDITIONAL;
+    case ':': return token::COLON;
+    case '~': return token::BIT_NOT;
+    case '<':
+      if (Next(it, last, 1, '<')) {
+        if (Next(it, last, 2, '=')) { length = 3; return token::ASSIGN_SHL; }
+        length = 2; return token::SHL;
+      }
+      if (Next(it, last, 1, '=')) { length = 2; return token::LTE; }
+      return token::LT;
+    case '>':
+      if (Next(it, last, 1, '>')) {
+        if (Next(it, last, 2, '>')) {
+          if (Next(it, last, 3, '=')) { length = 4; return token::ASSIGN_SHR; }
+          length = 3; return token::SHR;
+        }
+        if (Next(it, last, 2, '=')) { length = 3; return token::ASSIGN_SAR; }
+        length = 2; return token::SAR;
+      }
+      if (Next(it, last, 1, '=')) { length = 2; return token::GTE; }
+      return token::GT;
+    case '=':
+      if (Next(it, last, 1, '=')) {
+        if (Next(it, last, 2, '=')) { length = 3; return token::EQ_STRICT; }
+        length = 2; return token::EQ;
+      }
+      return token::ASSIGN;
+    case '!':
+      if (Next(it, last, 1, '=')) {
+        if (Next(it, last, 2, '=')) { length = 3; return token::NE_STRICT; }
+        length = 2; return token::NE;
+      }
+      return token::NOT;
+    case '+':
+      if (Next(it, last, 1, '+')) { length = 2; return token::INC; }
+      if (Next(it, last, 1, '=')) { length = 2; return token::ASSIGN_ADD; }
+      return token::ADD;
+    case '-':
+      if (Next(it, last, 1, '-')) { length = 2; return token::DEC; }
+      if (Next(it, last, 1, '=')) { length = 2; return token::ASSIGN_SUB; }
+      return token::SUB;
+    case '*':
+      if (Next(it, last, 1, '=')) { length = 2; return token::ASSIGN_MUL; }
+      return token::MUL;
+    case '/':
+      if (Next(it, last, 1, '=')) { length = 2; return token::ASSIGN_DIV; }
+      return token::DIV;
+    case '%':
+      if (Next(it, last, 1, '=')) { length = 2; return token::ASSIGN_MOD; }
+      return token::MOD;
+    case '&':
+      if (Next(it, last, 1, '&')) { length = 2; return token::AND; }
+      if (Next(it, last, 1, '=')) { length = 2; return token::ASSIGN_BIT_AND; }
+      return token::BIT_AND;
+    case '|':
+      if (Next(it, last, 1, '|')) { length = 2; return token::OR; }
+      if (Next(it, last, 1, '=')) { length = 2; return token::ASSIGN_BIT_OR; }
+      return token::BIT_OR;
+    case '^':
+      if (Next(it, last, 1, '=')) { length = 2; return token::ASSIGN_BIT_XOR; }
+      return token::BIT_XOR;
+    default:
+      return token::KIND_COUNT;
+  }
+}
+
+// Powers of ten that a double holds exactly.
+const double EXACT_POWERS_OF_TEN[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const int MAX_EXACT_POWER = 22;
+
+// Largest integer below which another decimal digit keeps a mantissa within
+// the 53 bits a double holds exactly.
+const boost::uint64_t MANTISSA_LIMIT = ((boost::uint64_t(1) << 53) - 9) / 10;
+
+// The value of a decimal literal that the fast path could not get exactly.
+double ConvertDecimal(char const* first, char const* last) {
+  char buffer[64];
+  std::size_t length = last - first;
+  if (length < sizeof(buffer)) {
+    std::memcpy(buffer, first, length);
+    buffer[length] = 0;
+    return std::strtod(buffer, 0);
+  }
+  return std::strtod(std::string(first, last).c_str(), 0);
+}
+
+// Scans a number in one pass. Integers (without a fraction or an exponent)
+// that fit in an int are ints; the rest are doubles. A mantissa of up to 15
+// digits scaled by at most 10^22 is converted exactly, with a single
+// multiplication or division: only longer literals go through strtod.
+char const* ScanNumber(char const* it, char const* last, ast::Numeric& value) {
+  char const* start = it;
+
+  if (*it == '0' && last - it > 2 && (it[1] == 'x' || it[1] == 'X') && IsHexDigit(it[2])) {
+    boost::uint64_t whole = 0;
+    double number = 0;
+    bool exact = true;
+    for (it += 2; it != last && IsHexDigit(*it); ++it) {
+      unsigned digit = IsDigit(*it) ? *it - '0' : (*it | 0x20) - 'a' + 10;
+      if (exact && whole >> 49 == 0) {
+        whole = whole * 16 + digit;
+      } else {
+        // past 2^53, each digit rounds
+        if (exact) number = double(whole);
+        exact = false;
+        number = number * 16 + digit;
+      }
+    }
+
+    if (exact && whole <= boost::uint64_t(std::numeric_limits<int>::max()))
+      value = int(whole);
+    else
+      value = exact ? double(whole) : number;
+    return it;
+  }
+
+  boost::uint64_t mantissa = 0;
+  int exponent = 0;
+  bool exact = true;
+  for (; it != last && IsDigit(*it); ++it) {
+    if (mantissa < MANTISSA_LIMIT)
+      mantissa = mantissa * 10 + (*it - '0');
+    else
+      exact = false;
+  }
+
+  bool integer = true;
+  if (it != last && *it == '.') {
+    integer = false;
+    for (++it; it != last && IsDigit(*it); ++it) {
+      if (mantissa < MANTISSA_LIMIT) {
+        mantissa = mantissa * 10 + (*it - '0');
+        --exponent;
+      } else if (*it != '0') {
+        exact = false;
+      }
+    }
+  }
+  if (it != last && (*it == 'e' || *it == 'E')) {
+    char const* digits = it + 1;
+    bool negative = digits != last && *digits == '-';
+    if (digits != last && (*digits == '+' || *digits == '-')) ++digits;
+    if (digits != last && IsDigit(*digits)) {
+      integer = false;
+      int scale = 0;
+      for (it = digits; it != last && IsDigit(*it); ++it) {
+        if (scale < 10000)
+          scale = scale * 10 + (*it - '0');
+      }
+      exponent += negative ? -scale : scale;
+    }
+  }
+
+  if (integer && exact) {
+    if (mantissa <= boost::uint64_t(std::numeric_limits<int>::max()))
+      value = int(mantissa);
+    else
+      value = double(mantissa);
+  } else if (exact && exponent >= -MAX_EXACT_POWER && exponent <= MAX_EXACT_POWER) {
+    value = exponent < 0 ? double(mantissa) / EXACT_POWERS_OF_TEN[-exponent]
+                         : double(mantissa) * EXACT_POWERS_OF_TEN[exponent];
+  } else {
+    value = ConvertDecimal(start, it);
+  }
+  return it;
+}
+
+#if defined(KUNJS_SIMD_WIDTH)
+// One bit per byte of bytes that is quote or a backslash.
+inline boost::uint32_t QuotesAndEscapes(Block bytes, Block quote) {
+  return Mask(Either(Equal(bytes, quote), Equal(bytes, Splat('\\'))));
+}
+#endif
+
+// Returns one past the closing quote, or 0 when the literal is unterminated.
+// escaped tells whether the literal has escape sequences.
+char const* ScanString(char const* it, char const* last, bool& escaped) {
+  char quote = *it;
+  escaped = false;
+  ++it;
+  while (true) {
+#if defined(KUNJS_SIMD_WIDTH)
+    Block const quotes = Splat(quote);
+    for (; last - it >= WIDTH; it += WIDTH) {
+      boost::uint32_t stops = QuotesAndEscapes(Load(it), quotes);
+      if (stops) {
+        it += LowestBit(stops);
+        break;
+      }
+    }
+#endif
+    for (; it != last && *it != quote && *it != '\\'; ++it) {}
+    if (it == last) return 0;
+    if (*it == quote) return it + 1;
+
+    escaped = true;
+    if (last - it < 2) return 0;
+    it += 2;
+  }
+}
+
+inline unsigned HexValue(char c) {
+  return IsDigit(c) ? c - '0' : (c | 0x20) - 'a' + 10;
+}
+
+inline bool IsOctalDigit(char c) {
+  return c >= '0' && c <= '7';
+}
+
+void AppendUtf8(unsigned code, ast::String& out) {
+  if (code < 0x80) {
+    out += char(code);
+  } else if (code < 0x800) {
+    out += char(0xc0 | (code >> 6));
+    out += char(0x80 | (code & 0x3f));
+  } else {
+    out += char(0xe0 | (code >> 12));
+    out += char(0x80 | ((code >> 6) & 0x3f));
+    out += char(0x80 | (code & 0x3f));
+  }
+}
+
+// Appends the value of the body of a string literal with escapes in it.
+// Unknown escapes stand for the character escaped, and so do \x and \u
+// without enough hex digits after them.
+void Decode(char const* it, char const* last, ast::String& out) {
+  while (it != last) {
+    char const* plain = it;
+    for (; it != last && *it != '\\'; ++it) {}
+    out.append(plain, it);
+    if (it == last) break;
+
+    char c = *++it;
+    ++it;
+    switch (c) {
+      case 'n': out += '\n'; break;
+      case 't': out += '\t'; break;
+      case 'r': out += '\r'; break;
+      case 'b': out += '\b'; break;
+      case 'f': out += '\f'; break;
+      case 'v': out += '\v'; break;
+      case '\r':
+        // a line continuation stands for nothing
+        if (it != last && *it == '\n') ++it;
+        break;
+      case '\n':
+        break;
+      case 'x':
+        if (last - it >= 2 && IsHexDigit(it[0]) && IsHexDigit(it[1])) {
+          AppendUtf8(HexValue(it[0]) * 16 + HexValue(it[1]), out);
+          it += 2;
+        } else {
+          out += c;
+        }
+        break;
+      case 'u':
+        if (last - it >= 4 && IsHexDigit(it[0]) && IsHexDigit(it[1]) &&
+            IsHexDigit(it[2]) && IsHexDigit(it[3])) {
+          AppendUtf8((HexValue(it[0]) << 12) | (HexValue(it[1]) << 8) |
+                     (HexValue(it[2]) << 4) | HexValue(it[3]), out);
+          it += 4;
+        } else {
+          out += c;
+        }
+        break;
+      default:
+        if (IsOctalDigit(c)) {
+          // legacy octal escapes, up to \377
+          unsigned code = c - '0';
+          if (it != last && IsOctalDigit(*it)) {
+            code = code * 8 + (*it++ - '0');
+            if (c <= '3' && it != last && IsOctalDigit(*it))
+              code = code * 8 + (*it++ - '0');
+          }
+          AppendUtf8(code, out);
+        } else {
+          out += c;
+        }
+        break;
+    }
+  }
+}
+
+}
+
+std::ostream& operator<<(std::ostream& out, Token const& token) {
+  char const* spelling = token::spelling(token.kind);
+  if (spelling)
+    return out << spelling;
+
+  return out << "(token " << token.kind << " @" << token.offset << ")";
+}
+
+TokenStream::TokenStream()
+    : source(0), origin(0), skip_function_bodies(false), table(&own_atoms), furthest(0) {}
+
+TokenStream::TokenStream(AtomTable& atoms)
+    : source(0), origin(0), skip_function_bodies(false), table(&atoms), furthest(0) {}
+
+// Cached, so that the lexer hands out reserved words' atoms (which the
+// grammar needs for property names like `object.default`) with a table
+// lookup instead of hashing their spelling every time.
+Atom TokenStream::reserved(token::Kind kind) {
+  Atom& atom = reserved_atoms[kind - token::BREAK];
+  if (atom == Atom())
+    atom = table->intern(token::spelling(kind));
+  return atom;
+}
+
+TokenStream::iterator TokenStream::begin() const {
+  return iterator(this, tokens.empty() ? 0 : &tokens[0]);
+}
+
+TokenStream::iterator TokenStream::end() const {
+  return iterator(this, tokens.empty() ? 0 : &tokens[0] + tokens.size());
+}
+
+void TokenStream::clear() {
+  source = 0;
+  tokens.clear();
+  numbers.clear();
+  origin = 0;
+  skip_function_bodies = false;
+  furthest = 0;
+}
+
+TokenStream::iterator TokenStream::reached() const {
+  return furthest ? iterator(this, furthest) : begin();
+}
+
+void TokenStream::restart() const {
+  furthest = tokens.empty() ? 0 : &tokens[0];
+}
+
+std::string TokenStream::text(Token const& token) const {
+  return std::string(source + token.offset + 1, source + token.offset + token.length - 1);
+}
+
+void TokenStream::string(Token const& token, ast::String& value) const {
+  char const* first = source + token.offset + 1;
+  char const* last = source + token.offset + token.length - 1;
+  if (token.value) {
+    value.clear();
+    value.reserve(last - first);
+    Decode(first, last, value);
+  } else {
+    value.assign(first, last);
+  }
+}
+
+// Only whitespace and comments are between two tokens, so any line
+// terminator there is one the grammar has to know about.
+bool TokenIterator::follows_line_break() const {
+  if (position == &owner->tokens[0])
+    return false;
+
+  Token const& previous = position[-1];
+  char const* first = owner->source + previous.offset + previous.length;
+  char const* last = owner->source + position->offset;
+  return FindLineEnd(first, last) != last;
+}
+
+// Bytes per token range from about 3 in dense code to far more in commented
+// code, so no one guess from the size fits both: the tokens of the first
+// bytes tell how many the rest will have.
+const std::ptrdiff_t DENSITY_SAMPLE = 4096;
+
+std::size_t Lexer::tokenize(char const* first, char const* last, TokenStream& stream) const {
+  stream.source = first;
+  std::size_t const before = stream.tokens.size();
+  char const* sampled = last - first > DENSITY_SAMPLE ? first + DENSITY_SAMPLE : 0;
+
+  char const* it = first;
+  while (true) {
+    char const* next = SkipSpace(it, last);
+    if (!next) break;
+    it = next;
+    if (it == last) break;
+
+    Token token;
+    token.offset = boost::uint32_t(it - first);
+    token.value = 0;
+
+    if (IsIdentifierStart(*it)) {
+      char const* end = it + 1;
+      for (; end != last && IsIdentifierPart(*end); ++end) {}
+      token.kind = KEYWORDS.classify(it, end - it);
+      if (token.kind == token::IDENTIFIER)
+        token.value = stream.atoms().intern(it, end).id;
+      else
+        token.value = stream.reserved(token.kind).id;
+      it = end;
+    } else if (IsDigit(*it) || (*it == '.' && last - it > 1 && IsDigit(it[1]))) {
+      ast::Numeric number;
+      token.kind = token::NUMBER;
+      token.value = boost::uint32_t(stream.numbers.size());
+      it = ScanNumber(it, last, number);
+      stream.numbers.push_back(number);
+    } else if (*it == '"' || *it == '\'') {
+      bool escaped;
+      char const* end = ScanString(it, last, escaped);
+      if (!end) break;
+      token.kind = token::STRING;
+      token.value = escaped;
+      it = end;
+    } else {
+      std::size_t length;
+      token.kind = ScanPunctuator(it, last, length);
+      if (token.kind == token::KIND_COUNT) break;
+      it += length;
+    }
+
+    token.length = boost::uint32_t(it - first) - token.offset;
+    stream.tokens.push_back(token);
+
+    if (sampled && it >= sampled) {
+      // room for the rest at the density of the sample, and an eighth more
+      std::size_t found = stream.tokens.size() - before;
+      stream.tokens.reserve(stream.tokens.size() + found * (last - it) / (it - first) * 9 / 8);
+      sampled = 0;
+    }
+  }
+
+  return it - first;
+}
+
+} // namespace kunjs
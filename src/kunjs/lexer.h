@@ -0,0 +1,271 @@
+#ifndef KUNJS_LEXER_H_
+#define KUNJS_LEXER_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "kunjs/ast.h"
+#include "kunjs/atom.h"
+
+#include <boost/cstdint.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace kunjs {
+
+// T(name, spelling) for every token kind. Kinds with a null spelling carry
+// a value (see Token::value).
+#define KUNJS_TOKEN_LIST(T)                  \
+  T(IDENTIFIER, 0)                           \
+  T(NUMBER, 0)                               \
+  T(STRING, 0)                               \
+  /* keywords */                             \
+  T(BREAK, "break")                          \
+  T(CASE, "case")                            \
+  T(CATCH, "catch")                          \
+  T(CONTINUE, "continue")                    \
+  T(DEBUGGER, "debugger")                    \
+  T(DEFAULT, "default")                      \
+  T(DELETE, "delete")                        \
+  T(DO, "do")                                \
+  T(ELSE, "else")                            \
+  T(FINALLY, "finally")                      \
+  T(FOR, "for")                              \
+  T(FUNCTION, "function")                    \
+  T(IF, "if")                                \
+  T(IN, "in")                                \
+  T(INSTANCEOF, "instanceof")                \
+  T(NEW, "new")                              \
+  T(RETURN, "return")                        \
+  T(SWITCH, "switch")                        \
+  T(THIS, "this")                            \
+  T(THROW, "throw")                          \
+  T(TRY, "try")                              \
+  T(TYPEOF, "typeof")                        \
+  T(VAR, "var")                              \
+  T(VOID, "void")                            \
+  T(WHILE, "while")                          \
+  T(WITH, "with")                            \
+  /* future reserved words */                \
+  T(CLASS, "class")                          \
+  T(CONST, "const")                          \
+  T(ENUM, "enum")                            \
+  T(EXPORT, "export")                        \
+  T(EXTENDS, "extends")                      \
+  T(IMPLEMENTS, "implements")                \
+  T(IMPORT, "import")                        \
+  T(INTERFACE, "interface")                  \
+  T(LET, "let")                              \
+  T(PACKAGE, "package")                      \
+  T(PRIVATE, "private")                      \
+  T(PROTECTED, "protected")                  \
+  T(PUBLIC, "public")                        \
+  T(STATIC, "static")                        \
+  T(SUPER, "super")                          \
+  T(YIELD, "yield")                          \
+  /* literal words */                        \
+  T(NULL_LITERAL, "null")                    \
+  T(TRUE_LITERAL, "true")                    \
+  T(FALSE_LITERAL, "false")                  \
+  /* punctuators */                          \
+  T(LBRACE, "{")                             \
+  T(RBRACE, "}")                             \
+  T(LPAREN, "(")                             \
+  T(RPAREN, ")")                             \
+  T(LBRACKET, "[")                           \
+  T(RBRACKET, "]")                           \
+  T(DOT, ".")                                \
+  T(SEMICOLON, ";")                          \
+  T(COMMA, ",")                              \
+  T(CONDITIONAL, "?")                        \
+  T(COLON, ":")                              \
+  T(LT, "<")                                 \
+  T(GT, ">")                                 \
+  T(LTE, "<=")                               \
+  T(GTE, ">=")                               \
+  T(EQ, "==")                                \
+  T(NE, "!=")                                \
+  T(EQ_STRICT, "===")                        \
+  T(NE_STRICT, "!==")                        \
+  T(ADD, "+")                                \
+  T(SUB, "-")                                \
+  T(MUL, "*")                                \
+  T(DIV, "/")                                \
+  T(MOD, "%")                                \
+  T(INC, "++")                               \
+  T(DEC, "--")                               \
+  T(SHL, "<<")                               \
+  T(SAR, ">>")                               \
+  T(SHR, ">>>")                              \
+  T(BIT_AND, "&")                            \
+  T(BIT_OR, "|")                             \
+  T(BIT_XOR, "^")                            \
+  T(NOT, "!")                                \
+  T(BIT_NOT, "~")                            \
+  T(AND, "&&")                               \
+  T(OR, "||")                                \
+  T(ASSIGN, "=")                             \
+  T(ASSIGN_ADD, "+=")                        \
+  T(ASSIGN_SUB, "-=")                        \
+  T(ASSIGN_MUL, "*=")                        \
+  T(ASSIGN_DIV, "/=")                        \
+  T(ASSIGN_MOD, "%=")                        \
+  T(ASSIGN_SHL, "<<=")                       \
+  T(ASSIGN_SAR, ">>=")                       \
+  T(ASSIGN_SHR, ">>>=")                      \
+  T(ASSIGN_BIT_AND, "&=")                    \
+  T(ASSIGN_BIT_OR, "|=")                     \
+  T(ASSIGN_BIT_XOR, "^=")
+
+namespace token {
+
+#define T(name, spelling) name,
+enum Kind {
+  KUNJS_TOKEN_LIST(T)
+  KIND_COUNT
+};
+#undef T
+
+// The source text of a keyword or punctuator; null for IDENTIFIER, NUMBER
+// and STRING.
+char const* spelling(Kind kind);
+
+// Keywords, future reserved words and literal words: everything that looks
+// like an identifier but is not one.
+inline bool is_reserved(Kind kind) {
+  return kind >= BREAK && kind <= FALSE_LITERAL;
+}
+
+} // namespace token
+
+// 16 bytes per token. value is the id of the name's Atom for identifiers and
+// reserved words, an index into TokenStream::numbers for numbers, 1 for
+// string literals with escape sequences (0 for the others), and unused
+// otherwise.
+struct Token {
+  token::Kind kind;
+  boost::uint32_t offset;
+  boost::uint32_t length;
+  boost::uint32_t value;
+};
+
+std::ostream& operator<<(std::ostream& out, Token const& token);
+
+class TokenIterator;
+
+// The tokens of one source, plus the side tables their values refer to.
+// Names are interned into an AtomTable, which is usually shared by all the
+// streams of an engine and outlives them; a stream created without one
+// keeps its own.
+class TokenStream : private boost::noncopyable {
+ public:
+  typedef TokenIterator iterator;
+
+  TokenStream();
+  explicit TokenStream(AtomTable& atoms);
+
+  iterator begin() const;
+  iterator end() const;
+
+  // Drops the tokens; the atoms stay in their table.
+  void clear();
+
+  // The furthest token an iterator over the stream has been moved to since
+  // the last restart(): where a parse that failed without an expectation
+  // failure got stuck.
+  iterator reached() const;
+  void restart() const;
+
+  AtomTable& atoms() const { return *table; }
+  Atom atom(Token const& token) const { return Atom(token.value); }
+  std::string const& name(Token const& token) const { return table->name(atom(token)); }
+
+  // Atom of a reserved word's spelling (see token::is_reserved), interned
+  // the first time the stream asks for it.
+  Atom reserved(token::Kind kind);
+
+  // Text of a string literal, without its quotes, as it is in the source.
+  std::string text(Token const& token) const;
+
+  // Value of a string literal: its text with the escape sequences decoded
+  // (\u escapes into UTF-8). Literals without escapes, which most are, are
+  // copied straight from the source.
+  void string(Token const& token, ast::String& value) const;
+
+  // Start of the tokenized source: token offsets are relative to it, and it
+  // must outlive any use of the stream.
+  char const* source;
+  std::vector<Token> tokens;
+  std::vector<ast::Numeric> numbers;
+
+  // Offset of source in the script it is part of, when only a piece of a
+  // script was tokenized (see Parser::parse_body).
+  boost::uint32_t origin;
+
+  // Read by the grammar: function bodies are skipped rather than parsed
+  // (see Parser::PREPARSE).
+  bool skip_function_bodies;
+
+ private:
+  friend class TokenIterator;
+
+  AtomTable own_atoms;
+  AtomTable* table;
+  mutable Token const* furthest;
+  Atom reserved_atoms[token::FALSE_LITERAL - token::BREAK + 1];
+};
+
+// Random access over the tokens of a stream. Grammar primitives reach the
+// stream's side tables through it.
+class TokenIterator
+    : public boost::iterator_facade<
+          TokenIterator, Token const, boost::random_access_traversal_tag> {
+ public:
+  TokenIterator() : owner(0), position(0) {}
+  TokenIterator(TokenStream const* stream, Token const* position)
+      : owner(stream), position(position) {}
+
+  TokenStream const& stream() const { return *owner; }
+
+  // Whether a line terminator, maybe inside a comment, comes between the
+  // token and the one before it; false for the first token.
+  bool follows_line_break() const;
+
+ private:
+  friend class boost::iterator_core_access;
+
+  Token const& dereference() const { return *position; }
+  bool equal(TokenIterator const& other) const { return position == other.position; }
+  void increment() { ++position; Reach(); }
+  void decrement() { --position; }
+  void advance(std::ptrdiff_t n) { position += n; Reach(); }
+
+  void Reach() const {
+    if (!owner->furthest || position > owner->furthest)
+      owner->furthest = position;
+  }
+  std::ptrdiff_t distance_to(TokenIterator const& other) const { return other.position - position; }
+
+  TokenStream const* owner;
+  Token const* position;
+};
+
+// Splits JavaScript source into tokens. Whitespace and comments are dropped;
+// keywords are told apart from identifiers with a perfect hash.
+class Lexer {
+ public:
+  // Appends the tokens of [first, last) to stream and returns the offset of
+  // the first character that could not be tokenized, which is
+  // (last - first) when the whole input was consumed.
+  std::size_t tokenize(char const* first, char const* last, TokenStream& stream) const;
+};
+
+} // namespace kunjs
+
+#endif // KUNJS_LEXER_H_
@@ -0,0 +1,103 @@
+#include "kunjs/parse_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(_WIN32)
+#include <process.h>
+#define KUNJS_GETPID _getpid
+#else
+#include <unistd.h>
+#define KUNJS_GETPID getpid
+#endif
+
+namespace kunjs {
+
+ParseCache::ParseCache(std::string const& directory) : directory(directory) {}
+
+boost::uint64_t ParseCache::hash(Source code) {
+  boost::uint64_t value = 14695981039346656037ull;
+  for (char const* it = code.begin(); it != code.end(); ++it) {
+    value ^= static_cast<unsigned char>(*it);
+    value *= 1099511628211ull;
+  }
+  return value;
+}
+
+std::string ParseCache::path(Source code) const {
+  std::ostringstream name;
+  name << directory << "/" << std::hex << hash(code) << "-" << std::dec << code.size() << ".kast";
+  return name.str();
+}
+
+// An entry starts with the size of its source and the source itself: the
+// name only tells which entry to look at, as different sources can have it.
+bool ParseCache::load(Source code, AtomTable& atoms, flat::Tree& tree) const {
+  MappedFile file;
+  if (!file.open(path(code)))
+    return false;
+
+  Source entry = file.source();
+  boost::uint64_t size;
+  if (entry.size() < sizeof(size))
+    return false;
+  std::memcpy(&size, entry.begin(), sizeof(size));
+  char const* source = entry.begin() + sizeof(size);
+  if (size != code.size() || std::size_t(entry.end() - source) < code.size() ||
+      std::memcmp(source, code.begin(), code.size()) != 0)
+    return false;
+  return flat::read(Source(source + code.size(), entry.end()), atoms, tree);
+}
+
+bool ParseCache::store(Source code, flat::Tree const& tree) const {
+  boost::uint64_t size = code.size();
+  std::string data(reinterpret_cast<char const*>(&size), sizeof(size));
+  data.append(code.begin(), code.end());
+  flat::write(tree, data);
+
+  std::string target = path(code);
+  std::ostringstream temporary;
+  temporary << target << "." << KUNJS_GETPID() << ".tmp";
+  {
+    std::ofstream file(temporary.str().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+    if (!file.flush()) {
+      file.close();
+      std::remove(temporary.str().c_str());
+      return false;
+    }
+  }
+
+#if defined(_WIN32)
+  // rename() only replaces an existing file on POSIX
+  std::remove(target.c_str());
+#endif
+  if (std::rename(temporary.str().c_str(), target.c_str()) != 0) {
+    std::remove(temporary.str().c_str());
+    return false;
+  }
+  return true;
+}
+
+ParseResult ParseCache::parse(Parser const& parser, Source code, AtomTable& atoms,
+                              flat::Tree& tree, bool* hit) const {
+  ParseResult result;
+  result.success = load(code, atoms, tree);
+  if (hit)
+    *hit = result.success;
+  if (result.success)
+    return result;
+
+  ParsedProgram parsed(atoms);
+  result = parser.parse(code, parsed);
+  if (result) {
+    flat::flatten(parsed.program(), atoms, tree);
+    store(code, tree);
+  }
+  return result;
+}
+
+} // namespace kunjs
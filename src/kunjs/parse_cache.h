@@ -0,0 +1,57 @@
+#ifndef KUNJS_PARSE_CACHE_H_
+#define KUNJS_PARSE_CACHE_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "kunjs/atom.h"
+#include "kunjs/flat_ast.h"
+#include "kunjs/parser.h"
+#include "kunjs/source.h"
+
+#include <boost/cstdint.hpp>
+
+#include <string>
+
+namespace kunjs {
+
+// Parsed programs kept on disk between runs, so that a script that has not
+// changed since it was last seen is read back as a flat::Tree instead of
+// being parsed again. Entries are files of the directory given to the
+// constructor (which must exist), named after a hash and the size of the
+// source. Each holds the source it was parsed from, which a hit must match
+// byte for byte, and then the tree in the format of flat::write. An entry
+// that cannot be read (of another source of the same name, of an older
+// format, or cut short) is a miss and is written again.
+//
+// Any number of processes may share a directory: entries are written to a
+// temporary file first and renamed into place.
+class ParseCache {
+ public:
+  explicit ParseCache(std::string const& directory);
+
+  // Reads code's entry into tree, interning its names into atoms. False
+  // when there is no usable entry.
+  bool load(Source code, AtomTable& atoms, flat::Tree& tree) const;
+
+  // Writes tree as code's entry; false when the file cannot be written.
+  bool store(Source code, flat::Tree const& tree) const;
+
+  // Loads code's entry or, on a miss, parses code in full, flattens it into
+  // tree and stores it. hit tells which one happened.
+  ParseResult parse(Parser const& parser, Source code, AtomTable& atoms,
+                    flat::Tree& tree, bool* hit = 0) const;
+
+  std::string path(Source code) const;
+
+  // 64-bit FNV-1a of the bytes of code.
+  static boost::uint64_t hash(Source code);
+
+ private:
+  std::string directory;
+};
+
+} // namespace kunjs
+
+#endif // KUNJS_PARSE_CACHE_H_
@@ -0,0 +1,86 @@
+#include "kunjs/parse_job.h"
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+
+namespace kunjs {
+
+namespace {
+
+boost::posix_time::ptime Now() {
+  return boost::posix_time::microsec_clock::universal_time();
+}
+
+}
+
+ParseJob::ParseJob(Parser const& parser, std::size_t threads)
+    : parser(parser), workers(threads), next(0) {
+  if (!workers)
+    workers = std::max(1u, boost::thread::hardware_concurrency());
+}
+
+void ParseJob::add(Source code) {
+  ParsedFile* file = new ParsedFile();
+  files.push_back(file);
+  file->code = code;
+}
+
+void ParseJob::add_file(std::string const& path) {
+  ParsedFile* file = new ParsedFile();
+  files.push_back(file);
+  file->path = path;
+}
+
+bool ParseJob::run(Parser::Mode mode) {
+  next = 0;
+  std::size_t count = std::min(workers, files.size());
+  if (count <= 1) {
+    Work(mode);
+  } else {
+    // the calling thread is one of the workers
+    boost::thread_group group;
+    for (std::size_t i = 1; i < count; ++i)
+      group.create_thread(boost::bind(&ParseJob::Work, this, mode));
+    Work(mode);
+    group.join_all();
+  }
+
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    if (!files[i].result)
+      return false;
+  }
+  return true;
+}
+
+void ParseJob::Work(Parser::Mode mode) {
+  while (true) {
+    std::size_t i;
+    {
+      boost::mutex::scoped_lock taking(lock);
+      if (next == files.size())
+        return;
+      i = next++;
+    }
+    Parse(files[i], mode);
+  }
+}
+
+void ParseJob::Parse(ParsedFile& file, Parser::Mode mode) {
+  boost::posix_time::ptime start = Now();
+  if (!file.path.empty()) {
+    file.readable = file.file.is_open() || file.file.open(file.path);
+    file.code = file.file.source();
+  }
+
+  if (file.readable)
+    file.result = parser.parse(file.code, file.program, mode);
+  else
+    file.result = ParseResult();
+
+  file.elapsed_us = static_cast<double>((Now() - start).total_microseconds());
+}
+
+} // namespace kunjs
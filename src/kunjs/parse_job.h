@@ -0,0 +1,93 @@
+#ifndef KUNJS_PARSE_JOB_H_
+#define KUNJS_PARSE_JOB_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "kunjs/parser.h"
+#include "kunjs/source.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace kunjs {
+
+// One input of a ParseJob, and what came of it.
+struct ParsedFile : private boost::noncopyable {
+  ParsedFile() : readable(true), elapsed_us(0) {}
+
+  // Empty for inputs given as text.
+  std::string path;
+
+  // False when the file could not be mapped; it was not parsed, then.
+  bool readable;
+  ParseResult result;
+
+  // Time spent mapping (for files) and parsing it, in microseconds.
+  double elapsed_us;
+
+  // Has an atom table of its own: tables are not synchronized, so programs
+  // parsed at the same time cannot share one.
+  ParsedProgram program;
+
+ private:
+  friend class ParseJob;
+
+  Source code;
+  MappedFile file;
+};
+
+// Parses many scripts at once, one per worker thread at a time. Workers
+// take the next input as soon as they are done with one, so a few big files
+// do not hold back the rest. The Parser is shared by all of them; each
+// input gets its own ParsedProgram (and so its own arena), and the results
+// are kept in the order the inputs were added, whichever finished first.
+//
+//   ParseJob job(parser);
+//   job.add_file("lib/jquery.js");
+//   job.add_file("app.js");
+//   job.run();
+//   for (std::size_t i = 0; i < job.size(); ++i)
+//     if (!job[i].result) ...
+class ParseJob : private boost::noncopyable {
+ public:
+  // With threads = 0, one worker per hardware thread.
+  explicit ParseJob(Parser const& parser, std::size_t threads = 0);
+
+  // The text is not copied: it must stay there until the job is destroyed
+  // (and for parse_body, after a PREPARSE).
+  void add(Source code);
+  // Mapped when its turn comes (see MappedFile), and unmapped with the job.
+  void add_file(std::string const& path);
+
+  // Parses every input added so far; true when they all parsed.
+  bool run(Parser::Mode mode = Parser::FULL);
+
+  std::size_t threads() const { return workers; }
+  std::size_t size() const { return files.size(); }
+  ParsedFile const& operator[](std::size_t i) const { return files[i]; }
+  ParsedFile& operator[](std::size_t i) { return files[i]; }
+
+  // Source of input i, for Parser::parse_body.
+  Source code(std::size_t i) const { return files[i].code; }
+
+ private:
+  void Work(Parser::Mode mode);
+  void Parse(ParsedFile& file, Parser::Mode mode);
+
+  Parser const& parser;
+  std::size_t workers;
+  boost::ptr_vector<ParsedFile> files;
+
+  boost::mutex lock;
+  std::size_t next;
+};
+
+} // namespace kunjs
+
+#endif // KUNJS_PARSE_JOB_H_
@@ -1,40 +1,163 @@
 #include "kunjs/parser.h"
 #include "kunjs/grammar.h"
-#include "kunjs/printer.h"
 
 #include <boost/spirit/include/qi_parse.hpp>
+#include <boost/spirit/include/qi_expect.hpp>
+#include <boost/spirit/home/support/utf8.hpp>
+
+#include <new>
+#include <ostream>
 #include <string>
+#include <vector>
 
 namespace kunjs {
 
-bool Parser::parse(std::string code, ast::Program& ast) {
-  typedef kunjs::javascript_grammar<std::string::const_iterator> javascript;
-  javascript grammar;
-  std::string::const_iterator begin = code.begin();
-  std::string::const_iterator end = code.end();
+namespace {
+
+void Locate(Source code, ParseResult& result) {
+  Location location = LineTable(code).locate(boost::uint32_t(result.offset));
+  result.line = location.line;
+  result.column = location.column;
+}
+
+std::string Describe(qi::info const& what) {
+  // literals are tagged "literal-char"/"literal-string"; the literal itself
+  // is far more useful in an error message
+  if (boost::spirit::utf8_string const* literal = boost::get<boost::spirit::utf8_string>(&what.value))
+    return '"' + *literal + '"';
+
+  return what.tag;
+}
+
+}
+
+std::ostream& operator<<(std::ostream& out, ParseResult const& result) {
+  if (result.success)
+    return out << "Parsing succeeded";
 
-  bool result = phrase_parse(begin, end, grammar, boost::spirit::ascii::space, ast);
+  out << "Parsing failed at line " << result.line << ", column " << result.column;
+  if (!result.expected.empty())
+    out << ": expecting " << result.expected;
 
-  ASTPrinter print_ast(0);
-  print_ast(ast);
+  return out;
+}
+
+ParsedProgram::ParsedProgram() : root(0) {
+  clear();
+}
 
-  std::cout << "Result: " << std::boolalpha << result << "\n";
-  if (result && begin == end) {
-    std::cout << "-------------------------\n";
-    std::cout << "Parsing succeeded\n";
-    std::cout << "\n-------------------------\n";
-    return true;
+ParsedProgram::ParsedProgram(AtomTable& atoms) : tokens(atoms), root(0) {
+  clear();
+}
+
+// Nothing in the tree owns memory outside of the arena, so there is no need
+// to run its destructors.
+ParsedProgram::~ParsedProgram() {}
+
+void ParsedProgram::clear() {
+  memory.reset();
+  Arena::Scope scope(memory);
+  root = new (memory.allocate(sizeof(ast::Program))) ast::Program();
+}
+
+Parser::Parser() : grammar(new grammar_type()) {}
+
+Parser::~Parser() {}
+
+template <typename Rule, typename Attribute>
+ParseResult Parser::parse(Source code, char const* first, char const* last,
+                          TokenStream& tokens, Rule const& rule, Attribute& attr) const {
+  ParseResult result;
+  std::size_t origin = first - code.begin();
+
+  result.offset = origin + lexer.tokenize(first, last, tokens);
+  if (result.offset != origin + (last - first)) {
+    result.expected = "token";
+    Locate(code, result);
+    return result;
   }
-  else {
-    std::string rest(begin, end);
-    std::cout << "-------------------------\n";
-    std::cout << "Parsing failed\n";
-    std::cout << "stopped at: \": " << rest << "\"\n";
-    std::cout << "-------------------------\n";
-    return false;
+
+  TokenIterator begin = tokens.begin();
+  TokenIterator end = tokens.end();
+  tokens.restart();
+
+  try {
+    result.success = qi::parse(begin, end, rule, attr) && begin == end;
+    if (!result.success)
+      begin = tokens.reached();
+  } catch (qi::expectation_failure<TokenIterator> const& failure) {
+    begin = failure.first;
+    result.expected = Describe(failure.what_);
   }
 
+  if (!result.success) {
+    result.offset = begin == end ? last - code.begin() : origin + begin->offset;
+    Locate(code, result);
+  }
+
+  return result;
 }
 
-} // namespace kunjs
+ParseResult Parser::parse(Source code) const {
+  ast::Program ast;
+  TokenStream tokens;
+  return parse(code, tokens, ast);
+}
+
+ParseResult Parser::parse(Source code, ast::Program& ast, AtomTable& atoms) const {
+  TokenStream tokens(atoms);
+  return parse(code, tokens, ast);
+}
+
+ParseResult Parser::parse(Source code, ParsedProgram& parsed, Mode mode) const {
+  parsed.clear();
+  parsed.tokens.clear();
+  parsed.tokens.skip_function_bodies = mode == PREPARSE;
+  parsed.line_table.build(code);
+
+  Arena::Scope scope(parsed.memory);
+  return parse(code, parsed.tokens, *parsed.root);
+}
+
+ParseResult Parser::parse_body(Source code, ParsedProgram& parsed,
+                               ast::FunctionBody& body) const {
+  ParseResult result;
+  if (!body.lazy) {
+    result.success = true;
+    return result;
+  }
+
+  ast::Span source = body.source;
+  char const* first = code.begin() + source.offset;
+  char const* last = first + source.length;
 
+  parsed.tokens.clear();
+  parsed.tokens.origin = source.offset;
+  parsed.tokens.skip_function_bodies = true;
+
+  Arena::Scope scope(parsed.memory);
+  body.lazy = false;
+  result = parse(code, first, last, parsed.tokens, grammar->function_body, body);
+
+  // a body that does not parse stays lazy (and empty), as if never tried
+  if (!result) {
+    body.clear();
+    body.lazy = true;
+    body.source = source;
+  }
+  return result;
+}
+
+ParseResult Parser::parse(Source code, TokenStream& tokens, ast::Program& ast) const {
+  return parse(code, code.begin(), code.end(), tokens, *grammar, ast);
+}
+
+std::vector<ast::Program> Parser::parse_many(std::vector<std::string> const& codes, AtomTable& atoms) const {
+  std::vector<ast::Program> programs(codes.size());
+  for (std::vector<std::string>::size_type i = 0; i < codes.size(); ++i)
+    parse(codes[i], programs[i], atoms);
+
+  return programs;
+}
+
+} // namespace kunjs
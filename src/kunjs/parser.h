@@ -5,23 +5,128 @@
 #pragma once
 #endif
 
+#include "kunjs/arena.h"
 #include "kunjs/ast.h"
+#include "kunjs/lexer.h"
+#include "kunjs/source.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cstddef>
+#include <iosfwd>
 #include <string>
+#include <vector>
 
 //#define BOOST_SPIRIT_DEBUG
 
 namespace kunjs {
 
-namespace {
-static ast::Program OPTIONAL = ast::Program();
-}
+template <typename Iterator> struct javascript_grammar;
+
+// Outcome of a parse. Nothing is printed and nothing is allocated when
+// parsing succeeds; on failure, the position is reported as a byte offset
+// (and line/column, both 1-based) into the source, which is never copied.
+struct ParseResult {
+  ParseResult()
+      : success(false), offset(0), line(0), column(0) {}
+
+  operator bool() const { return success; }
+
+  bool success;
+  std::size_t offset;
+  std::size_t line;
+  std::size_t column;
+
+  // Name of the rule (or the literal) the parser was expecting at offset.
+  // Empty when parsing succeeded or when it just stopped before the end of
+  // the input without violating an expectation.
+  std::string expected;
+};
 
-class Parser {
+std::ostream& operator<<(std::ostream& out, ParseResult const& result);
+
+// A program together with the arena its nodes, lists and strings are
+// allocated from. Its destructor (and parsing into it again) drops the whole
+// tree at once, without visiting it; the arena and the token buffers are kept
+// for the next parse, so a long-running process that keeps parsing into the
+// same ParsedProgram soon stops allocating for the AST.
+//
+// Names are interned into the AtomTable given to the constructor, which must
+// outlive the program; without one, the program keeps a table of its own.
+// The lines of the source are kept too, to tell where its nodes are (see
+// ast::Located).
+class ParsedProgram : private boost::noncopyable {
  public:
-  bool parse(std::string code, ast::Program& ast = OPTIONAL);
+  ParsedProgram();
+  explicit ParsedProgram(AtomTable& atoms);
+  ~ParsedProgram();
+
+  ast::Program const& program() const { return *root; }
+  ast::Program& program() { return *root; }
+  Arena const& arena() const { return memory; }
+  AtomTable const& atoms() const { return tokens.atoms(); }
+  LineTable const& lines() const { return line_table; }
+
+  Location locate(ast::Located const& node) const { return line_table.locate(node.offset); }
+
+  // Drops the program, leaving an empty one.
+  void clear();
+
+ private:
+  friend class Parser;
+
+  Arena memory;
+  TokenStream tokens;
+  LineTable line_table;
+  ast::Program* root;
+};
+
+// A parsing session. The source is first split into tokens by the Lexer and
+// the grammar then runs over the tokens. The grammar is built once, when the
+// Parser is created, and parse() never modifies it: one Parser can be kept
+// around for the whole process and shared by any number of threads.
+class Parser : private boost::noncopyable {
+ public:
+  // PREPARSE leaves every function body lazy (see ast::FunctionBody): its
+  // braces are matched, but what is between them is neither checked nor
+  // turned into nodes until parse_body is called for it. Top-level code is
+  // always parsed in full.
+  enum Mode { FULL, PREPARSE };
+
+  Parser();
+  ~Parser();
+
+  // The code is read where it is, never copied (see Source). Names and
+  // strings are copied out of it, so only lazy bodies still refer to it
+  // once parsing is done: after a PREPARSE, keep it for parse_body.
+  ParseResult parse(Source code) const;
+  ParseResult parse(Source code, ast::Program& ast, AtomTable& atoms) const;
+  ParseResult parse(Source code, ParsedProgram& parsed, Mode mode = FULL) const;
+
+  // Parses a lazy body of parsed, which was pre-parsed from code, in place.
+  // The functions nested in it are left lazy in turn. The body is allocated
+  // from parsed's arena, and errors are located in code as a whole.
+  ParseResult parse_body(Source code, ParsedProgram& parsed, ast::FunctionBody& body) const;
+
+  // Parses each source independently, returning one program per input (in
+  // the same order). Programs for sources that fail to parse are partial.
+  std::vector<ast::Program> parse_many(std::vector<std::string> const& codes, AtomTable& atoms) const;
+
+ private:
+  typedef javascript_grammar<TokenIterator> grammar_type;
+
+  ParseResult parse(Source code, TokenStream& tokens, ast::Program& ast) const;
+
+  // Runs rule over the tokens from first to last, which are part of code.
+  template <typename Rule, typename Attribute>
+  ParseResult parse(Source code, char const* first, char const* last,
+                    TokenStream& tokens, Rule const& rule, Attribute& attr) const;
+
+  Lexer lexer;
+  boost::scoped_ptr<grammar_type const> grammar;
 };
 
 } // namespace kunjs
 
 #endif // KUNJS_PARSER_H_
-
@@ -1,716 +1,1166 @@
 #include "kunjs/printer.h"
 #include "kunjs/ast.h"
+#include "kunjs/ast_walker.h"
 
 #include <boost/variant.hpp>
 #include <boost/variant/apply_visitor.hpp>
 
-#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <ostream>
 #include <string>
+#include <vector>
 
 namespace kunjs {
 
 namespace {
 
-std::string Indent(int level) {
-  std::string result;
-  for (int i=0; i < level; i++)
-    result.append(" ");
+const int INDENT_STEP = 2;
+
+// How tightly expressions bind, loosest first. An expression printed where a
+// tighter one is expected is parenthesized.
+enum Precedence {
+  ASSIGNMENT,
+  CONDITIONAL,
+  LOGICAL_OR,
+  LOGICAL_AND,
+  BIT_OR,
+  BIT_XOR,
+  BIT_AND,
+  EQUALITY,
+  RELATIONAL,
+  SHIFT,
+  ADDITIVE,
+  MULTIPLICATIVE,
+  UNARY,
+  POSTFIX,
+  LHS,
+  PRIMARY
+};
+
+Precedence BinaryPrecedence(ast::Operator op) {
+  switch (op) {
+    case ast::op::OR: return LOGICAL_OR;
+    case ast::op::AND: return LOGICAL_AND;
+    case ast::op::BIT_OR: return BIT_OR;
+    case ast::op::BIT_XOR: return BIT_XOR;
+    case ast::op::BIT_AND: return BIT_AND;
+    case ast::op::EQ: case ast::op::NE: case ast::op::EQ_STRICT: case ast::op::NE_STRICT:
+      return EQUALITY;
+    case ast::op::LT: case ast::op::GT: case ast::op::LTE: case ast::op::GTE:
+    case ast::op::INSTANCEOF: case ast::op::IN:
+      return RELATIONAL;
+    case ast::op::SHL: case ast::op::SAR: case ast::op::SHR:
+      return SHIFT;
+    case ast::op::ADD: case ast::op::SUB:
+      return ADDITIVE;
+    default:
+      return MULTIPLICATIVE;
+  }
+}
 
-  return result;
+// Digits of a number that lex back to the same Numeric: the shortest that
+// give the same double, and doubles that look like ints get a fraction, or
+// they would come back as ints.
+std::size_t FormatNumber(ast::Numeric const& number, char (&text)[32]) {
+  if (int const* value = boost::get<int>(&number))
+    return std::sprintf(text, "%d", *value);
+
+  double value = boost::get<double>(number);
+  if (value != value)
+    return std::sprintf(text, "(0/0)");
+  if (value > std::numeric_limits<double>::max())
+    return std::sprintf(text, "1e999");
+
+  int size = 0;
+  for (int precision = 15; precision <= 17; ++precision) {
+    size = std::sprintf(text, "%.*g", precision, value);
+    if (std::strtod(text, 0) == value)
+      break;
+  }
+  for (int i = 0; i < size; ++i) {
+    if (text[i] == '.' || text[i] == 'e')
+      return size;
+  }
+  if (value >= -std::numeric_limits<int>::max() && value <= std::numeric_limits<int>::max())
+    size += std::sprintf(text + size, ".0");
+  return size;
 }
 
+// A string literal in the quotes it needs fewer escapes in. Bytes from 0x80
+// are copied as they are, so UTF-8 text stays UTF-8.
+void QuoteString(ast::String const& text, CodeBuffer& out) {
+  std::size_t doubles = 0, singles = 0;
+  for (ast::String::const_iterator it = text.begin(); it != text.end(); ++it) {
+    doubles += *it == '"';
+    singles += *it == '\'';
+  }
+  char quote = doubles > singles ? '\'' : '"';
+
+  out.append(quote);
+  char const* run = text.data();
+  char const* end = text.data() + text.size();
+  for (char const* it = run; it != end; ++it) {
+    unsigned char c = *it;
+    if (c >= 0x20 && c != '\\' && c != static_cast<unsigned char>(quote))
+      continue;
+
+    out.append(run, it - run);
+    run = it + 1;
+    char escaped[8] = { '\\', 0 };
+    switch (c) {
+      case '\n': escaped[1] = 'n'; break;
+      case '\r': escaped[1] = 'r'; break;
+      case '\t': escaped[1] = 't'; break;
+      case '\b': escaped[1] = 'b'; break;
+      case '\f': escaped[1] = 'f'; break;
+      default:
+        if (c < 0x20)
+          std::sprintf(escaped + 1, "x%02x", c);
+        else
+          escaped[1] = c;
+    }
+    out.append(escaped);
+  }
+  out.append(run, end - run);
+  out.append(quote);
 }
 
+// Visits literals for a printer, which prints each kind of value with a
+// literal() of its own.
+template <typename Printer>
+struct LiteralVisitor : boost::static_visitor<> {
+  explicit LiteralVisitor(Printer& printer) : printer(printer) {}
 
-ASTPrinter::ASTPrinter(int indent) : indentation(indent) {}
+  template <typename T>
+  void operator()(T const& value) const { printer.literal(value); }
 
-void ASTPrinter::operator()(std::vector<ast::Statement> const& list) const {
-  std::for_each(list.begin(), list.end(), *this);
-}
+  Printer& printer;
+};
 
-void ASTPrinter::operator()(ast::Program const& program) const {
-  ASTPrinter printer(indentation + INDENT_STEP);
-  std::cout << Indent(indentation) << "(Program " << std::endl;
-  std::for_each(program.begin(), program.end(), printer);
-  std::cout << Indent(indentation) << ")" << std::endl;
+bool IsWordByte(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+      || c == '_' || c == '$' || static_cast<unsigned char>(c) >= 0x80;
 }
 
-void ASTPrinter::operator()(ast::SourceElement const& element) const {
-  ASTPrinter printer(indentation + INDENT_STEP);
-  std::cout << Indent(indentation) << "(SourceElement " << std::endl;
-  boost::apply_visitor(printer, element);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+// Compact JavaScript. Tokens are written back to back, with a space only
+// where two of them would otherwise run together: between words (`var a`,
+// `a in b`), between pluses or minuses (`a- -b`, `a+ ++b`), and between an
+// integer and a dot (`1 .toString()`). The only parentheses are those of the
+// tree (ast::Expression), and those precedence needs in trees not made by the
+// parser: before each operand, at() sets the precedence the operand needs,
+// and an operator of a looser one is put between parentheses.
+class JavaScriptPrinter : public ast::Walker<JavaScriptPrinter> {
+ public:
+  using ast::Walker<JavaScriptPrinter>::enter;
+  using ast::Walker<JavaScriptPrinter>::at;
+  using ast::Walker<JavaScriptPrinter>::leave;
+
+  JavaScriptPrinter(AtomTable const& atoms, Source code, CodeBuffer& out)
+      : atoms(atoms), code(code), out(out), last(0), integer(false), context(ASSIGNMENT) {}
+
+  bool enter(ast::FunctionDeclaration const& function) {
+    Token("function");
+    Name(function.name);
+    Parameters(function.parameters);
+    return true;
+  }
 
-void ASTPrinter::operator()(ast::FunctionDeclaration const& function) const {
-  std::cout << Indent(indentation) << "(FunctionDeclaration)" << std::endl;
-}
+  void leave(ast::FunctionDeclaration const&) {
+    Token("}");
+  }
 
-void ASTPrinter::operator()(ast::Statement const& statement) const {
-  StatementPrinter printer(indentation + INDENT_STEP);
-  std::cout << Indent(indentation) << "(Statement " << std::endl;
-  boost::apply_visitor(printer, statement);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::FunctionExpression const& function) {
+    Token("function");
+    if (function.name) Name(function.name.get());
+    Parameters(function.parameters);
+    return true;
+  }
 
+  void leave(ast::FunctionExpression const&) {
+    Token("}");
+  }
 
-StatementPrinter::StatementPrinter(int indent) : indentation(indent) {}
+  bool enter(ast::FunctionBody const& body) {
+    if (body.lazy) {
+      assert(body.source.offset + body.source.length <= code.size() && "lazy body without its source");
+      out.append(code.begin() + body.source.offset, body.source.length);
+    }
+    return true;
+  }
 
-void StatementPrinter::operator()(ast::Expression const& expression) {
-  std::cout << Indent(indentation) << "(Expression " << std::endl;
-  ExpressionPrinter printer(indentation + INDENT_STEP);
-  std::for_each(expression.begin(), expression.end(), printer);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  // Statements
 
-void StatementPrinter::operator()(ast::Var const& var) {
-  for (ast::Var::const_iterator it = var.begin(); it != var.end(); ++it) {
-    (*this)(*it);
+  void at(ast::walk::ExpressionStatement const&, std::size_t slot) {
+    Comma(slot);
   }
-}
 
-void StatementPrinter::operator()(ast::VarDeclaration const& declaration) {
-  int next_level = indentation + INDENT_STEP;
-  ExpressionPrinter print_expression(next_level);
-  std::cout << Indent(indentation) << "(Var" << std::endl;
+  void leave(ast::walk::ExpressionStatement const&) {
+    Token(";");
+  }
 
-  std::cout << Indent(next_level) << "(name " << declaration.name << ")" << std::endl;
-  if (declaration.assignment) print_expression(declaration.assignment.get());
+  bool enter(ast::Var const&) {
+    Token("var");
+    return true;
+  }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  void at(ast::Var const&, std::size_t slot) {
+    Comma(slot);
+  }
 
-void StatementPrinter::operator()(ast::Noop const& noop) {
-  std::cout << Indent(indentation) << "(Empty)" << std::endl;
-}
+  void leave(ast::Var const&) {
+    Token(";");
+  }
 
-void StatementPrinter::operator()(ast::If const& conditional) {
-  int next = indentation + INDENT_STEP;
-  StatementPrinter print_expression(next + INDENT_STEP);
-  ASTPrinter print_statement(next + INDENT_STEP);
+  bool enter(ast::VarDeclaration const& declaration) {
+    Name(declaration.name);
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(If " << std::endl;
+  void at(ast::VarDeclaration const& declaration, std::size_t) {
+    if (declaration.assignment) {
+      Token("=");
+      context = ASSIGNMENT;
+    }
+  }
 
-  std::cout << Indent(next) << "(condition " << std::endl;
-  print_expression(conditional.condition);
-  std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::Noop const&) {
+    Token(";");
+    return false;
+  }
 
-  std::cout << Indent(next) << "(true_clause " << std::endl;
-  print_statement(conditional.true_clause);
-  std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::If const&) {
+    Token("if(");
+    return true;
+  }
 
-  if (conditional.false_clause) {
-    std::cout << Indent(next) << "(false_clause " << std::endl;
-    print_statement(conditional.false_clause.get());
-    std::cout << Indent(next) << ")" << std::endl;
+  void at(ast::If const& conditional, std::size_t slot) {
+    if (slot == 1)
+      Token(")");
+    else if (slot == 2 && conditional.false_clause)
+      Token("else");
   }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::DoWhile const&) {
+    Token("do");
+    return true;
+  }
 
-void StatementPrinter::operator()(ast::DoWhile const& loop) {
-  int next = indentation + INDENT_STEP;
-  StatementPrinter print_expression(next + INDENT_STEP);
-  ASTPrinter print_statement(next + INDENT_STEP);
+  void at(ast::DoWhile const&, std::size_t slot) {
+    if (slot == 1) Token("while(");
+  }
 
-  std::cout << Indent(indentation) << "(DoWhile " << std::endl;
+  void leave(ast::DoWhile const&) {
+    Token(");");
+  }
 
-  std::cout << Indent(next) << "(body " << std::endl;
-  print_statement(loop.statement);
-  std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::While const&) {
+    Token("while(");
+    return true;
+  }
 
-  std::cout << Indent(next) << "(condition " << std::endl;
-  print_expression(loop.condition);
-  std::cout << Indent(next) << ")" << std::endl;
+  void at(ast::While const&, std::size_t slot) {
+    if (slot == 1) Token(")");
+  }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::For const&) {
+    Token("for(");
+    return true;
+  }
 
-void StatementPrinter::operator()(ast::While const& loop) {
-  int next = indentation + INDENT_STEP;
-  StatementPrinter print_expression(next + INDENT_STEP);
-  ASTPrinter print_statement(next + INDENT_STEP);
+  void at(ast::For const&, std::size_t slot) {
+    if (slot) Token(slot < 3 ? ";" : ")");
+  }
 
-  std::cout << Indent(indentation) << "(While " << std::endl;
+  // The declarations print their own `var` and semicolon.
+  bool enter(ast::ForWithVar const&) {
+    Token("for(");
+    return true;
+  }
 
-  std::cout << Indent(next) << "(condition " << std::endl;
-  print_expression(loop.condition);
-  std::cout << Indent(next) << ")" << std::endl;
+  void at(ast::ForWithVar const&, std::size_t slot) {
+    if (slot > 1) Token(slot < 3 ? ";" : ")");
+  }
 
-  std::cout << Indent(next) << "(body " << std::endl;
-  print_statement(loop.statement);
-  std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::Foreach const&) {
+    Token("for(");
+    return true;
+  }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  void at(ast::Foreach const&, std::size_t slot) {
+    if (slot) Token(slot == 1 ? "in" : ")");
+  }
+
+  bool enter(ast::ForeachWithVar const&) {
+    Token("for(var");
+    return true;
+  }
 
-void StatementPrinter::operator()(ast::For const& loop) {
-  int next = indentation + INDENT_STEP;
-  StatementPrinter print_expression(next + INDENT_STEP);
-  ASTPrinter print_statement(next + INDENT_STEP);
+  void at(ast::ForeachWithVar const&, std::size_t slot) {
+    if (slot) Token(slot == 1 ? "in" : ")");
+  }
 
-  std::cout << Indent(indentation) << "(For " << std::endl;
+  bool enter(ast::Continue const& jump) {
+    Token("continue");
+    if (jump.label) Name(jump.label.get());
+    Token(";");
+    return false;
+  }
 
-  if (loop.initialization) {
-    std::cout << Indent(next) << "(initialization " << std::endl;
-    print_expression(loop.initialization.get());
-    std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::Break const& jump) {
+    Token("break");
+    if (jump.label) Name(jump.label.get());
+    Token(";");
+    return false;
   }
 
-  if (loop.condition) {
-    std::cout << Indent(next) << "(condition " << std::endl;
-    print_expression(loop.condition.get());
-    std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::Return const&) {
+    Token("return");
+    return true;
   }
 
-  if (loop.action) {
-    std::cout << Indent(next) << "(action " << std::endl;
-    print_expression(loop.action.get());
-    std::cout << Indent(next) << ")" << std::endl;
+  void leave(ast::Return const&) {
+    Token(";");
   }
 
-  std::cout << Indent(next) << "(body " << std::endl;
-  print_statement(loop.statement);
-  std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::With const&) {
+    Token("with(");
+    return true;
+  }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  void at(ast::With const&, std::size_t slot) {
+    if (slot == 1) Token(")");
+  }
+
+  bool enter(ast::LabelledStatement const& labelled) {
+    Name(labelled.label);
+    Token(":");
+    return true;
+  }
 
-void StatementPrinter::operator()(ast::ForWithVar const& loop) {
-  int next = indentation + INDENT_STEP;
-  StatementPrinter print_expression(next + INDENT_STEP);
-  ASTPrinter print_statement(next + INDENT_STEP);
+  bool enter(ast::Switch const&) {
+    Token("switch(");
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(ForWithVar " << std::endl;
+  void at(ast::Switch const&, std::size_t slot) {
+    if (slot == 1) Token("){");
+  }
 
-  for (ast::Var::const_iterator it = loop.initialization.begin(); it != loop.initialization.end(); ++it) {
-    std::cout << Indent(next) << "(initialization " << std::endl;
-    print_expression(*it);
-    std::cout << Indent(next) << ")" << std::endl;
+  void leave(ast::Switch const&) {
+    Token("}");
   }
 
-  if (loop.condition) {
-    std::cout << Indent(next) << "(condition " << std::endl;
-    print_expression(loop.condition.get());
-    std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::Case const&) {
+    Token("case");
+    return true;
   }
 
-  if (loop.action) {
-    std::cout << Indent(next) << "(action " << std::endl;
-    print_expression(loop.action.get());
-    std::cout << Indent(next) << ")" << std::endl;
+  // The colon follows the match, which is the last child of a clause without
+  // statements.
+  void at(ast::Case const&, std::size_t slot) {
+    if (slot == 1) Token(":");
   }
 
-  std::cout << Indent(next) << "(body " << std::endl;
-  print_statement(loop.statement);
-  std::cout << Indent(next) << ")" << std::endl;
+  void leave(ast::Case const& clause) {
+    if (clause.statements.empty()) Token(":");
+  }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::walk::Default const&) {
+    Token("default:");
+    return true;
+  }
+
+  bool enter(ast::Throw const&) {
+    Token("throw");
+    return true;
+  }
 
-void StatementPrinter::operator()(ast::Foreach const& loop) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print_lhs_expression(next + INDENT_STEP);
-  StatementPrinter print_expression(next + INDENT_STEP);
-  ASTPrinter print_statement(next + INDENT_STEP);
+  void leave(ast::Throw const&) {
+    Token(";");
+  }
 
-  std::cout << Indent(indentation) << "(Foreach " << std::endl;
+  bool enter(ast::Try const&) {
+    Token("try");
+    return true;
+  }
 
-  std::cout << Indent(next) << "(item " << std::endl;
-  print_lhs_expression(loop.item);
-  std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::Catch const& clause) {
+    Token("catch(");
+    Name(clause.exception_name);
+    Token("){");
+    return true;
+  }
 
-  std::cout << Indent(next) << "(list " << std::endl;
-  print_expression(loop.list);
-  std::cout << Indent(next) << ")" << std::endl;
+  void leave(ast::Catch const&) {
+    Token("}");
+  }
 
-  std::cout << Indent(next) << "(body " << std::endl;
-  print_statement(loop.statement);
-  std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::walk::Finally const&) {
+    Token("finally{");
+    return true;
+  }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  void leave(ast::walk::Finally const&) {
+    Token("}");
+  }
 
-void StatementPrinter::operator()(ast::ForeachWithVar const& loop) {
-  int next = indentation + INDENT_STEP;
-  StatementPrinter print_expression(next + INDENT_STEP);
-  ASTPrinter print_statement(next + INDENT_STEP);
+  bool enter(ast::walk::Debugger const&) {
+    Token("debugger;");
+    return false;
+  }
 
-  std::cout << Indent(indentation) << "(ForeachWithVar " << std::endl;
+  bool enter(ast::Block const&) {
+    Token("{");
+    return true;
+  }
 
-  std::cout << Indent(next) << "(item " << std::endl;
-  print_expression(loop.item);
-  std::cout << Indent(next) << ")" << std::endl;
+  void leave(ast::Block const&) {
+    Token("}");
+  }
 
-  std::cout << Indent(next) << "(list " << std::endl;
-  print_expression(loop.list);
-  std::cout << Indent(next) << ")" << std::endl;
+  // Expressions
 
-  std::cout << Indent(next) << "(body " << std::endl;
-  print_statement(loop.statement);
-  std::cout << Indent(next) << ")" << std::endl;
+  void at(ast::Expression const&, std::size_t slot) {
+    Comma(slot);
+  }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(Atom identifier) {
+    Name(identifier);
+    return false;
+  }
 
-void StatementPrinter::operator()(ast::Continue const& node) {
-  std::cout << Indent(indentation) << "(Continue";
-  if (node.label) {
-    std::cout << " (label " << node.label.get() << "))" << std::endl;
-  } else {
-    std::cout << ")" << std::endl;
+  bool enter(ast::This const&) {
+    Token("this");
+    return false;
   }
-}
 
-void StatementPrinter::operator()(ast::Break const& node) {
-  std::cout << Indent(indentation) << "(Break";
-  if (node.label) {
-    std::cout << " (label " << node.label.get() << "))" << std::endl;
-  } else {
-    std::cout << ")" << std::endl;
+  bool enter(ast::Literal const& literal) {
+    LiteralVisitor<JavaScriptPrinter> visitor(*this);
+    boost::apply_visitor(visitor, literal);
+    return false;
   }
-}
 
-void StatementPrinter::operator()(ast::Return const& node) {
-  std::cout << Indent(indentation) << "(Return";
-  if (node.expression) {
-    std::cout << std::endl;
-    StatementPrinter print_expression(indentation + INDENT_STEP);
-    print_expression(node.expression.get());
-    std::cout << Indent(indentation) << ")" << std::endl;
-  } else {
-    std::cout << ")" << std::endl;
+  void literal(ast::Null const&) {
+    Token("null");
   }
-}
 
-void StatementPrinter::operator()(ast::With const& with) {
-  int next = indentation + INDENT_STEP;
-  StatementPrinter print_expression(next + INDENT_STEP);
-  ASTPrinter print_statement(next + INDENT_STEP);
+  void literal(bool value) {
+    Token(value ? "true" : "false");
+  }
 
-  std::cout << Indent(indentation) << "(With" << std::endl;
+  void literal(ast::Numeric const& number) {
+    char text[32];
+    std::size_t size = FormatNumber(number, text);
+    Separate(text[0]);
+    out.append(text, size);
+    last = text[size - 1];
+    integer = true;
+    for (std::size_t i = 0; i < size; ++i)
+      integer = integer && text[i] >= '0' && text[i] <= '9';
+  }
 
-  std::cout << Indent(next) << "(context " << std::endl;
-  print_expression(with.context);
-  std::cout << Indent(next) << ")" << std::endl;
+  void literal(ast::String const& text) {
+    Separate('"');
+    QuoteString(text, out);
+    last = '"';
+  }
 
-  std::cout << Indent(next) << "(body " << std::endl;
-  print_statement(with.statement);
-  std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::walk::Parenthesized const&) {
+    Token("(");
+    return true;
+  }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  void at(ast::walk::Parenthesized const&, std::size_t slot) {
+    Comma(slot);
+  }
 
-void StatementPrinter::operator()(ast::LabelledStatement const& labelled) {
-  int next = indentation + INDENT_STEP;
-  ASTPrinter print_statement(next);
+  void leave(ast::walk::Parenthesized const&) {
+    Token(")");
+  }
 
-  std::cout << Indent(indentation) << "(LabelledStatement" << std::endl;
-  std::cout << Indent(next) << "(label " << labelled.label << ")" << std::endl;
-  print_statement(labelled.statement);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::ArrayLiteral const&) {
+    Token("[");
+    return true;
+  }
 
-void StatementPrinter::operator()(ast::Case const& clause) {
-  int next = indentation + INDENT_STEP;
-  StatementPrinter print_expression(next + INDENT_STEP);
-  ASTPrinter print_statement(next);
+  void at(ast::ArrayLiteral const&, std::size_t slot) {
+    Comma(slot);
+  }
 
-  std::cout << Indent(indentation) << "(Case" << std::endl;
+  void leave(ast::ArrayLiteral const&) {
+    Token("]");
+  }
 
-  std::cout << Indent(next) << "(match" << std::endl;
-  print_expression(clause.match_clause);
-  std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::UnaryExpression const& expression) {
+    Open(UNARY);
+    Token(ast::op::spelling(expression.operator_));
+    return true;
+  }
 
-  print_statement(clause.statements);
+  void at(ast::UnaryExpression const&, std::size_t) {
+    context = UNARY;
+  }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  void leave(ast::UnaryExpression const&) {
+    Close();
+  }
 
-void StatementPrinter::operator()(ast::Switch const& conditional) {
-  int next = indentation + INDENT_STEP;
-  StatementPrinter print_case(next);
-  StatementPrinter print_expression(next + INDENT_STEP);
-  ASTPrinter print_statement(next + INDENT_STEP);
+  bool enter(ast::PostfixExpression const&) {
+    Open(POSTFIX);
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(Switch" << std::endl;
+  void at(ast::PostfixExpression const&, std::size_t) {
+    context = LHS;
+  }
 
-  std::cout << Indent(next) << "(condition" << std::endl;
-  print_expression(conditional.condition);
-  std::cout << Indent(next) << ")" << std::endl;
+  void leave(ast::PostfixExpression const& expression) {
+    Token(ast::op::spelling(expression.operator_));
+    Close();
+  }
 
-  for (std::vector<ast::Case>::const_iterator it = conditional.clauses.begin();
-       it != conditional.clauses.end(); ++it) {
-    print_case(*it);
+  bool enter(ast::BinaryExpression const& expression) {
+    Open(BinaryPrecedence(expression.operator_));
+    return true;
   }
 
-  if (conditional.default_clause) {
-    std::cout << Indent(next) << "(Default" << std::endl;
-    print_statement(conditional.default_clause.get());
-    std::cout << Indent(next) << ")" << std::endl;
+  // Binary operators are left-associative: an operand of the same precedence
+  // needs parentheses on the right only.
+  void at(ast::BinaryExpression const& expression, std::size_t slot) {
+    Precedence precedence = BinaryPrecedence(expression.operator_);
+    if (slot == 0) {
+      context = precedence;
+    } else {
+      Token(ast::op::spelling(expression.operator_));
+      context = Precedence(precedence + 1);
+    }
   }
 
-  for (std::vector<ast::Case>::const_iterator it = conditional.other_clauses.begin();
-       it != conditional.other_clauses.end(); ++it) {
-    print_case(*it);
+  void leave(ast::BinaryExpression const&) {
+    Close();
   }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::ConditionalExpression const&) {
+    Open(CONDITIONAL);
+    return true;
+  }
 
-void StatementPrinter::operator()(ast::Throw const& node) {
-  StatementPrinter print_expression(indentation + INDENT_STEP);
-  std::cout << Indent(indentation) << "(Throw" << std::endl;
-  print_expression(node.expression);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  void at(ast::ConditionalExpression const&, std::size_t slot) {
+    if (slot == 0) {
+      context = LOGICAL_OR;
+    } else {
+      Token(slot == 1 ? "?" : ":");
+      context = ASSIGNMENT;
+    }
+  }
 
-void StatementPrinter::operator()(ast::Try const& node) {
-  int next = indentation + INDENT_STEP;
-  ASTPrinter print_statement(next);
-  ASTPrinter print_nested_statement(next + INDENT_STEP);
+  void leave(ast::ConditionalExpression const&) {
+    Close();
+  }
 
-  std::cout << Indent(indentation) << "(Try" << std::endl;
-  print_statement(node.statements);
+  bool enter(ast::Assignment const&) {
+    Open(ASSIGNMENT);
+    return true;
+  }
 
-  if (node.catch_block) {
-    ast::Catch block = node.catch_block.get();
-    std::cout << Indent(next) << "(Catch" << std::endl;
-    std::cout << Indent(next + INDENT_STEP) << "(exception_name " << block.exception_name << ")" << std::endl;
-    print_nested_statement(block.statements);
-    std::cout << Indent(next) << ")" << std::endl;
+  void at(ast::Assignment const& expression, std::size_t slot) {
+    if (slot == 0) {
+      context = LHS;
+    } else {
+      Token(ast::op::spelling(expression.operator_));
+      context = ASSIGNMENT;
+    }
   }
 
-  if (node.finally_block) {
-    std::cout << Indent(next) << "(Finally" << std::endl;
-    print_nested_statement(node.finally_block.get());
-    std::cout << Indent(next) << ")" << std::endl;
+  void leave(ast::Assignment const&) {
+    Close();
   }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::NewExpression const& expression) {
+    for (std::size_t i = 0; i < expression.operators.size(); ++i)
+      Token("new");
+    return true;
+  }
 
-void StatementPrinter::operator()(std::string const& debugger) {
-  std::cout << Indent(indentation) << "(Debugger)" << std::endl;
-}
+  bool enter(ast::Instantiation const&) {
+    Token("new");
+    return true;
+  }
 
-void StatementPrinter::operator()(std::vector<ast::Statement> const& list) {
-  ASTPrinter printer(indentation);
-  printer(list);
-}
+  bool enter(ast::Arguments const&) {
+    Token("(");
+    return true;
+  }
 
+  void at(ast::Arguments const&, std::size_t slot) {
+    Comma(slot);
+  }
 
-ExpressionPrinter::ExpressionPrinter(int indent) : indentation(indent) {}
+  void leave(ast::Arguments const&) {
+    Token(")");
+  }
 
-void ExpressionPrinter::operator()(ast::AssignmentExpression const& expression) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print_lhs(next + INDENT_STEP);
-  ExpressionPrinter print_conditional(next);
+  bool enter(ast::walk::Subscript const&) {
+    Token("[");
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(AssignmentExpression" << std::endl;
+  void at(ast::walk::Subscript const&, std::size_t slot) {
+    Comma(slot);
+  }
 
-  for (std::vector<ast::AssignmentOperation>::const_iterator it = expression.assignments.begin();
-       it != expression.assignments.end(); ++it) {
-    std::cout << Indent(next) << "(AssignmentOperation" << std::endl;
-    print_lhs(it->lhs);
-    std::cout << Indent(next + INDENT_STEP) << "(operator " << it->operator_ << ")" << std::endl;
-    std::cout << Indent(next) << ")" << std::endl;
+  void leave(ast::walk::Subscript const&) {
+    Token("]");
   }
 
-  print_conditional(expression.rhs);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::walk::Property const& property) {
+    Token(".");
+    Name(property.name);
+    return false;
+  }
 
-void ExpressionPrinter::operator()(ast::ConditionalExpression const& expression) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print_logical_or(next);
-  ExpressionPrinter print_assignment(next + INDENT_STEP);
+ private:
+  // Before an item of a comma-separated list.
+  void Comma(std::size_t slot) {
+    if (slot) Token(",");
+    context = ASSIGNMENT;
+  }
 
-  std::cout << Indent(indentation) << "(ConditionalExpression" << std::endl;
-  print_logical_or(expression.lhs);
+  // Opens an operator of the given precedence, between parentheses if it is
+  // looser than where it is.
+  void Open(Precedence precedence) {
+    bool parentheses = precedence < context;
+    if (parentheses) Token("(");
+    open.push_back(parentheses);
+  }
 
-  if (expression.conditional_clauses) {
-    ast::ConditionalClauses ternary = expression.conditional_clauses.get();
+  void Close() {
+    if (open.back()) Token(")");
+    open.pop_back();
+  }
 
-    std::cout << Indent(next) << "(true_clause" << std::endl;
-    print_assignment(ternary.true_clause.get());
-    std::cout << Indent(next) << ")" << std::endl;
+  void Parameters(ast::List<Atom>::type const& parameters) {
+    Token("(");
+    for (std::size_t i = 0; i < parameters.size(); ++i) {
+      if (i) Token(",");
+      Name(parameters[i]);
+    }
+    Token("){");
+  }
 
-    std::cout << Indent(next) << "(false_clause" << std::endl;
-    print_assignment(ternary.false_clause.get());
-    std::cout << Indent(next) << ")" << std::endl;
+  void Name(Atom name) {
+    std::string const& text = atoms.name(name);
+    Separate(text[0]);
+    out.append(text);
+    last = text[text.size() - 1];
   }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  void Token(char const* text) {
+    std::size_t size = std::char_traits<char>::length(text);
+    Separate(text[0]);
+    out.append(text, size);
+    last = text[size - 1];
+  }
 
-void ExpressionPrinter::operator()(ast::LogicalOrExpression const& expression) {
-  ExpressionPrinter print_logical_and(indentation + INDENT_STEP);
+  void Separate(char next) {
+    if ((IsWordByte(last) && IsWordByte(next))
+        || ((next == '+' || next == '-') && last == next)
+        || (integer && next == '.'))
+      out.append(' ');
+    integer = false;
+  }
 
-  std::cout << Indent(indentation) << "(LogicalOrExpression" << std::endl;
-  print_logical_and(expression.lhs);
-  std::for_each(expression.operations.begin(), expression.operations.end(), print_logical_and);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  AtomTable const& atoms;
+  Source code;
+  CodeBuffer& out;
+  // The last byte written, and whether it ended a number that would take a
+  // following dot for its fraction.
+  char last;
+  bool integer;
+  // The precedence the next operand needs, and whether each open operator
+  // was parenthesized.
+  Precedence context;
+  std::vector<bool> open;
+};
+
+// The tree, a node per line:
+//
+//   (Program
+//     (If @0
+//       (Name a)
+//       (Block @6
+//         (Return @8
+//           (Number 1)))))
+//
+// Nodes the parser located are followed by their offset. Every node opens
+// its line in enter() and closes it in leave(), but for the leaves, which do
+// both in enter(), and for the few kinds below that open no line or more
+// than one.
+class TreeDumper : public ast::Walker<TreeDumper> {
+ public:
+  using ast::Walker<TreeDumper>::at;
+
+  TreeDumper(AtomTable const& atoms, CodeBuffer& out)
+      : atoms(atoms), out(out), depth(0) {}
+
+  template <typename Node>
+  void leave(Node const&) {
+    Close();
+  }
 
-void ExpressionPrinter::operator()(ast::LogicalAndExpression const& expression) {
-  ExpressionPrinter print(indentation + INDENT_STEP);
+  bool enter(ast::Program const&) {
+    Open("Program");
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(LogicalAndExpression" << std::endl;
-  print(expression.lhs);
-  std::for_each(expression.operations.begin(), expression.operations.end(), print);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::FunctionDeclaration const& function) {
+    Open("FunctionDeclaration", function);
+    Name(function.name);
+    Parameters(function.parameters);
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::BitwiseOrExpression const& expression) {
-  ExpressionPrinter print(indentation + INDENT_STEP);
+  bool enter(ast::FunctionExpression const& function) {
+    Open("FunctionExpression", function);
+    if (function.name) Name(function.name.get());
+    Parameters(function.parameters);
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(BitwiseOrExpression" << std::endl;
-  print(expression.lhs);
-  std::for_each(expression.operations.begin(), expression.operations.end(), print);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::FunctionBody const& body) {
+    if (body.lazy) {
+      char text[32];
+      std::sprintf(text, " %lu bytes", static_cast<unsigned long>(body.source.length));
+      Open("LazyBody");
+      out.append(text);
+      Close();
+      return false;
+    }
+    Open("Body");
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::BitwiseXorExpression const& expression) {
-  ExpressionPrinter print(indentation + INDENT_STEP);
+  // Statements
 
-  std::cout << Indent(indentation) << "(BitwiseXorExpression" << std::endl;
-  print(expression.lhs);
-  std::for_each(expression.operations.begin(), expression.operations.end(), print);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::walk::ExpressionStatement const&) {
+    Open("ExpressionStatement");
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::BitwiseAndExpression const& expression) {
-  ExpressionPrinter print(indentation + INDENT_STEP);
+  bool enter(ast::Var const&) {
+    Open("Var");
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(BitwiseAndExpression" << std::endl;
-  print(expression.lhs);
-  std::for_each(expression.operations.begin(), expression.operations.end(), print);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::VarDeclaration const& declaration) {
+    Open("VarDeclaration");
+    Name(declaration.name);
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::EqualityExpression const& expression) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print(next);
+  bool enter(ast::Noop const&) {
+    Leaf("Empty");
+    return false;
+  }
 
-  std::cout << Indent(indentation) << "(EqualityExpression" << std::endl;
-  print(expression.lhs);
+  bool enter(ast::If const& conditional) {
+    Open("If", conditional);
+    return true;
+  }
 
-  for (std::vector<ast::EqualityOperation>::const_iterator it = expression.operations.begin();
-       it != expression.operations.end(); ++it) {
-    std::cout << Indent(next) << "(operator " << it->operator_ << ")" << std::endl;
-    print(it->rhs);
+  bool enter(ast::DoWhile const& loop) {
+    Open("DoWhile", loop);
+    return true;
   }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::While const& loop) {
+    Open("While", loop);
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::RelationalExpression const& expression) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print(next);
+  bool enter(ast::For const& loop) {
+    Open("For", loop);
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(RelationalExpression" << std::endl;
-  print(expression.lhs);
+  void at(ast::For const& loop, std::size_t slot) {
+    if ((slot == 0 && !loop.initialization) || (slot == 1 && !loop.condition)
+        || (slot == 2 && !loop.action))
+      Leaf("None");
+  }
 
-  for (std::vector<ast::RelationalOperation>::const_iterator it = expression.operations.begin();
-       it != expression.operations.end(); ++it) {
-    std::cout << Indent(next) << "(operator " << it->operator_ << ")" << std::endl;
-    print(it->rhs);
+  bool enter(ast::ForWithVar const& loop) {
+    Open("ForWithVar", loop);
+    return true;
   }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  void at(ast::ForWithVar const& loop, std::size_t slot) {
+    if ((slot == 1 && !loop.condition) || (slot == 2 && !loop.action))
+      Leaf("None");
+  }
 
-void ExpressionPrinter::operator()(ast::ShiftExpression const& expression) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print(next);
+  bool enter(ast::Foreach const& loop) {
+    Open("Foreach", loop);
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(ShiftExpression" << std::endl;
-  print(expression.lhs);
+  bool enter(ast::ForeachWithVar const& loop) {
+    Open("ForeachWithVar", loop);
+    return true;
+  }
 
-  for (std::vector<ast::ShiftOperation>::const_iterator it = expression.operations.begin();
-       it != expression.operations.end(); ++it) {
-    std::cout << Indent(next) << "(operator " << it->operator_ << ")" << std::endl;
-    print(it->rhs);
+  bool enter(ast::Continue const& jump) {
+    Open("Continue", jump);
+    if (jump.label) Name(jump.label.get());
+    Close();
+    return false;
   }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::Break const& jump) {
+    Open("Break", jump);
+    if (jump.label) Name(jump.label.get());
+    Close();
+    return false;
+  }
 
-void ExpressionPrinter::operator()(ast::AdditiveExpression const& expression) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print(next);
+  bool enter(ast::Return const& node) {
+    Open("Return", node);
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(AdditiveExpression" << std::endl;
-  print(expression.lhs);
+  bool enter(ast::With const& with) {
+    Open("With", with);
+    return true;
+  }
 
-  for (std::vector<ast::AdditiveOperation>::const_iterator it = expression.operations.begin();
-       it != expression.operations.end(); ++it) {
-    std::cout << Indent(next) << "(operator " << it->operator_ << ")" << std::endl;
-    print(it->rhs);
+  bool enter(ast::LabelledStatement const& labelled) {
+    Open("Labelled", labelled);
+    Name(labelled.label);
+    return true;
   }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::Switch const& conditional) {
+    Open("Switch", conditional);
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::MultiplicativeExpression const& expression) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print(next);
+  bool enter(ast::Case const&) {
+    Open("Case");
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(MultiplicativeExpression" << std::endl;
-  print(expression.lhs);
+  bool enter(ast::walk::Default const&) {
+    Open("Default");
+    return true;
+  }
 
-  for (std::vector<ast::MultiplicativeOperation>::const_iterator it = expression.operations.begin();
-       it != expression.operations.end(); ++it) {
-    std::cout << Indent(next) << "(operator " << it->operator_ << ")" << std::endl;
-    print(it->rhs);
+  bool enter(ast::Throw const& node) {
+    Open("Throw", node);
+    return true;
   }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::Try const& node) {
+    Open("Try", node);
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::UnaryExpression const& expression) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print(next);
+  // The statements of catch and finally clauses are dumped as a block.
+  bool enter(ast::Catch const& clause) {
+    Open("Catch");
+    Name(clause.exception_name);
+    Open("Block", clause.statements);
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(UnaryExpression" << std::endl;
-  for (std::vector<std::string>::const_iterator it = expression.operators.begin();
-       it != expression.operators.end(); ++it) {
-    std::cout << Indent(next) << "(operator " << *it << ")" << std::endl;
+  void leave(ast::Catch const&) {
+    Close();
+    Close();
   }
 
-  print(expression.rhs);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::walk::Finally const& clause) {
+    Open("Finally");
+    Open("Block", clause.statements);
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::PostfixExpression const& expression) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print(next);
+  void leave(ast::walk::Finally const&) {
+    Close();
+    Close();
+  }
 
-  std::cout << Indent(indentation) << "(PostfixExpression" << std::endl;
-  print(expression.lhs);
+  bool enter(ast::walk::Debugger const&) {
+    Leaf("Debugger");
+    return false;
+  }
 
-  if (expression.operator_) {
-    std::cout << Indent(next) << "(operator " << expression.operator_.get() << ")" << std::endl;
+  bool enter(ast::Block const& block) {
+    Open("Block", block);
+    return true;
   }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  // Expressions
 
-void ExpressionPrinter::operator()(ast::LhsExpression const& expression) {
-  ExpressionPrinter printer(indentation + INDENT_STEP);
-  std::cout << Indent(indentation) << "(LhsExpression" << std::endl;
-  boost::apply_visitor(printer, expression);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  // The expression of a statement: a single expression is dumped alone, a
+  // comma-separated one as a Sequence.
+  bool enter(ast::Expression const& expression) {
+    if (expression.size() != 1) Open("Sequence");
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::CallExpression const& expression) {
-  std::cout << Indent(indentation) << "(CallExpression)" << std::endl;
-}
+  void leave(ast::Expression const& expression) {
+    if (expression.size() != 1) Close();
+  }
 
-void ExpressionPrinter::operator()(ast::NewExpression const& expression) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print(next);
+  bool enter(Atom identifier) {
+    Name(identifier);
+    return false;
+  }
 
-  std::cout << Indent(indentation) << "(NewExpression" << std::endl;
-  for (std::vector<std::string>::const_iterator it = expression.operators.begin();
-       it != expression.operators.end(); ++it) {
-    std::cout << Indent(next) << "(operator " << *it << ")" << std::endl;
+  bool enter(ast::This const&) {
+    Leaf("This");
+    return false;
   }
 
-  print(expression.member);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::Literal const& literal) {
+    LiteralVisitor<TreeDumper> visitor(*this);
+    boost::apply_visitor(visitor, literal);
+    return false;
+  }
 
-void ExpressionPrinter::operator()(ast::MemberExpression const& expression) {
-  ExpressionPrinter printer(indentation + INDENT_STEP);
-  std::cout << Indent(indentation) << "(MemberExpression" << std::endl;
-  boost::apply_visitor(printer, expression);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  void literal(ast::Null const&) {
+    Leaf("Null");
+  }
+
+  void literal(bool value) {
+    Open("Boolean");
+    out.append(value ? " true" : " false");
+    Close();
+  }
 
-void ExpressionPrinter::operator()(ast::MemberAccess const& expression) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print(next + INDENT_STEP);
-  std::cout << Indent(indentation) << "(MemberAccess" << std::endl;
+  void literal(ast::Numeric const& number) {
+    char text[32];
+    std::size_t size = FormatNumber(number, text);
+    Open("Number");
+    out.append(' ');
+    out.append(text, size);
+    Close();
+  }
 
-  std::cout << Indent(next) << "(member " << std::endl;
-  print(expression.member);
-  std::cout << Indent(next) << ")" << std::endl;
+  void literal(ast::String const& text) {
+    Open("String");
+    out.append(' ');
+    QuoteString(text, out);
+    Close();
+  }
 
-  if (!expression.modifiers.empty()) {
-    std::cout << Indent(next) << "(modifiers " << std::endl;
-    std::for_each(expression.modifiers.begin(), expression.modifiers.end(), print);
-    std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::walk::Parenthesized const&) {
+    Open("Parenthesized");
+    return true;
   }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::ArrayLiteral const&) {
+    Open("Array");
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::MemberOptions const& expression) {
-  ExpressionPrinter printer(indentation + INDENT_STEP);
-  std::cout << Indent(indentation) << "(MemberOptions" << std::endl;
-  boost::apply_visitor(printer, expression);
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::UnaryExpression const& expression) {
+    Operator("Unary", expression, expression.operator_);
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::MemberModifier const& expression) {
-  std::cout << Indent(indentation) << "(MemberModifier)" << std::endl;
-}
+  bool enter(ast::PostfixExpression const& expression) {
+    Operator("Postfix", expression, expression.operator_);
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::Instantiation const& expression) {
-  int next = indentation + INDENT_STEP;
-  ExpressionPrinter print(next);
-  StatementPrinter print_statement(next + INDENT_STEP);
+  bool enter(ast::BinaryExpression const& expression) {
+    Operator("Binary", expression, expression.operator_);
+    return true;
+  }
 
-  std::cout << Indent(indentation) << "(Instantiation" << std::endl;
-  print(expression.member);
+  bool enter(ast::ConditionalExpression const& expression) {
+    Open("Conditional", expression);
+    return true;
+  }
 
-  std::cout << Indent(next) << "(arguments " << std::endl;
-  print_statement(expression.arguments);
-  std::cout << Indent(next) << ")" << std::endl;
+  bool enter(ast::Assignment const& expression) {
+    Operator("Assignment", expression, expression.operator_);
+    return true;
+  }
 
-  std::cout << Indent(indentation) << ")" << std::endl;
-}
+  bool enter(ast::CallExpression const& expression) {
+    Open("Call", expression);
+    return true;
+  }
+
+  bool enter(ast::NewExpression const& expression) {
+    for (std::size_t i = 0; i < expression.operators.size(); ++i)
+      Open("New", expression);
+    return true;
+  }
+
+  void leave(ast::NewExpression const& expression) {
+    for (std::size_t i = 0; i < expression.operators.size(); ++i)
+      Close();
+  }
+
+  // Accesses without modifiers are their member alone.
+  bool enter(ast::MemberAccess const& expression) {
+    if (!expression.modifiers.empty()) Open("MemberAccess");
+    return true;
+  }
+
+  void leave(ast::MemberAccess const& expression) {
+    if (!expression.modifiers.empty()) Close();
+  }
+
+  bool enter(ast::Instantiation const& expression) {
+    Open("Instantiation", expression);
+    return true;
+  }
+
+  bool enter(ast::Arguments const&) {
+    Open("Arguments");
+    return true;
+  }
+
+  bool enter(ast::walk::Subscript const&) {
+    Open("Index");
+    return true;
+  }
 
-void ExpressionPrinter::operator()(ast::PrimaryExpression const& expression) {
-  PrimaryExpressionPrinter printer(indentation + INDENT_STEP);
-  std::cout << Indent(indentation) << "(PrimaryExpression" << std::endl;
-  boost::apply_visitor(printer, expression);
-  std::cout << Indent(indentation) << ")" << std::endl;
+  bool enter(ast::walk::Property const& property) {
+    Open("Property");
+    Name(property.name);
+    Close();
+    return false;
+  }
+
+ private:
+  void Parameters(ast::List<Atom>::type const& parameters) {
+    Open("Parameters");
+    for (std::size_t i = 0; i < parameters.size(); ++i) {
+      out.append(' ');
+      out.append(atoms.name(parameters[i]));
+    }
+    Close();
+  }
+
+  void Name(Atom name) {
+    Open("Name");
+    out.append(' ');
+    out.append(atoms.name(name));
+    Close();
+  }
+
+  void Leaf(char const* kind) {
+    Open(kind);
+    Close();
+  }
+
+  void Operator(char const* kind, ast::Located const& node, ast::Operator op) {
+    Open(kind);
+    out.append(' ');
+    out.append(ast::op::spelling(op));
+    Offset(node);
+  }
+
+  void Open(char const* kind, ast::Located const& node) {
+    Open(kind);
+    Offset(node);
+  }
+
+  void Offset(ast::Located const& node) {
+    if (node.offset != ast::Located::NONE) {
+      char text[16];
+      std::sprintf(text, " @%u", static_cast<unsigned>(node.offset));
+      out.append(text);
+    }
+  }
+
+  void Open(char const* kind) {
+    if (depth) {
+      out.append('\n');
+      out.append(depth * INDENT_STEP, ' ');
+    }
+    out.append('(');
+    out.append(kind);
+    ++depth;
+  }
+
+  void Close() {
+    out.append(')');
+    if (!--depth)
+      out.append('\n');
+  }
+
+  AtomTable const& atoms;
+  CodeBuffer& out;
+  std::size_t depth;
+};
+
+template <typename Node>
+void Print(AtomTable const& atoms, Printer::Mode mode, Source code, Node const& node, CodeBuffer& out) {
+  if (mode == Printer::DUMP) {
+    TreeDumper dumper(atoms, out);
+    dumper.walk(node);
+  } else {
+    JavaScriptPrinter printer(atoms, code, out);
+    printer.walk(node);
+  }
 }
 
-void ExpressionPrinter::operator()(ast::FunctionExpression const& expression) {
-  std::cout << Indent(indentation) << "(FunctionExpression)" << std::endl;
 }
 
+const std::size_t CodeBuffer::CHUNK_SIZE;
 
-PrimaryExpressionPrinter::PrimaryExpressionPrinter(int indent) : indentation(indent) {}
+CodeBuffer::CodeBuffer(std::string& out) : text(&out), stream(0) {}
 
-void PrimaryExpressionPrinter::operator()(ast::This const& node) {
-  std::cout << Indent(indentation) << "(This)" << std::endl;
+CodeBuffer::CodeBuffer(std::ostream& out) : text(&chunk), stream(&out) {
+  chunk.reserve(CHUNK_SIZE + CHUNK_SIZE / 4);
 }
 
-void PrimaryExpressionPrinter::operator()(std::string const& identifier) {
-  std::cout << Indent(indentation) << "(identifier " << identifier << ")" << std::endl;
+CodeBuffer::~CodeBuffer() {
+  flush();
 }
 
-void PrimaryExpressionPrinter::operator()(ast::Literal const& literal) {
-  std::cout << Indent(indentation) << "(literal " << literal << ")" << std::endl;
+void CodeBuffer::flush() {
+  if (!stream || chunk.empty())
+    return;
+  stream->write(chunk.data(), chunk.size());
+  chunk.clear();
 }
 
-void PrimaryExpressionPrinter::operator()(ast::Expression const& expression) {
-  StatementPrinter print(indentation);
-  print(expression);
+Printer::Printer(AtomTable const& atoms, Mode mode, Source code)
+    : atoms(atoms), mode(mode), code(code) {}
+
+void Printer::print(ast::Program const& program, CodeBuffer& out) const {
+  Print(atoms, mode, code, program, out);
+}
+
+void Printer::print(ast::Statement const& statement, CodeBuffer& out) const {
+  Print(atoms, mode, code, statement, out);
 }
 
+void Printer::print(ast::AssignmentExpression const& expression, CodeBuffer& out) const {
+  Print(atoms, mode, code, expression, out);
+}
+
+std::string Printer::print(ast::Program const& program) const {
+  std::string text;
+  CodeBuffer out(text);
+  print(program, out);
+  return text;
+}
 
 } // namespace kunjs
 
 namespace std {
-std::ostream& operator<<(std::ostream& stream, kunjs::ast::Null const& value) {
+std::ostream& operator<<(std::ostream& stream, kunjs::ast::Null const&) {
   stream << "null";
   return stream;
 }
 }
-
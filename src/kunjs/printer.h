@@ -6,110 +6,84 @@
 #endif
 
 #include "kunjs/ast.h"
-#include <boost/variant/static_visitor.hpp>
+#include "kunjs/atom.h"
+#include "kunjs/source.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <iosfwd>
 #include <string>
 
 namespace kunjs {
 
-static const int INDENT_STEP = 2;
-
+// Where printed code goes: appended to a string of the caller, which grows as
+// needed, or written to a stream a chunk at a time. Printers append a token
+// at a time, so a stream only sees a write per CHUNK_SIZE bytes, on flush()
+// and on destruction, rather than one per token.
+class CodeBuffer : private boost::noncopyable {
+ public:
+  static const std::size_t CHUNK_SIZE = 64 * 1024;
 
-class ASTPrinter : public boost::static_visitor<> {
+  explicit CodeBuffer(std::string& out);
+  explicit CodeBuffer(std::ostream& out);
+  ~CodeBuffer();
 
- public:
-  ASTPrinter(int indent);
-  void operator()(ast::Program const& node) const;
-  void operator()(ast::SourceElement const& node) const;
-  void operator()(ast::FunctionDeclaration const& node) const;
-  void operator()(std::vector<ast::Statement> const& list) const;
-  void operator()(ast::Statement const& node) const;
+  void append(char c) {
+    text->push_back(c);
+    if (stream && text->size() >= CHUNK_SIZE) flush();
+  }
 
- private:
-  mutable int indentation;
-};
+  void append(char const* data, std::size_t size) {
+    text->append(data, size);
+    if (stream && text->size() >= CHUNK_SIZE) flush();
+  }
 
+  void append(char const* data) { append(data, std::char_traits<char>::length(data)); }
+  void append(std::string const& data) { append(data.data(), data.size()); }
 
-class StatementPrinter : public boost::static_visitor<> {
+  // count copies of c
+  void append(std::size_t count, char c) {
+    text->append(count, c);
+    if (stream && text->size() >= CHUNK_SIZE) flush();
+  }
 
- public:
-  StatementPrinter(int indent);
-  void operator()(ast::Expression const& expression);
-  void operator()(ast::Var const& var);
-  void operator()(ast::VarDeclaration const& var);
-  void operator()(ast::Noop const& noop);
-  void operator()(ast::If const& conditional);
-  void operator()(ast::DoWhile const& loop);
-  void operator()(ast::While const& loop);
-  void operator()(ast::For const& loop);
-  void operator()(ast::ForWithVar const& loop);
-  void operator()(ast::Foreach const& loop);
-  void operator()(ast::ForeachWithVar const& loop);
-  void operator()(ast::Continue const& node);
-  void operator()(ast::Break const& node);
-  void operator()(ast::Return const& node);
-  void operator()(ast::With const& with);
-  void operator()(ast::LabelledStatement const& labelled);
-  void operator()(ast::Switch const& conditional);
-  void operator()(ast::Case const& clause);
-  void operator()(ast::Throw const& node);
-  void operator()(ast::Try const& node);
-  void operator()(std::string const& debugger);
-  void operator()(std::vector<ast::Statement> const& list);
+  // Writes what is buffered to the stream; nothing to do for a string.
+  void flush();
 
  private:
-  mutable int indentation;
+  std::string* text;
+  std::ostream* stream;
+  std::string chunk;
 };
 
-
-class ExpressionPrinter : public boost::static_visitor<> {
-
+// Prints programs, or parts of them, in one of two forms:
+//
+//   DUMP        the tree of the nodes, one per line and indented by depth,
+//               with the offsets of the located ones, for debugging
+//   JAVASCRIPT  compact JavaScript, with no more spaces, parentheses and
+//               braces than it needs, that parses back to the same tree
+//
+// Bodies the parser left lazy (see Parser::PREPARSE) are copied from code,
+// the source the program was parsed from, as they were written.
+class Printer {
  public:
-  ExpressionPrinter(int indent);
-  void operator()(ast::AssignmentExpression const& expression);
-  void operator()(ast::ConditionalExpression const& expression);
-  void operator()(ast::LogicalOrExpression const& expression);
-  void operator()(ast::LogicalAndExpression const& expression);
-  void operator()(ast::BitwiseOrExpression const& expression);
-  void operator()(ast::BitwiseXorExpression const& expression);
-  void operator()(ast::BitwiseAndExpression const& expression);
-  void operator()(ast::EqualityExpression const& expression);
-  void operator()(ast::RelationalExpression const& expression);
-  void operator()(ast::ShiftExpression const& expression);
-  void operator()(ast::AdditiveExpression const& expression);
-  void operator()(ast::MultiplicativeExpression const& expression);
-  void operator()(ast::UnaryExpression const& expression);
-  void operator()(ast::PostfixExpression const& expression);
-  void operator()(ast::LhsExpression const& expression);
-  void operator()(ast::CallExpression const& expression);
-  void operator()(ast::NewExpression const& expression);
-  void operator()(ast::MemberExpression const& expression);
-  void operator()(ast::MemberAccess const& expression);
-  void operator()(ast::MemberOptions const& expression);
-  void operator()(ast::MemberModifier const& expression);
-  void operator()(ast::Instantiation const& expression);
-  void operator()(ast::PrimaryExpression const& expression);
-  void operator()(ast::FunctionExpression const& expression);
+  enum Mode { DUMP, JAVASCRIPT };
 
+  Printer(AtomTable const& atoms, Mode mode, Source code = Source());
 
- private:
-  mutable int indentation;
-};
-
+  void print(ast::Program const& program, CodeBuffer& out) const;
+  void print(ast::Statement const& statement, CodeBuffer& out) const;
+  void print(ast::AssignmentExpression const& expression, CodeBuffer& out) const;
 
-class PrimaryExpressionPrinter : public boost::static_visitor<> {
- public:
-  PrimaryExpressionPrinter(int indent);
-  void operator()(ast::This const& node);
-  void operator()(std::string const& identifier);
-  void operator()(ast::Literal const& literal);
-  void operator()(ast::Expression const& expression);
+  std::string print(ast::Program const& program) const;
 
  private:
-  mutable int indentation;
+  AtomTable const& atoms;
+  Mode mode;
+  Source code;
 };
 
-
 } // namespace kunjs
 
 #endif // KUNJS_PRINTER_H_
-
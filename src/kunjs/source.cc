@@ -0,0 +1,115 @@
+#include "kunjs/source.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kunjs {
+
+MappedFile::MappedFile() : data(""), size(0), opened(false) {}
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+// Empty files are not mapped (a mapping cannot be empty): they are open,
+// with an empty source.
+#if defined(_WIN32)
+
+bool MappedFile::open(char const* path) {
+  close();
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER length;
+  bool mapped = GetFileSizeEx(file, &length) != 0;
+  if (mapped && length.QuadPart > 0) {
+    HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+    if (mapping)
+      CloseHandle(mapping);
+    mapped = view != 0;
+    if (mapped) {
+      data = static_cast<char const*>(view);
+      size = static_cast<std::size_t>(length.QuadPart);
+    }
+  }
+  CloseHandle(file);
+  opened = mapped;
+  return opened;
+}
+
+void MappedFile::close() {
+  if (size)
+    UnmapViewOfFile(data);
+  data = "";
+  size = 0;
+  opened = false;
+}
+
+#else
+
+bool MappedFile::open(char const* path) {
+  close();
+  int file = ::open(path, O_RDONLY);
+  if (file < 0)
+    return false;
+
+  struct stat status;
+  bool mapped = fstat(file, &status) == 0;
+  if (mapped && status.st_size > 0) {
+    void* view = mmap(0, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    mapped = view != MAP_FAILED;
+    if (mapped) {
+      // read front to back, once
+      madvise(view, status.st_size, MADV_SEQUENTIAL);
+      data = static_cast<char const*>(view);
+      size = static_cast<std::size_t>(status.st_size);
+    }
+  }
+  ::close(file);
+  opened = mapped;
+  return opened;
+}
+
+void MappedFile::close() {
+  if (size)
+    munmap(const_cast<char*>(data), size);
+  data = "";
+  size = 0;
+  opened = false;
+}
+
+#endif
+
+void LineTable::build(Source code) {
+  starts.clear();
+  starts.push_back(0);
+  for (char const* it = code.begin(); it != code.end(); ++it) {
+    if (*it == '\r' && it + 1 != code.end() && it[1] == '\n')
+      ++it;
+    if (*it == '\n' || *it == '\r')
+      starts.push_back(boost::uint32_t(it + 1 - code.begin()));
+  }
+}
+
+Location LineTable::locate(boost::uint32_t offset) const {
+  if (starts.empty())
+    return Location(1, offset + 1);
+
+  // the last line starting at or before offset
+  std::vector<boost::uint32_t>::const_iterator line =
+      std::upper_bound(starts.begin(), starts.end(), offset) - 1;
+  return Location(line - starts.begin() + 1, offset - *line + 1);
+}
+
+} // namespace kunjs
@@ -0,0 +1,94 @@
+#ifndef KUNJS_SOURCE_H_
+#define KUNJS_SOURCE_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace kunjs {
+
+// The text of a script, which is not owned: a std::string, a literal and a
+// mapped file are all parsed where they are, without being copied first.
+// Whatever holds the text must outlive the Source, and keep it unchanged.
+class Source {
+ public:
+  Source() : first(""), last(first) {}
+  Source(char const* text) : first(text), last(text + std::strlen(text)) {}
+  Source(std::string const& text) : first(text.data()), last(text.data() + text.size()) {}
+  Source(char const* first, char const* last) : first(first), last(last) {}
+  Source(char const* first, std::size_t size) : first(first), last(first + size) {}
+
+  char const* begin() const { return first; }
+  char const* end() const { return last; }
+  std::size_t size() const { return last - first; }
+  bool empty() const { return first == last; }
+
+  std::string str() const { return std::string(first, last); }
+
+ private:
+  char const* first;
+  char const* last;
+};
+
+// A file mapped read-only into memory, so that a script is parsed straight
+// from the page cache. The mapping (and any Source taken from it) stays
+// valid until the file is closed or the MappedFile is destroyed.
+class MappedFile : private boost::noncopyable {
+ public:
+  MappedFile();
+  ~MappedFile();
+
+  // False (leaving the file closed) when path cannot be opened or mapped.
+  bool open(char const* path);
+  bool open(std::string const& path) { return open(path.c_str()); }
+  void close();
+
+  bool is_open() const { return opened; }
+  Source source() const { return Source(data, size); }
+
+ private:
+  char const* data;
+  std::size_t size;
+  bool opened;
+};
+
+// A line and a column in a source, both 1-based. Columns count bytes.
+struct Location {
+  Location() : line(0), column(0) {}
+  Location(std::size_t line, std::size_t column) : line(line), column(column) {}
+
+  std::size_t line;
+  std::size_t column;
+};
+
+// Where the lines of a source start, so that the byte offsets kept in the
+// AST (see ast::Node) can be told as lines and columns. Built with one pass
+// over the source; each lookup is a binary search. Lines end at '\n', '\r'
+// or "\r\n", as they do for the lexer's line breaks.
+class LineTable {
+ public:
+  LineTable() {}
+  explicit LineTable(Source code) { build(code); }
+
+  void build(Source code);
+
+  // Offsets past the end of the source are on its last line.
+  Location locate(boost::uint32_t offset) const;
+
+  std::size_t lines() const { return starts.size(); }
+
+ private:
+  std::vector<boost::uint32_t> starts;
+};
+
+} // namespace kunjs
+
+#endif // KUNJS_SOURCE_H_
@@ -0,0 +1,229 @@
+#ifndef KUNJS_TOKEN_PARSER_H_
+#define KUNJS_TOKEN_PARSER_H_
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include "kunjs/ast.h"
+#include "kunjs/lexer.h"
+
+#include <boost/proto/proto.hpp>
+#include <boost/spirit/home/qi/parser.hpp>
+#include <boost/spirit/home/qi/skip_over.hpp>
+#include <boost/spirit/home/qi/detail/assign_to.hpp>
+#include <boost/spirit/home/support/handles_container.hpp>
+#include <boost/spirit/home/support/info.hpp>
+#include <boost/spirit/home/support/unused.hpp>
+
+#include <string>
+
+// Qi primitives matching the tokens produced by kunjs::Lexer. They only work
+// with TokenIterator, which gives them access to the stream's side tables.
+
+namespace kunjs {
+
+namespace qi = boost::spirit::qi;
+
+// One token of the given kind. Like qi::lit, it exposes no attribute.
+struct token_parser : qi::primitive_parser<token_parser> {
+  template <typename Context, typename Iterator>
+  struct attribute { typedef boost::spirit::unused_type type; };
+
+  explicit token_parser(token::Kind kind) : kind(kind) {}
+
+  template <typename Iterator, typename Context, typename Skipper, typename Attribute>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const& skipper, Attribute&) const {
+    qi::skip_over(first, last, skipper);
+    if (first == last || first->kind != kind)
+      return false;
+
+    ++first;
+    return true;
+  }
+
+  template <typename Context>
+  qi::info what(Context&) const {
+    return qi::info("token", token::spelling(kind));
+  }
+
+  token::Kind kind;
+};
+
+// The `;` ending a continue, break or return statement, or where one is
+// inserted: before a line break (no line terminator is allowed before their
+// label or expression), a `}` or the end of the program. Only the `;` is
+// consumed.
+struct line_end_parser : qi::primitive_parser<line_end_parser> {
+  template <typename Context, typename Iterator>
+  struct attribute { typedef boost::spirit::unused_type type; };
+
+  template <typename Iterator, typename Context, typename Skipper, typename Attribute>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const& skipper, Attribute&) const {
+    qi::skip_over(first, last, skipper);
+    if (first == last || first->kind == token::RBRACE)
+      return true;
+    if (first->kind != token::SEMICOLON)
+      return first.follows_line_break();
+
+    ++first;
+    return true;
+  }
+
+  template <typename Context>
+  qi::info what(Context&) const {
+    return qi::info("token", token::spelling(token::SEMICOLON));
+  }
+};
+
+// One keyword or punctuator of the given kind, exposing its spelling.
+struct operator_parser : qi::primitive_parser<operator_parser> {
+  template <typename Context, typename Iterator>
+  struct attribute { typedef ast::String type; };
+
+  explicit operator_parser(token::Kind kind) : kind(kind) {}
+
+  template <typename Iterator, typename Context, typename Skipper, typename Attribute>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const& skipper, Attribute& attr) const {
+    qi::skip_over(first, last, skipper);
+    if (first == last || first->kind != kind)
+      return false;
+
+    boost::spirit::traits::assign_to(ast::String(token::spelling(kind)), attr);
+    ++first;
+    return true;
+  }
+
+  template <typename Context>
+  qi::info what(Context&) const {
+    return qi::info("token", token::spelling(kind));
+  }
+
+  token::Kind kind;
+};
+
+// An identifier, exposing its atom. With reserved set, keywords and
+// reserved words are accepted as names too (as in `object.default`).
+struct name_parser : qi::primitive_parser<name_parser> {
+  template <typename Context, typename Iterator>
+  struct attribute { typedef Atom type; };
+
+  explicit name_parser(bool reserved) : reserved(reserved) {}
+
+  template <typename Iterator, typename Context, typename Skipper, typename Attribute>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const& skipper, Attribute& attr) const {
+    qi::skip_over(first, last, skipper);
+    if (first == last)
+      return false;
+
+    if (first->kind != token::IDENTIFIER && !(reserved && token::is_reserved(first->kind)))
+      return false;
+
+    boost::spirit::traits::assign_to(first.stream().atom(*first), attr);
+    ++first;
+    return true;
+  }
+
+  template <typename Context>
+  qi::info what(Context&) const {
+    return qi::info(reserved ? "identifier_name" : "identifier");
+  }
+
+  bool reserved;
+};
+
+// A numeric literal, exposing the value the lexer already scanned.
+struct number_parser : qi::primitive_parser<number_parser> {
+  template <typename Context, typename Iterator>
+  struct attribute { typedef ast::Numeric type; };
+
+  template <typename Iterator, typename Context, typename Skipper, typename Attribute>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const& skipper, Attribute& attr) const {
+    qi::skip_over(first, last, skipper);
+    if (first == last || first->kind != token::NUMBER)
+      return false;
+
+    boost::spirit::traits::assign_to(first.stream().numbers[first->value], attr);
+    ++first;
+    return true;
+  }
+
+  template <typename Context>
+  qi::info what(Context&) const {
+    return qi::info("number");
+  }
+};
+
+// A string literal, exposing its value (see TokenStream::string).
+struct string_parser : qi::primitive_parser<string_parser> {
+  template <typename Context, typename Iterator>
+  struct attribute { typedef ast::String type; };
+
+  template <typename Iterator, typename Context, typename Skipper, typename Attribute>
+  bool parse(Iterator& first, Iterator const& last,
+             Context&, Skipper const& skipper, Attribute& attr) const {
+    qi::skip_over(first, last, skipper);
+    if (first == last || first->kind != token::STRING)
+      return false;
+
+    Assign(first.stream(), *first, attr);
+    ++first;
+    return true;
+  }
+
+  template <typename Context>
+  qi::info what(Context&) const {
+    return qi::info("string");
+  }
+
+ private:
+  // Straight into the rule's string, which is in the arena already.
+  static void Assign(TokenStream const& stream, Token const& token, ast::String& attr) {
+    stream.string(token, attr);
+  }
+
+  template <typename Attribute>
+  static void Assign(TokenStream const& stream, Token const& token, Attribute& attr) {
+    ast::String value;
+    stream.string(token, value);
+    boost::spirit::traits::assign_to(value, attr);
+  }
+};
+
+// Wraps a primitive so it can be combined with Qi operators.
+template <typename Parser>
+typename boost::proto::terminal<Parser>::type terminal(Parser const& parser) {
+  typename boost::proto::terminal<Parser>::type result = {parser};
+  return result;
+}
+
+inline boost::proto::terminal<token_parser>::type tok(token::Kind kind) {
+  return terminal(token_parser(kind));
+}
+
+inline boost::proto::terminal<operator_parser>::type op(token::Kind kind) {
+  return terminal(operator_parser(kind));
+}
+
+} // namespace kunjs
+
+namespace boost { namespace spirit { namespace traits {
+
+// The primitives exposing an ast::String fill it as a whole, not one char at
+// a time, when the surrounding sequence collapses to a string.
+template <typename Attribute, typename Context, typename Iterator>
+struct handles_container<kunjs::operator_parser, Attribute, Context, Iterator>
+  : mpl::true_ {};
+
+template <typename Attribute, typename Context, typename Iterator>
+struct handles_container<kunjs::string_parser, Attribute, Context, Iterator>
+  : mpl::true_ {};
+
+} } }
+
+#endif // KUNJS_TOKEN_PARSER_H_
@@ -0,0 +1,131 @@
+#include "kunjs/ast_walker.h"
+#include "kunjs/arena.h"
+#include "kunjs/parser.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+namespace ast = kunjs::ast;
+
+kunjs::AtomTable atoms;
+
+// Prints binary expressions as `(lhs rhs)`, names as themselves and other
+// literals as `#`.
+class Tracer : public ast::Walker<Tracer> {
+ public:
+  using ast::Walker<Tracer>::enter;
+  using ast::Walker<Tracer>::at;
+  using ast::Walker<Tracer>::leave;
+
+  bool enter(ast::BinaryExpression const&) { trace += "("; return true; }
+  void at(ast::BinaryExpression const&, std::size_t slot) { if (slot) trace += " "; }
+  void leave(ast::BinaryExpression const&) { trace += ")"; }
+  bool enter(kunjs::Atom name) { trace += atoms.name(name); return true; }
+  bool enter(ast::Literal const&) { trace += "#"; return true; }
+
+  std::string trace;
+};
+
+// Counts names, negations, the slots of for loops and the function
+// expressions left, optionally skipping the insides of functions.
+class Counter : public ast::Walker<Counter> {
+ public:
+  using ast::Walker<Counter>::enter;
+  using ast::Walker<Counter>::at;
+  using ast::Walker<Counter>::leave;
+
+  explicit Counter(bool skip_functions = false)
+      : skip_functions(skip_functions), names(0), functions(0), negations(0), for_slots(0) {}
+
+  bool enter(kunjs::Atom) { ++names; return true; }
+  bool enter(ast::FunctionExpression const&) { return !skip_functions; }
+  void leave(ast::FunctionExpression const&) { ++functions; }
+  bool enter(ast::UnaryExpression const&) { ++negations; return true; }
+  void at(ast::For const&, std::size_t) { ++for_slots; }
+
+  bool skip_functions;
+  std::size_t names;
+  std::size_t functions;
+  std::size_t negations;
+  std::size_t for_slots;
+};
+
+void Parse(std::string const& code, kunjs::ParsedProgram& parsed) {
+  kunjs::Parser parser;
+  ASSERT_TRUE(parser.parse(code, parsed));
+}
+
+// `-(-(...-(1)))`, depth negations deep. Built by hand, since the parser
+// recurses on nesting itself, and never destroyed, since destroying it would
+// recurse as deep: its nodes go back with the arena that is current.
+ast::AssignmentExpression const& Negations(std::size_t depth) {
+  ast::AssignmentExpression* root =
+      new (kunjs::Arena::acquire(sizeof(ast::AssignmentExpression))) ast::AssignmentExpression;
+  ast::AssignmentExpression* expression = root;
+  for (std::size_t i = 0; i < depth; ++i) {
+    ast::UnaryExpression negation;
+    negation.operator_ = ast::op::SUB;
+    static_cast<ast::ExpressionNode&>(*expression) = negation;
+    expression = &boost::get<ast::UnaryExpression>(*expression).operand;
+  }
+  static_cast<ast::ExpressionNode&>(*expression) = ast::Literal(ast::Numeric(1));
+  return *root;
+}
+
+}
+
+TEST(ASTWalker, CallsHooksInOrder) {
+  kunjs::ParsedProgram parsed(atoms);
+  Parse("a + b * 2 - c;", parsed);
+  Tracer tracer;
+  tracer.walk(parsed.program());
+  ASSERT_EQ("((a (b #)) c)", tracer.trace);
+}
+
+TEST(ASTWalker, SkipsWhatEnterRefuses) {
+  kunjs::ParsedProgram parsed(atoms);
+  Parse("f(function (x) { return y + z; }, w);", parsed);
+
+  Counter all;
+  all.walk(parsed.program());
+  ASSERT_EQ(4u, all.names);
+  ASSERT_EQ(1u, all.functions);
+
+  Counter outside(true);
+  outside.walk(parsed.program());
+  ASSERT_EQ(2u, outside.names);
+  ASSERT_EQ(0u, outside.functions);
+}
+
+TEST(ASTWalker, VisitsEmptySlots) {
+  kunjs::ParsedProgram parsed(atoms);
+  Parse("for (;;) ; for (i = 0; i < n; ) i++;", parsed);
+  Counter counter;
+  counter.walk(parsed.program());
+  ASSERT_EQ(8u, counter.for_slots);
+  ASSERT_EQ(4u, counter.names);
+}
+
+TEST(ASTWalker, WalksStatementsAndExpressions) {
+  kunjs::ParsedProgram parsed(atoms);
+  Parse("if (a) b = c; d * 2;", parsed);
+  Counter counter;
+  counter.walk(boost::get<ast::Statement>(parsed.program()[0]));
+  ASSERT_EQ(3u, counter.names);
+
+  ast::Statement const& statement = boost::get<ast::Statement>(parsed.program()[1]);
+  Tracer tracer;
+  tracer.walk(boost::get<ast::Expression>(statement).front());
+  ASSERT_EQ("(d #)", tracer.trace);
+}
+
+TEST(ASTWalker, WalksDeepTrees) {
+  kunjs::Arena arena;
+  kunjs::Arena::Scope scope(arena);
+  ast::AssignmentExpression const& deep = Negations(200000);
+  Counter counter;
+  counter.walk(deep);
+  ASSERT_EQ(200000u, counter.negations);
+}
@@ -0,0 +1,44 @@
+#include "kunjs/atom.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+TEST(AtomTable, EqualNamesShareAnAtom) {
+  kunjs::AtomTable atoms;
+  std::string code = "length = list.length";
+  kunjs::Atom first = atoms.intern(code.data(), code.data() + 6);
+  kunjs::Atom second = atoms.intern(code.data() + 14, code.data() + code.size());
+  kunjs::Atom list = atoms.intern("list");
+
+  ASSERT_EQ(first, second);
+  ASSERT_NE(first, list);
+  ASSERT_EQ(2u, atoms.size());
+  ASSERT_EQ("length", atoms.name(first));
+  ASSERT_EQ("list", atoms.name(list));
+}
+
+TEST(AtomTable, AtomsAreNumberedInOrder) {
+  kunjs::AtomTable atoms;
+  ASSERT_EQ(0u, atoms.intern("a").id);
+  ASSERT_EQ(1u, atoms.intern("b").id);
+  ASSERT_EQ(0u, atoms.intern("a").id);
+  ASSERT_EQ(2u, atoms.intern("").id);
+}
+
+TEST(AtomTable, NamesKeepTheirAddress) {
+  kunjs::AtomTable atoms;
+  kunjs::Atom first = atoms.intern("first");
+  std::string const* name = &atoms.name(first);
+  for (int i = 0; i < 1000; ++i)
+    atoms.intern("name" + std::string(1, char('a' + i % 26)) + std::string(i / 26, 'x'));
+  ASSERT_EQ(name, &atoms.name(first));
+}
+
+TEST(AtomTable, Find) {
+  kunjs::AtomTable atoms;
+  kunjs::Atom known = atoms.intern("known");
+  std::string unknown = "unknown";
+  ASSERT_EQ(known, atoms.find("known", "known" + 5));
+  ASSERT_EQ(kunjs::Atom(), atoms.find(unknown.data(), unknown.data() + unknown.size()));
+  ASSERT_EQ(1u, atoms.size());
+}
@@ -0,0 +1,203 @@
+#include "kunjs/compiler/bytecode_compiler.h"
+#include "kunjs/compiler/interpreter.h"
+#include "kunjs/compiler/scope.h"
+#include "kunjs/arena.h"
+#include "kunjs/parser.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+namespace ast = kunjs::ast;
+namespace compiler = kunjs::compiler;
+
+kunjs::AtomTable atoms;
+
+void Parse(std::string const& code, kunjs::ParsedProgram& parsed) {
+  kunjs::Parser parser;
+  ASSERT_TRUE(parser.parse(code, parsed));
+}
+
+std::string Interpret(std::string const& code) {
+  kunjs::ParsedProgram parsed(atoms);
+  Parse(code, parsed);
+  compiler::Code bytecode;
+  EXPECT_TRUE(compiler::BytecodeCompiler()(parsed.program(), bytecode));
+  compiler::Interpreter interpreter;
+  return compiler::to_string(interpreter.run(bytecode));
+}
+
+// The opcodes of code, one name a line.
+std::string Listing(std::string const& code) {
+  kunjs::ParsedProgram parsed(atoms);
+  Parse(code, parsed);
+  compiler::Code bytecode;
+  compiler::BytecodeCompiler()(parsed.program(), bytecode);
+  std::string listing;
+  for (std::size_t i = 0; i < bytecode.instructions.size(); ++i)
+    listing += std::string(compiler::bytecode::name(
+        compiler::bytecode::Opcode(bytecode.instructions[i].opcode))) + "\n";
+  return listing;
+}
+
+// `1 + (1 + (... + 1))`, each level taking a register more. Built by hand
+// and never destroyed, like the trees of test/ast_walker_test.cc.
+ast::Program const& Sums(std::size_t depth) {
+  ast::Program* program = new (kunjs::Arena::acquire(sizeof(ast::Program))) ast::Program;
+  program->push_back(ast::Statement(ast::Expression(1)));
+  ast::AssignmentExpression* sum =
+      &boost::get<ast::Expression>(boost::get<ast::Statement>(program->back())).front();
+  for (std::size_t i = 0; i < depth; ++i) {
+    ast::BinaryExpression addition;
+    addition.operator_ = ast::op::ADD;
+    static_cast<ast::ExpressionNode&>(addition.lhs) = ast::Literal(ast::Numeric(1));
+    static_cast<ast::ExpressionNode&>(*sum) = addition;
+    sum = &boost::get<ast::BinaryExpression>(*sum).rhs;
+  }
+  static_cast<ast::ExpressionNode&>(*sum) = ast::Literal(ast::Numeric(1));
+  return *program;
+}
+
+}
+
+TEST(Bytecode, ComputesLikeTheJIT) {
+  ASSERT_EQ("3", Interpret("1 + 2;"));
+  ASSERT_EQ("-5", Interpret("1+2-3+7-12;"));
+  ASSERT_EQ("2.5", Interpret("5.0 / 2;"));
+  ASSERT_EQ("8.5", Interpret("1/2+2*(3+7) - 12;"));
+  ASSERT_EQ("6.25", Interpret("10 % 3 + 7 * 3 / 4.0;"));
+  ASSERT_EQ("true", Interpret("4 <= 13 - 3;"));
+  ASSERT_EQ("false", Interpret("2 < 2.0;"));
+  ASSERT_EQ("hello", Interpret("1; 'hello';"));
+  ASSERT_EQ("null", Interpret("null;"));
+  ASSERT_EQ("null", Interpret(""));
+}
+
+TEST(Bytecode, RunsOperators) {
+  ASSERT_EQ("-5", Interpret("-(2 + 3);"));
+  ASSERT_EQ("0", Interpret("-0;"));
+  ASSERT_EQ("true", Interpret("!0;"));
+  ASSERT_EQ("-8", Interpret("~7;"));
+  ASSERT_EQ("7", Interpret("3 | 4 & 6 ^ 2;"));
+  ASSERT_EQ("-4", Interpret("-16 >> 2;"));
+  ASSERT_EQ("number", Interpret("typeof 1.5;"));
+  ASSERT_EQ("a12", Interpret("'a' + 1 + 2;"));
+  ASSERT_EQ("3a", Interpret("1 + 2 + 'a';"));
+  ASSERT_EQ("true", Interpret("'1' == 1;"));
+  ASSERT_EQ("false", Interpret("'1' === 1;"));
+  ASSERT_EQ("true", Interpret("'abc' < 'abd';"));
+  ASSERT_EQ("0", Interpret("0 && 1;"));
+  ASSERT_EQ("x", Interpret("0 || 'x';"));
+  ASSERT_EQ("b", Interpret("1 > 2 ? 'a' : 'b';"));
+}
+
+TEST(Bytecode, LeavesIntegersWhereResultsAreNot) {
+  ASSERT_EQ("2.5", Interpret("5 / 2;"));
+  ASSERT_EQ("2", Interpret("6 / 3;"));
+  ASSERT_EQ("2147483648", Interpret("2147483647 + 1;"));
+  ASSERT_EQ("-2147483649", Interpret("-2147483647 - 2;"));
+  ASSERT_EQ("4294967296", Interpret("65536 * 65536;"));
+  ASSERT_EQ("2147483648", Interpret("(-2147483647 - 1) / -1;"));
+  ASSERT_EQ("Infinity", Interpret("1 / 0;"));
+  ASSERT_EQ("NaN", Interpret("7 % 0;"));
+  ASSERT_EQ("-1", Interpret("-7 % 3;"));
+  ASSERT_EQ("-Infinity", Interpret("1 / (0 * -1);"));
+  ASSERT_EQ("-Infinity", Interpret("1 / (-4 % 2);"));
+  ASSERT_EQ("-Infinity", Interpret("1 / (0 / -3);"));
+  ASSERT_EQ("-Infinity", Interpret("1 / ((-2147483647 - 1) % -1);"));
+  ASSERT_EQ("4294967295", Interpret("-1 >>> 0;"));
+  ASSERT_EQ("1073741823", Interpret("-1 >>> 34;"));
+  ASSERT_EQ("-2147483648", Interpret("1 << 31;"));
+}
+
+TEST(Bytecode, KeepsVariables) {
+  ASSERT_EQ("7", Interpret("var x = 2; x = x * 3; x += 1; x;"));
+  ASSERT_EQ("5", Interpret("y = 5; y;"));
+  ASSERT_EQ("1", Interpret("var a = 1; a++;"));
+  ASSERT_EQ("2", Interpret("var a = 1; a++; a;"));
+  ASSERT_EQ("0", Interpret("var a = 1; --a;"));
+  ASSERT_EQ("9", Interpret("var a, b; a = b = 3; a * b;"));
+  ASSERT_EQ("null", Interpret("undeclared;"));
+  ASSERT_EQ("null", Interpret("var late; late;"));
+}
+
+TEST(Bytecode, RunsControlFlow) {
+  ASSERT_EQ("45", Interpret("var s = 0; for (var i = 0; i < 10; i++) s += i; s;"));
+  ASSERT_EQ("10", Interpret("i = 0; while (i < 10) i++; i;"));
+  ASSERT_EQ("1", Interpret("i = 0; do i++; while (false); i;"));
+  ASSERT_EQ("no", Interpret("if (0) 'yes'; else 'no';"));
+  ASSERT_EQ("25", Interpret("var s = 0;"
+                      "for (var i = 0; ; i++) {"
+                      "  if (i >= 10) break;"
+                      "  if (i % 2 == 0) continue;"
+                      "  s += i;"
+                      "}"
+                      "s;"));
+  ASSERT_EQ("12", Interpret("var n = 0;"
+                      "outer: for (var i = 0; i < 4; i++)"
+                      "  for (var j = 0; j < 4; j++) {"
+                      "    if (j == 3) continue outer;"
+                      "    n++;"
+                      "  }"
+                      "n;"));
+  ASSERT_EQ("3", Interpret("var k = 0; block: { k = 3; break block; k = 4; } k;"));
+}
+
+TEST(Bytecode, SkipsWhatItCannotCompile) {
+  ASSERT_EQ("null", Interpret("f(1);"));
+  ASSERT_EQ("3", Interpret("a.b = 3;"));
+  ASSERT_EQ("2", Interpret("2; function f() { return 1; }"));
+}
+
+TEST(Bytecode, AllocatesRegistersAsAStack) {
+  ASSERT_EQ("LOAD_CONSTANT\nLOAD_CONSTANT\nADD\nMOVE\nMOVE\nRETURN\n", Listing("x = 1 + 2;"));
+
+  kunjs::ParsedProgram parsed(atoms);
+  Parse("var a = 1, b = 2; (a + b) * (a - b) + (a * b);", parsed);
+  compiler::Scope scope(parsed.program());
+  ASSERT_EQ(2u, scope.size());
+  compiler::Code code;
+  ASSERT_TRUE(compiler::BytecodeCompiler()(parsed.program(), code));
+  // result, a, b, and three for the expression
+  ASSERT_EQ(6u, code.registers);
+}
+
+TEST(Bytecode, RefusesWhatNeedsTooManyRegisters) {
+  kunjs::Arena arena;
+  kunjs::Arena::Scope scope(arena);
+  compiler::Code small;
+  ASSERT_TRUE(compiler::BytecodeCompiler()(Sums(1000), small));
+  compiler::Interpreter interpreter;
+  ASSERT_EQ("1001", compiler::to_string(interpreter.run(small)));
+
+  compiler::Code large;
+  ASSERT_FALSE(compiler::BytecodeCompiler()(Sums(70000), large));
+}
+
+TEST(Interpreter, CountsBackEdges) {
+  kunjs::ParsedProgram parsed(atoms);
+  Parse("var n = 0;"
+        "for (var i = 0; i < 4; i++)"
+        "  for (var j = 0; j < 5; j++) n++;"
+        "while (n < 25) n++;"
+        "n;", parsed);
+  compiler::Code code;
+  ASSERT_TRUE(compiler::BytecodeCompiler()(parsed.program(), code));
+  compiler::Interpreter interpreter;
+  ASSERT_EQ(0u, interpreter.back_edges());
+  ASSERT_EQ("25", compiler::to_string(interpreter.run(code)));
+  ASSERT_EQ(4u + 4u * 5u + 5u, interpreter.back_edges());
+  ASSERT_EQ("25", compiler::to_string(interpreter.run(code)));
+  ASSERT_EQ(29u, interpreter.back_edges());
+}
+
+TEST(Interpreter, RunsAgain) {
+  kunjs::ParsedProgram parsed(atoms);
+  Parse("var s = ''; for (var i = 0; i < 3; i++) s = s + i; s;", parsed);
+  compiler::Code code;
+  ASSERT_TRUE(compiler::BytecodeCompiler()(parsed.program(), code));
+  compiler::Interpreter interpreter;
+  ASSERT_EQ("012", compiler::to_string(interpreter.run(code)));
+  ASSERT_EQ("012", compiler::to_string(interpreter.run(code)));
+}
@@ -1,21 +1,67 @@
 #include "kunjs/compiler.h"
+#include "kunjs/compiler/bytecode_compiler.h"
+#include "kunjs/compiler/program_compiler.h"
+#include "kunjs/flat_ast.h"
+#include "kunjs/kunjs.h"
+#include "kunjs/parser.h"
 #include <llvm/Constants.h>
 #include <llvm/DerivedTypes.h>
+#include <llvm/Instructions.h>
+#include <llvm/LLVMContext.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <gtest/gtest.h>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
 
 namespace {
 void DumpValue(llvm::Value* value) {
   std::cout << "--> value: " << std::flush;
   value->dump();
 }
+
+// Runs programs on an engine of its own, and counts the wrong results.
+void RunOnEngine(int* failures) {
+  kunjs::Runner runner(kunjs::Runner::JIT);
+  for (int i = 0; i < 200; ++i) {
+    std::ostringstream code, expected;
+    code << i << " * 2 + 1.5;";
+    expected << i * 2 + 1.5;
+    if (runner.run(code.str()) != expected.str())
+      ++*failures;
+  }
+}
+
+void Record(std::vector<kunjs::TierEvent>* events, kunjs::TierEvent const& event) {
+  events->push_back(event);
+}
+
+// What the function of a program returns; the programs below fold to a
+// constant.
+llvm::Value* Returned(llvm::Function* program) {
+  EXPECT_TRUE(program != 0);
+  return llvm::cast<llvm::ReturnInst>(program->getEntryBlock().getTerminator())->getReturnValue();
+}
+
+llvm::Function* CompileFlat(kunjs::Compiler& engine, char const* code,
+                            kunjs::compiler::ProgramCompiler::Coverage coverage) {
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  EXPECT_TRUE(parser.parse(code, parsed));
+  kunjs::flat::Tree tree;
+  kunjs::flat::flatten(parsed.program(), parsed.atoms(), tree);
+  kunjs::compiler::ProgramCompiler compile(engine.module(), coverage);
+  return compile(tree);
+}
 }
 
 TEST(Compiler, Int) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("1;");
+  llvm::Value* result = Returned(compiler.compile("1;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -25,7 +71,7 @@ TEST(Compiler, Int) {
 
 TEST(Compiler, Float) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("3.14;");
+  llvm::Value* result = Returned(compiler.compile("3.14;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantFP>(result));
@@ -35,7 +81,7 @@ TEST(Compiler, Float) {
 
 TEST(Compiler, Null) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("null;");
+  llvm::Value* result = Returned(compiler.compile("null;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantPointerNull>(result));
@@ -45,7 +91,7 @@ TEST(Compiler, Null) {
 
 TEST(Compiler, True) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("true;");
+  llvm::Value* result = Returned(compiler.compile("true;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -55,7 +101,7 @@ TEST(Compiler, True) {
 
 TEST(Compiler, False) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("false;");
+  llvm::Value* result = Returned(compiler.compile("false;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -65,7 +111,7 @@ TEST(Compiler, False) {
 
 TEST(Compiler, ShiftLeft) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("55 << 4;");
+  llvm::Value* result = Returned(compiler.compile("55 << 4;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -75,7 +121,7 @@ TEST(Compiler, ShiftLeft) {
 
 TEST(Compiler, ShiftRight) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("451 >> 2;");
+  llvm::Value* result = Returned(compiler.compile("451 >> 2;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -85,17 +131,17 @@ TEST(Compiler, ShiftRight) {
 
 TEST(Compiler, SignalShiftRight) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("-451 >>> 2;");
+  llvm::Value* result = Returned(compiler.compile("(0 - 451) >>> 2;"));
   DumpValue(result);
 
-  ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
-  llvm::ConstantInt* r = llvm::cast<llvm::ConstantInt>(result);
-  ASSERT_TRUE(r->equalsInt(112));
+  ASSERT_TRUE(llvm::isa<llvm::ConstantFP>(result));
+  llvm::ConstantFP* r = llvm::cast<llvm::ConstantFP>(result);
+  ASSERT_TRUE(r->isExactlyValue(1073741711));
 }
 
 TEST(Compiler, FloatShiftLeft) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("55 << 4.0;");
+  llvm::Value* result = Returned(compiler.compile("55 << 4.0;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -105,27 +151,27 @@ TEST(Compiler, FloatShiftLeft) {
 
 TEST(Compiler, FloatShiftRight) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("-21.0 >> 2;");
+  llvm::Value* result = Returned(compiler.compile("(0 - 21.0) >> 2;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
   llvm::ConstantInt* r = llvm::cast<llvm::ConstantInt>(result);
-  ASSERT_TRUE(r->equalsInt(5));
+  ASSERT_TRUE(r->equalsInt(-6U));
 }
 
 TEST(Compiler, FloatSignalShiftRight) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("-451.0 >>> 2.3;");
+  llvm::Value* result = Returned(compiler.compile("(0 - 451.0) >>> 2.3;"));
   DumpValue(result);
 
-  ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
-  llvm::ConstantInt* r = llvm::cast<llvm::ConstantInt>(result);
-  ASSERT_TRUE(r->equalsInt(112));
+  ASSERT_TRUE(llvm::isa<llvm::ConstantFP>(result));
+  llvm::ConstantFP* r = llvm::cast<llvm::ConstantFP>(result);
+  ASSERT_TRUE(r->isExactlyValue(1073741711));
 }
 
 TEST(Compiler, SimpleIntArithmetic) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("1+2;");
+  llvm::Value* result = Returned(compiler.compile("1+2;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -135,7 +181,7 @@ TEST(Compiler, SimpleIntArithmetic) {
 
 TEST(Compiler, ComplexIntArithmetic) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("1+2-3+7-12;");
+  llvm::Value* result = Returned(compiler.compile("1+2-3+7-12;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -145,7 +191,7 @@ TEST(Compiler, ComplexIntArithmetic) {
 
 TEST(Compiler, SimpleFloatArithmetic) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("2.72 + 7.145;");
+  llvm::Value* result = Returned(compiler.compile("2.72 + 7.145;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantFP>(result));
@@ -155,7 +201,7 @@ TEST(Compiler, SimpleFloatArithmetic) {
 
 TEST(Compiler, ComplexFloatArithmetic) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("4.123 -20 + 62.145 - 108.2;");
+  llvm::Value* result = Returned(compiler.compile("4.123 -20 + 62.145 - 108.2;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantFP>(result));
@@ -165,7 +211,7 @@ TEST(Compiler, ComplexFloatArithmetic) {
 
 TEST(Compiler, IntMultiplication) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("5*9;");
+  llvm::Value* result = Returned(compiler.compile("5*9;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -175,17 +221,17 @@ TEST(Compiler, IntMultiplication) {
 
 TEST(Compiler, ComplexIntMultiplication) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("1/2+2*(3+7) - 12;");
+  llvm::Value* result = Returned(compiler.compile("1/2+2*(3+7) - 12;"));
   DumpValue(result);
 
-  ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
-  llvm::ConstantInt* r = llvm::cast<llvm::ConstantInt>(result);
-  ASSERT_TRUE(r->equalsInt(8));
+  ASSERT_TRUE(llvm::isa<llvm::ConstantFP>(result));
+  llvm::ConstantFP* r = llvm::cast<llvm::ConstantFP>(result);
+  ASSERT_TRUE(r->isExactlyValue(8.5));
 }
 
 TEST(Compiler, FloatMultiplication) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("5.0 / 2;");
+  llvm::Value* result = Returned(compiler.compile("5.0 / 2;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantFP>(result));
@@ -195,7 +241,7 @@ TEST(Compiler, FloatMultiplication) {
 
 TEST(Compiler, ComplexFloatMultiplication) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("10 % 3 + 7 * 3 / 4.0;");
+  llvm::Value* result = Returned(compiler.compile("10 % 3 + 7 * 3 / 4.0;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantFP>(result));
@@ -205,7 +251,7 @@ TEST(Compiler, ComplexFloatMultiplication) {
 
 TEST(Compiler, LessThanOrEqual) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("4 <= 13 - 3;");
+  llvm::Value* result = Returned(compiler.compile("4 <= 13 - 3;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -215,7 +261,7 @@ TEST(Compiler, LessThanOrEqual) {
 
 TEST(Compiler, GreaterThanOrEqual) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("4 >= 13 - 9;");
+  llvm::Value* result = Returned(compiler.compile("4 >= 13 - 9;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -225,7 +271,7 @@ TEST(Compiler, GreaterThanOrEqual) {
 
 TEST(Compiler, LessThan) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("2 < 2.0;");
+  llvm::Value* result = Returned(compiler.compile("2 < 2.0;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -235,7 +281,7 @@ TEST(Compiler, LessThan) {
 
 TEST(Compiler, GreaterThan) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("32.3 > 1;");
+  llvm::Value* result = Returned(compiler.compile("32.3 > 1;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -245,7 +291,7 @@ TEST(Compiler, GreaterThan) {
 
 TEST(Compiler, Equal) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("2 == 2;");
+  llvm::Value* result = Returned(compiler.compile("2 == 2;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -255,7 +301,7 @@ TEST(Compiler, Equal) {
 
 TEST(Compiler, NotEqual) {
   kunjs::Compiler compiler;
-  llvm::Value* result = compiler.compile("2.0 != 2;");
+  llvm::Value* result = Returned(compiler.compile("2.0 != 2;"));
   DumpValue(result);
 
   ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
@@ -263,3 +309,266 @@ TEST(Compiler, NotEqual) {
   ASSERT_TRUE(r->isZero());
 }
 
+TEST(Compiler, FlatTree) {
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  ASSERT_TRUE(parser.parse("1/2+2*(3+7) - 12;", parsed));
+  kunjs::flat::Tree tree;
+  kunjs::flat::flatten(parsed.program(), parsed.atoms(), tree);
+
+  kunjs::Compiler engine;
+  kunjs::compiler::ProgramCompiler compile(engine.module());
+  llvm::Value* result = Returned(compile(tree));
+  DumpValue(result);
+
+  ASSERT_TRUE(llvm::isa<llvm::ConstantFP>(result));
+  llvm::ConstantFP* r = llvm::cast<llvm::ConstantFP>(result);
+  ASSERT_TRUE(r->isExactlyValue(8.5));
+}
+
+TEST(Compiler, CompilesInFullOrNotAtAll) {
+  kunjs::Compiler engine;
+  kunjs::ParseResult result;
+  kunjs::compiler::ProgramCompiler::Coverage const whole = kunjs::compiler::ProgramCompiler::WHOLE;
+  ASSERT_TRUE(engine.compile("1/2+2*(3+7) - 12;", result, whole) != 0);
+  ASSERT_TRUE(engine.compile("true == 2 > 1;", result, whole) != 0);
+  ASSERT_TRUE(engine.compile("x;", result, whole) == 0);
+  ASSERT_TRUE(result);
+  ASSERT_TRUE(engine.compile("x;", result) != 0);
+  ASSERT_TRUE(engine.compile("'a' + 1;", result, whole) == 0);
+  ASSERT_TRUE(engine.compile("-1;", result, whole) == 0);
+  ASSERT_TRUE(engine.compile("1; ;", result, whole) == 0);
+  ASSERT_TRUE(engine.compile("1 +;", result, whole) == 0);
+  ASSERT_FALSE(result);
+}
+
+TEST(Compiler, CompilesFlatTreesInFullOrNotAtAll) {
+  kunjs::Compiler engine;
+  kunjs::compiler::ProgramCompiler::Coverage const whole = kunjs::compiler::ProgramCompiler::WHOLE;
+  ASSERT_TRUE(CompileFlat(engine, "true == 2 > 1;", whole) != 0);
+  llvm::Value* result = Returned(CompileFlat(engine, "(1, 6 & 3 | 8 ^ 1.5);", whole));
+  ASSERT_TRUE(llvm::isa<llvm::ConstantInt>(result));
+  ASSERT_TRUE(llvm::cast<llvm::ConstantInt>(result)->equalsInt(11));
+
+  char const* const partial[] = {
+    "x;", "-1;", "x++;", "x = 1;", "true ? 1 : 2;", "1 && 2;", "[1, 2];", "'a' + 1;",
+    "a.b;", "f();", "1; ;", "{}", "var x = 1;", "function f() {}"
+  };
+  for (std::size_t i = 0; i < sizeof(partial) / sizeof(partial[0]); ++i) {
+    ASSERT_TRUE(CompileFlat(engine, partial[i], whole) == 0) << partial[i];
+    ASSERT_TRUE(CompileFlat(engine, partial[i], kunjs::compiler::ProgramCompiler::PARTIAL) != 0);
+  }
+}
+
+TEST(Runner, RunsPrograms) {
+  kunjs::Runner::Tier const tiers[] = {
+    kunjs::Runner::INTERPRETER, kunjs::Runner::JIT, kunjs::Runner::TIERED
+  };
+  for (int i = 0; i < 3; ++i) {
+    kunjs::Runner runner(tiers[i]);
+    ASSERT_EQ("3", runner.run("1 + 2;"));
+    ASSERT_EQ("-5", runner.run("1+2-3+7-12;"));
+    ASSERT_EQ("2.5", runner.run("5.0 / 2;"));
+    ASSERT_EQ("8.5", runner.run("1/2+2*(3+7) - 12;"));
+    ASSERT_EQ("6.25", runner.run("10 % 3 + 7 * 3 / 4.0;"));
+    ASSERT_EQ("true", runner.run("4 <= 13 - 3;"));
+    ASSERT_EQ("false", runner.run("2 < 2.0;"));
+    ASSERT_EQ("hello", runner.run("1; 'hello';"));
+    ASSERT_EQ("null", runner.run("null;"));
+    ASSERT_EQ("11", runner.run("6 & 3 | 8 ^ 1.5;"));
+    ASSERT_EQ("null", runner.run(""));
+  }
+}
+
+TEST(Runner, DividesIntegersAsDoubles) {
+  kunjs::Runner runner(kunjs::Runner::JIT);
+  ASSERT_EQ("2.5", runner.run("5 / 2;"));
+  ASSERT_EQ("Infinity", runner.run("1 / 0;"));
+  ASSERT_EQ("NaN", runner.run("0 / 0;"));
+  ASSERT_EQ("NaN", runner.run("7 % 0;"));
+  ASSERT_EQ("0", runner.run("4 % 2;"));
+  ASSERT_EQ("1.5", runner.run("7.5 % 2;"));
+}
+
+TEST(Runner, ShiftsAndMasksAsInt32) {
+  kunjs::Runner runner(kunjs::Runner::JIT);
+  ASSERT_EQ("2", runner.run("1 << 33;"));
+  ASSERT_EQ("-2147483648", runner.run("1 << 31;"));
+  ASSERT_EQ("-2147483648", runner.run("2147483648 | 0;"));
+  ASSERT_EQ("3", runner.run("4294967296.5 | 3;"));
+  ASSERT_EQ("4294967295", runner.run("4294967295 >>> 0;"));
+  ASSERT_EQ("1073741823", runner.run("(0 - 1) >>> 34;"));
+}
+
+// Moving a script to the JIT must not change what it gives: each is run
+// interpreted, then hot enough to be compiled, then as machine code.
+TEST(Runner, GivesTheSameResultsInEveryTier) {
+  char const* const programs[] = {
+    "1 + 2;", "5 / 2;", "1 / 0;", "0 / 0;", "7 % 0;", "7.5 % 2;", "4 % 2;",
+    "1 << 33;", "1 << 31;", "2147483648 | 0;", "4294967295 >>> 0;", "(0 - 1) >>> 0;",
+    "4294967296.5 | 3;", "1e300 | 0;", "(0 / 0) | 0;", "(1 / 0) >> 1;", "1e20 ^ 5;",
+    "2147483647 + 1;", "(0 - 2147483647) - 2;", "65536 * 65536;", "1 / (0 * (0 - 1));",
+    "1 / ((0 - 4) % 2);", "1 / (0 / (0 - 3));", "(0 - 2147483647 - 1) / (0 - 1);",
+    "0 / 0 == 0 / 0;", "0 / 0 != 0 / 0;", "0 / 0 < 1;", "1 / 0 > 1e308;",
+    "true == 2 > 1;", "6 & 3 | 8 ^ 1.5;", "1/2+2*(3+7) - 12;"
+  };
+  std::vector<kunjs::TierEvent> events;
+  kunjs::Runner::Tiering tiering;
+  tiering.calls = 1;
+  tiering.listener = boost::bind(Record, &events, _1);
+  std::size_t compiled = 0;
+  for (std::size_t i = 0; i < sizeof(programs) / sizeof(programs[0]); ++i) {
+    std::string interpreted = kunjs::Runner(kunjs::Runner::INTERPRETER).run(programs[i]);
+    kunjs::Runner tiered(tiering);
+    ASSERT_EQ(interpreted, tiered.run(programs[i])) << programs[i];
+    ASSERT_EQ(interpreted, tiered.run(programs[i])) << programs[i];
+    compiled += events.back().kind == kunjs::TierEvent::COMPILED;
+  }
+  // the ones the JIT declines stay interpreted
+  ASSERT_LT(20u, compiled);
+}
+
+// What the JIT cannot compile yet is null, not some operand of it.
+TEST(Runner, LeavesWhatItCannotCompileNull) {
+  kunjs::Runner runner(kunjs::Runner::JIT);
+  ASSERT_EQ("null", runner.run("-5;"));
+  ASSERT_EQ("null", runner.run("!true;"));
+  ASSERT_EQ("null", runner.run("'a' + 1;"));
+  ASSERT_EQ("null", runner.run("var a = 3; a * 2;"));
+  ASSERT_EQ("null", runner.run("1 + (true ? 1 : 2);"));
+  ASSERT_EQ("null", runner.run("[1, 2] * 2;"));
+}
+
+TEST(Runner, RunsWhatBytecodeCannotHoldWithTheJIT) {
+  // a register a variable, more than an operand can name
+  std::ostringstream code;
+  code << "var v0";
+  for (int i = 1; i < 70000; ++i)
+    code << ", v" << i;
+  code << "; 1 + 2;";
+  kunjs::ParsedProgram parsed;
+  ASSERT_TRUE(kunjs::Parser().parse(code.str(), parsed));
+  kunjs::compiler::Code bytecode;
+  ASSERT_FALSE(kunjs::compiler::BytecodeCompiler()(parsed.program(), bytecode));
+
+  kunjs::Runner::Tier const tiers[] = { kunjs::Runner::INTERPRETER, kunjs::Runner::TIERED };
+  for (int i = 0; i < 2; ++i) {
+    kunjs::Runner runner(tiers[i]);
+    ASSERT_EQ("3", runner.run(code.str()));
+  }
+}
+
+TEST(Runner, ReportsSyntaxErrors) {
+  kunjs::Runner interpreted(kunjs::Runner::INTERPRETER);
+  ASSERT_EQ(0u, interpreted.run("1 +;").find("Parsing failed"));
+  kunjs::Runner compiled(kunjs::Runner::JIT);
+  ASSERT_EQ(0u, compiled.run("1 +;").find("Parsing failed"));
+  kunjs::Runner tiered;
+  ASSERT_EQ(0u, tiered.run("1 +;").find("Parsing failed"));
+  ASSERT_EQ(0u, tiered.run("1 +;").find("Parsing failed"));
+}
+
+TEST(Runner, MovesHotScriptsToTheJIT) {
+  std::vector<kunjs::TierEvent> events;
+  kunjs::Runner::Tiering tiering;
+  tiering.calls = 3;
+  tiering.listener = boost::bind(Record, &events, _1);
+  kunjs::Runner runner(tiering);
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ("8.5", runner.run("1/2+2*(3+7) - 12;"));
+    ASSERT_EQ("hello", runner.run("1; 'hello';"));
+  }
+  // each is compiled at the start of the run after the one it got hot in
+  ASSERT_EQ(4u, events.size());
+  ASSERT_EQ(kunjs::TierEvent::QUEUED, events[0].kind);
+  ASSERT_EQ("1/2+2*(3+7) - 12;", events[0].code);
+  ASSERT_EQ(3u, events[0].calls);
+  ASSERT_EQ(kunjs::TierEvent::COMPILED, events[1].kind);
+  ASSERT_EQ("1/2+2*(3+7) - 12;", events[1].code);
+  ASSERT_EQ(kunjs::TierEvent::QUEUED, events[2].kind);
+  ASSERT_EQ("1; 'hello';", events[2].code);
+  ASSERT_EQ(3u, events[2].calls);
+  ASSERT_EQ(kunjs::TierEvent::COMPILED, events[3].kind);
+  ASSERT_EQ("1; 'hello';", events[3].code);
+
+  kunjs::Runner::Tiering never;
+  never.calls = never.back_edges = 0;
+  never.listener = tiering.listener;
+  kunjs::Runner interpreted(never);
+  for (int i = 0; i < 200; ++i)
+    interpreted.run("1 + 2;");
+  ASSERT_EQ(4u, events.size());
+}
+
+TEST(Runner, CallsMachineCodeOfEveryType) {
+  std::vector<kunjs::TierEvent> events;
+  kunjs::Runner::Tiering tiering;
+  tiering.calls = 1;
+  tiering.listener = boost::bind(Record, &events, _1);
+  kunjs::Runner runner(tiering);
+  char const* const programs[][2] = {
+    { "4 <= 13 - 3;", "true" }, { "7 - 9;", "-2" }, { "5.0 / 2;", "2.5" }, { "'text';", "text" }
+  };
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(programs[i][1], runner.run(programs[i][0]));
+    ASSERT_EQ(programs[i][1], runner.run(programs[i][0]));
+    ASSERT_EQ(kunjs::TierEvent::COMPILED, events.back().kind);
+    ASSERT_EQ(programs[i][1], runner.run(programs[i][0]));
+  }
+
+  // more scripts than the runner keeps: the machine code of the first ones
+  // is freed along with them
+  for (int i = 0; i < 300; ++i) {
+    std::ostringstream code, expected;
+    code << i << " * 2 + 1.5;";
+    expected << i * 2 + 1.5;
+    ASSERT_EQ(expected.str(), runner.run(code.str()));
+    ASSERT_EQ(expected.str(), runner.run(code.str()));
+  }
+  ASSERT_EQ("2.5", runner.run("5.0 / 2;"));
+}
+
+TEST(Runner, KeepsInterpretingWhatItCannotCompile) {
+  std::vector<kunjs::TierEvent> events;
+  kunjs::Runner::Tiering tiering;
+  tiering.calls = 0;
+  tiering.back_edges = 100;
+  tiering.listener = boost::bind(Record, &events, _1);
+  kunjs::Runner runner(tiering);
+  char const loop[] = "var s = 0; for (var i = 0; i < 60; i++) s += i; s;";
+  ASSERT_EQ("1770", runner.run(loop));
+  ASSERT_TRUE(events.empty());
+  ASSERT_EQ("1770", runner.run(loop));
+  ASSERT_EQ(1u, events.size());
+  ASSERT_EQ(kunjs::TierEvent::QUEUED, events[0].kind);
+  ASSERT_EQ(120u, events[0].back_edges);
+
+  runner.compile_queued();
+  ASSERT_EQ(2u, events.size());
+  ASSERT_EQ(kunjs::TierEvent::DECLINED, events[1].kind);
+  for (int i = 0; i < 3; ++i)
+    ASSERT_EQ("1770", runner.run(loop));
+  ASSERT_EQ(2u, events.size());
+}
+
+TEST(Runner, RunsEnginesOnManyThreads) {
+  int failures[4] = { 0, 0, 0, 0 };
+  boost::thread_group threads;
+  for (int i = 0; i < 4; ++i)
+    threads.create_thread(boost::bind(RunOnEngine, &failures[i]));
+  threads.join_all();
+  for (int i = 0; i < 4; ++i)
+    ASSERT_EQ(0, failures[i]);
+}
+
+TEST(Runner, GivesTheSameResultsAtEveryLevel) {
+  kunjs::compiler::Optimizer::Level const levels[] = {
+    kunjs::compiler::Optimizer::O0, kunjs::compiler::Optimizer::O1, kunjs::compiler::Optimizer::O2
+  };
+  for (int i = 0; i < 3; ++i) {
+    kunjs::Runner runner(kunjs::Runner::JIT, levels[i]);
+    ASSERT_EQ("6.25", runner.run("10 % 3 + 7 * 3 / 4.0;"));
+    ASSERT_EQ("true", runner.run("4 >= 13 - 9;"));
+    ASSERT_EQ("hello", runner.run("'hello';"));
+  }
+}
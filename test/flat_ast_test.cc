@@ -0,0 +1,243 @@
+#include "kunjs/flat_ast.h"
+#include "kunjs/parser.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+namespace {
+
+using kunjs::flat::Index;
+using kunjs::flat::NONE;
+namespace node = kunjs::flat::node;
+
+// Outlives the trees, which keep a pointer to it.
+kunjs::AtomTable atoms;
+
+void Flatten(std::string const& code, kunjs::flat::Tree& tree) {
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed(atoms);
+  ASSERT_TRUE(parser.parse(code, parsed));
+  kunjs::flat::flatten(parsed.program(), atoms, tree);
+}
+
+std::string Name(kunjs::flat::Tree const& tree, Index node) {
+  return tree.atoms->name(kunjs::Atom(tree[node].value));
+}
+
+// The only expression of the statement at index i of the program.
+Index Expression(kunjs::flat::Tree const& tree, Index i) {
+  Index statement = tree.child(tree.root, i);
+  EXPECT_EQ(node::SEQUENCE, tree[statement].kind);
+  EXPECT_EQ(1u, tree[statement].count);
+  return tree.child(statement, 0);
+}
+
+}
+
+TEST(FlatAST, RootIsTheLastNode) {
+  kunjs::flat::Tree tree;
+  Flatten("var n = 10; n;", tree);
+
+  ASSERT_EQ(tree.nodes.size() - 1, tree.root);
+  ASSERT_EQ(node::PROGRAM, tree[tree.root].kind);
+  ASSERT_EQ(2u, tree[tree.root].count);
+  for (Index i = 0; i < tree.nodes.size(); ++i) {
+    for (Index c = 0; c < tree[i].count; ++c) {
+      Index child = tree.child(i, c);
+      ASSERT_TRUE(child == NONE || child < i);
+    }
+  }
+}
+
+TEST(FlatAST, BinaryPrecedence) {
+  kunjs::flat::Tree tree;
+  Flatten("a - b + c * a;", tree);
+
+  Index sum = Expression(tree, 0);
+  ASSERT_EQ(node::BINARY, tree[sum].kind);
+  ASSERT_EQ(kunjs::ast::op::ADD, kunjs::ast::Operator(tree[sum].value));
+
+  Index difference = tree.child(sum, 0);
+  ASSERT_EQ(kunjs::ast::op::SUB, kunjs::ast::Operator(tree[difference].value));
+  Index product = tree.child(sum, 1);
+  ASSERT_EQ(kunjs::ast::op::MUL, kunjs::ast::Operator(tree[product].value));
+
+  // names are atoms
+  ASSERT_EQ("a", Name(tree, tree.child(difference, 0)));
+  ASSERT_EQ(tree[tree.child(difference, 0)].value, tree[tree.child(product, 1)].value);
+}
+
+TEST(FlatAST, Literals) {
+  kunjs::flat::Tree tree;
+  Flatten("f(1, 2.5, 'text', true, null);", tree);
+
+  Index call = Expression(tree, 0);
+  ASSERT_EQ(node::CALL, tree[call].kind);
+  ASSERT_EQ(6u, tree[call].count);
+  ASSERT_EQ(node::NAME, tree[tree.child(call, 0)].kind);
+  ASSERT_EQ(node::NUMBER, tree[tree.child(call, 1)].kind);
+  ASSERT_EQ(1, boost::get<int>(tree.numbers[tree[tree.child(call, 1)].value]));
+  ASSERT_EQ(2.5, boost::get<double>(tree.numbers[tree[tree.child(call, 2)].value]));
+  ASSERT_EQ("text", tree.strings[tree[tree.child(call, 3)].value]);
+  ASSERT_EQ(node::BOOLEAN, tree[tree.child(call, 4)].kind);
+  ASSERT_EQ(1u, tree[tree.child(call, 4)].value);
+  ASSERT_EQ(node::NULL_LITERAL, tree[tree.child(call, 5)].kind);
+}
+
+TEST(FlatAST, ArraysAreNotSequences) {
+  kunjs::flat::Tree tree;
+  Flatten("[1, 2]; (1, 2);", tree);
+
+  Index array = Expression(tree, 0);
+  ASSERT_EQ(node::ARRAY, tree[array].kind);
+  ASSERT_EQ(2u, tree[array].count);
+  Index sequence = Expression(tree, 1);
+  ASSERT_EQ(node::SEQUENCE, tree[sequence].kind);
+  ASSERT_EQ(2u, tree[sequence].count);
+}
+
+TEST(FlatAST, ModifiersWrapTheirObject) {
+  kunjs::flat::Tree tree;
+  Flatten("a.b(c)[d](e);", tree);
+
+  Index call = Expression(tree, 0);
+  ASSERT_EQ(node::CALL, tree[call].kind);
+  Index index = tree.child(call, 0);
+  ASSERT_EQ(node::INDEX, tree[index].kind);
+  Index method = tree.child(index, 0);
+  ASSERT_EQ(node::CALL, tree[method].kind);
+  Index member = tree.child(method, 0);
+  ASSERT_EQ(node::MEMBER, tree[member].kind);
+  ASSERT_EQ("b", Name(tree, member));
+}
+
+TEST(FlatAST, MissingClausesAreNone) {
+  kunjs::flat::Tree tree;
+  Flatten("for (;;) { break; }", tree);
+
+  Index loop = tree.child(tree.root, 0);
+  ASSERT_EQ(node::FOR, tree[loop].kind);
+  ASSERT_EQ(4u, tree[loop].count);
+  ASSERT_EQ(NONE, tree.child(loop, 0));
+  ASSERT_EQ(NONE, tree.child(loop, 1));
+  ASSERT_EQ(NONE, tree.child(loop, 2));
+  ASSERT_EQ(node::BLOCK, tree[tree.child(loop, 3)].kind);
+
+  Index jump = tree.child(tree.child(loop, 3), 0);
+  ASSERT_EQ(node::BREAK, tree[jump].kind);
+  ASSERT_EQ(NONE, tree[jump].value);
+}
+
+TEST(FlatAST, TryWithFinally) {
+  kunjs::flat::Tree tree;
+  Flatten("try { open(); } finally { close(); }", tree);
+
+  Index statement = tree.child(tree.root, 0);
+  ASSERT_EQ(node::TRY, tree[statement].kind);
+  ASSERT_EQ(NONE, tree.child(statement, 1));
+  ASSERT_NE(NONE, tree.child(statement, 2));
+  ASSERT_EQ(node::BLOCK, tree[tree.child(statement, 2)].kind);
+}
+
+TEST(FlatAST, SwitchKeepsClauseOrder) {
+  kunjs::flat::Tree tree;
+  Flatten("switch (day) { case 1: a(); default: b(); case 2: c(); }", tree);
+
+  Index statement = tree.child(tree.root, 0);
+  ASSERT_EQ(4u, tree[statement].count);
+  ASSERT_EQ(node::CASE, tree[tree.child(statement, 1)].kind);
+  ASSERT_EQ(node::DEFAULT, tree[tree.child(statement, 2)].kind);
+  ASSERT_EQ(node::CASE, tree[tree.child(statement, 3)].kind);
+}
+
+TEST(FlatAST, Print) {
+  kunjs::flat::Tree tree;
+  Flatten("function twice(x) { return x * 2; }", tree);
+
+  std::ostringstream out;
+  out << tree;
+  ASSERT_EQ(
+      "PROGRAM\n"
+      "  FUNCTION_DECLARATION twice\n"
+      "    PARAMETERS\n"
+      "      NAME x\n"
+      "    BLOCK\n"
+      "      RETURN\n"
+      "        SEQUENCE\n"
+      "          BINARY *\n"
+      "            NAME x\n"
+      "            NUMBER 2\n",
+      out.str());
+}
+
+TEST(FlatAST, WriteAndRead) {
+  kunjs::flat::Tree tree;
+  Flatten("function f(a, b) { return a + b * 2.5; }\n"
+          "outer: for (;;) { f('text', null); break outer; }", tree);
+  std::string data;
+  kunjs::flat::write(tree, data);
+
+  // into another table, where the names get other atoms
+  kunjs::AtomTable other;
+  other.intern("unrelated");
+  kunjs::flat::Tree copy;
+  ASSERT_TRUE(kunjs::flat::read(data, other, copy));
+  ASSERT_EQ(&other, copy.atoms);
+  ASSERT_EQ(tree.nodes.size(), copy.nodes.size());
+  ASSERT_EQ(tree.root, copy.root);
+
+  std::ostringstream original, read;
+  original << tree;
+  read << copy;
+  ASSERT_EQ(original.str(), read.str());
+}
+
+TEST(FlatAST, ReadRejectsBrokenData) {
+  kunjs::flat::Tree tree;
+  Flatten("var n = 10; n;", tree);
+  std::string data;
+  kunjs::flat::write(tree, data);
+
+  kunjs::AtomTable other;
+  kunjs::flat::Tree copy;
+  ASSERT_FALSE(kunjs::flat::read(kunjs::Source(data.data(), data.size() - 1), other, copy));
+  ASSERT_EQ(NONE, copy.root);
+  ASSERT_TRUE(copy.nodes.empty());
+
+  std::string newer = data;
+  newer[4] = char(kunjs::flat::FORMAT_VERSION + 1);
+  ASSERT_FALSE(kunjs::flat::read(newer, other, copy));
+  ASSERT_FALSE(kunjs::flat::read("", other, copy));
+}
+
+TEST(FlatAST, ReadRejectsTreesOfTheWrongShape) {
+  kunjs::flat::Tree tree;
+  Flatten("alpha + beta;", tree);
+  Index binary = Expression(tree, 0);
+  ASSERT_EQ(node::BINARY, tree[binary].kind);
+
+  kunjs::AtomTable other;
+  kunjs::flat::Tree copy;
+  std::string data;
+  kunjs::flat::write(tree, data);
+  ASSERT_TRUE(kunjs::flat::read(data, other, copy));
+
+  // a binary expression with one operand, then with a missing one
+  kunjs::flat::Tree broken;
+  Flatten("alpha + beta;", broken);
+  broken.nodes[binary].count = 1;
+  data.clear();
+  kunjs::flat::write(broken, data);
+  kunjs::AtomTable untouched;
+  ASSERT_FALSE(kunjs::flat::read(data, untouched, copy));
+
+  broken.nodes[binary].count = 2;
+  broken.children[broken[binary].first + 1] = NONE;
+  data.clear();
+  kunjs::flat::write(broken, data);
+  ASSERT_FALSE(kunjs::flat::read(data, untouched, copy));
+
+  // nothing is interned from data that is rejected
+  ASSERT_EQ(0u, untouched.size());
+}
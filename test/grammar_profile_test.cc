@@ -0,0 +1,98 @@
+#include "kunjs/grammar_profile.h"
+#include "kunjs/parser.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef kunjs::GrammarProfile::Rule Rule;
+
+Rule const* Find(std::vector<Rule> const& rules, std::string const& name) {
+  for (std::size_t i = 0; i < rules.size(); ++i) {
+    if (rules[i].name == name)
+      return &rules[i];
+  }
+  return 0;
+}
+
+}
+
+TEST(GrammarProfile, CountsNestedCalls) {
+  kunjs::GrammarProfile profile;
+  profile.enter(0, "statement", 0);
+  profile.enter(1, "expression", 4);
+  profile.leave(true, 9);
+  profile.enter(1, "expression", 4);
+  profile.leave(false, 0);
+  profile.leave(false, 0);
+
+  std::vector<Rule> rules = profile.rules();
+  ASSERT_EQ(2u, rules.size());
+  Rule const* statement = Find(rules, "statement");
+  ASSERT_TRUE(statement != 0);
+  ASSERT_EQ(1u, statement->calls);
+  ASSERT_EQ(1u, statement->failures());
+  ASSERT_EQ(0u, statement->bytes);
+
+  Rule const* expression = Find(rules, "expression");
+  ASSERT_TRUE(expression != 0);
+  ASSERT_EQ(2u, expression->calls);
+  ASSERT_EQ(1u, expression->matches);
+  ASSERT_EQ(5u, expression->bytes);
+
+  // the outer call took at least as long as the two nested ones
+  ASSERT_GE(statement->total_ns, expression->total_ns);
+  ASSERT_EQ(statement->total_ns, statement->self_ns + expression->total_ns);
+  for (std::size_t i = 1; i < rules.size(); ++i)
+    ASSERT_GE(rules[i - 1].self_ns, rules[i].self_ns);
+
+  profile.clear();
+  ASSERT_TRUE(profile.rules().empty());
+}
+
+TEST(GrammarProfile, ScopeSetsTheCurrentProfile) {
+  ASSERT_TRUE(kunjs::GrammarProfile::current() == 0);
+  kunjs::GrammarProfile outer, inner;
+  {
+    kunjs::GrammarProfile::Scope scope(outer);
+    ASSERT_EQ(&outer, kunjs::GrammarProfile::current());
+    {
+      kunjs::GrammarProfile::Scope nested(inner);
+      ASSERT_EQ(&inner, kunjs::GrammarProfile::current());
+    }
+    ASSERT_EQ(&outer, kunjs::GrammarProfile::current());
+  }
+  ASSERT_TRUE(kunjs::GrammarProfile::current() == 0);
+}
+
+TEST(GrammarProfile, RecordsTheRulesOfAParse) {
+  kunjs::Parser parser;
+  kunjs::GrammarProfile profile;
+  {
+    kunjs::GrammarProfile::Scope scope(profile);
+    ASSERT_TRUE(parser.parse("var n = 1;\nif (n) f(n);"));
+  }
+
+  std::vector<Rule> rules = profile.rules();
+  if (!kunjs::GrammarProfile::enabled()) {
+    ASSERT_TRUE(rules.empty());
+    return;
+  }
+
+  Rule const* variable = Find(rules, "variable_statement");
+  ASSERT_TRUE(variable != 0);
+  ASSERT_EQ(1u, variable->calls);
+  ASSERT_EQ(1u, variable->matches);
+  ASSERT_EQ(10u, variable->bytes);
+
+  Rule const* statement = Find(rules, "statement");
+  ASSERT_TRUE(statement != 0);
+  ASSERT_EQ(3u, statement->matches);
+
+  std::ostringstream report;
+  report << profile;
+  ASSERT_NE(std::string::npos, report.str().find("variable_statement"));
+}
@@ -0,0 +1,190 @@
+#include "kunjs/lexer.h"
+
+#include <gtest/gtest.h>
+#include <limits>
+#include <string>
+
+namespace {
+
+std::size_t Tokenize(std::string const& code, kunjs::TokenStream& stream) {
+  kunjs::Lexer lexer;
+  return lexer.tokenize(code.data(), code.data() + code.size(), stream);
+}
+
+}
+
+TEST(Lexer, Empty) {
+  kunjs::TokenStream stream;
+  ASSERT_EQ(0u, Tokenize("", stream));
+  ASSERT_TRUE(stream.tokens.empty());
+}
+
+TEST(Lexer, KeywordsAndIdentifiers) {
+  kunjs::TokenStream stream;
+  std::string code = "for forEach in instanceof null nullable yield _private $";
+  ASSERT_EQ(code.size(), Tokenize(code, stream));
+  ASSERT_EQ(9u, stream.tokens.size());
+  ASSERT_EQ(kunjs::token::FOR, stream.tokens[0].kind);
+  ASSERT_EQ(kunjs::token::IDENTIFIER, stream.tokens[1].kind);
+  ASSERT_EQ(kunjs::token::IN, stream.tokens[2].kind);
+  ASSERT_EQ(kunjs::token::INSTANCEOF, stream.tokens[3].kind);
+  ASSERT_EQ(kunjs::token::NULL_LITERAL, stream.tokens[4].kind);
+  ASSERT_EQ(kunjs::token::IDENTIFIER, stream.tokens[5].kind);
+  ASSERT_EQ(kunjs::token::YIELD, stream.tokens[6].kind);
+  ASSERT_EQ(kunjs::token::IDENTIFIER, stream.tokens[7].kind);
+  ASSERT_EQ("_private", stream.name(stream.tokens[7]));
+}
+
+TEST(Lexer, AllReservedWords) {
+  for (int kind = kunjs::token::BREAK; kind <= kunjs::token::FALSE_LITERAL; ++kind) {
+    kunjs::TokenStream stream;
+    std::string word = kunjs::token::spelling(kunjs::token::Kind(kind));
+    Tokenize(word, stream);
+    ASSERT_EQ(1u, stream.tokens.size());
+    ASSERT_EQ(kind, stream.tokens[0].kind) << word;
+  }
+}
+
+TEST(Lexer, InternedIdentifiers) {
+  kunjs::TokenStream stream;
+  Tokenize("a = b + a * b;", stream);
+  ASSERT_EQ(8u, stream.tokens.size());
+  ASSERT_EQ("a", stream.name(stream.tokens[0]));
+  ASSERT_EQ("b", stream.name(stream.tokens[2]));
+  ASSERT_EQ(stream.tokens[0].value, stream.tokens[4].value);
+  ASSERT_EQ(stream.tokens[2].value, stream.tokens[6].value);
+  ASSERT_NE(stream.tokens[0].value, stream.tokens[2].value);
+}
+
+TEST(Lexer, StreamsShareTheirAtomTable) {
+  kunjs::AtomTable atoms;
+  kunjs::TokenStream first(atoms);
+  kunjs::TokenStream second(atoms);
+  Tokenize("total = item.default;", first);
+  Tokenize("default: total;", second);
+
+  std::size_t size = atoms.size();
+  ASSERT_EQ(first.atom(first.tokens[0]), second.atom(second.tokens[2]));
+  ASSERT_EQ(first.atom(first.tokens[4]), second.atom(second.tokens[0]));
+  ASSERT_EQ(first.reserved(kunjs::token::DEFAULT), first.atom(first.tokens[4]));
+  ASSERT_EQ("default", atoms.name(second.atom(second.tokens[0])));
+
+  kunjs::TokenStream third(atoms);
+  ASSERT_EQ(size, atoms.size());
+}
+
+TEST(Lexer, LongestMatchPunctuators) {
+  kunjs::TokenStream stream;
+  Tokenize("a>>>=b>>>c>>d>=e===f!==g++", stream);
+  ASSERT_EQ(kunjs::token::ASSIGN_SHR, stream.tokens[1].kind);
+  ASSERT_EQ(kunjs::token::SHR, stream.tokens[3].kind);
+  ASSERT_EQ(kunjs::token::SAR, stream.tokens[5].kind);
+  ASSERT_EQ(kunjs::token::GTE, stream.tokens[7].kind);
+  ASSERT_EQ(kunjs::token::EQ_STRICT, stream.tokens[9].kind);
+  ASSERT_EQ(kunjs::token::NE_STRICT, stream.tokens[11].kind);
+  ASSERT_EQ(kunjs::token::INC, stream.tokens[13].kind);
+}
+
+TEST(Lexer, Numbers) {
+  kunjs::TokenStream stream;
+  Tokenize("42 3.14 1e3 0x1F .5", stream);
+  ASSERT_EQ(5u, stream.numbers.size());
+  ASSERT_EQ(42, boost::get<int>(stream.numbers[0]));
+  ASSERT_EQ(3.14, boost::get<double>(stream.numbers[1]));
+  ASSERT_EQ(1000.0, boost::get<double>(stream.numbers[2]));
+  ASSERT_EQ(31, boost::get<int>(stream.numbers[3]));
+  ASSERT_EQ(0.5, boost::get<double>(stream.numbers[4]));
+}
+
+TEST(Lexer, NumbersAreExact) {
+  kunjs::TokenStream stream;
+  std::string code =
+      "2147483647 2147483648 0x7fffffff 0x80000000 0x1fffffffffffff "
+      "0.1 1.5e-3 123.456e2 12345678901234567890 0.30000000000000004 1e400 "
+      "1.000000000000000000000000000000";
+  ASSERT_EQ(code.size(), Tokenize(code, stream));
+  ASSERT_EQ(12u, stream.numbers.size());
+  ASSERT_EQ(2147483647, boost::get<int>(stream.numbers[0]));
+  ASSERT_EQ(2147483648.0, boost::get<double>(stream.numbers[1]));
+  ASSERT_EQ(2147483647, boost::get<int>(stream.numbers[2]));
+  ASSERT_EQ(2147483648.0, boost::get<double>(stream.numbers[3]));
+  ASSERT_EQ(9007199254740991.0, boost::get<double>(stream.numbers[4]));
+
+  // the same doubles as strtod's
+  ASSERT_EQ(0.1, boost::get<double>(stream.numbers[5]));
+  ASSERT_EQ(1.5e-3, boost::get<double>(stream.numbers[6]));
+  ASSERT_EQ(12345.6, boost::get<double>(stream.numbers[7]));
+  ASSERT_EQ(12345678901234567890.0, boost::get<double>(stream.numbers[8]));
+  ASSERT_EQ(0.30000000000000004, boost::get<double>(stream.numbers[9]));
+  ASSERT_EQ(std::numeric_limits<double>::infinity(), boost::get<double>(stream.numbers[10]));
+  ASSERT_EQ(1.0, boost::get<double>(stream.numbers[11]));
+}
+
+TEST(Lexer, Strings) {
+  kunjs::TokenStream stream;
+  std::string code = "'it\\'s' \"say \\\"hi\\\"\"";
+  Tokenize(code, stream);
+  ASSERT_EQ(2u, stream.tokens.size());
+  ASSERT_EQ(kunjs::token::STRING, stream.tokens[0].kind);
+  ASSERT_EQ("it\\'s", stream.text(stream.tokens[0]));
+  ASSERT_EQ("say \\\"hi\\\"", stream.text(stream.tokens[1]));
+}
+
+TEST(Lexer, StringValues) {
+  kunjs::TokenStream stream;
+  std::string code =
+      "'plain' 'it\\'s' '\\n\\t\\\\' '\\x41\\u00e9\\u20ac' '\\101\\0' 'line\\\ncontinued' '\\q\\x4'";
+  ASSERT_EQ(code.size(), Tokenize(code, stream));
+  ASSERT_EQ(7u, stream.tokens.size());
+  ASSERT_EQ(0u, stream.tokens[0].value);
+  ASSERT_EQ(1u, stream.tokens[1].value);
+
+  std::string values[] = {
+    "plain", "it's", "\n\t\\", "A\xc3\xa9\xe2\x82\xac", std::string("A\0", 2),
+    "linecontinued", "qx4"
+  };
+  for (std::size_t i = 0; i < 7; ++i) {
+    kunjs::ast::String value;
+    stream.string(stream.tokens[i], value);
+    ASSERT_EQ(values[i], std::string(value.data(), value.size())) << i;
+  }
+}
+
+TEST(Lexer, Comments) {
+  kunjs::TokenStream stream;
+  std::string code = "/* license\n * text */ a; // trailing\n// whole line\nb;";
+  ASSERT_EQ(code.size(), Tokenize(code, stream));
+  ASSERT_EQ(4u, stream.tokens.size());
+  ASSERT_EQ(22u, stream.tokens[0].offset);
+}
+
+// Whitespace and comments are skipped in blocks of up to 32 bytes: every
+// length from 1 to 100 puts the end of a run at another place in a block.
+TEST(Lexer, LongSpaceAndComments) {
+  for (std::size_t length = 1; length <= 100; ++length) {
+    std::string filler(length, '*');
+    std::string blanks;
+    for (std::size_t i = 0; i < length; ++i)
+      blanks += " \t\r\n\v\f"[i % 6];
+
+    std::string code = "a" + blanks + "b /*" + filler + "*/ c //" + std::string(length / 2, '\t') + filler + "\nd";
+    kunjs::TokenStream stream;
+    ASSERT_EQ(code.size(), Tokenize(code, stream)) << length;
+    ASSERT_EQ(4u, stream.tokens.size()) << length;
+    ASSERT_EQ(1 + length, stream.tokens[1].offset);
+    ASSERT_EQ("c", stream.name(stream.tokens[2]));
+    ASSERT_EQ(code.size() - 1, stream.tokens[3].offset);
+
+    // "* /" does not close a comment, and one that is never closed stops
+    // the lexer right after the last token
+    std::string unterminated = "a /*" + filler + "* /" + filler + "*";
+    ASSERT_EQ(1u, Tokenize(unterminated, stream)) << length;
+  }
+}
+
+TEST(Lexer, StopsAtInvalidInput) {
+  kunjs::TokenStream stream;
+  ASSERT_EQ(4u, Tokenize("a = 'unterminated", stream));
+  ASSERT_EQ(2u, stream.tokens.size());
+  ASSERT_EQ(2u, Tokenize("a #", stream));
+}
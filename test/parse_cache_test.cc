@@ -0,0 +1,88 @@
+#include "kunjs/parse_cache.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+TEST(ParseCache, MissThenHit) {
+  kunjs::Parser parser;
+  kunjs::ParseCache cache(".");
+  std::string code = "function twice(x) { return x * 2; } twice(21);";
+  std::remove(cache.path(code).c_str());
+
+  kunjs::AtomTable atoms;
+  kunjs::flat::Tree parsed;
+  bool hit = true;
+  ASSERT_TRUE(cache.parse(parser, code, atoms, parsed, &hit));
+  ASSERT_FALSE(hit);
+
+  kunjs::AtomTable restarted;
+  kunjs::flat::Tree loaded;
+  ASSERT_TRUE(cache.parse(parser, code, restarted, loaded, &hit));
+  ASSERT_TRUE(hit);
+
+  std::ostringstream expected, actual;
+  expected << parsed;
+  actual << loaded;
+  ASSERT_EQ(expected.str(), actual.str());
+  std::remove(cache.path(code).c_str());
+}
+
+TEST(ParseCache, KeyedBySource) {
+  kunjs::ParseCache cache("cache");
+  ASSERT_NE(cache.path("a;"), cache.path("b;"));
+  ASSERT_EQ(cache.path("a;"), cache.path(std::string("a;")));
+  ASSERT_EQ(0u, cache.path("a;").find("cache/"));
+}
+
+// As if two sources had the same hash and size: the entry of one is not the
+// other's.
+TEST(ParseCache, EntryOfAnotherSourceIsAMiss) {
+  kunjs::Parser parser;
+  kunjs::ParseCache cache(".");
+  std::string code = "var a = 1;", other = "var b = 2;";
+  kunjs::AtomTable atoms;
+  kunjs::flat::Tree tree;
+  ASSERT_TRUE(cache.parse(parser, code, atoms, tree));
+  std::remove(cache.path(other).c_str());
+  ASSERT_EQ(0, std::rename(cache.path(code).c_str(), cache.path(other).c_str()));
+
+  ASSERT_FALSE(cache.load(other, atoms, tree));
+  bool hit = true;
+  ASSERT_TRUE(cache.parse(parser, other, atoms, tree, &hit));
+  ASSERT_FALSE(hit);
+  ASSERT_TRUE(cache.load(other, atoms, tree));
+  std::remove(cache.path(other).c_str());
+}
+
+TEST(ParseCache, BrokenEntryIsAMiss) {
+  kunjs::Parser parser;
+  kunjs::ParseCache cache(".");
+  std::string code = "var n = 1;";
+  {
+    std::ofstream file(cache.path(code).c_str(), std::ios::out | std::ios::binary);
+    file << "not a tree";
+  }
+
+  kunjs::AtomTable atoms;
+  kunjs::flat::Tree tree;
+  ASSERT_FALSE(cache.load(code, atoms, tree));
+  bool hit = true;
+  ASSERT_TRUE(cache.parse(parser, code, atoms, tree, &hit));
+  ASSERT_FALSE(hit);
+  ASSERT_TRUE(cache.load(code, atoms, tree));
+  std::remove(cache.path(code).c_str());
+}
+
+TEST(ParseCache, SyntaxErrorsAreNotStored) {
+  kunjs::Parser parser;
+  kunjs::ParseCache cache(".");
+  std::string code = "var = ;";
+
+  kunjs::AtomTable atoms;
+  kunjs::flat::Tree tree;
+  ASSERT_FALSE(cache.parse(parser, code, atoms, tree));
+  ASSERT_FALSE(cache.load(code, atoms, tree));
+}
@@ -0,0 +1,76 @@
+#include "kunjs/parse_job.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST(ParseJob, KeepsTheInputOrder) {
+  std::vector<std::string> codes;
+  for (int i = 0; i < 50; ++i) {
+    std::ostringstream code;
+    for (int j = 0; j <= i; ++j)
+      code << "var v" << j << " = " << j << ";\n";
+    codes.push_back(code.str());
+  }
+
+  kunjs::Parser parser;
+  kunjs::ParseJob job(parser, 4);
+  for (std::size_t i = 0; i < codes.size(); ++i)
+    job.add(codes[i]);
+  ASSERT_TRUE(job.run());
+
+  ASSERT_EQ(codes.size(), job.size());
+  for (std::size_t i = 0; i < job.size(); ++i) {
+    ASSERT_TRUE(job[i].readable);
+    ASSERT_TRUE(job[i].result);
+    ASSERT_EQ(i + 1, job[i].program.program().size());
+    ASSERT_GE(job[i].elapsed_us, 0);
+  }
+}
+
+TEST(ParseJob, ReportsEachFailure) {
+  kunjs::Parser parser;
+  kunjs::ParseJob job(parser, 2);
+  job.add("a;");
+  job.add("a +;");
+  job.add("b;");
+  ASSERT_FALSE(job.run());
+
+  ASSERT_TRUE(job[0].result);
+  ASSERT_FALSE(job[1].result);
+  ASSERT_EQ(4u, job[1].result.column);
+  ASSERT_TRUE(job[2].result);
+}
+
+TEST(ParseJob, Files) {
+  std::string path = "kunjs_parse_job.js";
+  {
+    std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+    file << "function f() { return 1; }\nf();\n";
+  }
+
+  kunjs::Parser parser;
+  kunjs::ParseJob job(parser);
+  ASSERT_GE(job.threads(), 1u);
+  job.add_file(path);
+  job.add_file("kunjs_no_such_file.js");
+  ASSERT_FALSE(job.run(kunjs::Parser::PREPARSE));
+
+  ASSERT_EQ(path, job[0].path);
+  ASSERT_TRUE(job[0].result);
+  ASSERT_EQ(2u, job[0].program.program().size());
+
+  // lazy bodies are parsed from the mapping, which the job keeps
+  kunjs::ast::FunctionDeclaration& function =
+      boost::get<kunjs::ast::FunctionDeclaration>(job[0].program.program().at(0));
+  ASSERT_TRUE(function.body.lazy);
+  ASSERT_TRUE(parser.parse_body(job.code(0), job[0].program, function.body));
+  ASSERT_EQ(1u, function.body.size());
+
+  ASSERT_FALSE(job[1].readable);
+  ASSERT_FALSE(job[1].result);
+  std::remove(path.c_str());
+}
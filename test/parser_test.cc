@@ -1,5 +1,6 @@
 #include "kunjs/parser.h"
 
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <gtest/gtest.h>
 #include <string>
 
@@ -123,6 +124,75 @@ TEST(Parser, ComplexLogicalExpression) {
   ASSERT_TRUE(result);
 }
 
+TEST(Parser, LiteralIsASingleNode) {
+  kunjs::Parser parser;
+  kunjs::AtomTable atoms;
+  kunjs::ast::Program program;
+  bool result = parser.parse("1;", program, atoms);
+  ASSERT_TRUE(result);
+  kunjs::ast::Statement const& statement = boost::get<kunjs::ast::Statement>(program.at(0));
+  kunjs::ast::Expression const& expression = boost::get<kunjs::ast::Expression>(statement);
+  ASSERT_EQ(1u, expression.size());
+  ASSERT_TRUE(boost::get<kunjs::ast::Literal>(&expression.at(0)) != 0);
+}
+
+TEST(Parser, BinaryPrecedence) {
+  kunjs::Parser parser;
+  kunjs::AtomTable atoms;
+  kunjs::ast::Program program;
+  bool result = parser.parse("a - b + c * d;", program, atoms);
+  ASSERT_TRUE(result);
+  kunjs::ast::Statement const& statement = boost::get<kunjs::ast::Statement>(program.at(0));
+  kunjs::ast::Expression const& expression = boost::get<kunjs::ast::Expression>(statement);
+
+  kunjs::ast::BinaryExpression const& sum = boost::get<kunjs::ast::BinaryExpression>(expression.at(0));
+  ASSERT_EQ(kunjs::ast::op::ADD, sum.operator_);
+  kunjs::ast::BinaryExpression const& difference = boost::get<kunjs::ast::BinaryExpression>(sum.lhs);
+  ASSERT_EQ(kunjs::ast::op::SUB, difference.operator_);
+  ASSERT_EQ("a", atoms.name(boost::get<kunjs::Atom>(difference.lhs)));
+  ASSERT_EQ("b", atoms.name(boost::get<kunjs::Atom>(difference.rhs)));
+  kunjs::ast::BinaryExpression const& product = boost::get<kunjs::ast::BinaryExpression>(sum.rhs);
+  ASSERT_EQ(kunjs::ast::op::MUL, product.operator_);
+  ASSERT_EQ("c", atoms.name(boost::get<kunjs::Atom>(product.lhs)));
+  ASSERT_EQ("d", atoms.name(boost::get<kunjs::Atom>(product.rhs)));
+}
+
+TEST(Parser, AssignmentIsRightAssociative) {
+  kunjs::Parser parser;
+  kunjs::AtomTable atoms;
+  kunjs::ast::Program program;
+  bool result = parser.parse("a = b += -c ? d : e;", program, atoms);
+  ASSERT_TRUE(result);
+  kunjs::ast::Statement const& statement = boost::get<kunjs::ast::Statement>(program.at(0));
+  kunjs::ast::Expression const& expression = boost::get<kunjs::ast::Expression>(statement);
+
+  kunjs::ast::Assignment const& outer = boost::get<kunjs::ast::Assignment>(expression.at(0));
+  ASSERT_EQ(kunjs::ast::op::ASSIGN, outer.operator_);
+  kunjs::ast::Assignment const& inner = boost::get<kunjs::ast::Assignment>(outer.value);
+  ASSERT_EQ(kunjs::ast::op::ASSIGN_ADD, inner.operator_);
+  kunjs::ast::ConditionalExpression const& conditional =
+      boost::get<kunjs::ast::ConditionalExpression>(inner.value);
+  ASSERT_EQ(kunjs::ast::op::SUB, boost::get<kunjs::ast::UnaryExpression>(conditional.condition).operator_);
+}
+
+TEST(Parser, OperatorsKeepTheirSpelling) {
+  char const* operators[] = {
+    "||", "&&", "|", "^", "&", "==", "!=", "===", "!==", "<", ">", "<=", ">=",
+    "instanceof", "in", "<<", ">>", ">>>", "+", "-", "*", "/", "%"
+  };
+  kunjs::Parser parser;
+  kunjs::AtomTable atoms;
+  for (std::size_t i = 0; i < sizeof(operators) / sizeof(operators[0]); ++i) {
+    kunjs::ast::Program program;
+    std::string code = std::string("a ") + operators[i] + " b;";
+    ASSERT_TRUE(parser.parse(code, program, atoms)) << code;
+    kunjs::ast::Statement const& statement = boost::get<kunjs::ast::Statement>(program.at(0));
+    kunjs::ast::Expression const& expression = boost::get<kunjs::ast::Expression>(statement);
+    kunjs::ast::BinaryExpression const& binary = boost::get<kunjs::ast::BinaryExpression>(expression.at(0));
+    ASSERT_STREQ(operators[i], kunjs::ast::op::spelling(binary.operator_));
+  }
+}
+
 TEST(Parser, DoWhile) {
   kunjs::Parser parser;
   std::string code =
@@ -163,6 +233,50 @@ TEST(Parser, SimpleForLoop) {
   ASSERT_TRUE(result);
 }
 
+TEST(Parser, ForInLoop) {
+  kunjs::Parser parser;
+  kunjs::AtomTable atoms;
+  kunjs::ast::Program program;
+  bool result = parser.parse("for (key in object) { count++; }", program, atoms);
+  ASSERT_TRUE(result);
+  kunjs::ast::Statement const& loop = boost::get<kunjs::ast::Statement>(program.at(0));
+  ASSERT_TRUE(boost::get<kunjs::ast::Foreach>(&loop) != 0);
+}
+
+TEST(Parser, ForInLoopWithVar) {
+  kunjs::Parser parser;
+  kunjs::AtomTable atoms;
+  kunjs::ast::Program program;
+  bool result = parser.parse("for (var key in object) { count++; }", program, atoms);
+  ASSERT_TRUE(result);
+  kunjs::ast::Statement const& loop = boost::get<kunjs::ast::Statement>(program.at(0));
+  ASSERT_TRUE(boost::get<kunjs::ast::ForeachWithVar>(&loop) != 0);
+}
+
+TEST(Parser, ForLoopHeaderWithBrackets) {
+  kunjs::Parser parser;
+  kunjs::AtomTable atoms;
+  kunjs::ast::Program program;
+  bool result = parser.parse("for (i = list[(0)]; i < list[1]; i++) {}", program, atoms);
+  ASSERT_TRUE(result);
+  kunjs::ast::Statement const& loop = boost::get<kunjs::ast::Statement>(program.at(0));
+  ASSERT_TRUE(boost::get<kunjs::ast::For>(&loop) != 0);
+}
+
+TEST(Parser, NestedLoops) {
+  kunjs::Parser parser;
+  std::string code =
+      "for (var i = 0; i < 10; i++) {"
+      "  for (key in object) {"
+      "    for (var name in key) {"
+      "      for (;;) { if (name) { break; } else { continue; } }"
+      "    }"
+      "  }"
+      "}";
+  bool result = parser.parse(code);
+  ASSERT_TRUE(result);
+}
+
 TEST(Parser, FunctionCall) {
   kunjs::Parser parser;
   std::string code = "veryUseful(10, \"arg2\");";
@@ -170,6 +284,40 @@ TEST(Parser, FunctionCall) {
   ASSERT_TRUE(result);
 }
 
+TEST(Parser, MethodCallInExpression) {
+  kunjs::Parser parser;
+  bool result = parser.parse("total = list[i].length() + new Date() * 2 - i++;");
+  ASSERT_TRUE(result);
+}
+
+TEST(Parser, ParsedProgramLivesInItsArena) {
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  std::string code =
+      "function accumulate(list, initialValueOfTheTotal) {"
+      "  for (var i = 0; i < list.length; i++) { initialValueOfTheTotal += list[i]; }"
+      "  return initialValueOfTheTotal;"
+      "}";
+
+  ASSERT_TRUE(parser.parse(code, parsed));
+  ASSERT_EQ(1u, parsed.program().size());
+  kunjs::ast::FunctionDeclaration const& function =
+      boost::get<kunjs::ast::FunctionDeclaration>(parsed.program().at(0));
+  ASSERT_EQ("initialValueOfTheTotal", parsed.atoms().name(function.parameters.at(1)));
+
+  std::size_t used = parsed.arena().used();
+  std::size_t reserved = parsed.arena().reserved();
+  ASSERT_GT(used, 0u);
+
+  // the second parse reuses the blocks of the first one
+  ASSERT_TRUE(parser.parse(code, parsed));
+  ASSERT_EQ(used, parsed.arena().used());
+  ASSERT_EQ(reserved, parsed.arena().reserved());
+
+  parsed.clear();
+  ASSERT_TRUE(parsed.program().empty());
+}
+
 TEST(Parser, FunctionDefinition) {
   kunjs::Parser parser;
   std::string code =
@@ -243,6 +391,65 @@ TEST(Parser, LabelledFor) {
   ASSERT_TRUE(result);
 }
 
+TEST(Parser, LineBreakEndsReturn) {
+  kunjs::Parser parser;
+  kunjs::AtomTable atoms;
+  kunjs::ast::Program program;
+  bool result = parser.parse("function f() {\n  return\n  x + 1;\n}", program, atoms);
+  ASSERT_TRUE(result);
+  kunjs::ast::FunctionDeclaration const& function =
+      boost::get<kunjs::ast::FunctionDeclaration>(program.at(0));
+  ASSERT_EQ(2u, function.body.size());
+  kunjs::ast::Statement const& statement = boost::get<kunjs::ast::Statement>(function.body.at(0));
+  ASSERT_FALSE(boost::get<kunjs::ast::Return>(statement).expression);
+
+
+  // a comment spanning lines counts as a line break
+  kunjs::ast::Program commented;
+  ASSERT_TRUE(parser.parse("function f() { return /* a\n comment */ x; }", commented, atoms));
+  kunjs::ast::FunctionDeclaration const& other =
+      boost::get<kunjs::ast::FunctionDeclaration>(commented.at(0));
+  ASSERT_EQ(2u, other.body.size());
+}
+
+TEST(Parser, LineBreakEndsBreakAndContinue) {
+  kunjs::Parser parser;
+  kunjs::AtomTable atoms;
+  kunjs::ast::Program program;
+  bool result = parser.parse("while (x) { break\nlabel; }", program, atoms);
+  ASSERT_TRUE(result);
+  kunjs::ast::While const& loop =
+      boost::get<kunjs::ast::While>(boost::get<kunjs::ast::Statement>(program.at(0)));
+  kunjs::ast::Block const& block = boost::get<kunjs::ast::Block>(loop.statement);
+  ASSERT_EQ(2u, block.size());
+  ASSERT_FALSE(boost::get<kunjs::ast::Break>(block.at(0)).label);
+
+  ASSERT_TRUE(parser.parse("while (x) { continue\n}"));
+  ASSERT_TRUE(parser.parse("label: while (x) { continue label; }"));
+}
+
+TEST(Parser, BraceAndEndOfProgramEndBreakContinueAndReturn) {
+  kunjs::Parser parser;
+  ASSERT_TRUE(parser.parse("while (1) { break }"));
+  ASSERT_TRUE(parser.parse("outer: while (1) { continue outer }"));
+  ASSERT_TRUE(parser.parse("function f() { return x + 1 }"));
+  ASSERT_TRUE(parser.parse("while (1) break"));
+  ASSERT_FALSE(parser.parse("while (1) { break x y }"));
+
+  // the } is left to the block
+  kunjs::AtomTable atoms;
+  kunjs::ast::Program program;
+  ASSERT_TRUE(parser.parse("while (x) { break } y;", program, atoms));
+  ASSERT_EQ(2u, program.size());
+}
+
+TEST(Parser, NoPostfixOperatorAfterLineBreak) {
+  kunjs::Parser parser;
+  ASSERT_TRUE(parser.parse("i ++;"));
+  ASSERT_FALSE(parser.parse("i\n++;"));
+  ASSERT_FALSE(parser.parse("i // comment\n--;"));
+}
+
 TEST(Parser, Try) {
   kunjs::Parser parser;
   std::string code =
@@ -373,3 +580,234 @@ TEST(Parser, SwitchDefault) {
   ASSERT_TRUE(result);
 }
 
+
+TEST(Parser, FailurePosition) {
+  kunjs::Parser parser;
+  std::string code =
+      "var x = 1;\n"
+      "do x; while (y)";
+
+  kunjs::ParseResult result = parser.parse(code);
+  ASSERT_FALSE(result.success);
+  ASSERT_EQ(code.size(), result.offset);
+  ASSERT_EQ(2u, result.line);
+  ASSERT_EQ(16u, result.column);
+  ASSERT_EQ("\";\"", result.expected);
+}
+
+TEST(Parser, FailureExpectingRule) {
+  kunjs::Parser parser;
+  kunjs::ParseResult result = parser.parse("a;\n  b + ;");
+  ASSERT_FALSE(result.success);
+  ASSERT_EQ(9u, result.offset);
+  ASSERT_EQ(2u, result.line);
+  ASSERT_EQ(7u, result.column);
+  ASSERT_EQ("unary_expression", result.expected);
+}
+
+TEST(Parser, FailureWithoutExpectationIsWhereParsingStopped) {
+  kunjs::Parser parser;
+  kunjs::ParseResult result = parser.parse("a;\nb )");
+  ASSERT_FALSE(result.success);
+  ASSERT_EQ(5u, result.offset);
+  ASSERT_EQ(2u, result.line);
+  ASSERT_EQ(3u, result.column);
+}
+
+TEST(Parser, UnclosedBracketsAreExpected) {
+  kunjs::Parser parser;
+  ASSERT_EQ("\")\"", parser.parse("x = (1").expected);
+  ASSERT_EQ("\"]\"", parser.parse("x = [1, 2").expected);
+  ASSERT_EQ("\"]\"", parser.parse("a[1;").expected);
+}
+
+// Each unclosed bracket used to be parsed again by the next alternative,
+// doubling the work per level.
+TEST(Parser, DeepMalformedNestingFailsQuickly) {
+  kunjs::Parser parser;
+  std::string code = "x = ";
+  for (int i = 0; i < 40; ++i)
+    code += i % 2 ? "[" : "(";
+  code += "1;";
+
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+  kunjs::ParseResult result = parser.parse(code);
+  boost::posix_time::time_duration elapsed =
+      boost::posix_time::microsec_clock::universal_time() - start;
+  ASSERT_FALSE(result.success);
+  ASSERT_EQ(code.size() - 1, result.offset);
+  ASSERT_LT(elapsed.total_milliseconds(), 1000);
+}
+
+TEST(Parser, Comments) {
+  kunjs::Parser parser;
+  std::string code =
+      "/* license header\n"
+      " * spanning lines */\n"
+      "var n = 10; // trailing comment\n"
+      "// whole line\n"
+      "n;";
+
+  bool result = parser.parse(code);
+  ASSERT_TRUE(result);
+}
+
+TEST(Parser, ReservedWordAsMemberName) {
+  kunjs::Parser parser;
+  bool result = parser.parse("var value = options.default;");
+  ASSERT_TRUE(result);
+}
+
+TEST(Parser, ReservedWordAsIdentifier) {
+  kunjs::Parser parser;
+  bool result = parser.parse("var default = 1;");
+  ASSERT_FALSE(result);
+}
+
+TEST(Parser, PreparseLeavesBodiesLazy) {
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  std::string code =
+      "function f(a) { if (a) { return '}'; } /* } */ return a; }\n"
+      "f(1);";
+  ASSERT_TRUE(parser.parse(code, parsed, kunjs::Parser::PREPARSE));
+  ASSERT_EQ(2u, parsed.program().size());
+
+  kunjs::ast::FunctionDeclaration const& function =
+      boost::get<kunjs::ast::FunctionDeclaration>(parsed.program().at(0));
+  ASSERT_TRUE(function.body.lazy);
+  ASSERT_TRUE(function.body.empty());
+  ASSERT_EQ(" if (a) { return '}'; } /* } */ return a; ",
+            code.substr(function.body.source.offset, function.body.source.length));
+}
+
+TEST(Parser, PreparseSkipsBodyErrors) {
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  std::string code = "function f() { return +; }";
+  ASSERT_TRUE(parser.parse(code, parsed, kunjs::Parser::PREPARSE));
+  ASSERT_FALSE(parser.parse(code, parsed));
+}
+
+TEST(Parser, PreparseUnclosedBody) {
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  kunjs::ParseResult result = parser.parse("var f = function () { if (x) { y(); }", parsed, kunjs::Parser::PREPARSE);
+  ASSERT_FALSE(result);
+  ASSERT_EQ("\"}\"", result.expected);
+}
+
+TEST(Parser, PreparseFunctionExpressions) {
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  std::string code = "var f = function () { return +; };";
+  ASSERT_TRUE(parser.parse(code, parsed, kunjs::Parser::PREPARSE));
+  ASSERT_FALSE(parser.parse(code, parsed));
+}
+
+TEST(Parser, ParseBodyInPlace) {
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  std::string code =
+      "function twice(x) {\n"
+      "  function inner() { return x; }\n"
+      "  return inner() * 2;\n"
+      "}";
+  ASSERT_TRUE(parser.parse(code, parsed, kunjs::Parser::PREPARSE));
+
+  kunjs::ast::FunctionDeclaration& function =
+      boost::get<kunjs::ast::FunctionDeclaration>(parsed.program().at(0));
+  ASSERT_TRUE(function.body.lazy);
+
+  ASSERT_TRUE(parser.parse_body(code, parsed, function.body));
+  ASSERT_FALSE(function.body.lazy);
+  ASSERT_EQ(2u, function.body.size());
+
+  // nested functions are parsed one level at a time
+  kunjs::ast::FunctionDeclaration& inner = boost::get<kunjs::ast::FunctionDeclaration>(function.body.at(0));
+  ASSERT_EQ("inner", parsed.atoms().name(inner.name));
+  ASSERT_TRUE(inner.body.lazy);
+  ASSERT_EQ(" return x; ", code.substr(inner.body.source.offset, inner.body.source.length));
+
+  ASSERT_TRUE(parser.parse_body(code, parsed, inner.body));
+  ASSERT_EQ(1u, inner.body.size());
+}
+
+TEST(Parser, ParseBodyFailurePosition) {
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  std::string code =
+      "function f() {\n"
+      "  return + ;\n"
+      "}";
+  ASSERT_TRUE(parser.parse(code, parsed, kunjs::Parser::PREPARSE));
+
+  kunjs::ast::FunctionDeclaration& function =
+      boost::get<kunjs::ast::FunctionDeclaration>(parsed.program().at(0));
+  kunjs::ParseResult result = parser.parse_body(code, parsed, function.body);
+  ASSERT_FALSE(result);
+  ASSERT_EQ(2u, result.line);
+  ASSERT_EQ(12u, result.column);
+  ASSERT_EQ("unary_expression", result.expected);
+  ASSERT_TRUE(function.body.lazy);
+}
+
+TEST(Parser, NodesKnowWhereTheyStart) {
+  namespace ast = kunjs::ast;
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  std::string code =
+      "var a = 1;\n"
+      "if (a) {\n"
+      "  f(a + 2, function () {});\n"
+      "  throw new Error(a);\n"
+      "}";
+  ASSERT_TRUE(parser.parse(code, parsed));
+
+  ast::Statement const& statement = boost::get<ast::Statement>(parsed.program().at(1));
+  ast::If const& condition = boost::get<ast::If>(statement);
+  ASSERT_EQ(code.find("if"), condition.offset);
+  ASSERT_EQ(2u, parsed.locate(condition).line);
+  ASSERT_EQ(1u, parsed.locate(condition).column);
+
+  ast::Block const& block = boost::get<ast::Block>(condition.true_clause);
+  ASSERT_EQ(code.find("{"), block.offset);
+
+  ast::CallExpression const& call =
+      boost::get<ast::CallExpression>(boost::get<ast::Expression>(block.at(0)).at(0));
+  ASSERT_EQ(code.find("f("), call.offset);
+  ASSERT_EQ(3u, parsed.locate(call).line);
+  ASSERT_EQ(3u, parsed.locate(call).column);
+  ASSERT_EQ(code.find("a + 2"), boost::get<ast::BinaryExpression>(call.arguments.at(0)).offset);
+
+  ast::NewExpression const& wrapper = boost::get<ast::NewExpression>(call.arguments.at(1));
+  ast::MemberAccess const& access = boost::get<ast::MemberAccess>(wrapper.member);
+  ASSERT_EQ(code.find("function"), boost::get<ast::FunctionExpression>(access.member).offset);
+
+  ast::Throw const& thrown = boost::get<ast::Throw>(block.at(1));
+  ASSERT_EQ(code.find("throw"), thrown.offset);
+  ast::NewExpression const& error = boost::get<ast::NewExpression>(thrown.expression.at(0));
+  ASSERT_EQ(code.find("new"), error.offset);
+  ASSERT_EQ(code.find("new"), boost::get<ast::Instantiation>(error.member).offset);
+}
+
+TEST(Parser, LazyBodiesAreLocatedInTheWholeSource) {
+  namespace ast = kunjs::ast;
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  std::string code =
+      "x = 1;\n"
+      "function f() {\n"
+      "  return x;\n"
+      "}";
+  ASSERT_TRUE(parser.parse(code, parsed, kunjs::Parser::PREPARSE));
+
+  ast::FunctionDeclaration& function = boost::get<ast::FunctionDeclaration>(parsed.program().at(1));
+  ASSERT_EQ(code.find("function"), function.offset);
+  ASSERT_TRUE(parser.parse_body(code, parsed, function.body));
+
+  ast::Return const& result = boost::get<ast::Return>(boost::get<ast::Statement>(function.body.at(0)));
+  ASSERT_EQ(code.find("return"), result.offset);
+  ASSERT_EQ(3u, parsed.locate(result).line);
+  ASSERT_EQ(3u, parsed.locate(result).column);
+}
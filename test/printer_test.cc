@@ -0,0 +1,131 @@
+#include "kunjs/parser.h"
+#include "kunjs/printer.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+namespace {
+
+kunjs::AtomTable atoms;
+
+std::string Print(std::string const& code, kunjs::Printer::Mode mode = kunjs::Printer::JAVASCRIPT) {
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed(atoms);
+  kunjs::ParseResult result = parser.parse(code, parsed);
+  EXPECT_TRUE(result) << result;
+  return kunjs::Printer(atoms, mode).print(parsed.program());
+}
+
+// A dump without the offsets, which printing moves.
+std::string Tree(std::string const& code) {
+  std::string dump = Print(code, kunjs::Printer::DUMP);
+  std::string tree;
+  for (std::size_t i = 0; i < dump.size(); ++i) {
+    if (dump[i] == ' ' && i + 1 < dump.size() && dump[i + 1] == '@') {
+      for (i += 2; i < dump.size() && dump[i] >= '0' && dump[i] <= '9'; ++i) {}
+      --i;
+    } else {
+      tree += dump[i];
+    }
+  }
+  return tree;
+}
+
+// Printed code parses back to the same tree, and printing it again gives the
+// same code.
+void ExpectRoundTrip(std::string const& code) {
+  std::string printed = Print(code);
+  EXPECT_EQ(Tree(code), Tree(printed)) << printed;
+  EXPECT_EQ(printed, Print(printed));
+}
+
+}
+
+TEST(Printer, CompactJavaScript) {
+  ASSERT_EQ("var a=1,b;if(a){f(a+2,function(x){return x;});}else b=[a,(a)];",
+            Print("var a = 1, b;\n"
+                  "if (a) {\n"
+                  "  f(a + 2, function (x) { return x; });\n"
+                  "} else b = [a, (a)];\n"));
+  ASSERT_EQ("function twice(x){return x*2;}", Print("function twice(x) { return x * 2; }"));
+}
+
+TEST(Printer, SeparatesTokensOnlyWhereNeeded) {
+  ASSERT_EQ("a- -b;a+ +b;a+ ++b;a++ +b;", Print("a - -b; a + +b; a + ++b; a++ + b;"));
+  ASSERT_EQ("typeof x;x in y;x instanceof Y;new Date;", Print("typeof x; x in y; x instanceof Y; new Date;"));
+  ASSERT_EQ("1 .toString();1.5.toString();", Print("1 .toString(); 1.5.toString();"));
+  ASSERT_EQ("if(a)b();else if(c)d();else{}", Print("if (a) b(); else if (c) d(); else {}"));
+}
+
+TEST(Printer, Literals) {
+  ASSERT_EQ("f(null,true,false,10,10.0,0.1,2.5e+30,255);",
+            Print("f(null, true, false, 10, 10.0, 0.1, 2.5e30, 0xff);"));
+  ASSERT_EQ("f(\"it's\",'say \"hi\"',\"a\\\\b\\n\");",
+            Print("f(\"it's\", 'say \"hi\"', 'a\\\\b\\n');"));
+}
+
+TEST(Printer, RoundTrips) {
+  char const* const scripts[] = {
+    "var a = (1, 2), b = [1, [2, 3], (4)];",
+    "x = a ? b : c ? d : e; y = (a ? b : c) ? d : e; z = a = b += 2;",
+    "x = (a + b) * c - (d - e) / f % g; y = a - (b + c); z = !(a && b) || c;",
+    "for (var i = 0, n = a.length; i < n; i++) for (k in o) for (var j in o) ;",
+    "for (;;) { continue; } outer: do { break outer; } while (false);",
+    "switch (x) { case 1: case 2: a(); break; default: b(); case 3: }",
+    "try { f(); } catch (e) { throw e; } finally { g(); } try {} finally {}",
+    "with (o) x.y[z](1)(2).w[0] = new new F(a)(b); debugger;",
+    "(function () { return typeof this === 'object'; })(); void 0; delete a[b];",
+    "var s = 'caf\xc3\xa9 \\t \\x01', n = -1.25e-7 + 4294967296;",
+    "(new Date()).getTime(); a = b ? function f() {} : (c, d);",
+  };
+  for (std::size_t i = 0; i < sizeof(scripts) / sizeof(scripts[0]); ++i)
+    ExpectRoundTrip(scripts[i]);
+}
+
+TEST(Printer, Dump) {
+  ASSERT_EQ(
+      "(Program\n"
+      "  (If @0\n"
+      "    (Name a)\n"
+      "    (Block @7\n"
+      "      (Return @9\n"
+      "        (Binary * @16\n"
+      "          (Parenthesized\n"
+      "            (Binary + @17\n"
+      "              (Name a)\n"
+      "              (Number 1)))\n"
+      "          (Array\n"
+      "            (String \"x\")))))))\n",
+      Print("if (a) { return (a + 1) * ['x']; }", kunjs::Printer::DUMP));
+}
+
+TEST(Printer, CopiesLazyBodies) {
+  std::string code = "function f(a) { return a  +  1; } f(2);";
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed(atoms);
+  ASSERT_TRUE(parser.parse(code, parsed, kunjs::Parser::PREPARSE));
+  ASSERT_EQ("function f(a){ return a  +  1; }f(2);",
+            kunjs::Printer(atoms, kunjs::Printer::JAVASCRIPT, code).print(parsed.program()));
+}
+
+TEST(CodeBuffer, WritesStreamsInChunks) {
+  std::string code = "var a = [1, 2, 3];\n";
+  while (code.size() < 3 * kunjs::CodeBuffer::CHUNK_SIZE)
+    code += code;
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed(atoms);
+  ASSERT_TRUE(parser.parse(code, parsed));
+  kunjs::Printer printer(atoms, kunjs::Printer::JAVASCRIPT);
+  std::string printed = printer.print(parsed.program());
+
+  std::ostringstream stream;
+  {
+    kunjs::CodeBuffer out(stream);
+    printer.print(parsed.program(), out);
+    // full chunks have been written already, the rest waits for a flush
+    ASSERT_GE(stream.str().size(), kunjs::CodeBuffer::CHUNK_SIZE);
+    ASSERT_LT(stream.str().size(), printed.size());
+  }
+  ASSERT_EQ(printed, stream.str());
+}
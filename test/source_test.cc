@@ -0,0 +1,107 @@
+#include "kunjs/parser.h"
+#include "kunjs/source.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace {
+
+std::string Write(std::string const& name, std::string const& contents) {
+  std::string path = "kunjs_" + name + ".js";
+  std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+  file << contents;
+  return path;
+}
+
+}
+
+TEST(Source, PointsIntoTheText) {
+  std::string code = "var n = 10;";
+  kunjs::Source source(code);
+  ASSERT_EQ(code.data(), source.begin());
+  ASSERT_EQ(code.size(), source.size());
+
+  kunjs::Source literal("n;");
+  ASSERT_EQ(2u, literal.size());
+  ASSERT_TRUE(kunjs::Source().empty());
+}
+
+TEST(Source, ParsesAPieceOfABuffer) {
+  // not terminated where the script ends
+  char const buffer[] = "var n = 10; n; )(garbage";
+  kunjs::Parser parser;
+  ASSERT_TRUE(parser.parse(kunjs::Source(buffer, 14)));
+  ASSERT_FALSE(parser.parse(kunjs::Source(buffer, sizeof(buffer) - 1)));
+}
+
+TEST(MappedFile, MapsTheWholeFile) {
+  std::string code = "function twice(x) { return x * 2; }\ntwice(21);\n";
+  std::string path = Write("mapped", code);
+
+  kunjs::MappedFile file;
+  ASSERT_TRUE(file.open(path));
+  ASSERT_TRUE(file.is_open());
+  ASSERT_EQ(code, file.source().str());
+
+  kunjs::Parser parser;
+  kunjs::ParsedProgram parsed;
+  ASSERT_TRUE(parser.parse(file.source(), parsed));
+  ASSERT_EQ(2u, parsed.program().size());
+
+  file.close();
+  ASSERT_FALSE(file.is_open());
+  ASSERT_TRUE(file.source().empty());
+  std::remove(path.c_str());
+}
+
+TEST(MappedFile, EmptyFile) {
+  std::string path = Write("empty", "");
+  kunjs::MappedFile file;
+  ASSERT_TRUE(file.open(path));
+  ASSERT_TRUE(file.source().empty());
+  std::remove(path.c_str());
+}
+
+TEST(MappedFile, MissingFile) {
+  kunjs::MappedFile file;
+  ASSERT_FALSE(file.open("kunjs_no_such_file.js"));
+  ASSERT_FALSE(file.is_open());
+}
+
+TEST(LineTable, LocatesOffsets) {
+  std::string code = "a;\n\nvar b;\r\n  c;";
+  kunjs::LineTable lines(code);
+  ASSERT_EQ(4u, lines.lines());
+
+  ASSERT_EQ(1u, lines.locate(0).line);
+  ASSERT_EQ(1u, lines.locate(0).column);
+  ASSERT_EQ(1u, lines.locate(2).line);
+  ASSERT_EQ(3u, lines.locate(2).column);
+  ASSERT_EQ(2u, lines.locate(3).line);
+  ASSERT_EQ(3u, lines.locate(4).line);
+  ASSERT_EQ(5u, lines.locate(8).column);
+
+  kunjs::Location c = lines.locate(boost::uint32_t(code.find('c')));
+  ASSERT_EQ(4u, c.line);
+  ASSERT_EQ(3u, c.column);
+
+  // past the end, on the last line
+  ASSERT_EQ(4u, lines.locate(100).line);
+  ASSERT_EQ(1u, kunjs::LineTable(kunjs::Source()).lines());
+}
+
+TEST(LineTable, EndsLinesWhereTheLexerDoes) {
+  std::string code = "a\rb\r\nc\nd\r";
+  kunjs::LineTable lines(code);
+  ASSERT_EQ(5u, lines.lines());
+
+  ASSERT_EQ(2u, lines.locate(2).line);
+  ASSERT_EQ(1u, lines.locate(2).column);
+  ASSERT_EQ(2u, lines.locate(4).line);
+  ASSERT_EQ(3u, lines.locate(5).line);
+  ASSERT_EQ(1u, lines.locate(5).column);
+  ASSERT_EQ(4u, lines.locate(7).line);
+  ASSERT_EQ(5u, lines.locate(9).line);
+}